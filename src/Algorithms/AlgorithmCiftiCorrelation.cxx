@@ -200,89 +200,12 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
     CiftiXMLOld newXML = myCifti->getCiftiXMLOld();
     newXML.applyColumnMapToRows();
     myCiftiOut->setCiftiXML(newXML);
-    int numCacheRows;
-    bool cacheFullInput = true;
-    if (memLimitGB >= 0.0f)
+    vector<pair<int, int> > ciftiIndexList(numRows);
+    for (int i = 0; i < numRows; ++i)
     {
-        numCacheRows = numRowsForMem(memLimitGB, cacheFullInput);
-    } else {
-        numCacheRows = numRows;
-    }
-    if (numCacheRows > numRows) numCacheRows = numRows;
-    if (cacheFullInput)
-    {
-        if (numCacheRows != numRows) CaretLogInfo("computing " + AString::number(numCacheRows) + " rows at a time");
-    } else {
-        CaretLogInfo("computing " + AString::number(numCacheRows) + " rows at a time, reading rows as needed during processing");
-    }
-    vector<CaretArray<float> > outRows;
-    if (cacheFullInput)
-    {
-        for (int i = 0; i < numRows; ++i)
-        {
-            cacheRow(i);
-        }
-    }
-    for (int startrow = 0; startrow < numRows; startrow += numCacheRows)
-    {
-        int endrow = startrow + numCacheRows;
-        if (endrow > numRows) endrow = numRows;
-        outRows.resize(endrow - startrow);
-        for (int i = startrow; i < endrow; ++i)
-        {
-            if (!cacheFullInput)
-            {
-                cacheRow(i);//preload the rows in a range which we will reuse as much as possible during one row by row scan
-            }
-            if (outRows[i - startrow].size() != numRows)
-            {
-                outRows[i - startrow] = CaretArray<float>(numRows);
-            }
-        }
-        int curRow = 0;//because we can't trust the order threads hit the critical section
-#pragma omp CARET_PARFOR schedule(dynamic)
-        for (int i = 0; i < numRows; ++i)
-        {
-            float movingRrs;
-            int myrow;
-            const float* movingRow;
-#pragma omp critical
-            {//CiftiFile may explode if we request multiple rows concurrently (needs mutexes), but we should force sequential requests anyway
-                myrow = curRow;//so, manually force it to read sequentially
-                ++curRow;
-                movingRow = getRow(myrow, movingRrs);
-            }
-            for (int j = startrow; j < endrow; ++j)
-            {
-                if (myrow >= startrow && myrow < endrow)//check whether we are in the output memory area
-                {
-                    if (j >= myrow)//if so, only compute one half, and store both places
-                    {
-                        float cacheRrs;
-                        const float* cacheRow = getRow(j, cacheRrs, true);
-                        outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                        outRows[myrow - startrow][j] = outRows[j - startrow][myrow];
-                    }
-                } else {
-                    float cacheRrs;
-                    const float* cacheRow = getRow(j, cacheRrs, true);
-                    outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                }
-            }
-        }
-        for (int i = startrow; i < endrow; ++i)
-        {
-            myCiftiOut->setRow(outRows[i - startrow], i);
-        }
-        if (!cacheFullInput)
-        {
-            clearCache();//tell the cache we are going to preload a different set of rows now
-        }
-    }
-    if (cacheFullInput)
-    {
-        clearCache();//don't currently need to do this, its just for completeness
+        ciftiIndexList[i] = pair<int, int>(i, i);
     }
+    processRows(myCiftiOut, ciftiIndexList, fisherZ, memLimitGB);
 }
 
 AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj, const CiftiFile* myCifti, CiftiFile* myCiftiOut,
@@ -385,7 +308,61 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
         }
     }
     myCiftiOut->setCiftiXML(newXML);
-    int numSelected = (int)ciftiIndexList.size(), numRows = myCifti->getNumberOfRows();
+    processRows(myCiftiOut, ciftiIndexList, fisherZ, memLimitGB);
+}
+
+AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj, const CiftiFile* myCifti, CiftiFile* myCiftiOut, const CiftiFile* ciftiRoi,
+                                                     const vector<float>* weights, const bool& fisherZ, const float& memLimitGB,
+                                                     const bool& noDemean, const bool& covariance): AbstractAlgorithm(NULL)//HACK: get around the sentinel by passing a null, because this implementation calls another
+{
+    const CiftiXML& roiXML = ciftiRoi->getCiftiXML();//roi is not optional in this variant
+    if (roiXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS) throw AlgorithmException("cifti roi does not have brain models mapping along column");
+    const CiftiBrainModelsMap myDenseMap = roiXML.getBrainModelsMap(CiftiXML::ALONG_COLUMN);
+    MetricFile leftRoi, rightRoi, cerebRoi;
+    MetricFile* leftRoiPtr = NULL, *rightRoiPtr = NULL, *cerebRoiPtr = NULL;
+    VolumeFile volRoi;
+    VolumeFile* volRoiPtr = NULL;
+    vector<StructureEnum::Enum> surfStructs = myDenseMap.getSurfaceStructureList();
+    for (int i = 0; i < (int)surfStructs.size(); ++i)
+    {
+        MetricFile* thisRoi = NULL;
+        switch (surfStructs[i])
+        {
+            case StructureEnum::CORTEX_LEFT:
+                thisRoi = &leftRoi;
+                leftRoiPtr = thisRoi;
+                break;
+            case StructureEnum::CORTEX_RIGHT:
+                thisRoi = &rightRoi;
+                rightRoiPtr = thisRoi;
+                break;
+            case StructureEnum::CEREBELLUM:
+                thisRoi = &cerebRoi;
+                cerebRoiPtr = thisRoi;
+                break;
+            default:
+                throw AlgorithmException("structure not supported for surface type: " + StructureEnum::toName(surfStructs[i]));
+        }
+        AlgorithmCiftiSeparate(NULL, ciftiRoi, CiftiXML::ALONG_COLUMN, surfStructs[i], thisRoi);
+    }
+    if (myDenseMap.hasVolumeData())
+    {
+        int64_t offsetOut[3];
+        AlgorithmCiftiSeparate(NULL, ciftiRoi, CiftiXML::ALONG_COLUMN, &volRoi, offsetOut, NULL, false);//don't crop, because it needs to match the original volume space in the input
+        volRoiPtr = &volRoi;
+    }
+    AlgorithmCiftiCorrelation(myProgObj, myCifti, myCiftiOut, leftRoiPtr, rightRoiPtr, cerebRoiPtr, volRoiPtr, weights, fisherZ, memLimitGB, noDemean, covariance);//HACK: pass through our progress object
+}
+
+namespace
+{//only the rows are batched, each pair is still a separate dsdot call, so that the -simd choice applies to every dot product
+    const int MOVING_BLOCK = 64;//moving rows fetched per trip through the critical section
+    const int CACHED_TILE = 8;//cached rows correlated with a whole block of moving rows before moving on, so they stay in cache while the block streams past
+}
+
+void AlgorithmCiftiCorrelation::processRows(CiftiFile* myCiftiOut, const vector<pair<int, int> >& ciftiIndexList, const bool& fisherZ, const float& memLimitGB)
+{//ciftiIndexList is (input row, output row) for every output row to compute
+    int numSelected = (int)ciftiIndexList.size(), numRows = m_inputCifti->getNumberOfRows();
     int numCacheRows;
     bool cacheFullInput = true;
     if (memLimitGB >= 0.0f)
@@ -409,13 +386,14 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             cacheRow(i);
         }
     }
+    const int rowLength = getRowLength();
+    const int numBlocks = (numRows + MOVING_BLOCK - 1) / MOVING_BLOCK;
     CaretArray<int> indexReverse(numRows, -1);
     for (int startrow = 0; startrow < numSelected; startrow += numCacheRows)
     {
         int endrow = startrow + numCacheRows;
         if (endrow > numSelected) endrow = numSelected;
         outRows.resize(endrow - startrow);
-        int curRow = 0;//because we can't trust the order threads hit the critical section
         for (int i = startrow; i < endrow; ++i)
         {
             if (!cacheFullInput)
@@ -428,33 +406,65 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             }
             indexReverse[ciftiIndexList[i].first] = i;
         }
+        vector<const float*> chunkRows(endrow - startrow);
+        vector<float> chunkRrs(endrow - startrow);
+        for (int i = startrow; i < endrow; ++i)
+        {
+            chunkRows[i - startrow] = getRow(ciftiIndexList[i].first, chunkRrs[i - startrow], true);
+        }
+        int curRow = 0;//because we can't trust the order threads hit the critical section
 #pragma omp CARET_PARFOR schedule(dynamic)
-        for (int i = 0; i < numRows; ++i)
+        for (int block = 0; block < numBlocks; ++block)
         {
-            float movingRrs;
-            int myrow;
-            const float* movingRow;
+            const float* movingRows[MOVING_BLOCK];
+            float movingRrs[MOVING_BLOCK];
+            int blockStart, blockSize;
 #pragma omp critical
             {//CiftiFile may explode if we request multiple rows concurrently (needs mutexes), but we should force sequential requests anyway
-                myrow = curRow;//so, manually force it to read sequentially
-                ++curRow;
-                movingRow = getRow(myrow, movingRrs);
+                blockStart = curRow;//so, manually force it to read sequentially
+                blockSize = min(MOVING_BLOCK, numRows - blockStart);
+                curRow += blockSize;
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    movingRows[i] = getRow(blockStart + i, movingRrs[i], false, i);
+                }
+            }
+            int firstNeeded = endrow;//moving rows that are also in the output range only compute one half, find the first output row this block needs
+            for (int i = 0; i < blockSize; ++i)
+            {
+                int reverse = indexReverse[blockStart + i];
+                if (reverse == -1)
+                {
+                    firstNeeded = startrow;
+                    break;
+                }
+                if (reverse < firstNeeded) firstNeeded = reverse;
             }
-            for (int j = startrow; j < endrow; ++j)
+            for (int tileStart = startrow; tileStart < endrow; tileStart += CACHED_TILE)
             {
-                if (indexReverse[myrow] != -1)//check if we are on a row that is in the output memory range
+                int tileEnd = min(tileStart + CACHED_TILE, endrow);
+                if (tileEnd <= firstNeeded) continue;//all of these get filled in from the other half
+                for (int i = 0; i < blockSize; ++i)
                 {
-                    if (indexReverse[myrow] <= j)//if so, only compute one of the elements, then store it both places
+                    int myrow = blockStart + i;
+                    int reverse = indexReverse[myrow];
+                    for (int outIndex = tileStart; outIndex < tileEnd; ++outIndex)
                     {
-                        float cacheRrs;
-                        const float* cacheRow = getRow(ciftiIndexList[j].first, cacheRrs, true);
-                        outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                        outRows[indexReverse[myrow] - startrow][ciftiIndexList[j].first] = outRows[j - startrow][myrow];
+                        int cacheIndex = ciftiIndexList[outIndex].first;
+                        if (reverse != -1)//check if we are on a row that is in the output memory range
+                        {
+                            if (reverse <= outIndex)//if so, only compute one of the elements, then store it both places
+                            {
+                                double accum = dsdot(movingRows[i], chunkRows[outIndex - startrow], rowLength);
+                                float value = finishCorrelation(accum, movingRrs[i], chunkRrs[outIndex - startrow], myrow == cacheIndex, fisherZ);
+                                outRows[outIndex - startrow][myrow] = value;
+                                outRows[reverse - startrow][cacheIndex] = value;
+                            }
+                        } else {
+                            double accum = dsdot(movingRows[i], chunkRows[outIndex - startrow], rowLength);
+                            outRows[outIndex - startrow][myrow] = finishCorrelation(accum, movingRrs[i], chunkRrs[outIndex - startrow], false, fisherZ);
+                        }
                     }
-                } else {
-                    float cacheRrs;
-                    const float* cacheRow = getRow(ciftiIndexList[j].first, cacheRrs, true);
-                    outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
                 }
             }
         }
@@ -474,73 +484,33 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
     }
 }
 
-AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj, const CiftiFile* myCifti, CiftiFile* myCiftiOut, const CiftiFile* ciftiRoi,
-                                                     const vector<float>* weights, const bool& fisherZ, const float& memLimitGB,
-                                                     const bool& noDemean, const bool& covariance): AbstractAlgorithm(NULL)//HACK: get around the sentinel by passing a null, because this implementation calls another
+int AlgorithmCiftiCorrelation::getRowLength()
 {
-    const CiftiXML& roiXML = ciftiRoi->getCiftiXML();//roi is not optional in this variant
-    if (roiXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS) throw AlgorithmException("cifti roi does not have brain models mapping along column");
-    const CiftiBrainModelsMap myDenseMap = roiXML.getBrainModelsMap(CiftiXML::ALONG_COLUMN);
-    MetricFile leftRoi, rightRoi, cerebRoi;
-    MetricFile* leftRoiPtr = NULL, *rightRoiPtr = NULL, *cerebRoiPtr = NULL;
-    VolumeFile volRoi;
-    VolumeFile* volRoiPtr = NULL;
-    vector<StructureEnum::Enum> surfStructs = myDenseMap.getSurfaceStructureList();
-    for (int i = 0; i < (int)surfStructs.size(); ++i)
-    {
-        MetricFile* thisRoi = NULL;
-        switch (surfStructs[i])
-        {
-            case StructureEnum::CORTEX_LEFT:
-                thisRoi = &leftRoi;
-                leftRoiPtr = thisRoi;
-                break;
-            case StructureEnum::CORTEX_RIGHT:
-                thisRoi = &rightRoi;
-                rightRoiPtr = thisRoi;
-                break;
-            case StructureEnum::CEREBELLUM:
-                thisRoi = &cerebRoi;
-                cerebRoiPtr = thisRoi;
-                break;
-            default:
-                throw AlgorithmException("structure not supported for surface type: " + StructureEnum::toName(surfStructs[i]));
-        }
-        AlgorithmCiftiSeparate(NULL, ciftiRoi, CiftiXML::ALONG_COLUMN, surfStructs[i], thisRoi);
-    }
-    if (myDenseMap.hasVolumeData())
-    {
-        int64_t offsetOut[3];
-        AlgorithmCiftiSeparate(NULL, ciftiRoi, CiftiXML::ALONG_COLUMN, &volRoi, offsetOut, NULL, false);//don't crop, because it needs to match the original volume space in the input
-        volRoiPtr = &volRoi;
-    }
-    AlgorithmCiftiCorrelation(myProgObj, myCifti, myCiftiOut, leftRoiPtr, rightRoiPtr, cerebRoiPtr, volRoiPtr, weights, fisherZ, memLimitGB, noDemean, covariance);//HACK: pass through our progress object
+    if (m_weightedMode) return (int)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
+    return m_numCols;
 }
 
-float AlgorithmCiftiCorrelation::correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const bool& fisherZ)
-{
+float AlgorithmCiftiCorrelation::finishCorrelation(const double& accum, const float& rrs1, const float& rrs2, const bool& sameRow, const bool& fisherZ)
+{//rows have already had the (weighted) row means subtracted out, and weights applied
     double r;
-    if (row1 == row2 && !m_covariance)
+    if (sameRow && !m_covariance)
     {
         r = 1.0;//short circuit for same row
     } else {
         if (m_weightedMode)
         {
-            int numWeights = (int)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
-            double accum = dsdot(row1, row2, numWeights);//these have already had the weighted row means subtracted out, and weights applied
             if (m_covariance)
             {
                 if (m_binaryWeights)
                 {
-                    r = accum / numWeights;
+                    r = accum / (int)m_weightIndexes.size();
                 } else {
                     r = accum / rrs1;//NOTE: will equal rrs2 as it only depends on weights, and is not square root
                 }
             } else {
-                r = accum / (rrs1 * rrs2);//as do these
+                r = accum / (rrs1 * rrs2);
             }
         } else {
-            double accum = dsdot(row1, row2, m_numCols);//these have already had the row means subtracted out
             if (m_covariance)
             {
                 r = accum / m_numCols;
@@ -638,7 +608,7 @@ void AlgorithmCiftiCorrelation::clearCache()
     m_cacheUsed = 0;
 }
 
-const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached)
+const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached, const int& tempSlot)
 {
     float* ret;
     CaretAssertVectorIndex(m_rowInfo, ciftiIndex);
@@ -651,7 +621,7 @@ const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& roo
         {
             throw AlgorithmException("something very bad happened, notify the developers");
         }
-        ret = getTempRow();
+        ret = getTempRow(tempSlot);
         m_inputCifti->getRow(ret, ciftiIndex);
         if (!m_rowInfo[ciftiIndex].m_haveCalculated)
         {
@@ -769,8 +739,9 @@ void AlgorithmCiftiCorrelation::doSubtract(float* row, const float& mean)
     }
 }
 
-float* AlgorithmCiftiCorrelation::getTempRow()
-{
+float* AlgorithmCiftiCorrelation::getTempRow(const int& slot)
+{//each thread gets MOVING_BLOCK rows, so a whole block can be read in one trip through the critical section
+    CaretAssert(slot >= 0 && slot < MOVING_BLOCK);
 #ifdef CARET_OMP
     int oldsize = (int)m_tempRows.size();
     int threadNum = omp_get_thread_num();
@@ -779,17 +750,17 @@ float* AlgorithmCiftiCorrelation::getTempRow()
         m_tempRows.resize(threadNum + 1);
         for (int i = oldsize; i <= threadNum; ++i)
         {
-            m_tempRows[i] = CaretArray<float>(m_numCols);
+            m_tempRows[i] = CaretArray<float>(((int64_t)m_numCols) * MOVING_BLOCK);
         }
     }
-    return m_tempRows[threadNum].getArray();
+    return m_tempRows[threadNum].getArray() + ((int64_t)m_numCols) * slot;
 #else
     if (m_tempRows.size() == 0)
     {
         m_tempRows.resize(1);
-        m_tempRows[0] = CaretArray<float>(m_numCols);
+        m_tempRows[0] = CaretArray<float>(((int64_t)m_numCols) * MOVING_BLOCK);
     }
-    return m_tempRows[0].getArray();
+    return m_tempRows[0].getArray() + ((int64_t)m_numCols) * slot;
 #endif
 }
 
@@ -800,9 +771,9 @@ int AlgorithmCiftiCorrelation::numRowsForMem(const float& memLimitGB, bool& cach
     int64_t targetBytes = (int64_t)(memLimitGB * 1024 * 1024 * 1024);
     if (m_inputCifti->isInMemory()) targetBytes -= numRows * m_numCols * 4;//count in-memory input against the total too
 #ifdef CARET_OMP
-    targetBytes -= inrowBytes * omp_get_max_threads();
+    targetBytes -= ((int64_t)inrowBytes) * MOVING_BLOCK * omp_get_max_threads();
 #else
-    targetBytes -= inrowBytes;//1 row in memory that isn't a reference to cache
+    targetBytes -= ((int64_t)inrowBytes) * MOVING_BLOCK;//1 block of rows in memory that isn't a reference to cache
 #endif
     targetBytes -= numRows * sizeof(RowInfo);//storage for mean, stdev, and info about caching
     int64_t perRowBytes = inrowBytes + outrowBytes;//cache and memory collation for output rows
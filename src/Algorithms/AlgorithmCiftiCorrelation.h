@@ -21,6 +21,7 @@
  */
 /*LICENSE_END*/
 
+#include <utility>
 #include <vector>
 #include "AbstractAlgorithm.h"
 #include "CaretPointer.h"
@@ -59,9 +60,11 @@ namespace caret {
         void computeRowStats(const float* row, float& mean, float& rootResidSqr);
         void doSubtract(float* row, const float& mean);
         void clearCache();
-        const float* getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached = false);
-        float* getTempRow();
-        float correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const bool& fisherZ);
+        const float* getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached = false, const int& tempSlot = 0);
+        float* getTempRow(const int& slot);
+        int getRowLength();
+        float finishCorrelation(const double& accum, const float& rrs1, const float& rrs2, const bool& sameRow, const bool& fisherZ);
+        void processRows(CiftiFile* myCiftiOut, const std::vector<std::pair<int, int> >& ciftiIndexList, const bool& fisherZ, const float& memLimitGB);
         void init(const CiftiFile* input, const std::vector<float>* weights, const bool& noDemean, const bool& covariance);
         int numRowsForMem(const float& memLimitGB, bool& cacheFullInput);
     protected:
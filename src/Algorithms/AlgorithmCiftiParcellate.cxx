@@ -21,6 +21,7 @@
 #include "AlgorithmCiftiParcellate.h"
 #include "AlgorithmException.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
@@ -29,6 +30,7 @@
 #include "ReductionOperation.h"
 #include "SurfaceFile.h"
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 
@@ -238,6 +240,184 @@ void AlgorithmCiftiParcellate::useParameters(OperationParameters* myParams, Prog
                              legacyMode, emptyFillValue, emptyMaskOut);
 }
 
+namespace
+{
+    //MEAN and SUM are linear, so parcellating with them is a sparse matrix (parcels by brainordinates) times the data, and we can avoid gathering each parcel's values
+    class ParcelMatrix
+    {
+        vector<int64_t> m_parcelStart, m_members;//compressed rows: members of parcel i are m_members[m_parcelStart[i]] to m_members[m_parcelStart[i + 1] - 1], in index order
+        vector<float> m_indexWeights;//weight of each brainordinate, 1 if unweighted
+        vector<double> m_divisor;//sum of weights for MEAN, 1 for SUM
+    public:
+        static bool canUse(const ReductionEnum::Enum& method, const float& excludeLow, const float& excludeHigh, const bool& onlyNumeric, const bool& isLabel)
+        {
+            if (isLabel || onlyNumeric || (excludeLow > 0.0f && excludeHigh > 0.0f)) return false;
+            return method == ReductionEnum::MEAN || method == ReductionEnum::SUM;
+        }
+        
+        ParcelMatrix(const vector<int>& indexToParcel, const int& numParcels, const ReductionEnum::Enum& method, const vector<vector<float> >* parcelWeights = NULL)
+        {
+            CaretAssert(method == ReductionEnum::MEAN || method == ReductionEnum::SUM);
+            int64_t numIndices = (int64_t)indexToParcel.size();
+            m_parcelStart.resize(numParcels + 1, 0);
+            for (int64_t j = 0; j < numIndices; ++j)
+            {
+                if (indexToParcel[j] != -1) ++m_parcelStart[indexToParcel[j] + 1];
+            }
+            for (int i = 0; i < numParcels; ++i)
+            {
+                m_parcelStart[i + 1] += m_parcelStart[i];
+            }
+            m_members.resize(m_parcelStart[numParcels]);
+            m_indexWeights.resize(numIndices, 0.0f);
+            vector<int64_t> fillPos(m_parcelStart.begin(), m_parcelStart.end() - 1);
+            for (int64_t j = 0; j < numIndices; ++j)
+            {
+                int parcel = indexToParcel[j];
+                if (parcel != -1)
+                {
+                    CaretAssert(parcel >= 0 && parcel < numParcels);
+                    int64_t memberIndex = fillPos[parcel] - m_parcelStart[parcel];
+                    m_members[fillPos[parcel]] = j;
+                    ++fillPos[parcel];
+                    if (parcelWeights != NULL)
+                    {//weight lists are built in index order, same as the members
+                        CaretAssert(memberIndex < (int64_t)(*parcelWeights)[parcel].size());
+                        m_indexWeights[j] = (*parcelWeights)[parcel][memberIndex];
+                    } else {
+                        m_indexWeights[j] = 1.0f;
+                    }
+                }
+            }
+            m_divisor.resize(numParcels, 1.0);
+            if (method == ReductionEnum::MEAN)
+            {
+                for (int i = 0; i < numParcels; ++i)
+                {
+                    double weightsum = 0.0;//same order of summation as ReductionOperation, so the results match
+                    for (int64_t k = m_parcelStart[i]; k < m_parcelStart[i + 1]; ++k)
+                    {
+                        weightsum += m_indexWeights[m_members[k]];
+                    }
+                    m_divisor[i] = weightsum;
+                }
+            }
+        }
+        
+        int getNumberOfParcels() const { return (int)m_divisor.size(); }
+        
+        bool isEmpty(const int& parcel) const { return m_parcelStart[parcel] == m_parcelStart[parcel + 1]; }
+        
+        float getIndexWeight(const int64_t& index) const { return m_indexWeights[index]; }
+        
+        double getDivisor(const int& parcel) const { return m_divisor[parcel]; }
+        
+        //one row of brainordinates to one row of parcels
+        void multiply(const float* input, float* output, const float& emptyFillVal) const
+        {
+            int numParcels = getNumberOfParcels();
+            for (int i = 0; i < numParcels; ++i)
+            {
+                if (isEmpty(i))
+                {
+                    output[i] = emptyFillVal;
+                    continue;
+                }
+                double accum = 0.0;
+                for (int64_t k = m_parcelStart[i]; k < m_parcelStart[i + 1]; ++k)
+                {
+                    int64_t index = m_members[k];
+                    accum += input[index] * m_indexWeights[index];
+                }
+                output[i] = accum / m_divisor[i];
+            }
+        }
+    };
+    
+    void doSparseParcellation(const CiftiFile* myCiftiIn, const int& direction, CiftiFile* myCiftiOut, const ParcelMatrix& parcelMatrix,
+                              const vector<int>& indexToParcel, const float& emptyFillVal)
+    {
+        const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
+        CaretAssert(myInputXML.getNumberOfDimensions() == 2);
+        const int64_t BLOCK_ROWS = 64, COL_CHUNK = 1024;
+        int64_t numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+        int64_t numCols = myInputXML.getDimensionLength(CiftiXML::ALONG_ROW);
+        int numParcels = parcelMatrix.getNumberOfParcels();
+        if (direction == CiftiXML::ALONG_ROW)
+        {//each row is independent, read a block of rows and multiply them in parallel
+            vector<float> inBlock(BLOCK_ROWS * numCols), outBlock(BLOCK_ROWS * numParcels);
+            for (int64_t blockStart = 0; blockStart < numRows; blockStart += BLOCK_ROWS)
+            {
+                int64_t blockRows = min(BLOCK_ROWS, numRows - blockStart);
+                for (int64_t i = 0; i < blockRows; ++i)
+                {
+                    myCiftiIn->getRow(inBlock.data() + i * numCols, blockStart + i);
+                }
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int64_t i = 0; i < blockRows; ++i)
+                {
+                    parcelMatrix.multiply(inBlock.data() + i * numCols, outBlock.data() + i * numParcels, emptyFillVal);
+                }
+                for (int64_t i = 0; i < blockRows; ++i)
+                {
+                    myCiftiOut->setRow(outBlock.data() + i * numParcels, blockStart + i);
+                }
+            }
+        } else {//rows are brainordinates, stream the member rows once and accumulate into the parcel rows, threads split the columns so they never write the same accumulator
+            CaretAssert(direction == CiftiXML::ALONG_COLUMN);
+            vector<double> accum(numParcels * numCols, 0.0);
+            vector<float> inBlock(BLOCK_ROWS * numCols);
+            vector<int64_t> blockIndices;
+            blockIndices.reserve(BLOCK_ROWS);
+            int64_t nextRow = 0;
+            while (nextRow < numRows)
+            {
+                blockIndices.clear();
+                for (; nextRow < numRows && (int64_t)blockIndices.size() < BLOCK_ROWS; ++nextRow)
+                {
+                    if (indexToParcel[nextRow] != -1)
+                    {
+                        myCiftiIn->getRow(inBlock.data() + blockIndices.size() * numCols, nextRow);
+                        blockIndices.push_back(nextRow);
+                    }
+                }
+                int64_t blockRows = (int64_t)blockIndices.size();
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int64_t colStart = 0; colStart < numCols; colStart += COL_CHUNK)
+                {
+                    int64_t colEnd = min(colStart + COL_CHUNK, numCols);
+                    for (int64_t i = 0; i < blockRows; ++i)
+                    {//rows are in index order, so each parcel sums in the same order as ReductionOperation
+                        const float weight = parcelMatrix.getIndexWeight(blockIndices[i]);
+                        const float* inRow = inBlock.data() + i * numCols;
+                        double* accumRow = accum.data() + indexToParcel[blockIndices[i]] * numCols;
+                        for (int64_t j = colStart; j < colEnd; ++j)
+                        {
+                            accumRow[j] += inRow[j] * weight;
+                        }
+                    }
+                }
+            }
+            vector<float> scratchOutRow(numCols);
+            for (int i = 0; i < numParcels; ++i)
+            {
+                if (parcelMatrix.isEmpty(i))
+                {
+                    scratchOutRow.assign(numCols, emptyFillVal);
+                } else {
+                    const double divisor = parcelMatrix.getDivisor(i);
+                    const double* accumRow = accum.data() + i * numCols;
+                    for (int64_t j = 0; j < numCols; ++j)
+                    {
+                        scratchOutRow[j] = accumRow[j] / divisor;
+                    }
+                }
+                myCiftiOut->setRow(scratchOutRow.data(), i);
+            }
+        }
+    }
+}
+
 AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const CiftiFile* myCiftiLabel, const int& direction, CiftiFile* myCiftiOut,
                                                    const ReductionEnum::Enum& method, const float& excludeLow, const float& excludeHigh, const bool& onlyNumeric,
                                                    const bool& legacyMode, const float& emptyFillVal, CiftiFile* emptyMaskOut) : AbstractAlgorithm(myProgObj)
@@ -324,6 +504,11 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
     {
         CaretLogWarning(ReductionEnum::toName(method) + " reduction requested while parcellating label data");
     }
+    if (dims.size() == 2 && ParcelMatrix::canUse(method, excludeLow, excludeHigh, onlyNumeric, isLabel))
+    {
+        doSparseParcellation(myCiftiIn, direction, myCiftiOut, ParcelMatrix(indexToParcel, numParcels, method), indexToParcel, emptyFillVal);
+        return;
+    }
     if (direction == CiftiXML::ALONG_ROW)
     {
         vector<float> scratchOutRow(numParcels);
@@ -521,6 +706,11 @@ namespace
             }
             emptyMaskOut->setColumn(emptyMaskData.data(), 0);
         }
+        if (dims.size() == 2 && ParcelMatrix::canUse(method, excludeLow, excludeHigh, onlyNumeric, isLabel))
+        {
+            doSparseParcellation(myCiftiIn, direction, myCiftiOut, ParcelMatrix(indexToParcel, numParcels, method, &parcelWeights), indexToParcel, emptyFillVal);
+            return;
+        }
         int64_t numCols = myInputXML.getDimensionLength(CiftiXML::ALONG_ROW);
         vector<float> scratchRow(numCols);
         if (direction == CiftiXML::ALONG_ROW)
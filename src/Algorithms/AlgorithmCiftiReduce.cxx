@@ -22,10 +22,13 @@
 #include "AlgorithmException.h"
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 #include "MultiDimIterator.h"
+#include "ReductionAccumulator.h"
 #include "ReductionOperation.h"
 
+#include <algorithm>
 #include <vector>
 
 using namespace caret;
@@ -106,32 +109,62 @@ AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const Cift
     myOutXML.setMap(direction, newMap);
     ciftiOut->setCiftiXML(myOutXML);
     vector<int64_t> inDims = inputXML.getDimensions();
+    const int64_t BLOCK_ROWS = 64;
+    AString errorMessage;//can't throw out of an omp region
     if (direction == CiftiXML::ALONG_ROW)
     {
         if (inDims[0] == 1 && ! ReductionOperation::isLengthOneReasonable(myReduce))
         {
             CaretLogWarning("-cifti-reduce is being used for a length=1 reduction on file '" + ciftiIn->getFileName() + "'");
         }
-        vector<float> scratchInRow(inDims[0]);
-        for (MultiDimIterator<int64_t> iter(vector<int64_t>(inDims.begin() + 1, inDims.end())); !iter.atEnd(); ++iter)
-        {// + 1 to exclude row dimension, because getRow/setRow
-            ciftiIn->getRow(scratchInRow.data(), *iter);
-            float result = -1;
-            if (onlyNumeric)
+        vector<float> inBlock(BLOCK_ROWS * inDims[0]), outBlock(BLOCK_ROWS);
+        vector<vector<int64_t> > blockIndices;
+        MultiDimIterator<int64_t> iter(vector<int64_t>(inDims.begin() + 1, inDims.end()));// + 1 to exclude row dimension, because getRow/setRow
+        while (!iter.atEnd())
+        {//read a block of rows, then reduce them in parallel
+            blockIndices.clear();
+            for (; !iter.atEnd() && (int64_t)blockIndices.size() < BLOCK_ROWS; ++iter)
             {
-                result = ReductionOperation::reduceOnlyNumeric(scratchInRow.data(), inDims[0], myReduce);
-            } else {
-                result = ReductionOperation::reduce(scratchInRow.data(), inDims[0], myReduce);
+                ciftiIn->getRow(inBlock.data() + blockIndices.size() * inDims[0], *iter);
+                blockIndices.push_back(*iter);
+            }
+            int64_t blockRows = (int64_t)blockIndices.size();
+#pragma omp CARET_PAR
+            {
+                ReductionAccumulator myAccum(myReduce, onlyNumeric);//one per thread, reset() keeps the allocations
+                myAccum.reserve(inDims[0]);
+#pragma omp CARET_FOR schedule(dynamic)
+                for (int64_t i = 0; i < blockRows; ++i)
+                {
+                    myAccum.reset();
+                    myAccum.addValues(inBlock.data() + i * inDims[0], inDims[0]);
+                    try
+                    {
+                        outBlock[i] = myAccum.getResult();
+                    } catch (CaretException& e) {
+#pragma omp critical
+                        errorMessage = e.whatString();
+                    }
+                }
+            }
+            if (errorMessage != "") throw AlgorithmException(errorMessage);
+            for (int64_t i = 0; i < blockRows; ++i)
+            {
+                ciftiOut->setRow(outBlock.data() + i, blockIndices[i]);//if reducing along row, length of output row is 1
             }
-            ciftiOut->setRow(&result, *iter);//if reducing along row, length of output row is 1
         }
     } else {
         if (inDims[direction] == 1 && ! ReductionOperation::isLengthOneReasonable(myReduce))
         {
             CaretLogWarning("-cifti-reduce is being used for a length=1 reduction on file '" + ciftiIn->getFileName() + "'");
         }
-        vector<vector<float> > scratchInRows(inDims[direction], vector<float>(inDims[0]));
-        vector<float> outRow(inDims[0]), reduceScratch(inDims[direction]);//reduction isn't along row, so out rows will be same length as in rows
+        const int64_t COL_CHUNK = 1024;
+        vector<float> inBlock(BLOCK_ROWS * inDims[0]), outRow(inDims[0]);//reduction isn't along row, so out rows will be same length as in rows
+        vector<ReductionAccumulator> accumulators(inDims[0], ReductionAccumulator(myReduce, onlyNumeric));
+        for (int64_t i = 0; i < inDims[0]; ++i)
+        {
+            accumulators[i].reserve(inDims[direction]);
+        }
         vector<int64_t> otherDims = inDims;
         otherDims.erase(otherDims.begin() + direction);//direction isn't 0
         otherDims.erase(otherDims.begin());//remove row direction because getRow/setRow
@@ -139,22 +172,39 @@ AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const Cift
         {
             vector<int64_t> indexvec = *iter;
             indexvec.insert(indexvec.begin() + direction - 1, -1);//dummy value in place of reduce direction
-            for (int64_t i = 0; i < inDims[direction]; ++i)
+            for (int64_t i = 0; i < inDims[0]; ++i)
             {
-                indexvec[direction - 1] = i;
-                ciftiIn->getRow(scratchInRows[i].data(), indexvec);
+                accumulators[i].reset();
+            }
+            for (int64_t blockStart = 0; blockStart < inDims[direction]; blockStart += BLOCK_ROWS)
+            {//stream the rows once, each thread updates the accumulators for its own range of columns
+                int64_t blockRows = min(BLOCK_ROWS, inDims[direction] - blockStart);
+                for (int64_t j = 0; j < blockRows; ++j)
+                {
+                    indexvec[direction - 1] = blockStart + j;
+                    ciftiIn->getRow(inBlock.data() + j * inDims[0], indexvec);
+                }
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int64_t colStart = 0; colStart < inDims[0]; colStart += COL_CHUNK)
+                {
+                    int64_t colEnd = min(colStart + COL_CHUNK, inDims[0]);
+                    for (int64_t j = 0; j < blockRows; ++j)
+                    {
+                        const float* inRow = inBlock.data() + j * inDims[0];
+                        for (int64_t i = colStart; i < colEnd; ++i)
+                        {
+                            accumulators[i].addValue(inRow[i]);
+                        }
+                    }
+                }
             }
             for (int64_t i = 0; i < inDims[0]; ++i)
             {
-                for (int64_t j = 0; j < inDims[direction]; ++j)
-                {//need reduction input in contiguous array
-                    reduceScratch[j] = scratchInRows[j][i];
-                }
-                if (onlyNumeric)
+                try
                 {
-                    outRow[i] = ReductionOperation::reduceOnlyNumeric(reduceScratch.data(), inDims[direction], myReduce);
-                } else {
-                    outRow[i] = ReductionOperation::reduce(reduceScratch.data(), inDims[direction], myReduce);
+                    outRow[i] = accumulators[i].getResult();
+                } catch (CaretException& e) {
+                    throw AlgorithmException(e.whatString());
                 }
             }
             indexvec[direction - 1] = 0;//only one element along reduce output direction
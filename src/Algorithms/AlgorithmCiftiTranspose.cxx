@@ -20,7 +20,15 @@
 
 #include "AlgorithmCiftiTranspose.h"
 #include "AlgorithmException.h"
+#include "CaretLogger.h"
 #include "CiftiFile.h"
+#include "ElapsedTimer.h"
+
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <cstring>
 
 using namespace caret;
 using namespace std;
@@ -47,7 +55,9 @@ OperationParameters* AlgorithmCiftiTranspose::getParameters()
     
     ret->setHelpText(
         AString("The input must be a 2-dimensional cifti file.  ") +
-        "The output is a cifti file where every row in the input is a column in the output."
+        "The output is a cifti file where every row in the input is a column in the output.\n\n" +
+        "When -mem-limit is smaller than the matrix and the input is read from disk, the data is transposed in two passes through a temporary file, " +
+        "which requires free space in the temporary directory (set by the TMPDIR environment variable) equal to the size of the matrix in float32."
     );
     return ret;
 }
@@ -82,34 +92,155 @@ AlgorithmCiftiTranspose::AlgorithmCiftiTranspose(ProgressObject* myProgObj, cons
     outXML.setMap(0, *(inXML.getMap(1)));
     outXML.setMap(1, *(inXML.getMap(0)));
     ciftiOut->setCiftiXML(outXML);
-    int rowSize = outXML.getDimensionLength(CiftiXML::ALONG_ROW), colSize = outXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
-    int64_t outRowBytes = rowSize * sizeof(float);
-    int numCacheRows = colSize;
-    if (memLimitGB >= 0.0f)
+    int64_t rowSize = outXML.getDimensionLength(CiftiXML::ALONG_ROW), colSize = outXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    int64_t matrixBytes = rowSize * colSize * (int64_t)sizeof(float);
+    if (memLimitGB < 0.0f)
+    {
+        transposeRereading(ciftiIn, ciftiOut, matrixBytes, &myProgress);
+        return;
+    }
+    int64_t memLimitBytes = (int64_t)(memLimitGB * 1024 * 1024 * 1024);
+    if (memLimitBytes >= matrixBytes || ciftiIn->isInMemory())
+    {//rereading an in-memory input is just a memory copy, don't bother with the temporary file
+        transposeRereading(ciftiIn, ciftiOut, memLimitBytes, &myProgress);
+    } else {
+        transposeExternal(ciftiIn, ciftiOut, memLimitBytes, &myProgress);
+    }
+}
+
+namespace
+{
+    void transposeBlock(const float* in, const int64_t& inRows, const int64_t& inCols, float* out)
+    {//out is inCols by inRows, done in square tiles so that both the reads and the writes stay in cache
+        const int64_t TILE = 64;
+        for (int64_t r0 = 0; r0 < inRows; r0 += TILE)
+        {
+            int64_t rEnd = min(r0 + TILE, inRows);
+            for (int64_t c0 = 0; c0 < inCols; c0 += TILE)
+            {
+                int64_t cEnd = min(c0 + TILE, inCols);
+                for (int64_t r = r0; r < rEnd; ++r)
+                {
+                    const float* inRow = in + r * inCols;
+                    for (int64_t c = c0; c < cEnd; ++c)
+                    {
+                        out[c * inRows + r] = inRow[c];
+                    }
+                }
+            }
+        }
+    }
+    
+    AString throughputTask(const AString& prefix, const int64_t& bytes, const ElapsedTimer& myTimer)
     {
-        numCacheRows = memLimitGB * 1024 * 1024 * 1024 / outRowBytes;
-        if (numCacheRows < 1) numCacheRows = 1;
-        if (numCacheRows > colSize) numCacheRows = colSize;
+        double seconds = myTimer.getElapsedTimeSeconds();
+        if (seconds <= 0.0) return prefix;
+        return prefix + ", " + AString::number(bytes / seconds / (1024 * 1024), 'f', 1) + " MiB/s";
     }
+}
+
+void AlgorithmCiftiTranspose::transposeRereading(const CiftiFile* ciftiIn, CiftiFile* ciftiOut, const int64_t& memLimitBytes, LevelProgress* myProgress)
+{
+    const CiftiXML& outXML = ciftiOut->getCiftiXML();
+    int64_t rowSize = outXML.getDimensionLength(CiftiXML::ALONG_ROW), colSize = outXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    int64_t outRowBytes = rowSize * sizeof(float);
+    int64_t numCacheRows = max((int64_t)1, min(colSize, memLimitBytes / outRowBytes));
     vector<vector<float> > cacheRows(numCacheRows, vector<float>(rowSize));
     vector<float> scratchInRow(colSize);
-    for (int i = 0; i < colSize; i += numCacheRows)//loop through cache chunks
+    ElapsedTimer myTimer;
+    myTimer.start();
+    int64_t bytesRead = 0;
+    for (int64_t i = 0; i < colSize; i += numCacheRows)//loop through cache chunks
     {
-        int end = i + numCacheRows;
+        int64_t end = i + numCacheRows;
         if (end > colSize) end = colSize;
-        for (int j = 0; j < rowSize; ++j)//loop through all input rows
+        for (int64_t j = 0; j < rowSize; ++j)//loop through all input rows
         {
             ciftiIn->getRow(scratchInRow.data(), j);
-            for (int k = i; k < end; ++k)
+            for (int64_t k = i; k < end; ++k)
             {
                 cacheRows[k - i][j] = scratchInRow[k];
             }
         }
-        for (int k = i; k < end; ++k)
+        for (int64_t k = i; k < end; ++k)
         {
             ciftiOut->setRow(cacheRows[k - i].data(), k);
         }
+        bytesRead += rowSize * colSize * (int64_t)sizeof(float);
+        if (myProgress != NULL)
+        {
+            myProgress->setTask(throughputTask("transposing, reading input", bytesRead, myTimer));
+            myProgress->reportProgress(((float)end) / colSize);
+        }
+    }
+    CaretLogFine(throughputTask("transposed by rereading input " + AString::number((colSize + numCacheRows - 1) / numCacheRows) + " times", bytesRead, myTimer));
+}
+
+void AlgorithmCiftiTranspose::transposeExternal(const CiftiFile* ciftiIn, CiftiFile* ciftiOut, const int64_t& memLimitBytes, LevelProgress* myProgress)
+{//pass 1 writes each block of input rows transposed, so that pass 2 can read any range of output rows from a block as one contiguous chunk
+    const CiftiXML& outXML = ciftiOut->getCiftiXML();
+    int64_t rowSize = outXML.getDimensionLength(CiftiXML::ALONG_ROW), colSize = outXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    int64_t halfLimit = memLimitBytes / 2;//each pass uses two buffers
+    int64_t blockRows = max((int64_t)1, min(rowSize, halfLimit / (colSize * (int64_t)sizeof(float))));
+    int64_t groupRows = max((int64_t)1, min(colSize, halfLimit / (rowSize * (int64_t)sizeof(float))));
+    QTemporaryFile tempFile(QDir::tempPath() + "/wb_cifti_transpose_XXXXXX.tmp");
+    if (!tempFile.open()) throw AlgorithmException("failed to create temporary file in '" + QDir::tempPath() + "'");
+    const int64_t matrixBytes = rowSize * colSize * (int64_t)sizeof(float);
+    ElapsedTimer myTimer;
+    myTimer.start();
+    {
+        vector<float> inBlock(blockRows * colSize), transBlock(blockRows * colSize);
+        for (int64_t b0 = 0; b0 < rowSize; b0 += blockRows)
+        {
+            int64_t numRows = min(blockRows, rowSize - b0);
+            for (int64_t r = 0; r < numRows; ++r)
+            {
+                ciftiIn->getRow(inBlock.data() + r * colSize, b0 + r);
+            }
+            transposeBlock(inBlock.data(), numRows, colSize, transBlock.data());
+            int64_t toWrite = numRows * colSize * (int64_t)sizeof(float);
+            if (tempFile.write((const char*)transBlock.data(), toWrite) != toWrite)
+            {
+                throw AlgorithmException("failed to write to temporary file '" + tempFile.fileName() + "', check free space in '" + QDir::tempPath() + "'");
+            }
+            if (myProgress != NULL)
+            {
+                myProgress->setTask(throughputTask("transposing, pass 1 of 2", (b0 + numRows) * colSize * (int64_t)sizeof(float), myTimer));
+                myProgress->reportProgress(0.5f * (b0 + numRows) / rowSize);
+            }
+        }
+        if (!tempFile.flush()) throw AlgorithmException("failed to write to temporary file '" + tempFile.fileName() + "'");
+    }
+    CaretLogFine(throughputTask("transpose pass 1 complete", matrixBytes, myTimer));
+    myTimer.start();
+    vector<float> outGroup(groupRows * rowSize), segment(groupRows * blockRows);
+    for (int64_t k0 = 0; k0 < colSize; k0 += groupRows)
+    {
+        int64_t numOut = min(groupRows, colSize - k0);
+        for (int64_t b0 = 0; b0 < rowSize; b0 += blockRows)
+        {//the output rows k0 to k0 + numOut are contiguous within each transposed block
+            int64_t numRows = min(blockRows, rowSize - b0);
+            int64_t toRead = numOut * numRows * (int64_t)sizeof(float);
+            if (!tempFile.seek((b0 * colSize + k0 * numRows) * (int64_t)sizeof(float)) || tempFile.read((char*)segment.data(), toRead) != toRead)
+            {
+                throw AlgorithmException("failed to read from temporary file '" + tempFile.fileName() + "'");
+            }
+            for (int64_t g = 0; g < numOut; ++g)
+            {
+                memcpy(outGroup.data() + g * rowSize + b0, segment.data() + g * numRows, numRows * sizeof(float));
+            }
+        }
+        for (int64_t g = 0; g < numOut; ++g)
+        {
+            ciftiOut->setRow(outGroup.data() + g * rowSize, k0 + g);
+        }
+        if (myProgress != NULL)
+        {
+            myProgress->setTask(throughputTask("transposing, pass 2 of 2", (k0 + numOut) * rowSize * (int64_t)sizeof(float), myTimer));
+            myProgress->reportProgress(0.5f + 0.5f * (k0 + numOut) / colSize);
+        }
     }
+    CaretLogFine(throughputTask("transpose pass 2 complete", matrixBytes, myTimer));
 }
 
 float AlgorithmCiftiTranspose::getAlgorithmInternalWeight()
@@ -33,6 +33,10 @@ namespace caret {
         static float getAlgorithmInternalWeight();
     public:
         AlgorithmCiftiTranspose(ProgressObject* myProgObj, const CiftiFile* ciftiIn, CiftiFile* ciftiOut, const float& memLimitGB = -1.0f);
+        ///transpose by reading the entire input once per chunk of output rows that fits in memory, best when the input is in memory
+        static void transposeRereading(const CiftiFile* ciftiIn, CiftiFile* ciftiOut, const int64_t& memLimitBytes, LevelProgress* myProgress = NULL);
+        ///transpose through a temporary file, reading the input once and writing the output once, regardless of the memory limit
+        static void transposeExternal(const CiftiFile* ciftiIn, CiftiFile* ciftiOut, const int64_t& memLimitBytes, LevelProgress* myProgress = NULL);
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
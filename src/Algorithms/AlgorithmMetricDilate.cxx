@@ -25,6 +25,7 @@
 #include "CaretOMP.h"
 #include "FastStatistics.h"
 #include "GeodesicHelper.h"
+#include "GeodesicNeighborhoodIndex.h"
 #include "MetricFile.h"
 #include "PaletteColorMapping.h"
 #include "SurfaceFile.h"
@@ -347,10 +348,18 @@ void AlgorithmMetricDilate::processColumn(float* colScratch, const float* myInpu
             }
         }
     }
-    CaretPointer<GeodesicHelperBase> correctedBase;
+    const float* corrAreaData = NULL;
+    if (corrAreas != NULL) corrAreaData = corrAreas->getValuePointerForColumn(0);//NOTE: myAreas also points to this when applicable
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(cutoffBase, corrAreaData);//only reuse neighborhoods computed by something else, computing them for all vertices is wasteful when few are bad
+    CaretPointer<const GeodesicHelperBase> correctedBase;
     if (corrAreas != NULL)
     {
-        correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreas->getValuePointerForColumn(0)));//NOTE: myAreas also points to this when applicable
+        if (myNeighborhoods != NULL)
+        {
+            correctedBase = myNeighborhoods->getGeodesicHelperBase();//already computed, and consistent with the neighborhoods
+        } else {
+            correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreaData));
+        }
     }
 #pragma omp CARET_PAR
     {
@@ -375,7 +384,13 @@ void AlgorithmMetricDilate::processColumn(float* colScratch, const float* myInpu
             if (badNode)
             {
                 float closestDist;//NOTE: the only time this function is called with a badRoi is when using linear, which doesn't use the closest distance
-                int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
+                int closestNode;
+                if (myNeighborhoods != NULL)
+                {
+                    closestNode = myNeighborhoods->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
+                } else {
+                    closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
+                }
                 if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
                 {
                     const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
@@ -403,7 +418,12 @@ void AlgorithmMetricDilate::processColumn(float* colScratch, const float* myInpu
                         vector<float> distList;
                         if (linear)
                         {
-                            myGeoHelp->getNodesToGeoDist(i, distance, nodeList, distList);
+                            if (myNeighborhoods != NULL)
+                            {
+                                myNeighborhoods->getNodesToGeoDist(i, distance, nodeList, distList);
+                            } else {
+                                myGeoHelp->getNodesToGeoDist(i, distance, nodeList, distList);
+                            }
                             int numInRange = (int)nodeList.size();
                             Vector3D center = mySurf->getCoordinate(i);
                             vector<float> blockDists;
@@ -486,7 +506,12 @@ void AlgorithmMetricDilate::processColumn(float* colScratch, const float* myInpu
                                     cutoffDist = max(min(cutoffRatio * closestDist, cutoffDist), minKernel);//but small kernels are rather cheap anyway, so have a minimum size just in case
                                 }
                             }
-                            myGeoHelp->getNodesToGeoDist(i, cutoffDist, nodeList, distList);
+                            if (myNeighborhoods != NULL && cutoffDist <= myNeighborhoods->getMaxDistance())//legacy cutoff scales with the closest distance, so it can exceed the precomputed neighborhoods
+                            {
+                                myNeighborhoods->getNodesToGeoDist(i, cutoffDist, nodeList, distList);
+                            } else {
+                                myGeoHelp->getNodesToGeoDist(i, cutoffDist, nodeList, distList);
+                            }
                             int numInRange = (int)nodeList.size();
                             float totalWeight = 0.0f, weightedSum = 0.0f;
                             for (int j = 0; j < numInRange; ++j)
@@ -545,16 +570,16 @@ void AlgorithmMetricDilate::precomputeStencils(vector<pair<int, StencilElem> >&
     int numNodes = mySurf->getNumberOfNodes();
     vector<char> charRoi(numNodes, 0);
     const float* dataRoiVals = NULL;
-    int badCount = 0;
     if (dataRoi != NULL)
     {
         dataRoiVals = dataRoi->getValuePointerForColumn(0);
     }
+    vector<int> badNodes;
     for (int i = 0; i < numNodes; ++i)
     {
         if (badNodeData[i] > 0.0f)
         {
-            ++badCount;
+            badNodes.push_back(i);
         } else {
             if (dataRoiVals == NULL || dataRoiVals[i] > 0.0f)
             {
@@ -562,12 +587,20 @@ void AlgorithmMetricDilate::precomputeStencils(vector<pair<int, StencilElem> >&
             }
         }
     }
+    int badCount = (int)badNodes.size();
     myStencils.resize(badCount);//initializes all stencils to have empty lists
-    badCount = 0;
-    CaretPointer<GeodesicHelperBase> correctedBase;
+    const float* corrAreaData = NULL;
+    if (corrAreas != NULL) corrAreaData = corrAreas->getValuePointerForColumn(0);//NOTE: myAreas also points to this when applicable
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(cutoffBase, corrAreaData);//only reuse neighborhoods computed by something else, computing them for all vertices is wasteful when few are bad
+    CaretPointer<const GeodesicHelperBase> correctedBase;
     if (corrAreas != NULL)
     {
-        correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreas->getValuePointerForColumn(0)));//NOTE: myAreas also points to this when applicable
+        if (myNeighborhoods != NULL)
+        {
+            correctedBase = myNeighborhoods->getGeodesicHelperBase();//already computed, and consistent with the neighborhoods
+        } else {
+            correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreaData));
+        }
     }
 #pragma omp CARET_PAR
     {
@@ -580,74 +613,77 @@ void AlgorithmMetricDilate::precomputeStencils(vector<pair<int, StencilElem> >&
             myGeoHelp.grabNew(new GeodesicHelper(correctedBase));
         }
 #pragma omp CARET_FOR schedule(dynamic)
-        for (int i = 0; i < numNodes; ++i)
+        for (int myIndex = 0; myIndex < badCount; ++myIndex)//bad vertices were listed in order beforehand, so threads don't need to agree on where to put results
         {
-            if (badNodeData[i] > 0.0f)
+            const int i = badNodes[myIndex];
+            myStencils[myIndex].first = i;
+            StencilElem& myElem = myStencils[myIndex].second;
+            float closestDist;
+            int closestNode;
+            if (myNeighborhoods != NULL)
             {
-                int myIndex;
-#pragma omp critical
-                {
-                    myIndex = badCount;
-                    ++badCount;
-                }
-                myStencils[myIndex].first = i;
-                StencilElem& myElem = myStencils[myIndex].second;
-                float closestDist;
-                int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
-                if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
+                closestNode = myNeighborhoods->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
+            } else {
+                closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
+            }
+            if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
+            {
+                const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                vector<float> distList;
+                myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
+                const int numInRange = (int)nodeList.size();
+                for (int j = 0; j < numInRange; ++j)
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
-                    vector<float> distList;
-                    myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
-                    const int numInRange = (int)nodeList.size();
-                    for (int j = 0; j < numInRange; ++j)
+                    if (charRoi[nodeList[j]] != 0 && (closestNode == -1 || distList[j] < closestDist))
                     {
-                        if (charRoi[nodeList[j]] != 0 && (closestNode == -1 || distList[j] < closestDist))
-                        {
-                            closestNode = nodeList[j];
-                            closestDist = distList[j];
-                        }
+                        closestNode = nodeList[j];
+                        closestDist = distList[j];
                     }
                 }
-                if (closestNode != -1)
+            }
+            if (closestNode != -1)
+            {
+                vector<int32_t> nodeList;
+                vector<float> distList;
+                float cutoffDist = cutoffBase;
+                if (legacyCutoff)
                 {
-                    vector<int32_t> nodeList;
-                    vector<float> distList;
-                    float cutoffDist = cutoffBase;
-                    if (legacyCutoff)
+                    cutoffDist = closestDist * legacyCutoffRatio;
+                } else {
+                    if (exponent > 2.0f && cutoffRatio < 100.0f && cutoffRatio > 1.0f)//if the ratio is sane, use it, but never exceed cutoffBase
                     {
-                        cutoffDist = closestDist * legacyCutoffRatio;
-                    } else {
-                        if (exponent > 2.0f && cutoffRatio < 100.0f && cutoffRatio > 1.0f)//if the ratio is sane, use it, but never exceed cutoffBase
-                        {
-                            cutoffDist = max(min(cutoffRatio * closestDist, cutoffDist), minKernel);//but small kernels are rather cheap anyway, so have a minimum size just in case
-                        }
+                        cutoffDist = max(min(cutoffRatio * closestDist, cutoffDist), minKernel);//but small kernels are rather cheap anyway, so have a minimum size just in case
                     }
+                }
+                if (myNeighborhoods != NULL && cutoffDist <= myNeighborhoods->getMaxDistance())//legacy cutoff scales with the closest distance, so it can exceed the precomputed neighborhoods
+                {
+                    myNeighborhoods->getNodesToGeoDist(i, cutoffDist, nodeList, distList);
+                } else {
                     myGeoHelp->getNodesToGeoDist(i, cutoffDist, nodeList, distList);
-                    int numInRange = (int)nodeList.size();
-                    myElem.m_weightsum = 0.0f;
-                    for (int j = 0; j < numInRange; ++j)
+                }
+                int numInRange = (int)nodeList.size();
+                myElem.m_weightsum = 0.0f;
+                for (int j = 0; j < numInRange; ++j)
+                {
+                    if (charRoi[nodeList[j]] != 0)
                     {
-                        if (charRoi[nodeList[j]] != 0)
+                        float weight;
+                        const float tolerance = 0.9f;//distances should NEVER be less than closestDist, for obvious reasons
+                        float divdist = distList[j] / closestDist;
+                        if (divdist > tolerance)//tricky: if closestDist is zero, this filters between NaN and inf, resulting in a straight average between nodes with 0 distance
                         {
-                            float weight;
-                            const float tolerance = 0.9f;//distances should NEVER be less than closestDist, for obvious reasons
-                            float divdist = distList[j] / closestDist;
-                            if (divdist > tolerance)//tricky: if closestDist is zero, this filters between NaN and inf, resulting in a straight average between nodes with 0 distance
-                            {
-                                weight = myAreas[nodeList[j]] / pow(divdist, exponent);//NOTE: myAreas has already been pointed to the right data with -corrected-areas
-                            } else {
-                                weight = myAreas[nodeList[j]] / pow(tolerance, exponent);
-                            }
-                            myElem.m_weightsum += weight;
-                            myElem.m_weightlist.push_back(pair<int, float>(nodeList[j], weight));
+                            weight = myAreas[nodeList[j]] / pow(divdist, exponent);//NOTE: myAreas has already been pointed to the right data with -corrected-areas
+                        } else {
+                            weight = myAreas[nodeList[j]] / pow(tolerance, exponent);
                         }
-                    }
-                    if (myElem.m_weightsum == 0.0f)//set list to empty instead of making NaNs
-                    {
-                        myElem.m_weightlist.clear();
+                        myElem.m_weightsum += weight;
+                        myElem.m_weightlist.push_back(pair<int, float>(nodeList[j], weight));
                     }
                 }
+                if (myElem.m_weightsum == 0.0f)//set list to empty instead of making NaNs
+                {
+                    myElem.m_weightlist.clear();
+                }
             }
         }
     }
@@ -661,16 +697,16 @@ void AlgorithmMetricDilate::precomputeNearest(vector<pair<int, int> >& myNearest
     int numNodes = mySurf->getNumberOfNodes();
     vector<char> charRoi(numNodes, 0);
     const float* dataRoiVals = NULL;
-    int badCount = 0;
     if (dataRoi != NULL)
     {
         dataRoiVals = dataRoi->getValuePointerForColumn(0);
     }
+    vector<int> badNodes;
     for (int i = 0; i < numNodes; ++i)
     {
         if (badNodeData[i] > 0.0f)
         {
-            ++badCount;
+            badNodes.push_back(i);
         } else {
             if (dataRoiVals == NULL || dataRoiVals[i] > 0.0f)
             {
@@ -678,12 +714,20 @@ void AlgorithmMetricDilate::precomputeNearest(vector<pair<int, int> >& myNearest
             }
         }
     }
+    int badCount = (int)badNodes.size();
     myNearest.resize(badCount);
-    badCount = 0;
-    CaretPointer<GeodesicHelperBase> correctedBase;
+    const float* corrAreaData = NULL;
+    if (corrAreas != NULL) corrAreaData = corrAreas->getValuePointerForColumn(0);//NOTE: myAreas also points to this when applicable
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(distance, corrAreaData);//only reuse neighborhoods computed by something else, computing them for all vertices is wasteful when few are bad
+    CaretPointer<const GeodesicHelperBase> correctedBase;
     if (corrAreas != NULL)
     {
-        correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreas->getValuePointerForColumn(0)));//NOTE: myAreas also points to this when applicable
+        if (myNeighborhoods != NULL)
+        {
+            correctedBase = myNeighborhoods->getGeodesicHelperBase();//already computed, and consistent with the neighborhoods
+        } else {
+            correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreaData));
+        }
     }
 #pragma omp CARET_PAR
     {
@@ -696,36 +740,34 @@ void AlgorithmMetricDilate::precomputeNearest(vector<pair<int, int> >& myNearest
             myGeoHelp.grabNew(new GeodesicHelper(correctedBase));
         }
 #pragma omp CARET_FOR schedule(dynamic)
-        for (int i = 0; i < numNodes; ++i)
+        for (int myIndex = 0; myIndex < badCount; ++myIndex)//bad vertices were listed in order beforehand, so threads don't need to agree on where to put results
         {
-            if (badNodeData[i] > 0.0f)
+            const int i = badNodes[myIndex];
+            myNearest[myIndex].first = i;
+            float closestDist;
+            int closestNode;
+            if (myNeighborhoods != NULL)
             {
-                int myIndex;
-#pragma omp critical
-                {
-                    myIndex = badCount;
-                    ++badCount;
-                }
-                myNearest[myIndex].first = i;
-                float closestDist;
-                int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
-                if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
+                closestNode = myNeighborhoods->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
+            } else {
+                closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
+            }
+            if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
+            {
+                const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                vector<float> distList;
+                myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
+                const int numInRange = (int)nodeList.size();
+                for (int j = 0; j < numInRange; ++j)
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
-                    vector<float> distList;
-                    myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
-                    const int numInRange = (int)nodeList.size();
-                    for (int j = 0; j < numInRange; ++j)
+                    if (charRoi[nodeList[j]] != 0 && (closestNode == -1 || distList[j] < closestDist))
                     {
-                        if (charRoi[nodeList[j]] != 0 && (closestNode == -1 || distList[j] < closestDist))
-                        {
-                            closestNode = nodeList[j];
-                            closestDist = distList[j];
-                        }
+                        closestNode = nodeList[j];
+                        closestDist = distList[j];
                     }
                 }
-                myNearest[myIndex].second = closestNode;
             }
+            myNearest[myIndex].second = closestNode;
         }
     }
 }
@@ -24,6 +24,7 @@
 #include "CaretHeap.h"
 #include "CaretOMP.h"
 #include "GeodesicHelper.h"
+#include "GeodesicNeighborhoodIndex.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
@@ -412,8 +413,10 @@ void AlgorithmMetricExtrema::precomputeNeighborhoods(const SurfaceFile* mySurf,
     neighborhoods.clear();
     neighborhoods.resize(numNodes);
     CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();//can share this, we will only use 1-hop neighbors
-    CaretPointer<GeodesicHelper> myGeoHelp = mySurf->getGeodesicHelper();//must be thread-private
-    vector<float> junk;//also thread-private
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(distance);//only reuse neighborhoods something else cached, we copy them out anyway
+    CaretPointer<GeodesicHelper> myGeoHelp;
+    if (myNeighborhoods == NULL) myGeoHelp = mySurf->getGeodesicHelper();
+    vector<float> junk;
     for (int i = 0; i < numNodes; ++i)
     {
         if (roiColumn == NULL || roiColumn[i] > 0.0f)
@@ -437,7 +440,12 @@ void AlgorithmMetricExtrema::precomputeNeighborhoods(const SurfaceFile* mySurf,
                     continue;
                 }
             }
-            myGeoHelp->getNodesToGeoDist(i, distance, neighborhoods[i], junk);
+            if (myNeighborhoods != NULL)
+            {
+                myNeighborhoods->getNodesToGeoDist(i, distance, neighborhoods[i], junk);
+            } else {
+                myGeoHelp->getNodesToGeoDist(i, distance, neighborhoods[i], junk);
+            }
             int numelems = (int)neighborhoods[i].size();
             if (numelems < 7)
             {
@@ -23,7 +23,9 @@
 
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "GeodesicHelper.h"
+#include "GeodesicNeighborhoodIndex.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
 
@@ -181,18 +183,17 @@ AlgorithmMetricROIsFromExtrema::AlgorithmMetricROIsFromExtrema(ProgressObject* m
     vector<float> excludeDists(numNodes, -1.0f);
     vector<int32_t> excludeSources(numNodes, -1);
     vector<map<int32_t, float> > roiLists(mapsOut);
-    CaretPointer<GeodesicHelper> myHelp = mySurf->getGeodesicHelper();
     int64_t mapCounter = 0;
     if (myColumn == -1)
     {
         for (int i = 0; i < numCols; ++i)
         {
             const float* data = myMetric->getValuePointerForColumn(i);
-            processMap(data, excludeDists, excludeSources, roiLists, mapCounter, myHelp, limit, roiData, overlapType, numNodes);
+            processMap(data, excludeDists, excludeSources, roiLists, mapCounter, mySurf, limit, roiData, overlapType, numNodes);
         }
     } else {
         const float* data = myMetric->getValuePointerForColumn(0);
-        processMap(data, excludeDists, excludeSources, roiLists, mapCounter, myHelp, limit, roiData, overlapType, numNodes);
+        processMap(data, excludeDists, excludeSources, roiLists, mapCounter, mySurf, limit, roiData, overlapType, numNodes);
     }
     CaretAssert(mapCounter == extremaCount);
     myMetricOut->setNumberOfNodesAndColumns(numNodes, mapsOut);
@@ -239,87 +240,110 @@ AlgorithmMetricROIsFromExtrema::AlgorithmMetricROIsFromExtrema(ProgressObject* m
 }
 
 void AlgorithmMetricROIsFromExtrema::processMap(const float* data, vector<float>& excludeDists, vector<int32_t> excludeSources, vector<map<int32_t, float> >& roiLists,
-                                                int64_t& mapCounter, CaretPointer<GeodesicHelper>& myHelp, const float& limit, const float* roiData,
+                                                int64_t& mapCounter, const SurfaceFile* mySurf, const float& limit, const float* roiData,
                                                 const OverlapLogicEnum::Enum& overlapType, const int& numNodes)
 {
+    vector<int32_t> extrema;
     for (int j = 0; j < numNodes; ++j)
     {
         if ((roiData == NULL || roiData[j] > 0.0f) && data[j] != 0.0f)
         {
-            vector<int32_t> nodeList;
-            vector<float> distList;
-            myHelp->getNodesToGeoDist(j, limit, nodeList, distList);
-            int listNum = (int)nodeList.size();
-            switch (overlapType)
+            extrema.push_back(j);
+        }
+    }
+    int numExtrema = (int)extrema.size();
+    vector<vector<int32_t> > nodeLists(numExtrema);//find the neighborhoods in parallel, the overlap logic depends on order, so apply them serially afterwards
+    vector<vector<float> > distLists(numExtrema);
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(limit);//extrema are usually sparse, so don't compute neighborhoods for every vertex
+#pragma omp CARET_PAR
+    {
+        CaretPointer<GeodesicHelper> myHelp;
+        if (myNeighborhoods == NULL) myHelp = mySurf->getGeodesicHelper();
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int i = 0; i < numExtrema; ++i)
+        {
+            if (myNeighborhoods != NULL)
             {
-                case OverlapLogicEnum::ALLOW:
-                    if (roiData == NULL)
+                myNeighborhoods->getNodesToGeoDist(extrema[i], limit, nodeLists[i], distLists[i]);
+            } else {
+                myHelp->getNodesToGeoDist(extrema[i], limit, nodeLists[i], distLists[i]);
+            }
+        }
+    }
+    for (int i = 0; i < numExtrema; ++i)
+    {
+        const vector<int32_t>& nodeList = nodeLists[i];
+        const vector<float>& distList = distLists[i];
+        int listNum = (int)nodeList.size();
+        switch (overlapType)
+        {
+            case OverlapLogicEnum::ALLOW:
+                if (roiData == NULL)
+                {
+                    for (int k = 0; k < listNum; ++k)
+                    {
+                        const int32_t& thisNode = nodeList[k];
+                        roiLists[mapCounter][thisNode] = distList[k];
+                    }
+                } else {
+                    for (int k = 0; k < listNum; ++k)
                     {
-                        for (int k = 0; k < listNum; ++k)
+                        const int32_t& thisNode = nodeList[k];
+                        if (roiData[thisNode] > 0.0f)
                         {
-                            const int32_t& thisNode = nodeList[k];
                             roiLists[mapCounter][thisNode] = distList[k];
                         }
-                    } else {
-                        for (int k = 0; k < listNum; ++k)
-                        {
-                            const int32_t& thisNode = nodeList[k];
-                            if (roiData[thisNode] > 0.0f)
-                            {
-                                roiLists[mapCounter][thisNode] = distList[k];
-                            }
-                        }
                     }
-                    break;
-                case OverlapLogicEnum::CLOSEST:
-                    for (int k = 0; k < listNum; ++k)
+                }
+                break;
+            case OverlapLogicEnum::CLOSEST:
+                for (int k = 0; k < listNum; ++k)
+                {
+                    const int32_t& thisNode = nodeList[k];
+                    if (roiData == NULL || roiData[thisNode] > 0.0f)
                     {
-                        const int32_t& thisNode = nodeList[k];
-                        if (roiData == NULL || roiData[thisNode] > 0.0f)
+                        const float& thisDist = distList[k];
+                        if (excludeDists[thisNode] < 0.0f)
                         {
-                            const float& thisDist = distList[k];
-                            if (excludeDists[thisNode] < 0.0f)
+                            excludeDists[thisNode] = thisDist;
+                            excludeSources[thisNode] = mapCounter;
+                            roiLists[mapCounter][thisNode] = thisDist;
+                        } else {
+                            if (excludeDists[thisNode] > thisDist)
                             {
-                                excludeDists[thisNode] = thisDist;
-                                excludeSources[thisNode] = mapCounter;
-                                roiLists[mapCounter][thisNode] = thisDist;
-                            } else {
-                                if (excludeDists[thisNode] > thisDist)
-                                {
-                                    roiLists[excludeSources[thisNode]].erase(thisNode);
-                                }
-                                excludeDists[thisNode] = thisDist;
-                                excludeSources[thisNode] = mapCounter;
-                                roiLists[mapCounter][thisNode] = thisDist;
+                                roiLists[excludeSources[thisNode]].erase(thisNode);
                             }
+                            excludeDists[thisNode] = thisDist;
+                            excludeSources[thisNode] = mapCounter;
+                            roiLists[mapCounter][thisNode] = thisDist;
                         }
                     }
-                    break;
-                case OverlapLogicEnum::EXCLUDE:
-                    for (int k = 0; k < listNum; ++k)
+                }
+                break;
+            case OverlapLogicEnum::EXCLUDE:
+                for (int k = 0; k < listNum; ++k)
+                {
+                    const int32_t& thisNode = nodeList[k];
+                    if (roiData == NULL || roiData[thisNode] > 0.0f)
                     {
-                        const int32_t& thisNode = nodeList[k];
-                        if (roiData == NULL || roiData[thisNode] > 0.0f)
+                        const float& thisDist = distList[k];
+                        if (excludeDists[thisNode] < 0.0f)
                         {
-                            const float& thisDist = distList[k];
-                            if (excludeDists[thisNode] < 0.0f)
+                            excludeDists[thisNode] = thisDist;
+                            excludeSources[thisNode] = mapCounter;
+                            roiLists[mapCounter][thisNode] = thisDist;
+                        } else {
+                            if (excludeSources[thisNode] != -1)
                             {
-                                excludeDists[thisNode] = thisDist;
-                                excludeSources[thisNode] = mapCounter;
-                                roiLists[mapCounter][thisNode] = thisDist;
-                            } else {
-                                if (excludeSources[thisNode] != -1)
-                                {
-                                    roiLists[excludeSources[thisNode]].erase(thisNode);
-                                    excludeSources[thisNode] = -1;
-                                }
+                                roiLists[excludeSources[thisNode]].erase(thisNode);
+                                excludeSources[thisNode] = -1;
                             }
                         }
                     }
-                    break;
-            }
-            ++mapCounter;
+                }
+                break;
         }
+        ++mapCounter;
     }
 }
 
@@ -30,13 +30,11 @@
 
 namespace caret {
     
-    class GeodesicHelper;
-    
     class AlgorithmMetricROIsFromExtrema : public AbstractAlgorithm
     {
         AlgorithmMetricROIsFromExtrema();
         void processMap(const float* data, std::vector<float>& excludeDists, std::vector<int32_t> excludeSouces, std::vector<std::map<int32_t, float> >& roiLists,
-                        int64_t& mapCounter, CaretPointer<GeodesicHelper>& myHelp, const float& limit, const float* roiData, const OverlapLogicEnum::Enum& overlapType, const int& numNodes);
+                        int64_t& mapCounter, const SurfaceFile* mySurf, const float& limit, const float* roiData, const OverlapLogicEnum::Enum& overlapType, const int& numNodes);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
@@ -21,9 +21,12 @@
 #include "AlgorithmMetricReduce.h"
 #include "AlgorithmException.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "MetricFile.h"
+#include "ReductionAccumulator.h"
 #include "ReductionOperation.h"
 
+#include <algorithm>
 #include <vector>
 
 using namespace caret;
@@ -93,20 +96,42 @@ AlgorithmMetricReduce::AlgorithmMetricReduce(ProgressObject* myProgObj, const Me
     metricOut->setNumberOfNodesAndColumns(numNodes, 1);
     metricOut->setStructure(metricIn->getStructure());
     metricOut->setColumnName(0, ReductionEnum::toName(myReduce));
-    vector<float> scratch(numCols);
-    for (int node = 0; node < numNodes; ++node)
+    const int CHUNK = 1024;
+    vector<float> outCol(numNodes);
+    AString errorMessage;//can't throw out of an omp region
+#pragma omp CARET_PAR
     {
-        for (int col = 0; col < numCols; ++col)
-        {
-            scratch[col] = metricIn->getValue(node, col);
-        }
-        if (onlyNumeric)
-        {
-            metricOut->setValue(node, 0, ReductionOperation::reduceOnlyNumeric(scratch.data(), numCols, myReduce));
-        } else {
-            metricOut->setValue(node, 0, ReductionOperation::reduce(scratch.data(), numCols, myReduce));
+        vector<ReductionAccumulator> accumulators(CHUNK, ReductionAccumulator(myReduce, onlyNumeric));//per thread, reset() keeps the allocations
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int chunkStart = 0; chunkStart < numNodes; chunkStart += CHUNK)
+        {//read each column contiguously instead of gathering each vertex's values
+            int chunkEnd = min(chunkStart + CHUNK, numNodes);
+            for (int node = chunkStart; node < chunkEnd; ++node)
+            {
+                accumulators[node - chunkStart].reset();
+            }
+            for (int col = 0; col < numCols; ++col)
+            {
+                const float* colData = metricIn->getValuePointerForColumn(col);
+                for (int node = chunkStart; node < chunkEnd; ++node)
+                {
+                    accumulators[node - chunkStart].addValue(colData[node]);
+                }
+            }
+            for (int node = chunkStart; node < chunkEnd; ++node)
+            {
+                try
+                {
+                    outCol[node] = accumulators[node - chunkStart].getResult();
+                } catch (CaretException& e) {
+#pragma omp critical
+                    errorMessage = e.whatString();
+                }
+            }
         }
     }
+    if (errorMessage != "") throw AlgorithmException(errorMessage);
+    metricOut->setValuesForColumn(0, outCol.data());
 }
 
 AlgorithmMetricReduce::AlgorithmMetricReduce(ProgressObject* myProgObj, const MetricFile* metricIn, const ReductionEnum::Enum& myReduce, MetricFile* metricOut, const float& sigmaBelow, const float& sigmaAbove) : AbstractAlgorithm(myProgObj)
@@ -27,6 +27,8 @@
 #include "SurfaceFile.h"
 #include "SurfaceResamplingHelper.h"
 
+#include <algorithm>
+
 using namespace caret;
 using namespace std;
 
@@ -203,13 +205,45 @@ AlgorithmMetricResample::AlgorithmMetricResample(ProgressObject* myProgObj, cons
     {
         metricOut->setColumnName(i, metricIn->getColumnName(i));
         *metricOut->getPaletteColorMapping(i) = *metricIn->getPaletteColorMapping(i);
-        if (largest)
+    }
+    if (largest || numColumns == 1)
+    {
+        for (int i = 0; i < numColumns; ++i)
+        {
+            if (largest)
+            {
+                myHelp.resampleLargest(metricIn->getValuePointerForColumn(i), colScratch.data());
+            } else {
+                myHelp.resampleNormal(metricIn->getValuePointerForColumn(i), colScratch.data());
+            }
+            metricOut->setValuesForColumn(i, colScratch.data());
+        }
+    } else {//apply the weights to blocks of columns, rather than walking the weights once per column
+        const int BLOCK_COLUMNS = 64;
+        int numOldNodes = curSphere->getNumberOfNodes();
+        int blockSize = min(BLOCK_COLUMNS, numColumns);
+        vector<float> inTile((int64_t)numOldNodes * blockSize), outTile((int64_t)numNewNodes * blockSize);
+        for (int blockStart = 0; blockStart < numColumns; blockStart += BLOCK_COLUMNS)
         {
-            myHelp.resampleLargest(metricIn->getValuePointerForColumn(i), colScratch.data());
-        } else {
-            myHelp.resampleNormal(metricIn->getValuePointerForColumn(i), colScratch.data());
+            int blockCols = min(BLOCK_COLUMNS, numColumns - blockStart);
+            for (int j = 0; j < blockCols; ++j)
+            {
+                const float* inCol = metricIn->getValuePointerForColumn(blockStart + j);
+                for (int n = 0; n < numOldNodes; ++n)
+                {
+                    inTile[(int64_t)n * blockCols + j] = inCol[n];
+                }
+            }
+            myHelp.resampleNormalInterleaved(inTile.data(), outTile.data(), blockCols);
+            for (int j = 0; j < blockCols; ++j)
+            {
+                for (int n = 0; n < numNewNodes; ++n)
+                {
+                    colScratch[n] = outTile[(int64_t)n * blockCols + j];
+                }
+                metricOut->setValuesForColumn(blockStart + j, colScratch.data());
+            }
         }
-        metricOut->setValuesForColumn(i, colScratch.data());
     }
 }
 
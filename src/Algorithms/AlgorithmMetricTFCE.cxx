@@ -27,6 +27,7 @@
 #include "CaretOMP.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
+#include "TfcePermutationHelper.h"
 #include "TopologyHelper.h"
 
 #include <cmath>
@@ -73,6 +74,15 @@ OperationParameters* AlgorithmMetricTFCE::getParameters()
     OptionalParameter* corrAreaOpt = ret->createOptionalParameter(8, "-corrected-areas", "vertex areas to use instead of computing them from the surface");
     corrAreaOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
     
+    OptionalParameter* nullOpt = ret->createOptionalParameter(9, "-sign-flip-null", "build a max-statistic null distribution by sign flipping");
+    nullOpt->addStringParameter(1, "null-out", "output text file, one line per permutation");
+    OptionalParameter* numPermOpt = nullOpt->createOptionalParameter(2, "-permutations", "number of random sign flips (default 5000)");
+    numPermOpt->addIntegerParameter(1, "number", "the number of permutations, including the unpermuted data");
+    OptionalParameter* seedOpt = nullOpt->createOptionalParameter(3, "-seed", "seed for the random sign flips (default 0)");
+    seedOpt->addIntegerParameter(1, "seed", "the seed value");
+    OptionalParameter* designOpt = nullOpt->createOptionalParameter(4, "-design", "use specified sign flips instead of random ones");
+    designOpt->addStringParameter(1, "sign-file", "text file, one permutation per line, with 1 or -1 for each input column");
+    
     ret->setHelpText(
         AString("This command does not do any statistical analysis.  Please use something like PALM if you are just trying to do statistics on your data.\n\n") +
         "Threshold-free cluster enhancement is a method to increase the relative value of regions that would form clusters in a standard thresholding test.  " +
@@ -82,6 +92,11 @@ OperationParameters* AlgorithmMetricTFCE::getParameters()
         "Negative values are similarly enhanced by negating the data, running the same process, and negating the result.\n\n" +
         "When using -presmooth with -corrected-areas, note that it is an approximate correction within the smoothing algorithm (the TFCE correction is exact).  " +
         "Doing smoothing on individual surfaces before averaging/TFCE is preferred, when possible, in order to better tie the smoothing kernel size to the original feature size.\n\n" +
+        "-sign-flip-null treats each input column as a subject, and computes the one-sample t-statistic of the columns for each permutation of signs, " +
+        "writing only the maximum and minimum TFCE values of each permutation to <null-out>, for use as a family-wise null distribution.  " +
+        "The first random permutation is the unpermuted data.  " +
+        "The output metric is then the TFCE of the unpermuted t-statistic.  " +
+        "Presmoothing is applied to the input columns.\n\n" +
         "The TFCE method is explained in: Smith SM, Nichols TE., \"Threshold-free cluster enhancement: addressing problems of smoothing, threshold dependence and localisation in cluster inference.\" Neuroimage. 2009 Jan 1;44(1):83-98. PMID: 18501637"
     );
     return ret;
@@ -132,6 +147,40 @@ void AlgorithmMetricTFCE::useParameters(OperationParameters* myParams, ProgressO
     {
         corrAreaMetric = corrAreaOpt->getMetric(1);
     }
+    OptionalParameter* nullOpt = myParams->getOptionalParameter(9);
+    if (nullOpt->m_present)
+    {
+        if (columnSelect->m_present) throw AlgorithmException("-column and -sign-flip-null may not be used together");
+        vector<vector<float> > signFlips;
+        OptionalParameter* designOpt = nullOpt->getOptionalParameter(4);
+        if (designOpt->m_present)
+        {
+            if (nullOpt->getOptionalParameter(2)->m_present || nullOpt->getOptionalParameter(3)->m_present)
+            {
+                throw AlgorithmException("-design may not be used with -permutations or -seed");
+            }
+            TfcePermutationHelper::readSignFlips(designOpt->getString(1), myMetric->getNumberOfColumns(), signFlips);
+        } else {
+            int numPerms = 5000;
+            OptionalParameter* numPermOpt = nullOpt->getOptionalParameter(2);
+            if (numPermOpt->m_present)
+            {
+                numPerms = (int)numPermOpt->getInteger(1);
+                if (numPerms < 1) throw AlgorithmException("number of permutations must be positive");
+            }
+            uint32_t seed = 0;
+            OptionalParameter* seedOpt = nullOpt->getOptionalParameter(3);
+            if (seedOpt->m_present)
+            {
+                seed = (uint32_t)seedOpt->getInteger(1);
+            }
+            TfcePermutationHelper::randomSignFlips(numPerms, myMetric->getNumberOfColumns(), seed, signFlips);
+        }
+        vector<float> nullMax, nullMin;
+        AlgorithmMetricTFCE(myProgObj, mySurf, myMetric, myMetricOut, signFlips, nullMax, nullMin, presmooth, myRoi, param_e, param_h, corrAreaMetric);
+        TfcePermutationHelper::writeNullDistribution(nullOpt->getString(1), nullMax, nullMin);
+        return;
+    }
     AlgorithmMetricTFCE(myProgObj, mySurf, myMetric, myMetricOut, presmooth, myRoi, param_e, param_h, columnNum, corrAreaMetric);
 }
 
@@ -195,6 +244,75 @@ AlgorithmMetricTFCE::AlgorithmMetricTFCE(ProgressObject* myProgObj, const Surfac
     }
 }
 
+AlgorithmMetricTFCE::AlgorithmMetricTFCE(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric, MetricFile* myMetricOut, const vector<vector<float> >& signFlips,
+                                         vector<float>& nullMaxOut, vector<float>& nullMinOut, const float& presmooth, const MetricFile* myRoi,
+                                         const float& param_e, const float& param_h, const MetricFile* corrAreaMetric) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    int numNodes = mySurf->getNumberOfNodes();
+    int numCols = myMetric->getNumberOfColumns();
+    if (numNodes != myMetric->getNumberOfNodes()) throw AlgorithmException("metric and surface have different number of vertices");
+    if (myRoi != NULL && numNodes != myRoi->getNumberOfNodes()) throw AlgorithmException("roi metric and surface have different number of vertices");
+    if (corrAreaMetric != NULL && numNodes != corrAreaMetric->getNumberOfNodes()) throw AlgorithmException("corrected area metric and surface have different number of vertices");
+    if (numCols < 2) throw AlgorithmException("sign flipping requires at least 2 input columns");
+    int numPerms = (int)signFlips.size();
+    if (numPerms < 1) throw AlgorithmException("no permutations specified");
+    for (int p = 0; p < numPerms; ++p)
+    {
+        if ((int)signFlips[p].size() != numCols) throw AlgorithmException("sign flip permutation " + AString::number(p + 1) + " does not match the number of input columns");
+    }
+    const float* roiData = NULL, *areaData = NULL;
+    vector<float> surfAreaData;
+    if (corrAreaMetric == NULL)
+    {
+        mySurf->computeNodeAreas(surfAreaData);
+        areaData = surfAreaData.data();
+    } else {
+        areaData = corrAreaMetric->getValuePointerForColumn(0);
+    }
+    if (myRoi != NULL) roiData = myRoi->getValuePointerForColumn(0);
+    const MetricFile* toUse = myMetric;
+    MetricFile postSmooth;
+    if (presmooth > 0.0f)
+    {//smoothing is linear, so smoothing the inputs once is the same as smoothing each permuted sum
+        AlgorithmMetricSmoothing(NULL, mySurf, myMetric, presmooth, &postSmooth, myRoi, false, false, -1, corrAreaMetric);
+        toUse = &postSmooth;
+    }
+    vector<const float*> inputs(numCols);
+    for (int col = 0; col < numCols; ++col)
+    {
+        inputs[col] = toUse->getValuePointerForColumn(col);
+    }
+    CaretPointer<TopologyHelper> myHelper = mySurf->getTopologyHelper();
+    vector<int64_t> neighborStart(numNodes + 1, 0), neighbors;//flatten the topology once for all permutations
+    for (int node = 0; node < numNodes; ++node)
+    {
+        const vector<int32_t>& nodeNeighbors = myHelper->getNodeNeighbors(node);
+        neighbors.insert(neighbors.end(), nodeNeighbors.begin(), nodeNeighbors.end());
+        neighborStart[node + 1] = (int64_t)neighbors.size();
+    }
+    nullMaxOut.resize(numPerms);
+    nullMinOut.resize(numPerms);
+#pragma omp CARET_PAR
+    {
+        TfcePermutationHelper myTfce(neighborStart, neighbors, areaData, param_e, param_h);
+        vector<float> tstat(numNodes);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int p = 0; p < numPerms; ++p)
+        {
+            TfcePermutationHelper::signFlipTStatistic(inputs, signFlips[p].data(), numNodes, tstat.data());
+            myTfce.computeExtremes(tstat.data(), roiData, nullMaxOut[p], nullMinOut[p]);
+        }
+    }
+    vector<float> tstat(numNodes), outcol(numNodes), noFlip(numCols, 1.0f);
+    TfcePermutationHelper::signFlipTStatistic(inputs, noFlip.data(), numNodes, tstat.data());
+    processColumn(mySurf, tstat.data(), outcol.data(), roiData, param_e, param_h, areaData);
+    myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
+    myMetricOut->setStructure(mySurf->getStructure());
+    myMetricOut->setValuesForColumn(0, outcol.data());
+    myMetricOut->setMapName(0, "TFCE of t-statistic");
+}
+
 void AlgorithmMetricTFCE::processColumn(const SurfaceFile* mySurf, const float* colData, float* outData, const float* roiData, const float& param_e, const float& param_h, const float* areaData)
 {
     int numNodes = mySurf->getNumberOfNodes();
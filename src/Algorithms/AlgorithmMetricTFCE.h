@@ -23,6 +23,8 @@
 
 #include "AbstractAlgorithm.h"
 
+#include <vector>
+
 namespace caret {
     
     class TopologyHelper;
@@ -38,6 +40,10 @@ namespace caret {
     public:
         AlgorithmMetricTFCE(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric, MetricFile* myMetricOut, const float& presmooth = 0.0f,
                             const MetricFile* myRoi = NULL, const float& param_e = 1.0f, const float& param_h = 2.0f, const int& columnNum = -1, const MetricFile* corrAreaMetric = NULL);
+        ///sign flip permutation mode: one-sample t-statistic over the input columns, output is TFCE of the unpermuted statistic, and the extreme TFCE values of each permutation
+        AlgorithmMetricTFCE(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric, MetricFile* myMetricOut, const std::vector<std::vector<float> >& signFlips,
+                            std::vector<float>& nullMaxOut, std::vector<float>& nullMinOut, const float& presmooth = 0.0f, const MetricFile* myRoi = NULL,
+                            const float& param_e = 1.0f, const float& param_h = 2.0f, const MetricFile* corrAreaMetric = NULL);
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
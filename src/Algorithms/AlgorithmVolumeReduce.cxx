@@ -21,10 +21,13 @@
 #include "AlgorithmVolumeReduce.h"
 #include "AlgorithmException.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "GiftiLabelTable.h"
+#include "ReductionAccumulator.h"
 #include "ReductionOperation.h"
 #include "VolumeFile.h"
 
+#include <algorithm>
 #include <vector>
 
 using namespace caret;
@@ -97,24 +100,44 @@ AlgorithmVolumeReduce::AlgorithmVolumeReduce(ProgressObject* myProgObj, const Vo
         CaretLogWarning("reduction operation performed on label volume");
         *(volumeOut->getMapLabelTable(0)) = *(volumeIn->getMapLabelTable(0));
     }
+    const int64_t CHUNK = 4096;
     int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
-    vector<float> scratchArray(myDims[3]), outFrame(frameSize);
+    vector<float> outFrame(frameSize);
+    AString errorMessage;//can't throw out of an omp region
     for (int c = 0; c < myDims[4]; ++c)
     {
-        for (int64_t i = 0; i < frameSize; ++i)
+#pragma omp CARET_PAR
         {
-            for (int b = 0; b < myDims[3]; ++b)
-            {
-                const float* tempFrame = volumeIn->getFrame(b, c);
-                scratchArray[b] = tempFrame[i];
-            }
-            if (onlyNumeric)
-            {
-                outFrame[i] = ReductionOperation::reduceOnlyNumeric(scratchArray.data(), myDims[3], myReduce);
-            } else {
-                outFrame[i] = ReductionOperation::reduce(scratchArray.data(), myDims[3], myReduce);
+            vector<ReductionAccumulator> accumulators(CHUNK, ReductionAccumulator(myReduce, onlyNumeric));//per thread, reset() keeps the allocations
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int64_t chunkStart = 0; chunkStart < frameSize; chunkStart += CHUNK)
+            {//stream through the frames contiguously instead of gathering each voxel's timeseries
+                int64_t chunkEnd = min(chunkStart + CHUNK, frameSize);
+                for (int64_t i = chunkStart; i < chunkEnd; ++i)
+                {
+                    accumulators[i - chunkStart].reset();
+                }
+                for (int b = 0; b < myDims[3]; ++b)
+                {
+                    const float* tempFrame = volumeIn->getFrame(b, c);
+                    for (int64_t i = chunkStart; i < chunkEnd; ++i)
+                    {
+                        accumulators[i - chunkStart].addValue(tempFrame[i]);
+                    }
+                }
+                for (int64_t i = chunkStart; i < chunkEnd; ++i)
+                {
+                    try
+                    {
+                        outFrame[i] = accumulators[i - chunkStart].getResult();
+                    } catch (CaretException& e) {
+#pragma omp critical
+                        errorMessage = e.whatString();
+                    }
+                }
             }
         }
+        if (errorMessage != "") throw AlgorithmException(errorMessage);
         volumeOut->setFrame(outFrame.data(), 0, c);
     }
 }
@@ -26,7 +26,9 @@
 #include "CaretOMP.h"
 #include "CaretAssert.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 using namespace caret;
 using namespace std;
@@ -66,7 +68,9 @@ OperationParameters* AlgorithmVolumeSmoothing::getParameters()
     ret->setHelpText(
         AString("Gaussian smoothing for volumes.  By default, smooths all subvolumes with no ROI, if ROI is given, only ") +
         "positive voxels in the ROI volume have their values used, and all other voxels are set to zero.  Smoothing a non-orthogonal volume will " +
-        "be significantly slower, because the operation cannot be separated into 1-dimensional smoothings without distorting the kernel shape.\n\n" +
+        "be significantly slower, because the operation cannot be separated into 1-dimensional smoothings without distorting the kernel shape.  " +
+        "For orthogonal volumes, when the kernel sigma is at least 3 voxels along every axis, a recursive approximation of the gaussian is used, " +
+        "so the time taken does not increase with kernel size.  This kernel is not truncated, so results differ very slightly from the 3 sigma kernel used otherwise.\n\n" +
         "The -fix-zeros option causes the smoothing to not use an input value if it is zero, but still write a smoothed value to the voxel.  " +
         "This is useful for zeros that indicate lack of information, preventing them from pulling down the intensity of nearby voxels, while " +
         "giving the zero an extrapolated value."
@@ -104,7 +108,8 @@ void AlgorithmVolumeSmoothing::useParameters(OperationParameters* myParams, Prog
     AlgorithmVolumeSmoothing(myProgObj, myVol, myKernel, myOutVol, roiVol, fixZeros, subvolNum);
 }
 
-AlgorithmVolumeSmoothing::AlgorithmVolumeSmoothing(ProgressObject* myProgObj, const VolumeFile* inVol, const float& kernel, VolumeFile* outVol, const VolumeFile* roiVol, const bool& fixZeros, const int& subvol) : AbstractAlgorithm(myProgObj)
+AlgorithmVolumeSmoothing::AlgorithmVolumeSmoothing(ProgressObject* myProgObj, const VolumeFile* inVol, const float& kernel, VolumeFile* outVol, const VolumeFile* roiVol, const bool& fixZeros, const int& subvol,
+                                                   const float& recursiveMinimumSigma) : AbstractAlgorithm(myProgObj)
 {
     CaretAssert(inVol != NULL);
     CaretAssert(outVol != NULL);
@@ -148,6 +153,10 @@ AlgorithmVolumeSmoothing::AlgorithmVolumeSmoothing(ProgressObject* myProgObj, co
         int isize = irange * 2 + 1;//and construct a precomputed kernel in the box
         int jsize = jrange * 2 + 1;
         int ksize = krange * 2 + 1;
+        float sigmaVoxels[3] = { kernel / ispace, kernel / jspace, kernel / kspace };
+        bool useRecursive = (sigmaVoxels[0] >= recursiveMinimumSigma && sigmaVoxels[1] >= recursiveMinimumSigma && sigmaVoxels[2] >= recursiveMinimumSigma);
+        const float* roiFrame = NULL;
+        if (roiVol != NULL) roiFrame = roiVol->getFrame();
         CaretArray<float> iweights(isize), jweights(jsize), kweights(ksize);
         for (int i = 0; i < isize; ++i)
         {
@@ -175,8 +184,10 @@ AlgorithmVolumeSmoothing::AlgorithmVolumeSmoothing(ProgressObject* myProgObj, co
                 for (int c = 0; c < myDims[4]; ++c)
                 {
                     const float* inFrame = inVol->getFrame(s, c);
-                    if (roiVol == NULL)
-                    {
+                    if (useRecursive)
+                    {//cost doesn't depend on kernel size
+                        smoothFrameRecursive(inFrame, myDims, scratchFrame, scratchFrame2, scratchWeights, roiFrame, sigmaVoxels, fixZeros);
+                    } else if (roiVol == NULL) {
                         smoothFrame(inFrame, myDims, scratchFrame, scratchFrame2, scratchWeights, scratchWeights2, inVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros);
                     } else {
                         smoothFrameROI(inFrame, myDims, scratchFrame, scratchFrame2, scratchFrame3, scratchWeights, scratchWeights2, lists, inVol, roiVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros);
@@ -196,8 +207,10 @@ AlgorithmVolumeSmoothing::AlgorithmVolumeSmoothing(ProgressObject* myProgObj, co
             for (int c = 0; c < myDims[4]; ++c)
             {
                 const float* inFrame = inVol->getFrame(subvol, c);
-                if (roiVol == NULL)
-                {
+                if (useRecursive)
+                {//cost doesn't depend on kernel size
+                    smoothFrameRecursive(inFrame, myDims, scratchFrame, scratchFrame2, scratchWeights, roiFrame, sigmaVoxels, fixZeros);
+                } else if (roiVol == NULL) {
                     smoothFrame(inFrame, myDims, scratchFrame, scratchFrame2, scratchWeights, scratchWeights2, inVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros);
                 } else {
                     smoothFrameROI(inFrame, myDims, scratchFrame, scratchFrame2, scratchFrame3, scratchWeights, scratchWeights2, lists, inVol, roiVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros);
@@ -586,6 +599,128 @@ void AlgorithmVolumeSmoothing::smoothFrameROI(const float* inFrame, vector<int64
     }
 }
 
+namespace
+{
+    struct DericheCoefficients
+    {//4th order recursive approximation of a gaussian, from Deriche, "Recursively implementing the Gaussian and its derivatives", INRIA RR-1893, 1993
+        double n[4], m[5], d[5];
+        DericheCoefficients(const double& sigma)
+        {
+            const double a0 = 1.680, a1 = 3.735, w0 = 0.6318, b0 = 1.783;
+            const double a2 = -0.6803, a3 = -0.2598, w1 = 1.997, b1 = 1.723;
+            double cw0 = cos(w0 / sigma), sw0 = sin(w0 / sigma), cw1 = cos(w1 / sigma), sw1 = sin(w1 / sigma);
+            double e0 = exp(-b0 / sigma), e1 = exp(-b1 / sigma);
+            n[0] = a0 + a2;
+            n[1] = e1 * (a3 * sw1 - (a2 + 2.0 * a0) * cw1) + e0 * (a1 * sw0 - (2.0 * a2 + a0) * cw0);
+            n[2] = 2.0 * e0 * e1 * ((a0 + a2) * cw1 * cw0 - a1 * cw1 * sw0 - a3 * cw0 * sw1) + a2 * e0 * e0 + a0 * e1 * e1;
+            n[3] = e1 * e0 * e0 * (a3 * sw1 - a2 * cw1) + e0 * e1 * e1 * (a1 * sw0 - a0 * cw0);
+            d[0] = 1.0;
+            d[1] = -2.0 * e1 * cw1 - 2.0 * e0 * cw0;
+            d[2] = 4.0 * cw1 * cw0 * e0 * e1 + e1 * e1 + e0 * e0;
+            d[3] = -2.0 * cw0 * e0 * e1 * e1 - 2.0 * cw1 * e1 * e0 * e0;
+            d[4] = e0 * e0 * e1 * e1;
+            m[0] = 0.0;//anticausal part doesn't include the center sample
+            for (int i = 1; i < 4; ++i)
+            {
+                m[i] = n[i] - d[i] * n[0];
+            }
+            m[4] = -d[4] * n[0];
+            double numSum = 0.0, denSum = 0.0;//normalize to unit gain, so tiny weight sums far from data can be recognized
+            for (int i = 0; i < 4; ++i) numSum += n[i] + m[i + 1];
+            for (int i = 0; i < 5; ++i) denSum += d[i];
+            double scale = denSum / numSum;
+            for (int i = 0; i < 4; ++i) n[i] *= scale;
+            for (int i = 0; i < 5; ++i) m[i] *= scale;
+        }
+        
+        //filter a strided line in place, scratch must have room for the line - zero boundary conditions are exact in both directions, so no padding is needed
+        void filterLine(float* data, const int64_t& length, const int64_t& stride, double* scratch) const
+        {
+            double x1 = 0.0, x2 = 0.0, x3 = 0.0, y1 = 0.0, y2 = 0.0, y3 = 0.0, y4 = 0.0;
+            for (int64_t i = 0; i < length; ++i)
+            {
+                double x0 = data[i * stride];
+                double y0 = n[0] * x0 + n[1] * x1 + n[2] * x2 + n[3] * x3 - d[1] * y1 - d[2] * y2 - d[3] * y3 - d[4] * y4;
+                scratch[i] = y0;
+                x3 = x2; x2 = x1; x1 = x0;
+                y4 = y3; y3 = y2; y2 = y1; y1 = y0;
+            }
+            double x4 = 0.0;
+            x1 = 0.0; x2 = 0.0; x3 = 0.0; y1 = 0.0; y2 = 0.0; y3 = 0.0; y4 = 0.0;
+            for (int64_t i = length - 1; i >= 0; --i)
+            {
+                double y0 = m[1] * x1 + m[2] * x2 + m[3] * x3 + m[4] * x4 - d[1] * y1 - d[2] * y2 - d[3] * y3 - d[4] * y4;
+                double x0 = data[i * stride];
+                data[i * stride] = scratch[i] + y0;
+                x4 = x3; x3 = x2; x2 = x1; x1 = x0;
+                y4 = y3; y3 = y2; y2 = y1; y1 = y0;
+            }
+        }
+    };
+}
+
+void AlgorithmVolumeSmoothing::smoothFrameRecursive(const float* inFrame, const vector<int64_t>& myDims, CaretArray<float>& scratchFrame, CaretArray<float>& scratchData,
+                                                    CaretArray<float>& scratchWeights, const float* roiFrame, const float sigmaVoxels[3], const bool& fixZeros)
+{//normalized convolution like smoothFrame, but each axis is an IIR filter over the data times the mask, and the mask
+    const float WEIGHT_EPSILON = 1e-6f;//the direct kernel ends at 3 sigma, treat negligible weight sums like the zero sums it would have
+    const int64_t frameSize = myDims[0] * myDims[1] * myDims[2], sliceSize = myDims[0] * myDims[1];
+    const DericheCoefficients coefs[3] = { DericheCoefficients(sigmaVoxels[0]), DericheCoefficients(sigmaVoxels[1]), DericheCoefficients(sigmaVoxels[2]) };
+    for (int64_t i = 0; i < frameSize; ++i)
+    {
+        if ((roiFrame == NULL || roiFrame[i] > 0.0f) && (!fixZeros || inFrame[i] != 0.0f))
+        {
+            scratchData[i] = inFrame[i];
+            scratchWeights[i] = 1.0f;
+        } else {
+            scratchData[i] = 0.0f;
+            scratchWeights[i] = 0.0f;
+        }
+    }
+#pragma omp CARET_PAR
+    {
+        vector<double> lineScratch(max(myDims[0], max(myDims[1], myDims[2])));
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int k = 0; k < myDims[2]; ++k)//i axis
+        {
+            for (int j = 0; j < myDims[1]; ++j)
+            {
+                int64_t baseInd = k * sliceSize + j * myDims[0];
+                coefs[0].filterLine(scratchData + baseInd, myDims[0], 1, lineScratch.data());
+                coefs[0].filterLine(scratchWeights + baseInd, myDims[0], 1, lineScratch.data());
+            }
+        }
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int k = 0; k < myDims[2]; ++k)//j axis
+        {
+            for (int i = 0; i < myDims[0]; ++i)
+            {
+                int64_t baseInd = k * sliceSize + i;
+                coefs[1].filterLine(scratchData + baseInd, myDims[1], myDims[0], lineScratch.data());
+                coefs[1].filterLine(scratchWeights + baseInd, myDims[1], myDims[0], lineScratch.data());
+            }
+        }
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int j = 0; j < myDims[1]; ++j)//k axis
+        {
+            for (int i = 0; i < myDims[0]; ++i)
+            {
+                int64_t baseInd = j * myDims[0] + i;
+                coefs[2].filterLine(scratchData + baseInd, myDims[2], sliceSize, lineScratch.data());
+                coefs[2].filterLine(scratchWeights + baseInd, myDims[2], sliceSize, lineScratch.data());
+            }
+        }
+    }
+    for (int64_t i = 0; i < frameSize; ++i)
+    {
+        if ((roiFrame == NULL || roiFrame[i] > 0.0f) && scratchWeights[i] > WEIGHT_EPSILON)
+        {
+            scratchFrame[i] = scratchData[i] / scratchWeights[i];
+        } else {
+            scratchFrame[i] = 0.0f;
+        }
+    }
+}
+
 void AlgorithmVolumeSmoothing::smoothFrameNonOrth(const float* inFrame, const vector<int64_t>& myDims, CaretArray<float>& scratchFrame, const VolumeFile* inVol, const VolumeFile* roiVol, const CaretArray<float**>& weights, const int& irange, const int& jrange, const int& krange, const bool& fixZeros)
 {
     const float* roiFrame = NULL;
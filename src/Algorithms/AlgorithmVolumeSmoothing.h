@@ -39,10 +39,14 @@ namespace caret {
                                               CaretArray<float> scratchWeights, CaretArray<float> scratchWeights2, std::vector<int> lists[3],
                                               const VolumeFile* inVol, const VolumeFile* roiVol, CaretArray<float> iweights, CaretArray<float> jweights, CaretArray<float> kweights,
                                               int irange, int jrange, int krange, const bool& fixZeros);
+        void smoothFrameRecursive(const float* inFrame, const std::vector<int64_t>& myDims, CaretArray<float>& scratchFrame, CaretArray<float>& scratchData,
+                                  CaretArray<float>& scratchWeights, const float* roiFrame, const float sigmaVoxels[3], const bool& fixZeros);
         void smoothFrameNonOrth(const float* inFrame, const std::vector<int64_t>& myDims, CaretArray<float>& scratchFrame, const VolumeFile* inVol, const VolumeFile* roiVol, const CaretArray<float**>& weights, const int& irange, const int& jrange, const int& krange, const bool& fixZeros);
     public:
+        ///recursiveMinimumSigma is the smallest kernel sigma, in voxels along every axis, that uses the recursive gaussian instead of the direct kernel
+        ///below about 3 voxels sigma, the truncated kernel has few enough taps that direct convolution is as fast
         AlgorithmVolumeSmoothing(ProgressObject* myProgObj, const VolumeFile* inVol, const float& kernel, VolumeFile* outVol,
-                                 const VolumeFile* roiVol = NULL, const bool& fixZeros = false, const int& subvol = -1);
+                                 const VolumeFile* roiVol = NULL, const bool& fixZeros = false, const int& subvol = -1, const float& recursiveMinimumSigma = 3.0f);
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
@@ -25,6 +25,7 @@
 #include "CaretAssert.h"
 #include "CaretHeap.h"
 #include "CaretOMP.h"
+#include "TfcePermutationHelper.h"
 #include "VolumeFile.h"
 #include "VoxelIJK.h"
 
@@ -67,6 +68,15 @@ OperationParameters* AlgorithmVolumeTFCE::getParameters()
     OptionalParameter* subvolSelect = ret->createOptionalParameter(6, "-subvolume", "select a single subvolume");
     subvolSelect->addStringParameter(1, "subvolume", "the subvolume number or name");
     
+    OptionalParameter* nullOpt = ret->createOptionalParameter(7, "-sign-flip-null", "build a max-statistic null distribution by sign flipping");
+    nullOpt->addStringParameter(1, "null-out", "output text file, one line per permutation");
+    OptionalParameter* numPermOpt = nullOpt->createOptionalParameter(2, "-permutations", "number of random sign flips (default 5000)");
+    numPermOpt->addIntegerParameter(1, "number", "the number of permutations, including the unpermuted data");
+    OptionalParameter* seedOpt = nullOpt->createOptionalParameter(3, "-seed", "seed for the random sign flips (default 0)");
+    seedOpt->addIntegerParameter(1, "seed", "the seed value");
+    OptionalParameter* designOpt = nullOpt->createOptionalParameter(4, "-design", "use specified sign flips instead of random ones");
+    designOpt->addStringParameter(1, "sign-file", "text file, one permutation per line, with 1 or -1 for each input subvolume");
+    
     ret->setHelpText(
         AString("This command does not do any statistical analysis.  Please use something like PALM if you are just trying to do statistics on your data.\n\n") +
         "Threshold-free cluster enhancement is a method to increase the relative value of regions that would form clusters in a standard thresholding test.  " +
@@ -74,6 +84,11 @@ OperationParameters* AlgorithmVolumeTFCE::getParameters()
         "e(h, p)^E * h^H * dh\n\n" +
         "at each voxel p, where h ranges from 0 to the maximum value in the data, and e(h, p) is the extent of the cluster containing voxel p at threshold h.  " +
         "Negative values are similarly enhanced by negating the data, running the same process, and negating the result.\n\n" +
+        "-sign-flip-null treats each input subvolume as a subject, and computes the one-sample t-statistic of the subvolumes for each permutation of signs, " +
+        "writing only the maximum and minimum TFCE values of each permutation to <null-out>, for use as a family-wise null distribution.  " +
+        "The first random permutation is the unpermuted data.  " +
+        "The output volume is then the TFCE of the unpermuted t-statistic.  " +
+        "Presmoothing is applied to the input subvolumes.\n\n" +
         "This method is explained in: Smith SM, Nichols TE., \"Threshold-free cluster enhancement: addressing problems of smoothing, threshold dependence and localisation in cluster inference.\" Neuroimage. 2009 Jan 1;44(1):83-98. PMID: 18501637"
     );
     return ret;
@@ -117,6 +132,40 @@ void AlgorithmVolumeTFCE::useParameters(OperationParameters* myParams, ProgressO
             throw AlgorithmException("invalid subvolume specified");
         }
     }
+    OptionalParameter* nullOpt = myParams->getOptionalParameter(7);
+    if (nullOpt->m_present)
+    {
+        if (subvolSelect->m_present) throw AlgorithmException("-subvolume and -sign-flip-null may not be used together");
+        vector<vector<float> > signFlips;
+        OptionalParameter* designOpt = nullOpt->getOptionalParameter(4);
+        if (designOpt->m_present)
+        {
+            if (nullOpt->getOptionalParameter(2)->m_present || nullOpt->getOptionalParameter(3)->m_present)
+            {
+                throw AlgorithmException("-design may not be used with -permutations or -seed");
+            }
+            TfcePermutationHelper::readSignFlips(designOpt->getString(1), myVol->getNumberOfMaps(), signFlips);
+        } else {
+            int numPerms = 5000;
+            OptionalParameter* numPermOpt = nullOpt->getOptionalParameter(2);
+            if (numPermOpt->m_present)
+            {
+                numPerms = (int)numPermOpt->getInteger(1);
+                if (numPerms < 1) throw AlgorithmException("number of permutations must be positive");
+            }
+            uint32_t seed = 0;
+            OptionalParameter* seedOpt = nullOpt->getOptionalParameter(3);
+            if (seedOpt->m_present)
+            {
+                seed = (uint32_t)seedOpt->getInteger(1);
+            }
+            TfcePermutationHelper::randomSignFlips(numPerms, myVol->getNumberOfMaps(), seed, signFlips);
+        }
+        vector<float> nullMax, nullMin;
+        AlgorithmVolumeTFCE(myProgObj, myVol, myVolOut, signFlips, nullMax, nullMin, presmooth, myRoi, param_e, param_h);
+        TfcePermutationHelper::writeNullDistribution(nullOpt->getString(1), nullMax, nullMin);
+        return;
+    }
     AlgorithmVolumeTFCE(myProgObj, myVol, myVolOut, presmooth, myRoi, param_e, param_h, subvolNum);
 }
 
@@ -174,6 +223,95 @@ AlgorithmVolumeTFCE::AlgorithmVolumeTFCE(ProgressObject* myProgObj, const Volume
     }
 }
 
+AlgorithmVolumeTFCE::AlgorithmVolumeTFCE(ProgressObject* myProgObj, const VolumeFile* myVol, VolumeFile* myVolOut, const vector<vector<float> >& signFlips,
+                                         vector<float>& nullMaxOut, vector<float>& nullMinOut, const float& presmooth, const VolumeFile* myRoi,
+                                         const float& param_e, const float& param_h) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    if (myRoi != NULL && !myVol->getVolumeSpace().matches(myRoi->getVolumeSpace())) throw AlgorithmException("roi volume has different volume space than input");
+    vector<int64_t> dims = myVol->getDimensions();
+    if (dims[4] != 1) throw AlgorithmException("sign flipping is not supported on multi-component volumes");
+    int numSubvols = (int)dims[3];
+    if (numSubvols < 2) throw AlgorithmException("sign flipping requires at least 2 input subvolumes");
+    int numPerms = (int)signFlips.size();
+    if (numPerms < 1) throw AlgorithmException("no permutations specified");
+    for (int p = 0; p < numPerms; ++p)
+    {
+        if ((int)signFlips[p].size() != numSubvols) throw AlgorithmException("sign flip permutation " + AString::number(p + 1) + " does not match the number of input subvolumes");
+    }
+    const float* roiFrame = NULL;
+    if (myRoi != NULL) roiFrame = myRoi->getFrame();
+    const VolumeFile* toUse = myVol;
+    VolumeFile smoothed;
+    if (presmooth > 0.0f)
+    {//smoothing is linear, so smoothing the inputs once is the same as smoothing each permuted sum
+        AlgorithmVolumeSmoothing(NULL, myVol, presmooth, &smoothed, myRoi);
+        toUse = &smoothed;
+    }
+    vector<const float*> inputs(numSubvols);
+    for (int b = 0; b < numSubvols; ++b)
+    {
+        inputs[b] = toUse->getFrame(b);
+    }
+    Vector3D ivec, jvec, kvec, origin;
+    myVol->getVolumeSpace().getSpacingVectors(ivec, jvec, kvec, origin);
+    const int64_t frameSize = dims[0] * dims[1] * dims[2];
+    vector<float> voxelVolumes(frameSize, abs(ivec.dot(jvec.cross(kvec))));
+    const int STENCIL_SIZE = 18;//same face neighbors as tfce()
+    int64_t stencil[STENCIL_SIZE] = { 0, 0, -1,
+                                      0, -1, 0,
+                                      -1, 0, 0,
+                                      1, 0, 0,
+                                      0, 1, 0,
+                                      0, 0, 1 };
+    vector<int64_t> neighborStart(frameSize + 1, 0), neighbors;//flatten the voxel neighbors once for all permutations, only within the roi
+    for (int64_t k = 0; k < dims[2]; ++k)
+    {
+        for (int64_t j = 0; j < dims[1]; ++j)
+        {
+            for (int64_t i = 0; i < dims[0]; ++i)
+            {
+                int64_t index = myVol->getIndex(i, j, k);//loop order matches index order, so neighborStart is filled sequentially
+                if (roiFrame == NULL || roiFrame[index] > 0.0f)
+                {
+                    for (int s = 0; s < STENCIL_SIZE; s += 3)
+                    {
+                        if (myVol->indexValid(i + stencil[s], j + stencil[s + 1], k + stencil[s + 2]))
+                        {
+                            int64_t neighIndex = myVol->getIndex(i + stencil[s], j + stencil[s + 1], k + stencil[s + 2]);
+                            if (roiFrame == NULL || roiFrame[neighIndex] > 0.0f) neighbors.push_back(neighIndex);
+                        }
+                    }
+                }
+                neighborStart[index + 1] = (int64_t)neighbors.size();
+            }
+        }
+    }
+    nullMaxOut.resize(numPerms);
+    nullMinOut.resize(numPerms);
+#pragma omp CARET_PAR
+    {
+        TfcePermutationHelper myTfce(neighborStart, neighbors, voxelVolumes.data(), param_e, param_h);
+        vector<float> tstat(frameSize);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int p = 0; p < numPerms; ++p)
+        {
+            TfcePermutationHelper::signFlipTStatistic(inputs, signFlips[p].data(), frameSize, tstat.data());
+            myTfce.computeExtremes(tstat.data(), roiFrame, nullMaxOut[p], nullMinOut[p]);
+        }
+    }
+    vector<int64_t> outDims = dims;
+    outDims.resize(3);
+    VolumeFile tstatVol(outDims, myVol->getSform());
+    vector<float> tstat(frameSize), noFlip(numSubvols, 1.0f), outFrame(frameSize);
+    TfcePermutationHelper::signFlipTStatistic(inputs, noFlip.data(), frameSize, tstat.data());
+    tstatVol.setFrame(tstat.data());
+    processFrame(&tstatVol, 0, 0, outFrame.data(), roiFrame, param_e, param_h);
+    myVolOut->reinitialize(outDims, myVol->getSform(), 1, SubvolumeAttributes::FUNCTIONAL, myVol->m_header);
+    myVolOut->setFrame(outFrame.data());
+    myVolOut->setMapName(0, "TFCE of t-statistic");
+}
+
 void AlgorithmVolumeTFCE::processFrame(const VolumeFile* inVol, const int64_t& b, const int64_t& c, float* outData, const float* roiData, const float& param_e, const float& param_h)
 {
     vector<int64_t> dims = inVol->getDimensions();
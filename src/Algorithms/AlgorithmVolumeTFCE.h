@@ -23,6 +23,8 @@
 
 #include "AbstractAlgorithm.h"
 
+#include <vector>
+
 namespace caret {
     
     class AlgorithmVolumeTFCE : public AbstractAlgorithm
@@ -36,6 +38,10 @@ namespace caret {
     public:
         AlgorithmVolumeTFCE(ProgressObject* myProgObj, const VolumeFile* myVol, VolumeFile* myVolOut, const float& presmooth = 0.0f, const VolumeFile* myRoi = NULL,
                             const float& param_e = 0.5f, const float& param_h = 2.0f, const int64_t& subvolNum = -1);
+        ///sign flip permutation mode: one-sample t-statistic over the input subvolumes, output is TFCE of the unpermuted statistic, and the extreme TFCE values of each permutation
+        AlgorithmVolumeTFCE(ProgressObject* myProgObj, const VolumeFile* myVol, VolumeFile* myVolOut, const std::vector<std::vector<float> >& signFlips,
+                            std::vector<float>& nullMaxOut, std::vector<float>& nullMinOut, const float& presmooth = 0.0f, const VolumeFile* myRoi = NULL,
+                            const float& param_e = 0.5f, const float& param_h = 2.0f);
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
@@ -26,6 +26,7 @@
 #include "FloatMatrix.h"
 #include "MathFunctions.h"
 #include "MetricFile.h"
+#include "RibbonWeightMatrix.h"
 #include "SignedDistanceHelper.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
@@ -86,6 +87,8 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
     ribbonWeights->addVolumeOutputParameter(2, "weights-out", "volume to write the weights to");
     OptionalParameter* ribbonWeightsText = ribbonOpt->createOptionalParameter(6, "-output-weights-text", "write the voxel weights for all vertices to a text file");
     ribbonWeightsText->addStringParameter(1, "text-out", "output - the output text filename");//fake the output formatting
+    OptionalParameter* ribbonWeightsMatrix = ribbonOpt->createOptionalParameter(11, "-output-weights-matrix", "write the voxel weights for all vertices to a binary file");
+    ribbonWeightsMatrix->addStringParameter(1, "matrix-out", "output - the output weights filename");//fake the output formatting
     
     OptionalParameter* myelinStyleOpt = ret->createOptionalParameter(9, "-myelin-style", "use the method from myelin mapping");
     myelinStyleOpt->addVolumeParameter(1, "ribbon-roi", "an roi volume of the cortical ribbon for this hemisphere");
@@ -111,7 +114,9 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
         "The -gaussian option makes it act more like the myelin method, where the distance of a voxel from <surface> is used to downweight the voxel.  " +
         "The -interpolate suboption, instead of doing a weighted average of voxels, interpolates from the volume at the subdivided points inside the ribbon.  " +
         "If using both -interpolate and the -weighted suboption to -volume-roi, the roi volume weights are linearly interpolated, " +
-        "unless the -interpolate method is ENCLOSING_VOXEL, in which case ENCLOSING_VOXEL is also used for sampling the roi volume weights." +
+        "unless the -interpolate method is ENCLOSING_VOXEL, in which case ENCLOSING_VOXEL is also used for sampling the roi volume weights.  " +
+        "The -output-weights-matrix suboption saves the weights of all vertices, including the effects of -volume-roi and -gaussian, so that other volumes in the same " +
+        "volume space can be mapped with -volume-to-surface-apply-weights without recomputing them." +
         "\n\n" +
         "The myelin style method uses part of the caret5 myelin mapping command to do the mapping: for each surface vertex, take all voxels that are in a cylinder " +
         "with radius and height equal to cortical thickness, centered on the vertex and aligned with the surface normal, and that are also within the ribbon ROI, " +
@@ -262,9 +267,16 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
                 weightsOut = ribbonWeights->getOutputVolume(2);
             }
             OptionalParameter* ribbonWeightsText = ribbonOpt->getOptionalParameter(6);
+            OptionalParameter* ribbonWeightsMatrix = ribbonOpt->getOptionalParameter(11);
+            vector<vector<VoxelWeight> > myWeights;
+            vector<vector<VoxelWeight> >* allWeightsOut = NULL;
+            if (ribbonWeightsText->m_present || ribbonWeightsMatrix->m_present)
+            {
+                allWeightsOut = &myWeights;
+            }
             if (ribbonInterp)
             {
-                if (ribbonWeightsText->m_present || weightsOut != NULL)
+                if (ribbonWeightsText->m_present || ribbonWeightsMatrix->m_present || weightsOut != NULL)
                 {
                     throw AlgorithmException("-output-weights options are incompatible with -interpolate");
                 }
@@ -272,28 +284,31 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
                                                 mySubVol, gaussScale, badVertices);
             } else {
                 AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, innerSurf, outerSurf, myRoiVol, weightedRoi, subdivisions, thinColumns,
-                                                mySubVol, gaussScale, badVertices, weightsOutVertex, weightsOut);
+                                                mySubVol, gaussScale, badVertices, weightsOutVertex, weightsOut, allWeightsOut);
             }
-            if (ribbonWeightsText->m_present)
-            {//do this after the algorithm, to let it do the error condition checking
-                ofstream outFile(ribbonWeightsText->getString(1).toLocal8Bit().constData());
-                if (!outFile) throw AlgorithmException("failed to open output textfile '" + ribbonWeightsText->getString(1) + "'");
-                vector<vector<VoxelWeight> > myWeights;
-                const float* roiFrame = NULL;
-                if (myRoiVol != NULL) roiFrame = myRoiVol->getFrame();
-                AlgorithmVolumeToSurfaceMapping::precomputeWeightsRibbon(myWeights, myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, weightedRoi, subdivisions, thinColumns, mySurface, gaussScale);
-                for (int i = 0; i < (int)myWeights.size(); ++i)
+            if (allWeightsOut != NULL)
+            {//the algorithm hands back the weights it mapped with, so they don't need to be computed again
+                if (ribbonWeightsText->m_present)
                 {
-                    outFile << i << ", " << myWeights[i].size();
-                    for (int j = 0; j < (int)myWeights[i].size(); ++j)
+                    ofstream outFile(ribbonWeightsText->getString(1).toLocal8Bit().constData());
+                    if (!outFile) throw AlgorithmException("failed to open output textfile '" + ribbonWeightsText->getString(1) + "'");
+                    for (int i = 0; i < (int)myWeights.size(); ++i)
                     {
-                        for (int v = 0; v < 3; ++v)
+                        outFile << i << ", " << myWeights[i].size();
+                        for (int j = 0; j < (int)myWeights[i].size(); ++j)
                         {
-                            outFile << ", " << myWeights[i][j].ijk[v];
+                            for (int v = 0; v < 3; ++v)
+                            {
+                                outFile << ", " << myWeights[i][j].ijk[v];
+                            }
+                            outFile << ", " << myWeights[i][j].weight;
                         }
-                        outFile << ", " << myWeights[i][j].weight;
+                        outFile << endl;
                     }
-                    outFile << endl;
+                }
+                if (ribbonWeightsMatrix->m_present)
+                {
+                    RibbonWeightMatrix(myWeights, myVolume->getVolumeSpace(), mySurface->getStructure()).writeFile(ribbonWeightsMatrix->getString(1));
                 }
             }
             break;
@@ -410,7 +425,7 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
 AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
                                                                  const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const VolumeFile* roiVol, const bool roiWeights,
                                                                  const int32_t& subdivisions, const bool& thinColumns, const int64_t& mySubVol, const float& gaussScale, MetricFile* badVertices,
-                                                                 const int& weightsOutVertex, VolumeFile* weightsOut) : AbstractAlgorithm(myProgObj)
+                                                                 const int& weightsOutVertex, VolumeFile* weightsOut, vector<vector<VoxelWeight> >* allWeightsOut) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     vector<int64_t> myVolDims;
@@ -465,6 +480,19 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
             weightsOut->setValue(vertexWeights[i].weight, vertexWeights[i].ijk);
         }
     }
+    RibbonWeightMatrix myMatrix(myWeights, myVolume->getVolumeSpace());//same weights as a sparse matrix, so each frame is one matrix-vector product
+    if (allWeightsOut != NULL)
+    {
+        allWeightsOut->swap(myWeights);
+    }
+    myWeights.clear();
+    if (badVertices != NULL)
+    {
+        for (int64_t node = 0; node < numNodes; ++node)
+        {
+            if (!myMatrix.hasWeights(node)) badVertScratch[node] = 1.0f;
+        }
+    }
     CaretArray<float> myScratchArray(numNodes);
     float* myScratch = myScratchArray.getArray();
     if (mySubVol == -1)
@@ -481,29 +509,7 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
                 }
                 metricLabel += " ribbon constrained";
                 myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-                for (int64_t node = 0; node < numNodes; ++node)
-                {
-                    myScratch[node] = 0.0f;
-                    float totalWeight = 0.0f;
-                    int numVoxels = (int)myWeights[node].size();
-                    for (int voxel = 0; voxel < numVoxels; ++voxel)
-                    {
-                        float thisWeight = myWeights[node][voxel].weight;
-                        totalWeight += thisWeight;
-                        myScratch[node] += thisWeight * myVolume->getValue(myWeights[node][voxel].ijk, i, j);
-                    }
-                    if (totalWeight != 0.0f)
-                    {
-                        myScratch[node] /= totalWeight;
-                    } else {
-                        myScratch[node] = 0.0f;
-                        if (thisCol == 0 && badVertices != NULL)
-                        {
-                            badVertScratch[node] = 1.0f;
-                        }
-                    }
-                }
+                myMatrix.apply(myVolume->getFrame(i, j), myScratch);
                 myMetricOut->setValuesForColumn(thisCol, myScratch);
             }
         }
@@ -518,29 +524,7 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
             metricLabel += " ribbon constrained";
             int64_t thisCol = j;
             myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t node = 0; node < numNodes; ++node)
-            {
-                    myScratch[node] = 0.0f;
-                    float totalWeight = 0.0f;
-                    int numVoxels = (int)myWeights[node].size();
-                    for (int voxel = 0; voxel < numVoxels; ++voxel)
-                    {
-                        float thisWeight = myWeights[node][voxel].weight;
-                        totalWeight += thisWeight;
-                        myScratch[node] += thisWeight * myVolume->getValue(myWeights[node][voxel].ijk, mySubVol, j);
-                    }
-                    if (totalWeight != 0.0f)
-                    {
-                        myScratch[node] /= totalWeight;
-                    } else {
-                        myScratch[node] = 0.0f;
-                        if (badVertices != NULL)
-                        {
-                            badVertScratch[node] = 1.0f;
-                        }
-                    }
-            }
+            myMatrix.apply(myVolume->getFrame(mySubVol, j), myScratch);
             myMetricOut->setValuesForColumn(thisCol, myScratch);
         }
     }
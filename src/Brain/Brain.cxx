@@ -62,6 +62,7 @@
 #include "CiftiParcelScalarFile.h"
 #include "CiftiScalarDataSeriesFile.h"
 #include "CziImageFile.h"
+#include "DataFileReadPrefetcher.h"
 #include "DisplayPropertiesAnnotation.h"
 #include "DisplayPropertiesAnnotationTextSubstitution.h"
 #include "DisplayPropertiesBorders.h"
@@ -6398,6 +6399,123 @@ Brain::readDataFile(const DataFileTypeEnum::Enum dataFileType,
     return caretDataFileRead;
 }
 
+/**
+ * Read a data file while loading a spec file or scene.  If the file was
+ * read on a worker thread by the prefetcher, it is added to the brain,
+ * otherwise it is read here.  The load time is recorded for
+ * getDataFileLoadTimesReport().
+ *
+ * @param prefetcher
+ *    Prefetcher that may have read the file.
+ * @param dataFileType
+ *    Type of data file to read.
+ * @param structure
+ *    Struture of file (used if not invalid)
+ * @param dataFileNameIn
+ *    Name of data file to read.
+ * @throws DataFileException
+ *    If there is an error reading the file.
+ * @return
+ *    Pointer to file that was read, if no errors.
+ */
+CaretDataFile*
+Brain::readDataFileUsingPrefetcher(DataFileReadPrefetcher& prefetcher,
+                                   const DataFileTypeEnum::Enum dataFileType,
+                                   const StructureEnum::Enum structure,
+                                   const AString& dataFileNameIn)
+{
+    const AString dataFileName = convertFilePathNameToAbsolutePathName(dataFileNameIn);
+    
+    ElapsedTimer timer;
+    timer.start();
+    
+    DataFileLoadTime loadTime;
+    loadTime.m_filename = dataFileName;
+    loadTime.m_dataFileType = dataFileType;
+    loadTime.m_readSeconds = 0.0f;
+    loadTime.m_addSeconds = 0.0f;
+    loadTime.m_readInParallelFlag = false;
+    
+    CaretDataFile* caretDataFileRead = prefetcher.takeFile(dataFileName,
+                                                           loadTime.m_readSeconds);
+    if (caretDataFileRead != NULL) {
+        loadTime.m_readInParallelFlag = true;
+        
+        /*
+         * Time waiting for the worker thread is part of reading
+         */
+        timer.reset();
+        timer.start();
+        try {
+            /*
+             * Validation against surfaces must wait until the preceding
+             * files have been added to the brain
+             */
+            const CiftiMappableDataFile* ciftiMapFile = dynamic_cast<const CiftiMappableDataFile*>(caretDataFileRead);
+            if (ciftiMapFile != NULL) {
+                validateCiftiMappableDataFile(ciftiMapFile);
+            }
+            
+            caretDataFileRead = addReadOrReloadDataFile(FILE_MODE_ADD,
+                                                        caretDataFileRead,
+                                                        dataFileType,
+                                                        structure,
+                                                        dataFileName,
+                                                        false);
+        }
+        catch (const DataFileException&) {
+            delete caretDataFileRead;
+            throw;
+        }
+        loadTime.m_addSeconds = timer.getElapsedTimeSeconds();
+    }
+    else {
+        caretDataFileRead = readDataFile(dataFileType,
+                                         structure,
+                                         dataFileName,
+                                         false);
+        loadTime.m_readSeconds = timer.getElapsedTimeSeconds();
+    }
+    
+    m_dataFileLoadTimes.push_back(loadTime);
+    
+    return caretDataFileRead;
+}
+
+/**
+ * @return Text listing the time to load each data file during the most
+ * recent spec file or scene load, followed by the total time.
+ */
+AString
+Brain::getDataFileLoadTimesReport() const
+{
+    AString report("Read (s)   Add (s)  Parallel  Type                      File\n");
+    float totalReadSeconds = 0.0f;
+    float totalAddSeconds  = 0.0f;
+    for (const auto& loadTime : m_dataFileLoadTimes) {
+        report += (AString::number(loadTime.m_readSeconds, 'f', 3).rightJustified(8)
+                   + "  "
+                   + AString::number(loadTime.m_addSeconds, 'f', 3).rightJustified(8)
+                   + "  "
+                   + AString(loadTime.m_readInParallelFlag ? "yes" : "no").leftJustified(8)
+                   + "  "
+                   + DataFileTypeEnum::toName(loadTime.m_dataFileType).leftJustified(24)
+                   + "  "
+                   + loadTime.m_filename
+                   + "\n");
+        totalReadSeconds += loadTime.m_readSeconds;
+        totalAddSeconds  += loadTime.m_addSeconds;
+    }
+    report += ("Files: "
+               + AString::number(m_dataFileLoadTimes.size())
+               + ", sum of read times: "
+               + AString::number(totalReadSeconds, 'f', 3)
+               + " seconds, sum of add times: "
+               + AString::number(totalAddSeconds, 'f', 3)
+               + " seconds\n");
+    return report;
+}
+
 /**
  * Processing performed after adding or removing a data file.
  */
@@ -6477,6 +6595,27 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
                                        "Starting to read selected files");
     EventManager::get()->sendEvent(progressUpdate.getPointer());
 
+    m_dataFileLoadTimes.clear();
+    
+    /*
+     * Start reading the files that do not depend upon the Brain on worker
+     * threads.  Files are still added to the Brain below, in order, on
+     * this thread.
+     */
+    DataFileReadPrefetcher prefetcher;
+    const int32_t numPrefetchFileGroups = sf->getNumberOfDataFileTypeGroups();
+    for (int32_t ig = 0; ig < numPrefetchFileGroups; ig++) {
+        const SpecFileDataFileTypeGroup* group = sf->getDataFileTypeGroupByIndex(ig);
+        const int32_t numFiles = group->getNumberOfFiles();
+        for (int32_t iFile = 0; iFile < numFiles; iFile++) {
+            const SpecFileDataFile* dataFileInfo = group->getFileInformation(iFile);
+            if (dataFileInfo->isLoadingSelected()) {
+                prefetcher.addFile(group->getDataFileType(),
+                                   convertFilePathNameToAbsolutePathName(dataFileInfo->getFileName()));
+            }
+        }
+    }
+    
     /*
      * Note: Need to read palette first since some of the individual file
      * reading routines update palette coloring when file is read
@@ -6517,10 +6656,10 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
                 }
                 
                 try {
-                    readDataFile(dataFileType,
-                                 structure,
-                                 filename,
-                                 false);
+                    readDataFileUsingPrefetcher(prefetcher,
+                                                dataFileType,
+                                                structure,
+                                                filename);
                 }
                 catch (const DataFileException& e) {
                     if (errorMessage.isEmpty() == false) {
@@ -6594,6 +6733,7 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
                  + "\" was "
                  + AString::number(timer.getElapsedTimeSeconds())
                  + " seconds.");
+    CaretLogFine(getDataFileLoadTimesReport());
     
     m_isSpecFileBeingRead = false;
     
@@ -6751,6 +6891,33 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
     m_nonModifiedFilesForRestoringScene.clear();
     
     
+    /*
+     * Start reading new files that do not depend upon the Brain on
+     * worker threads.  Files are still added to the Brain below, in
+     * order, on this thread.
+     */
+    m_dataFileLoadTimes.clear();
+    DataFileReadPrefetcher prefetcher;
+    const int32_t numPrefetchFileGroups = specFileToLoad->getNumberOfDataFileTypeGroups();
+    for (int32_t ig = 0; ig < numPrefetchFileGroups; ig++) {
+        const SpecFileDataFileTypeGroup* group = specFileToLoad->getDataFileTypeGroupByIndex(ig);
+        const int32_t numFiles = group->getNumberOfFiles();
+        for (int32_t iFile = 0; iFile < numFiles; iFile++) {
+            const SpecFileDataFile* fileInfo = group->getFileInformation(iFile);
+            if (fileInfo->isLoadingSelected()
+                && (specFilesEntryToNonModifiedFile.find(fileInfo) == specFilesEntryToNonModifiedFile.end())) {
+                /*
+                 * Files relative to a scene file on the network are read
+                 * from the network and are not prefetched
+                 */
+                if ( ! sceneFileOnNetwork) {
+                    prefetcher.addFile(group->getDataFileType(),
+                                       convertFilePathNameToAbsolutePathName(fileInfo->getFileName()));
+                }
+            }
+        }
+    }
+    
     /*
      * Load new files and add existing files that were previously loaded.
      */
@@ -6818,10 +6985,10 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
                                 }
                             }
                         }
-                        readDataFile(dataFileType,
-                                     structure,
-                                     filename,
-                                     false);
+                        readDataFileUsingPrefetcher(prefetcher,
+                                                    dataFileType,
+                                                    structure,
+                                                    filename);
                     }
                 }
                 catch (const DataFileException& e) {
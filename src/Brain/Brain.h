@@ -74,6 +74,7 @@ namespace caret {
     class CiftiParcelScalarFile;
     class CiftiScalarDataSeriesFile;
     class CziImageFile;
+    class DataFileReadPrefetcher;
     class DisplayProperties;
     class DisplayPropertiesAnnotation;
     class DisplayPropertiesAnnotationTextSubstitution;
@@ -521,7 +522,26 @@ namespace caret {
         
         SamplesMetaDataManager* getSamplesMetaDataManager() const;
         
+        AString getDataFileLoadTimesReport() const;
+        
     private:
+        /**
+         * Time to load a file during the most recent spec file or scene load
+         */
+        struct DataFileLoadTime {
+            AString m_filename;
+            
+            DataFileTypeEnum::Enum m_dataFileType;
+            
+            /** Time reading the file, on a worker thread if read in parallel */
+            float m_readSeconds;
+            
+            /** Time adding the file to the Brain, on the main thread */
+            float m_addSeconds;
+            
+            bool m_readInParallelFlag;
+        };
+        
         /**
          * Reset the brain scene file mode
          */
@@ -583,6 +603,11 @@ namespace caret {
                           const AString& dataFileName,
                           const bool markDataFileAsModified);
         
+        CaretDataFile* readDataFileUsingPrefetcher(DataFileReadPrefetcher& prefetcher,
+                                                   const DataFileTypeEnum::Enum dataFileType,
+                                                   const StructureEnum::Enum structure,
+                                                   const AString& dataFileName);
+        
         void sortDataFilesByFileNameNoPath();
         
         void createModelChartTwo();
@@ -996,6 +1021,9 @@ namespace caret {
         /** true when a spec file is being read */
         bool m_isSpecFileBeingRead;
         
+        /** load times for files read by the most recent spec file or scene load */
+        std::vector<DataFileLoadTime> m_dataFileLoadTimes;
+        
         SceneClassAssistant* m_sceneAssistant;
         
         /** Selection manager */
@@ -71,6 +71,7 @@
 #include "CaretLogger.h"
 #include "CaretMappableDataFile.h"
 #include "CaretPreferences.h"
+#include "CaretTriangleBVH.h"
 #include "ChartableMatrixInterface.h"
 #include "ChartableMatrixSeriesInterface.h"
 #include "ChartModelDataSeries.h"
@@ -2974,10 +2975,12 @@ BrainOpenGLFixedPipeline::drawSurface(Surface* surface,
                  */
                 glPushAttrib(GL_ENABLE_BIT);
                 glDisable(GL_CULL_FACE);
-                this->drawSurfaceNodes(surface,
-                                       nodeColoringRGBA);
-                this->drawSurfaceTriangles(surface,
+                if ( ! this->identifySurfaceWithRayCast(surface)) {
+                    this->drawSurfaceNodes(surface,
                                            nodeColoringRGBA);
+                    this->drawSurfaceTriangles(surface,
+                                               nodeColoringRGBA);
+                }
                 glPopAttrib();
             }
 
@@ -3146,213 +3149,361 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
         
         
         if (triangleIndex >= 0) {
-            bool isTriangleIdAccepted = false;
-            if (triangleID != NULL) {
-                if (triangleID->isOtherScreenDepthCloserToViewer(depth)) {
-                    triangleID->setBrain(surface->getBrainStructure()->getBrain());
-                    triangleID->setSurface(surface);
-                    triangleID->setTriangleNumber(triangleIndex);
-                    const int32_t* triangleNodeIndices = surface->getTriangle(triangleIndex);
-                    triangleID->setNearestNode(triangleNodeIndices[0]);
-                    triangleID->setScreenDepth(depth);
-                    isTriangleIdAccepted = true;
-                    CaretLogFine("Selected Triangle: " + triangleID->toString());   
-                }
-                else {
-                    CaretLogFine("Rejecting Selected Triangle but still using: " + triangleID->toString());   
-                }
+            setSurfaceTriangleSelection(surface,
+                                        triangleID,
+                                        triangleIndex,
+                                        depth,
+                                        isProjection);
+        }
+    }
+}
+
+/**
+ * Identify the vertex and triangle under the mouse by casting a ray
+ * through the surface's bounding volume hierarchy, instead of drawing
+ * the surface in identification colors and reading back the pixels.
+ * The hit is the closest triangle, from either side, that is inside
+ * any surface clipping planes, as it would be when drawn.
+ *
+ * @param surface
+ *    Surface that is identified.
+ * @return
+ *    True if identification was performed, false if the surface must
+ *    be drawn for identification.
+ */
+bool
+BrainOpenGLFixedPipeline::identifySurfaceWithRayCast(Surface* surface)
+{
+    if (surface->getNumberOfTriangles() <= 0) {
+        return false;
+    }
+    
+    SelectionItemSurfaceNode* nodeID = m_brain->getSelectionManager()->getSurfaceNodeIdentification();
+    SelectionItemSurfaceTriangle* triangleID = m_brain->getSelectionManager()->getSurfaceTriangleIdentification();
+    if (( ! nodeID->isEnabledForSelection())
+        && ( ! triangleID->isEnabledForSelection())) {
+        return true;
+    }
+    
+    GLdouble modelviewMatrix[16];
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelviewMatrix);
+    GLdouble projectionMatrix[16];
+    glGetDoublev(GL_PROJECTION_MATRIX, projectionMatrix);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    /*
+     * Ray from the near clipping plane to the far clipping plane under the mouse
+     */
+    double nearXYZ[3], farXYZ[3];
+    if (( ! gluUnProject(this->mouseX, this->mouseY, 0.0,
+                         modelviewMatrix, projectionMatrix, viewport,
+                         &nearXYZ[0], &nearXYZ[1], &nearXYZ[2]))
+        || ( ! gluUnProject(this->mouseX, this->mouseY, 1.0,
+                            modelviewMatrix, projectionMatrix, viewport,
+                            &farXYZ[0], &farXYZ[1], &farXYZ[2]))) {
+        return false;
+    }
+    const float origin[3] = {
+        static_cast<float>(nearXYZ[0]),
+        static_cast<float>(nearXYZ[1]),
+        static_cast<float>(nearXYZ[2])
+    };
+    const float direction[3] = {
+        static_cast<float>(farXYZ[0] - nearXYZ[0]),
+        static_cast<float>(farXYZ[1] - nearXYZ[1]),
+        static_cast<float>(farXYZ[2] - nearXYZ[2])
+    };
+    
+    const StructureEnum::Enum structure = surface->getStructure();
+    const bool clippingFlag = m_clippingPlaneGroup->isSurfaceSelected();
+    CaretTriangleBVH::RayHit hit;
+    const bool hitFlag = surface->getTriangleBVH()->closestRayHit(origin,
+                                                                 direction,
+                                                                 hit,
+                                                                 [&](const CaretTriangleBVH::RayHit& rayHit) {
+        return (( ! clippingFlag)
+                || isCoordinateInsideClippingPlanesForStructure(structure, rayHit.m_xyz));
+    });
+    if ( ! hitFlag) {
+        return true;
+    }
+    
+    /*
+     * Window Z of the hit is the value the depth buffer would contain
+     */
+    double windowXYZ[3];
+    if ( ! gluProject(hit.m_xyz[0], hit.m_xyz[1], hit.m_xyz[2],
+                      modelviewMatrix, projectionMatrix, viewport,
+                      &windowXYZ[0], &windowXYZ[1], &windowXYZ[2])) {
+        return true;
+    }
+    const float depth = static_cast<float>(windowXYZ[2]);
+    
+    if (triangleID->isEnabledForSelection()) {
+        setSurfaceTriangleSelection(surface,
+                                    triangleID,
+                                    static_cast<int32_t>(hit.m_triangle),
+                                    depth,
+                                    false);
+    }
+    
+    if (nodeID->isEnabledForSelection()) {
+        /*
+         * Vertex of the triangle closest to the hit has the largest barycentric weight
+         */
+        const int32_t* triangleNodes = surface->getTriangle(static_cast<int32_t>(hit.m_triangle));
+        int32_t nearestCorner = 0;
+        for (int32_t i = 1; i < 3; i++) {
+            if (hit.m_barycentric[i] > hit.m_barycentric[nearestCorner]) {
+                nearestCorner = i;
             }
-            
-            /*
-             * Node indices
-             */
-            const int32_t n1 = triangles[triangleIndex*3];
-            const int32_t n2 = triangles[triangleIndex*3 + 1];
-            const int32_t n3 = triangles[triangleIndex*3 + 2];
-            
-            /*
-             * Node coordinates
-             */
-            const float* c1 = &coordinates[n1*3];
-            const float* c2 = &coordinates[n2*3];
-            const float* c3 = &coordinates[n3*3];
-            
-            const float average[3] = {
-                c1[0] + c2[0] + c3[0],
-                c1[1] + c2[1] + c3[1],
-                c1[2] + c2[2] + c3[2]
-            };
+        }
+        const int32_t nodeIndex = triangleNodes[nearestCorner];
+        if (nodeID->isOtherScreenDepthCloserToViewer(depth)) {
+            nodeID->setBrain(surface->getBrainStructure()->getBrain());
+            nodeID->setSurface(surface);
+            nodeID->setNodeNumber(nodeIndex);
+            nodeID->setScreenDepth(depth);
+            this->setSelectedItemScreenXYZ(nodeID, surface->getCoordinate(nodeIndex));
+            CaretLogFine("Selected Vertex: " + nodeID->toString());
+        }
+        else {
+            CaretLogFine("Rejecting Selected Vertex: " + nodeID->toString());
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * Process a triangle found by identification or projection.
+ *
+ * @param surface
+ *    Surface containing the triangle.
+ * @param triangleID
+ *    Triangle identification item, NULL if projecting.
+ * @param triangleIndex
+ *    Index of the triangle.
+ * @param depth
+ *    Screen depth of the triangle under the mouse.
+ * @param isProjection
+ *    True if in projection mode.
+ */
+void
+BrainOpenGLFixedPipeline::setSurfaceTriangleSelection(Surface* surface,
+                                                      SelectionItemSurfaceTriangle* triangleID,
+                                                      const int32_t triangleIndex,
+                                                      const float depth,
+                                                      const bool isProjection)
+{
+    const int32_t* triangles = surface->getTriangle(0);
+    const float* coordinates = surface->getCoordinate(0);
+    
+    bool isTriangleIdAccepted = false;
+    if (triangleID != NULL) {
+        if (triangleID->isOtherScreenDepthCloserToViewer(depth)) {
+            triangleID->setBrain(surface->getBrainStructure()->getBrain());
+            triangleID->setSurface(surface);
+            triangleID->setTriangleNumber(triangleIndex);
+            const int32_t* triangleNodeIndices = surface->getTriangle(triangleIndex);
+            triangleID->setNearestNode(triangleNodeIndices[0]);
+            triangleID->setScreenDepth(depth);
+            isTriangleIdAccepted = true;
+            CaretLogFine("Selected Triangle: " + triangleID->toString());   
+        }
+        else {
+            CaretLogFine("Rejecting Selected Triangle but still using: " + triangleID->toString());   
+        }
+    }
+    
+    /*
+     * Node indices
+     */
+    const int32_t n1 = triangles[triangleIndex*3];
+    const int32_t n2 = triangles[triangleIndex*3 + 1];
+    const int32_t n3 = triangles[triangleIndex*3 + 2];
+    
+    /*
+     * Node coordinates
+     */
+    const float* c1 = &coordinates[n1*3];
+    const float* c2 = &coordinates[n2*3];
+    const float* c3 = &coordinates[n3*3];
+    
+    const float average[3] = {
+        c1[0] + c2[0] + c3[0],
+        c1[1] + c2[1] + c3[1],
+        c1[2] + c2[2] + c3[2]
+    };
+    if (triangleID != NULL) {
+        if (isTriangleIdAccepted) {
+            this->setSelectedItemScreenXYZ(triangleID, average);
+        }
+    }
+           
+    GLdouble selectionModelviewMatrix[16];
+    glGetDoublev(GL_MODELVIEW_MATRIX, selectionModelviewMatrix);
+    
+    GLdouble selectionProjectionMatrix[16];
+    glGetDoublev(GL_PROJECTION_MATRIX, selectionProjectionMatrix);
+    
+    GLint selectionViewport[4];
+    glGetIntegerv(GL_VIEWPORT, selectionViewport);
+    
+    /*
+     * Window positions of each coordinate
+     */
+    double dc1[3] = { c1[0], c1[1], c1[2] };
+    double dc2[3] = { c2[0], c2[1], c2[2] };
+    double dc3[3] = { c3[0], c3[1], c3[2] };
+    double wc1[3], wc2[3], wc3[3];
+    if (gluProject(dc1[0], 
+                   dc1[1], 
+                   dc1[2],
+                   selectionModelviewMatrix,
+                   selectionProjectionMatrix,
+                   selectionViewport,
+                   &wc1[0],
+                   &wc1[1],
+                   &wc1[2])
+        && gluProject(dc2[0], 
+                      dc2[1], 
+                      dc2[2],
+                      selectionModelviewMatrix,
+                      selectionProjectionMatrix,
+                      selectionViewport,
+                      &wc2[0],
+                      &wc2[1],
+                      &wc2[2])
+        && gluProject(dc3[0], 
+                      dc3[1], 
+                      dc3[2],
+                      selectionModelviewMatrix,
+                      selectionProjectionMatrix,
+                      selectionViewport,
+                      &wc3[0],
+                      &wc3[1],
+                      &wc3[2])) {
+            const double d1 = MathFunctions::distanceSquared2D(wc1[0], 
+                                                               wc1[1], 
+                                                               this->mouseX, 
+                                                               this->mouseY);
+            const double d2 = MathFunctions::distanceSquared2D(wc2[0], 
+                                                               wc2[1], 
+                                                               this->mouseX, 
+                                                               this->mouseY);
+            const double d3 = MathFunctions::distanceSquared2D(wc3[0], 
+                                                               wc3[1], 
+                                                               this->mouseX, 
+                                                               this->mouseY);
             if (triangleID != NULL) {
                 if (isTriangleIdAccepted) {
-                    this->setSelectedItemScreenXYZ(triangleID, average);
+                    triangleID->setNearestNode(n3);
+                    triangleID->setNearestNodeScreenXYZ(wc3);
+                    triangleID->setNearestNodeModelXYZ(dc3);
+                    if ((d1 < d2) && (d1 < d3)) {
+                        triangleID->setNearestNode(n1);
+                        triangleID->setNearestNodeScreenXYZ(wc1);
+                        triangleID->setNearestNodeModelXYZ(dc1);
+                    }
+                    else if ((d2 < d1) && (d2 < d3)) {
+                        triangleID->setNearestNode(n2);
+                        triangleID->setNearestNodeScreenXYZ(wc2);
+                        triangleID->setNearestNodeModelXYZ(dc2);
+                    }
                 }
             }
-                   
-            GLdouble selectionModelviewMatrix[16];
-            glGetDoublev(GL_MODELVIEW_MATRIX, selectionModelviewMatrix);
-            
-            GLdouble selectionProjectionMatrix[16];
-            glGetDoublev(GL_PROJECTION_MATRIX, selectionProjectionMatrix);
-            
-            GLint selectionViewport[4];
-            glGetIntegerv(GL_VIEWPORT, selectionViewport);
             
             /*
-             * Window positions of each coordinate
+             * Getting projected position?
              */
-            double dc1[3] = { c1[0], c1[1], c1[2] };
-            double dc2[3] = { c2[0], c2[1], c2[2] };
-            double dc3[3] = { c3[0], c3[1], c3[2] };
-            double wc1[3], wc2[3], wc3[3];
-            if (gluProject(dc1[0], 
-                           dc1[1], 
-                           dc1[2],
-                           selectionModelviewMatrix,
-                           selectionProjectionMatrix,
-                           selectionViewport,
-                           &wc1[0],
-                           &wc1[1],
-                           &wc1[2])
-                && gluProject(dc2[0], 
-                              dc2[1], 
-                              dc2[2],
-                              selectionModelviewMatrix,
-                              selectionProjectionMatrix,
-                              selectionViewport,
-                              &wc2[0],
-                              &wc2[1],
-                              &wc2[2])
-                && gluProject(dc3[0], 
-                              dc3[1], 
-                              dc3[2],
-                              selectionModelviewMatrix,
-                              selectionProjectionMatrix,
-                              selectionViewport,
-                              &wc3[0],
-                              &wc3[1],
-                              &wc3[2])) {
-                    const double d1 = MathFunctions::distanceSquared2D(wc1[0], 
-                                                                       wc1[1], 
-                                                                       this->mouseX, 
-                                                                       this->mouseY);
-                    const double d2 = MathFunctions::distanceSquared2D(wc2[0], 
-                                                                       wc2[1], 
-                                                                       this->mouseX, 
-                                                                       this->mouseY);
-                    const double d3 = MathFunctions::distanceSquared2D(wc3[0], 
-                                                                       wc3[1], 
-                                                                       this->mouseX, 
-                                                                       this->mouseY);
-                    if (triangleID != NULL) {
-                        if (isTriangleIdAccepted) {
-                            triangleID->setNearestNode(n3);
-                            triangleID->setNearestNodeScreenXYZ(wc3);
-                            triangleID->setNearestNodeModelXYZ(dc3);
-                            if ((d1 < d2) && (d1 < d3)) {
-                                triangleID->setNearestNode(n1);
-                                triangleID->setNearestNodeScreenXYZ(wc1);
-                                triangleID->setNearestNodeModelXYZ(dc1);
-                            }
-                            else if ((d2 < d1) && (d2 < d3)) {
-                                triangleID->setNearestNode(n2);
-                                triangleID->setNearestNodeScreenXYZ(wc2);
-                                triangleID->setNearestNodeModelXYZ(dc2);
-                            }
-                        }
-                    }
+            if (isProjection) {
+                /*
+                 * Place window coordinates of triangle's nodes
+                 * onto the screen by setting Z-coordinate to zero
+                 */
+                wc1[2] = 0.0;
+                wc2[2] = 0.0;
+                wc3[2] = 0.0;
+                
+                /*
+                 * Area of triangle when projected to display
+                 */
+                const double triangleDisplayArea = 
+                    MathFunctions::triangleArea(wc1, wc2, wc3);
+                
+                /*
+                 * If area of triangle on display is small,
+                 * use a coordinate from the triangle
+                 */
+                if (triangleDisplayArea < 0.001) {
+                    float barycentricAreas[3] = { 1.0, 0.0, 0.0 };
+                    int barycentricNodes[3] = { n1, n1, n1 };
                     
+                    this->setProjectionModeData(depth, 
+                                                c1, 
+                                                surface->getStructure(), 
+                                                barycentricAreas, 
+                                                barycentricNodes, 
+                                                surface->getNumberOfNodes());
+                }
+                else {
                     /*
-                     * Getting projected position?
+                     * Determine position in triangle using barycentric coordinates
                      */
-                    if (isProjection) {
+                    double displayXYZ[3] = { 
+                        (double)this->mouseX,
+                        (double)this->mouseY,
+                        0.0 
+                    };
+                    
+                    const double areaU = (MathFunctions::triangleArea(displayXYZ, wc2, wc3)
+                                          / triangleDisplayArea);
+                    const double areaV = (MathFunctions::triangleArea(displayXYZ, wc3, wc1)
+                                          / triangleDisplayArea);
+                    const double areaW = (MathFunctions::triangleArea(displayXYZ, wc1, wc2)
+                                          / triangleDisplayArea);
+                    double totalArea = areaU + areaV + areaW;
+                    if (totalArea <= 0) {
+                        totalArea = 1.0;
+                    }
+                    if ((areaU < 0.0) || (areaV < 0.0) || (areaW < 0.0)) {
+                        CaretLogWarning("Invalid tile area: less than zero when projecting to surface.");
+                    }
+                    else {
                         /*
-                         * Place window coordinates of triangle's nodes
-                         * onto the screen by setting Z-coordinate to zero
+                         * Convert to surface coordinates
                          */
-                        wc1[2] = 0.0;
-                        wc2[2] = 0.0;
-                        wc3[2] = 0.0;
+                        const float projectedXYZ[3] = {
+                            (float)((dc1[0]*areaU + dc2[0]*areaV + dc3[0]*areaW) / totalArea),
+                            (float)((dc1[1]*areaU + dc2[1]*areaV + dc3[1]*areaW) / totalArea),
+                            (float)((dc1[2]*areaU + dc2[2]*areaV + dc3[2]*areaW) / totalArea)
+                        };
                         
-                        /*
-                         * Area of triangle when projected to display
-                         */
-                        const double triangleDisplayArea = 
-                            MathFunctions::triangleArea(wc1, wc2, wc3);
+                        const float barycentricAreas[3] = {
+                            (float)areaU,
+                            (float)areaV,
+                            (float)areaW
+                        };
                         
-                        /*
-                         * If area of triangle on display is small,
-                         * use a coordinate from the triangle
-                         */
-                        if (triangleDisplayArea < 0.001) {
-                            float barycentricAreas[3] = { 1.0, 0.0, 0.0 };
-                            int barycentricNodes[3] = { n1, n1, n1 };
-                            
-                            this->setProjectionModeData(depth, 
-                                                        c1, 
-                                                        surface->getStructure(), 
-                                                        barycentricAreas, 
-                                                        barycentricNodes, 
-                                                        surface->getNumberOfNodes());
-                        }
-                        else {
-                            /*
-                             * Determine position in triangle using barycentric coordinates
-                             */
-                            double displayXYZ[3] = { 
-                                (double)this->mouseX,
-                                (double)this->mouseY,
-                                0.0 
-                            };
-                            
-                            const double areaU = (MathFunctions::triangleArea(displayXYZ, wc2, wc3)
-                                                  / triangleDisplayArea);
-                            const double areaV = (MathFunctions::triangleArea(displayXYZ, wc3, wc1)
-                                                  / triangleDisplayArea);
-                            const double areaW = (MathFunctions::triangleArea(displayXYZ, wc1, wc2)
-                                                  / triangleDisplayArea);
-                            double totalArea = areaU + areaV + areaW;
-                            if (totalArea <= 0) {
-                                totalArea = 1.0;
-                            }
-                            if ((areaU < 0.0) || (areaV < 0.0) || (areaW < 0.0)) {
-                                CaretLogWarning("Invalid tile area: less than zero when projecting to surface.");
-                            }
-                            else {
-                                /*
-                                 * Convert to surface coordinates
-                                 */
-                                const float projectedXYZ[3] = {
-                                    (float)((dc1[0]*areaU + dc2[0]*areaV + dc3[0]*areaW) / totalArea),
-                                    (float)((dc1[1]*areaU + dc2[1]*areaV + dc3[1]*areaW) / totalArea),
-                                    (float)((dc1[2]*areaU + dc2[2]*areaV + dc3[2]*areaW) / totalArea)
-                                };
-                                
-                                const float barycentricAreas[3] = {
-                                    (float)areaU,
-                                    (float)areaV,
-                                    (float)areaW
-                                };
-                                
-                                const int32_t barycentricNodes[3] = {
-                                    n1,
-                                    n2,
-                                    n3
-                                };
-                            
-                                this->setProjectionModeData(depth, 
-                                                            projectedXYZ, 
-                                                            surface->getStructure(), 
-                                                            barycentricAreas, 
-                                                            barycentricNodes, 
-                                                            surface->getNumberOfNodes());
-                            }
-                        }
+                        const int32_t barycentricNodes[3] = {
+                            n1,
+                            n2,
+                            n3
+                        };
+                    
+                        this->setProjectionModeData(depth, 
+                                                    projectedXYZ, 
+                                                    surface->getStructure(), 
+                                                    barycentricAreas, 
+                                                    barycentricNodes, 
+                                                    surface->getNumberOfNodes());
                     }
+                }
             }
-            CaretLogFine("Selected Triangle: " + QString::number(triangleIndex));
-        }
-        
     }
+    CaretLogFine("Selected Triangle: " + QString::number(triangleIndex));
 }
 
 /**
@@ -248,6 +248,14 @@ namespace caret {
         void drawSurfaceTriangles(Surface* surface,
                                   const float* nodeColoringRGBA);
         
+        void setSurfaceTriangleSelection(Surface* surface,
+                                         SelectionItemSurfaceTriangle* triangleID,
+                                         const int32_t triangleIndex,
+                                         const float depth,
+                                         const bool isProjection);
+        
+        bool identifySurfaceWithRayCast(Surface* surface);
+        
         void drawSurfaceNodeAttributes(Surface* surface,
                                        const int32_t viewportHeight);
         
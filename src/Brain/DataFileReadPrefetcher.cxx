@@ -0,0 +1,225 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __DATA_FILE_READ_PREFETCHER_DECLARE__
+#include "DataFileReadPrefetcher.h"
+#undef __DATA_FILE_READ_PREFETCHER_DECLARE__
+
+#include <QtConcurrent/QtConcurrent>
+
+#include "CaretAssert.h"
+#include "CaretDataFileHelper.h"
+#include "DataFile.h"
+#include "DataFileException.h"
+#include "ElapsedTimer.h"
+#include "FileInformation.h"
+#include "Surface.h"
+
+using namespace caret;
+
+/**
+ * \class caret::DataFileReadPrefetcher
+ * \brief Reads data files on worker threads ahead of adding them to the Brain
+ * \ingroup Brain
+ *
+ * Reading a file (parsing XML, decoding and decompressing GIFTI arrays,
+ * reading NIfTI and CIFTI data) does not touch the Brain, so many files
+ * may be read at once on the global thread pool.  The file instances are
+ * created and deleted on the calling thread since their constructors and
+ * destructors register with the EventManager.  Adding a file to the Brain
+ * must remain on the main thread, in the original order, using
+ * takeFile() to wait for each file.
+ */
+
+/**
+ * Constructor.
+ */
+DataFileReadPrefetcher::DataFileReadPrefetcher()
+: CaretObject()
+{
+}
+
+/**
+ * Destructor.  Waits for any reads still in progress and deletes
+ * files that were never taken (such as when loading is cancelled).
+ */
+DataFileReadPrefetcher::~DataFileReadPrefetcher()
+{
+    for (auto& iter : m_pendingReads) {
+        PendingRead* pendingRead = iter.second.get();
+        pendingRead->m_future.waitForFinished();
+        delete pendingRead->m_caretDataFile;
+    }
+    m_pendingReads.clear();
+}
+
+/**
+ * Is reading of the given data file type safe on a worker thread?  These
+ * types read only their own content and do not send events while reading.
+ * Dense connectivity files are excluded since they read data on demand.
+ *
+ * @param dataFileType
+ *     Type of data file.
+ * @return
+ *     True if the type may be read in parallel.
+ */
+bool
+DataFileReadPrefetcher::isParallelReadSupported(const DataFileTypeEnum::Enum dataFileType)
+{
+    bool supportedFlag = false;
+    
+    switch (dataFileType) {
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_LABEL:
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_SCALAR:
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_TIME_SERIES:
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL:
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_LABEL:
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_SCALAR:
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_SERIES:
+        case DataFileTypeEnum::LABEL:
+        case DataFileTypeEnum::METRIC:
+        case DataFileTypeEnum::RGBA:
+        case DataFileTypeEnum::SURFACE:
+        case DataFileTypeEnum::VOLUME:
+            supportedFlag = true;
+            break;
+        default:
+            break;
+    }
+    
+    return supportedFlag;
+}
+
+/**
+ * Start reading a file on a worker thread.
+ *
+ * @param dataFileType
+ *     Type of data file.
+ * @param filename
+ *     Absolute path of the file.
+ * @return
+ *     True if reading was started.  False if the file type is not supported,
+ *     the file is on the network or does not exist, or the file is already
+ *     being read, in which case the caller should read the file itself.
+ */
+bool
+DataFileReadPrefetcher::addFile(const DataFileTypeEnum::Enum dataFileType,
+                                const AString& filename)
+{
+    if ( ! isParallelReadSupported(dataFileType)) {
+        return false;
+    }
+    if (DataFile::isFileOnNetwork(filename)) {
+        return false;
+    }
+    if ( ! FileInformation(filename).exists()) {
+        return false;
+    }
+    if (m_pendingReads.find(filename) != m_pendingReads.end()) {
+        return false;
+    }
+    
+    CaretDataFile* caretDataFile = NULL;
+    if (dataFileType == DataFileTypeEnum::SURFACE) {
+        /*
+         * Brain uses the Surface subclass of SurfaceFile
+         */
+        caretDataFile = new Surface();
+    }
+    else {
+        caretDataFile = CaretDataFileHelper::createCaretDataFileForFileType(dataFileType);
+    }
+    if (caretDataFile == NULL) {
+        return false;
+    }
+    
+    PendingRead* pendingRead = new PendingRead();
+    pendingRead->m_caretDataFile = caretDataFile;
+    m_pendingReads[filename].reset(pendingRead);
+    
+    pendingRead->m_future = QtConcurrent::run([pendingRead, filename]() {
+        ElapsedTimer timer;
+        timer.start();
+        try {
+            pendingRead->m_caretDataFile->readFile(filename);
+        }
+        catch (const DataFileException& dfe) {
+            pendingRead->m_exception.reset(new DataFileException(dfe));
+        }
+        catch (const std::bad_alloc&) {
+            pendingRead->m_exception.reset(new DataFileException(filename,
+                                                                 CaretDataFileHelper::createBadAllocExceptionMessage(filename)));
+        }
+        catch (const CaretException& e) {
+            pendingRead->m_exception.reset(new DataFileException(e));
+        }
+        pendingRead->m_readSeconds = timer.getElapsedTimeSeconds();
+    });
+    
+    return true;
+}
+
+/**
+ * Wait for a file to finish reading and take ownership of it.
+ *
+ * @param filename
+ *     Absolute path of the file, as given to addFile().
+ * @param readSecondsOut
+ *     Time spent reading the file on the worker thread.
+ * @return
+ *     The file that was read, or NULL if the file was not added.
+ * @throws DataFileException
+ *     If reading the file failed.
+ */
+CaretDataFile*
+DataFileReadPrefetcher::takeFile(const AString& filename,
+                                 float& readSecondsOut)
+{
+    readSecondsOut = 0.0f;
+    
+    auto iter = m_pendingReads.find(filename);
+    if (iter == m_pendingReads.end()) {
+        return NULL;
+    }
+    
+    std::unique_ptr<PendingRead> pendingRead(std::move(iter->second));
+    m_pendingReads.erase(iter);
+    CaretAssert(pendingRead);
+    pendingRead->m_future.waitForFinished();
+    readSecondsOut = pendingRead->m_readSeconds;
+    
+    if (pendingRead->m_exception) {
+        delete pendingRead->m_caretDataFile;
+        throw DataFileException(*pendingRead->m_exception);
+    }
+    
+    return pendingRead->m_caretDataFile;
+}
+
+/**
+ * @return Number of files that have been added but not yet taken.
+ */
+int32_t
+DataFileReadPrefetcher::getNumberOfPendingFiles() const
+{
+    return m_pendingReads.size();
+}
+
@@ -0,0 +1,84 @@
+#ifndef __DATA_FILE_READ_PREFETCHER_H__
+#define __DATA_FILE_READ_PREFETCHER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+
+#include <map>
+#include <memory>
+
+#include <QFuture>
+
+#include "CaretObject.h"
+#include "DataFileException.h"
+#include "DataFileTypeEnum.h"
+
+namespace caret {
+
+    class CaretDataFile;
+    
+    class DataFileReadPrefetcher
+    : public CaretObject
+    {
+        
+    public:
+        DataFileReadPrefetcher();
+        
+        virtual ~DataFileReadPrefetcher();
+        
+        static bool isParallelReadSupported(const DataFileTypeEnum::Enum dataFileType);
+        
+        bool addFile(const DataFileTypeEnum::Enum dataFileType,
+                     const AString& filename);
+        
+        CaretDataFile* takeFile(const AString& filename,
+                                float& readSecondsOut);
+        
+        int32_t getNumberOfPendingFiles() const;
+        
+    private:
+        DataFileReadPrefetcher(const DataFileReadPrefetcher&);
+
+        DataFileReadPrefetcher& operator=(const DataFileReadPrefetcher&);
+        
+        /**
+         * A file being read by a worker thread.  Only the worker
+         * thread touches the members until the future finishes.
+         */
+        struct PendingRead {
+            CaretDataFile* m_caretDataFile = NULL;
+            
+            std::unique_ptr<DataFileException> m_exception;
+            
+            float m_readSeconds = 0.0f;
+            
+            QFuture<void> m_future;
+        };
+        
+        std::map<AString, std::unique_ptr<PendingRead>> m_pendingReads;
+    };
+    
+#ifdef __DATA_FILE_READ_PREFETCHER_DECLARE__
+    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+#endif // __DATA_FILE_READ_PREFETCHER_DECLARE__
+
+} // namespace
+#endif  //__DATA_FILE_READ_PREFETCHER_H__
@@ -25,6 +25,7 @@
 #include "CaretAssert.h"
 #include "CaretHttpManager.h"
 #include "CaretLogger.h"
+#include "CiftiStatisticsExtension.h"
 #include "DataFileException.h"
 #include "FileInformation.h"
 #include "MultiDimArray.h"
@@ -42,18 +43,23 @@ namespace
         mutable NiftiIO m_nifti;//because file objects aren't stateless (current position), so reading "changes" them
         vector<int64_t> m_matrixDims;//store the dimensions even if the xml is forgotten
         CiftiXML m_xml;//we need to store the xml somewhere before it gets put into CiftiFile's copy
+        int m_statisticsExtension;//index of the reserved statistics extension when writing, -1 if none
+        bool m_statisticsWithMaps, m_statisticsCurrent;
     public:
-        CiftiOnDiskImpl(const QString& filename);//read-only
+        CiftiOnDiskImpl(const QString& filename, const bool& memoryMap = false);//read-only
         CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, const CiftiVersion& version, const bool& swapEndian,
                         const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval);//make new empty file with read/write
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const;
         void getColumn(float* dataOut, const int64_t& index) const;
+        const float* getRowPointer(const std::vector<int64_t>& indexSelect) const { return m_nifti.getMappedFloatData(5, indexSelect); }
         const CiftiXML& getCiftiXML() const { return m_xml; }
         QString getFilename() const { return m_nifti.getFilename(); }
         bool isSwapped() const { return m_nifti.getHeader().isSwapped(); }
         void setRow(const float* dataIn, const std::vector<int64_t>& indexSelect);
         void setColumn(const float* dataIn, const int64_t& index);
         void close();
+        void writeStatistics();
+        vector<char> getStatisticsBytes() const;
         void dropXML() { m_xml = CiftiXML(); m_nifti.dropExtensions(); }
     };
     
@@ -64,6 +70,7 @@ namespace
         CiftiMemoryImpl(const CiftiXML& xml);
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const;
         void getColumn(float* dataOut, const int64_t& index) const;
+        const float* getRowPointer(const std::vector<int64_t>& indexSelect) const { return m_array.get(1, indexSelect); }
         bool isInMemory() const { return true; }
         void setRow(const float* dataIn, const std::vector<int64_t>& indexSelect);
         void setColumn(const float* dataIn, const int64_t& index);
@@ -110,19 +117,60 @@ CiftiFile::WriteImplInterface::~WriteImplInterface()
 {
 }
 
+bool CiftiFile::s_writeStatistics = false;
+
 CiftiFile::CiftiFile(const QString& fileName)
 {
     m_endianPref = NATIVE;
     setWritingDataTypeNoScaling();//default argument is float32
+    m_statisticsParsed = true;
     openFile(fileName);
 }
 
-void CiftiFile::openFile(const QString& fileName)
+CiftiFile::~CiftiFile()
+{
+}
+
+void CiftiFile::setWriteStatistics(const bool& enabled)
+{
+    s_writeStatistics = enabled;
+}
+
+bool CiftiFile::getWriteStatistics()
+{
+    return s_writeStatistics;
+}
+
+const CiftiStatisticsExtension* CiftiFile::getStoredStatistics() const
+{
+    if (!m_statisticsParsed)
+    {//parse lazily, most files are opened without anyone asking for statistics of all of the data
+        m_statisticsParsed = true;
+        CaretPointer<CiftiStatisticsExtension> parsed(new CiftiStatisticsExtension());
+        if (parsed->readFromBytes(m_statisticsBytes, m_dims, m_readingImpl.getPointer()))
+        {
+            m_statistics = parsed;
+        }
+        m_statisticsBytes = vector<char>();
+    }
+    return m_statistics;
+}
+
+void CiftiFile::dropStoredStatistics()
+{
+    m_statisticsBytes = vector<char>();
+    m_statistics.grabNew(NULL);
+    m_statisticsParsed = true;
+}
+
+void CiftiFile::openFile(const QString& fileName, const bool& memoryMap)
 {
     close();//to make sure it closes everything first, even if the open throws
-    CaretPointer<CiftiOnDiskImpl> newRead(new CiftiOnDiskImpl(FileInformation(fileName).getAbsoluteFilePath()));//this constructor opens existing file read-only
+    CaretPointer<CiftiOnDiskImpl> newRead(new CiftiOnDiskImpl(FileInformation(fileName).getAbsoluteFilePath(), memoryMap));//this constructor opens existing file read-only
     m_readingImpl = newRead;//it should be noted that if the constructor throws (if the file isn't readable), new guarantees the memory allocated for the object will be freed
     m_xml = newRead->getCiftiXML();
+    m_statisticsBytes = newRead->getStatisticsBytes();//dropXML also drops the other extensions
+    m_statisticsParsed = m_statisticsBytes.empty();
     newRead->dropXML();//save some memory, we don't need 2 copies of the xml - figure out if there is a better way to prevent copies
     m_xmlBroken = false;
     m_dims = m_xml.getDimensions();
@@ -198,9 +246,11 @@ void CiftiFile::writeFile(const QString& fileName, const CiftiVersion& writingVe
         m_readingImpl = tempMemory;//we are about to make the old reading impl very unhappy, replace it so that if we get an error while writing, we hang onto the memory version
         m_writingImpl.grabNew(NULL);//and make it re-magic the writing implementation again if data is set
     }
-    CaretPointer<WriteImplInterface> tempWrite(new CiftiOnDiskImpl(myInfo.getAbsoluteFilePath(), m_xml, writingVersion, writeSwapped,
-                                                                   m_writingDataType, m_doWriteScaling, m_minScalingVal, m_maxScalingVal));
+    CaretPointer<CiftiOnDiskImpl> tempDisk(new CiftiOnDiskImpl(myInfo.getAbsoluteFilePath(), m_xml, writingVersion, writeSwapped,
+                                                               m_writingDataType, m_doWriteScaling, m_minScalingVal, m_maxScalingVal));
+    CaretPointer<WriteImplInterface> tempWrite(tempDisk);
     copyImplData(m_readingImpl, tempWrite, m_dims);
+    tempDisk->writeStatistics();//the temporary isn't closed, so this is the only chance
     if (collision)//if we rewrote the file, we need the handle to the new file, and to dump the temporary in-memory version
     {
         m_onDiskVersion = writingVersion;//also record the current version number
@@ -221,6 +271,7 @@ void CiftiFile::close()
     }
     m_writingImpl.grabNew(NULL);
     m_readingImpl.grabNew(NULL);
+    dropStoredStatistics();
     m_dims.clear();
     m_xml = CiftiXML();
     m_xmlBroken = false;
@@ -259,6 +310,20 @@ void CiftiFile::getRow(float* dataOut, const vector<int64_t>& indexSelect, const
     m_readingImpl->getRow(dataOut, indexSelect, tolerateShortRead);
 }
 
+const float* CiftiFile::getRowPointer(const vector<int64_t>& indexSelect) const
+{
+    if (m_dims.empty()) throw DataFileException("getRowPointer called on uninitialized CiftiFile");
+    if (m_readingImpl == NULL) return NULL;//no data yet, same as getRow
+    return m_readingImpl->getRowPointer(indexSelect);
+}
+
+const float* CiftiFile::getRowPointer(const int64_t& index) const
+{
+    if (m_dims.empty()) throw DataFileException("getRowPointer called on uninitialized CiftiFile");
+    if (m_dims.size() != 2) throw DataFileException("getRowPointer with single index called on non-2D CiftiFile");
+    return getRowPointer(vector<int64_t>(1, index));
+}
+
 void CiftiFile::getColumn(float* dataOut, const int64_t& index) const
 {
     if (m_dims.empty()) throw DataFileException("getColumn called on uninitialized CiftiFile");
@@ -277,6 +342,7 @@ void CiftiFile::setCiftiXML(const CiftiXML& xml, const bool useOldMetadata)
     }
     m_readingImpl.grabNew(NULL);//drop old matrix/file, as it is now invalid due to XML (and therefore matrix size) change
     m_writingImpl.grabNew(NULL);
+    dropStoredStatistics();
     if (useOldMetadata)
     {
         const GiftiMetaData* oldmd = m_xml.getFileMetaData();
@@ -335,12 +401,14 @@ void CiftiFile::forgetMapping(const int& direction)
 void CiftiFile::setRow(const float* dataIn, const vector<int64_t>& indexSelect)
 {
     verifyWriteImpl();
+    dropStoredStatistics();
     m_writingImpl->setRow(dataIn, indexSelect);
 }
 
 void CiftiFile::setColumn(const float* dataIn, const int64_t& index)
 {
     verifyWriteImpl();
+    dropStoredStatistics();
     if (m_dims.size() != 2) throw DataFileException("setColumn called on non-2D CiftiFile");
     m_writingImpl->setColumn(dataIn, index);
 }
@@ -377,6 +445,7 @@ int64_t CiftiFile::getNumberOfColumns() const
 void CiftiFile::setRow(const float* dataIn, const int64_t& index)
 {
     verifyWriteImpl();
+    dropStoredStatistics();
     if (m_dims.size() != 2) throw DataFileException("setRow with single index called on non-2D CiftiFile");
     vector<int64_t> tempvec(1, index);//could use a member if we need more speed
     m_writingImpl->setRow(dataIn, tempvec);
@@ -433,8 +502,14 @@ void CiftiFile::copyImplData(const ReadImplInterface* from, WriteImplInterface*
         vector<float> scratchRow(dims[0]);
         for (MultiDimIterator<int64_t> iter(iterateDims); !iter.atEnd(); ++iter)
         {
-            from->getRow(scratchRow.data(), *iter, false);
-            to->setRow(scratchRow.data(), *iter);
+            const float* rowRef = from->getRowPointer(*iter);//mapped or in-memory source doesn't need the scratch copy
+            if (rowRef != NULL)
+            {
+                to->setRow(rowRef, *iter);
+            } else {
+                from->getRow(scratchRow.data(), *iter, false);
+                to->setRow(scratchRow.data(), *iter);
+            }
         }
     }
 }
@@ -491,8 +566,11 @@ void CiftiMemoryImpl::setColumn(const float* dataIn, const int64_t& index)
     }
 }
 
-CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename)
+CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const bool& memoryMap)
 {//opens existing file for reading
+    m_statisticsExtension = -1;
+    m_statisticsWithMaps = false;
+    m_statisticsCurrent = true;
     m_nifti.openRead(filename);//read-only, so we don't need write permission to read a cifti file
     if (m_nifti.getNumComponents() != 1) throw DataFileException("complex or rgb datatype found in file '" + filename + "', these are not supported in cifti");
     const NiftiHeader& myHeader = m_nifti.getHeader();
@@ -557,6 +635,10 @@ CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename)
         }
     }
     m_matrixDims = m_xml.getDimensions();
+    if (memoryMap && !m_nifti.mapData())
+    {
+        CaretLogFine("unable to memory map cifti file '" + filename + "', using normal reads");//compressed or byteswapped files can't be mapped, not a problem
+    }
 }
 
 namespace
@@ -657,6 +739,9 @@ namespace
 CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, const CiftiVersion& version, const bool& swapEndian,
                                  const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval)
 {//starts writing new file
+    m_statisticsExtension = -1;
+    m_statisticsWithMaps = false;
+    m_statisticsCurrent = true;
     warnForBadExtension(filename, xml);
     NiftiHeader outHeader;
     if (rescale)
@@ -683,6 +768,16 @@ CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, c
     }
     outHeader.m_extensions.push_back(outExtension);
     m_matrixDims = xml.getDimensions();
+    if (CiftiFile::getWriteStatistics() && m_matrixDims.size() == 2 && !filename.endsWith(".gz"))
+    {//reserve room for the statistics, they get written when the data is complete, which needs seeking back to the header
+        m_statisticsWithMaps = CiftiStatisticsExtension::shouldStoreMapSummaries(xml);
+        CaretPointer<NiftiExtension> statsExtension(new NiftiExtension());
+        statsExtension->m_ecode = CiftiStatisticsExtension::NIFTI_ECODE_WORKBENCH_STATISTICS;
+        statsExtension->m_bytes = CiftiStatisticsExtension::makePlaceholder(m_matrixDims, m_statisticsWithMaps);
+        m_statisticsExtension = (int)outHeader.m_extensions.size();
+        outHeader.m_extensions.push_back(statsExtension);
+        m_statisticsCurrent = false;
+    }
     vector<int64_t> niftiDims(4, 1);//the reserved space and time dims
     niftiDims.insert(niftiDims.end(), m_matrixDims.begin(), m_matrixDims.end());
     if (version.hasReversedFirstDims())
@@ -706,10 +801,43 @@ CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, c
 
 void CiftiOnDiskImpl::close()
 {
+    writeStatistics();
     m_nifti.close();//lets this throw when there is a writing problem
     dropXML();
 }
 
+void CiftiOnDiskImpl::writeStatistics()
+{
+    if (m_statisticsExtension < 0 || m_statisticsCurrent) return;
+    CiftiStatisticsExtension myStatistics;
+    try
+    {
+        myStatistics.compute(this, m_matrixDims, m_statisticsWithMaps, m_nifti.getHeader());//read back what was written, so datatype conversion is included
+    } catch (DataFileException& e) {//rows that were never written, leave the placeholder, so readers ignore it
+        CaretLogWarning("unable to compute statistics for cifti file '" + m_nifti.getFilename() + "': " + e.whatString());
+        m_statisticsCurrent = true;
+        return;
+    }
+    vector<char> statsBytes;
+    myStatistics.writeToBytes(statsBytes);
+    m_nifti.rewriteExtension(m_statisticsExtension, statsBytes);
+    m_statisticsCurrent = true;
+}
+
+vector<char> CiftiOnDiskImpl::getStatisticsBytes() const
+{
+    const NiftiHeader& myHeader = m_nifti.getHeader();
+    for (size_t i = 0; i < myHeader.m_extensions.size(); ++i)
+    {
+        if (myHeader.m_extensions[i]->m_ecode == CiftiStatisticsExtension::NIFTI_ECODE_WORKBENCH_STATISTICS)
+        {
+            if (!CiftiStatisticsExtension::matchesHeader(myHeader.m_extensions[i]->m_bytes, myHeader)) break;//the nifti header isn't exposed past the reader, so check its fields here, the rows get checked when parsed
+            return myHeader.m_extensions[i]->m_bytes;
+        }
+    }
+    return vector<char>();
+}
+
 
 void CiftiOnDiskImpl::getRow(float* dataOut, const vector<int64_t>& indexSelect, const bool& tolerateShortRead) const
 {
@@ -738,6 +866,7 @@ void CiftiOnDiskImpl::getColumn(float* dataOut, const int64_t& index) const
 
 void CiftiOnDiskImpl::setRow(const float* dataIn, const vector<int64_t>& indexSelect)
 {
+    m_statisticsCurrent = (m_statisticsExtension < 0);
     m_nifti.writeData(dataIn, 5, indexSelect);
 }
 
@@ -746,6 +875,7 @@ void CiftiOnDiskImpl::setColumn(const float* dataIn, const int64_t& index)
     CaretAssert(m_matrixDims.size() == 2);//otherwise this shouldn't be called
     CaretAssert(index >= 0 && index < m_matrixDims[0]);
     CaretLogFine("setColumn called on CiftiOnDiskImpl, this will be slow");//generate logging messages at a low priority
+    m_statisticsCurrent = (m_statisticsExtension < 0);
     vector<int64_t> indexSelect(2);
     indexSelect[0] = index;
     int64_t colLength = m_matrixDims[1];
@@ -35,6 +35,8 @@
 namespace caret
 {
     
+    class CiftiStatisticsExtension;
+    
     class CiftiFile : public CiftiInterface
     {
     public:
@@ -51,9 +53,11 @@ namespace caret
             m_endianPref = NATIVE;
             setWritingDataTypeNoScaling();//default argument is float32
             m_xmlBroken = false;
+            m_statisticsParsed = true;
         }
         explicit CiftiFile(const QString &fileName);//calls openFile
-        void openFile(const QString& fileName);//starts on-disk reading
+        ~CiftiFile();//CiftiStatisticsExtension is incomplete here
+        void openFile(const QString& fileName, const bool& memoryMap = false);//starts on-disk reading, memoryMap only has an effect on uncompressed, native-endian files
         void openURL(const QString& url, const QString& user, const QString& pass);//open from XNAT
         void openURL(const QString& url);//same, without user/pass (or curently, reusing existing auth if the server matches
         void setWritingFile(const QString& fileName, const CiftiVersion& writingVersion = CiftiVersion(), const ENDIAN& endian = NATIVE);//starts on-disk writing
@@ -70,6 +74,10 @@ namespace caret
             return MultiDimIterator<int64_t>(std::vector<int64_t>(m_dims.begin() + 1, m_dims.end()));
         }
         void getColumn(float* dataOut, const int64_t& index) const;//for 2D only, will be slow if on disk!
+        ///pointer to the row without copying, if available (in memory, or memory mapped float32 with no scaling) - otherwise NULL, use getRow
+        ///valid until the file is closed or modified
+        const float* getRowPointer(const std::vector<int64_t>& indexSelect) const;
+        const float* getRowPointer(const int64_t& index) const;//2D only
         
         void setCiftiXML(const CiftiXML& xml, const bool useOldMetadata = true);
         void setCiftiXML(const CiftiXMLOld &xml, const bool useOldMetadata = true);//set xml from old implementation
@@ -89,11 +97,20 @@ namespace caret
         
         void forgetMapping(const int& direction);//HACK: reduce memory usage by modifying the XML
         
+        ///statistics that the writer stored in the file (see setWriteStatistics), parsed on first use
+        ///NULL if there are none, or if the data has been changed since the file was opened
+        const CiftiStatisticsExtension* getStoredStatistics() const;
+        
+        ///store file and per-map statistics in uncompressed 2D files written from now on, computed by reading the data back when the file is closed
+        static void setWriteStatistics(const bool& enabled);
+        static bool getWriteStatistics();
+        
         class ReadImplInterface
         {
         public:
             virtual void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const = 0;
             virtual void getColumn(float* dataOut, const int64_t& index) const = 0;
+            virtual const float* getRowPointer(const std::vector<int64_t>&) const { return NULL; }
             virtual bool isInMemory() const { return false; }
             virtual ~ReadImplInterface();
         };
@@ -118,7 +135,12 @@ namespace caret
         int16_t m_writingDataType;
         double m_minScalingVal, m_maxScalingVal;
         bool m_xmlBroken;//sentinel for forgetMapping hack
+        mutable std::vector<char> m_statisticsBytes;//statistics extension of the opened file, until it is parsed
+        mutable CaretPointer<CiftiStatisticsExtension> m_statistics;
+        mutable bool m_statisticsParsed;
+        static bool s_writeStatistics;
         
+        void dropStoredStatistics();
         void verifyWriteImpl();
         static void copyImplData(const ReadImplInterface* from, WriteImplInterface* to, const std::vector<int64_t>& dims);
     };
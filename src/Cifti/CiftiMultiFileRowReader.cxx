@@ -0,0 +1,180 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiMultiFileRowReader.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+#include "CiftiFile.h"
+#include "FileInformation.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+
+using namespace std;
+using namespace caret;
+
+class CiftiMultiFileRowReader::ReadTask : public QRunnable
+{
+    CiftiMultiFileRowReader* m_reader;
+    shared_ptr<PendingBlock> m_pending;
+public:
+    ReadTask(CiftiMultiFileRowReader* reader, const shared_ptr<PendingBlock>& pending) : m_reader(reader), m_pending(pending) { }
+    void run()
+    {
+        exception_ptr exPtr;
+        try
+        {
+            QMutexLocker fileLocker(m_reader->m_fileMutexes[m_pending->m_block->m_fileIndex].get());
+            m_reader->readBlock(m_pending->m_block.get());
+        } catch (...) {
+            exPtr = current_exception();//rethrown on the thread that requests this block
+        }
+        QMutexLocker locker(&(m_reader->m_mutex));
+        m_pending->m_exception = exPtr;
+        m_pending->m_done = true;
+        m_reader->m_blockDoneCondition.wakeAll();
+    }
+};
+
+CiftiMultiFileRowReader::CiftiMultiFileRowReader(const vector<const CiftiFile*>& inputFiles, const vector<int64_t>& rowDims, const int64_t& chunkRows, const int& blocksAhead)
+: m_inputFiles(inputFiles), m_rowDims(rowDims), m_chunkRows(chunkRows)
+{
+    CaretAssert(chunkRows > 0);
+    m_numRows = 1;
+    for (size_t i = 0; i < m_rowDims.size(); ++i)
+    {
+        m_numRows *= m_rowDims[i];
+    }
+    m_numChunks = (m_numRows - 1) / m_chunkRows + 1;
+    if (m_numRows < 1) m_numChunks = 0;
+    m_numBlocks = m_numChunks * int64_t(m_inputFiles.size());
+    m_nextBlockToSchedule = 0;
+    m_nextBlockToReturn = 0;
+    m_blocksAhead = blocksAhead;
+    if (m_blocksAhead < 0) m_blocksAhead = getDefaultBlocksAhead();
+    for (size_t i = 0; i < m_inputFiles.size(); ++i)
+    {
+        CaretAssert(m_inputFiles[i] != NULL);
+        //reading ahead is moot for data already in memory, and remote files are read through an http manager that belongs to this thread
+        if (m_inputFiles[i]->isInMemory() || FileInformation(m_inputFiles[i]->getFileName()).isRemoteFile())
+        {
+            m_blocksAhead = 0;
+        }
+        m_fileMutexes.push_back(unique_ptr<QMutex>(new QMutex()));
+    }
+    if (m_blocksAhead > 0)
+    {//more threads than files would only wait on the file mutexes
+        m_threadPool.setMaxThreadCount(max(1, min(m_blocksAhead, int(m_inputFiles.size()))));
+    }
+}
+
+CiftiMultiFileRowReader::~CiftiMultiFileRowReader()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_threadPool.clear();//don't start reading blocks nobody will ask for
+    }
+    m_threadPool.waitForDone();
+}
+
+int CiftiMultiFileRowReader::getDefaultBlocksAhead()
+{
+    return min(8, max(2, QThread::idealThreadCount()));
+}
+
+shared_ptr<const CiftiMultiFileRowReader::Block> CiftiMultiFileRowReader::nextBlock()
+{
+    if (m_nextBlockToReturn >= m_numBlocks)
+    {
+        CaretAssert(false);
+        throw CaretException("tried to read past the last block of cifti rows");
+    }
+    if (m_blocksAhead == 0)
+    {
+        shared_ptr<Block> ret = createBlock(m_nextBlockToReturn);
+        readBlock(ret.get());
+        ++m_nextBlockToReturn;
+        return ret;
+    }
+    QMutexLocker locker(&m_mutex);
+    scheduleBlocks();
+    CaretAssert(!m_pending.empty());
+    shared_ptr<PendingBlock> front = m_pending.front();
+    while (!front->m_done)
+    {
+        m_blockDoneCondition.wait(&m_mutex);
+    }
+    m_pending.pop_front();
+    ++m_nextBlockToReturn;
+    scheduleBlocks();//start reading a block to replace this one before returning it
+    if (front->m_exception)
+    {
+        rethrow_exception(front->m_exception);
+    }
+    return front->m_block;
+}
+
+void CiftiMultiFileRowReader::scheduleBlocks()
+{
+    while (int(m_pending.size()) < m_blocksAhead && m_nextBlockToSchedule < m_numBlocks)
+    {
+        shared_ptr<PendingBlock> pending(new PendingBlock());
+        pending->m_block = createBlock(m_nextBlockToSchedule);
+        ++m_nextBlockToSchedule;
+        m_pending.push_back(pending);
+        m_threadPool.start(new ReadTask(this, pending));//blocks of different files are read concurrently
+    }
+}
+
+shared_ptr<CiftiMultiFileRowReader::Block> CiftiMultiFileRowReader::createBlock(const int64_t& blockIndex) const
+{
+    CaretAssert(blockIndex >= 0 && blockIndex < m_numBlocks);
+    shared_ptr<Block> ret(new Block());
+    ret->m_chunkIndex = blockIndex / int64_t(m_inputFiles.size());
+    ret->m_fileIndex = blockIndex % int64_t(m_inputFiles.size());
+    ret->m_firstRow = ret->m_chunkIndex * m_chunkRows;
+    ret->m_numRows = min(m_chunkRows, m_numRows - ret->m_firstRow);
+    ret->m_rowLength = m_inputFiles[ret->m_fileIndex]->getDimensions()[0];
+    ret->m_data.resize(ret->m_numRows * ret->m_rowLength);
+    return ret;
+}
+
+void CiftiMultiFileRowReader::readBlock(Block* block) const
+{
+    const CiftiFile* thisFile = m_inputFiles[block->m_fileIndex];
+    int64_t numSelectDims = int64_t(thisFile->getDimensions().size()) - 1;//deal with files that are missing a dimension
+    CaretAssert(numSelectDims <= int64_t(m_rowDims.size()));
+    vector<int64_t> rowSelect(m_rowDims.size());
+    for (int64_t j = 0; j < block->m_numRows; ++j)
+    {
+        int64_t remainder = block->m_firstRow + j;//same order as MultiDimIterator, first dimension changes fastest
+        for (size_t d = 0; d < m_rowDims.size(); ++d)
+        {
+            rowSelect[d] = remainder % m_rowDims[d];
+            remainder /= m_rowDims[d];
+        }
+        vector<int64_t> fileSelect(rowSelect.begin(), rowSelect.begin() + numSelectDims);
+        thisFile->getRow(block->m_data.data() + j * block->m_rowLength, fileSelect);
+    }
+}
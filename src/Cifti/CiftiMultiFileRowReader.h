@@ -0,0 +1,96 @@
+#ifndef __CIFTI_MULTI_FILE_ROW_READER_H__
+#define __CIFTI_MULTI_FILE_ROW_READER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <deque>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "stdint.h"
+
+namespace caret
+{
+
+    class CiftiFile;
+
+    ///reads the same chunk of rows from each of several cifti files, in chunk-major, file-minor order, while reading the next blocks on worker threads
+    class CiftiMultiFileRowReader
+    {
+    public:
+        ///the rows of one chunk from one file
+        struct Block
+        {
+            int64_t m_chunkIndex, m_fileIndex, m_firstRow, m_numRows, m_rowLength;
+            std::vector<float> m_data;
+            const float* getRow(const int64_t& rowInBlock) const { return m_data.data() + rowInBlock * m_rowLength; }
+        };
+
+        ///rowDims are the dimensions after the first (row length) dimension, files with fewer dimensions use only the leading row indices
+        ///blocksAhead is how many blocks may be read before they are requested, 0 reads each block on the calling thread when requested, negative uses the default
+        CiftiMultiFileRowReader(const std::vector<const CiftiFile*>& inputFiles, const std::vector<int64_t>& rowDims, const int64_t& chunkRows, const int& blocksAhead = -1);
+        ~CiftiMultiFileRowReader();
+
+        ///blocks until the next block is read, rethrows any exception from reading it
+        std::shared_ptr<const Block> nextBlock();
+
+        int64_t getNumberOfRows() const { return m_numRows; }
+        int64_t getNumberOfChunks() const { return m_numChunks; }
+        int getBlocksAhead() const { return m_blocksAhead; }
+
+        ///enough to keep reading from several files while the caller computes on the current block
+        static int getDefaultBlocksAhead();
+    private:
+        CiftiMultiFileRowReader(const CiftiMultiFileRowReader&);
+        CiftiMultiFileRowReader& operator=(const CiftiMultiFileRowReader&);
+
+        struct PendingBlock
+        {
+            std::shared_ptr<Block> m_block;
+            bool m_done;
+            std::exception_ptr m_exception;
+            PendingBlock() : m_done(false) { }
+        };
+        class ReadTask;
+
+        void scheduleBlocks();//must be called with m_mutex locked
+        void readBlock(Block* block) const;
+        std::shared_ptr<Block> createBlock(const int64_t& blockIndex) const;
+
+        std::vector<const CiftiFile*> m_inputFiles;
+        std::vector<int64_t> m_rowDims;
+        int64_t m_chunkRows, m_numRows, m_numChunks, m_numBlocks, m_nextBlockToSchedule, m_nextBlockToReturn;
+        int m_blocksAhead;
+        std::deque<std::shared_ptr<PendingBlock> > m_pending;//in order of blocks, front is the next to return
+        std::vector<std::unique_ptr<QMutex> > m_fileMutexes;//a cifti file must not be read by two threads at once
+        QMutex m_mutex;
+        QWaitCondition m_blockDoneCondition;
+        QThreadPool m_threadPool;
+    };
+
+}
+
+#endif //__CIFTI_MULTI_FILE_ROW_READER_H__
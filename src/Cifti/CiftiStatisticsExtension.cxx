@@ -0,0 +1,593 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiStatisticsExtension.h"
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "DataFileException.h"
+#include "NiftiHeader.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include "zlib.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace caret;
+using namespace std;
+
+const int32_t CiftiStatisticsExtension::NIFTI_ECODE_WORKBENCH_STATISTICS = 31;//unregistered, next to NIFTI_ECODE_CARET, all registered codes are even
+const int CiftiStatisticsExtension::NUM_DISPLAY_BUCKETS = 100;//default of CaretMappableDataFile::getFileHistogramNumberOfBuckets()
+const int CiftiStatisticsExtension::NUM_MAP_PERCENTILE_BUCKETS = 100;
+const int64_t CiftiStatisticsExtension::MAX_MAP_SUMMARIES = 10000;//about 3.5KB each
+
+namespace
+{
+    const char STATISTICS_MAGIC[8] = { 'W', 'B', 'S', 'T', 'A', 'T', 'S', '2' };
+    const int64_t FINGERPRINT_SIZE = 4 + 3 * 8 + 2 * 4;//datatype, scaling, data offset, row checks
+    const int64_t HEADER_SIZE = 8 + 2 * 8 + 2 * 4 + FINGERPRINT_SIZE;//magic, dims, computed flag, number of map summaries, fingerprint
+    const int64_t NUM_BUCKETS_PERCENTILE_HIST = 10000;//same as FastStatistics
+
+    //the streams use single precision for the summaries, but the scaling should compare exactly
+    void writeDouble(QDataStream& stream, const double& value)
+    {
+        quint64 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        stream << bits;
+    }
+
+    void readDouble(QDataStream& stream, double& valueOut)
+    {
+        quint64 bits = 0;
+        stream >> bits;
+        memcpy(&valueOut, &bits, sizeof(bits));
+    }
+
+    int64_t getHistogramSize(const int& numBuckets)
+    {
+        return 4 + 2 * 4 + 6 * 8 + numBuckets * 8;//number of buckets, range, class counts, bucket counts
+    }
+
+    //collects what Histogram::update() would from one class of values, a pass for the range, then a pass for the buckets
+    struct HistogramAccumulator
+    {
+        float m_min, m_max, m_bucketSize;
+        int64_t m_count;
+        vector<int64_t> m_buckets;
+        HistogramAccumulator()
+        {
+            m_min = 0.0f;
+            m_max = 0.0f;
+            m_bucketSize = 0.0f;
+            m_count = 0;
+        }
+        void observe(const float& value)
+        {
+            if (m_count == 0)
+            {
+                m_min = value;
+                m_max = value;
+            } else {
+                if (value > m_max)
+                {
+                    m_max = value;
+                } else if (value < m_min) {
+                    m_min = value;
+                }
+            }
+            ++m_count;
+        }
+        void startBinning(const int& numBuckets)
+        {
+            m_buckets.assign(numBuckets, 0);
+            m_bucketSize = (m_max - m_min) / numBuckets;
+        }
+        void bin(const float& value)
+        {
+            if (m_max == m_min) return;//zero range gets split evenly in finish()
+            int bucket = (int)((value - m_min) / m_bucketSize);
+            if (bucket < 0) bucket = 0;
+            if (bucket >= (int)m_buckets.size()) bucket = (int)m_buckets.size() - 1;
+            ++m_buckets[bucket];
+        }
+        void finish(Histogram& histOut, const int64_t& posCount, const int64_t& zeroCount, const int64_t& negCount,
+                    const int64_t& infCount, const int64_t& negInfCount, const int64_t& nanCount)
+        {
+            int numBuckets = (int)m_buckets.size();
+            if (m_count > 0 && m_max == m_min)
+            {//same as Histogram
+                int64_t previous = 0;
+                for (int i = 0; i < numBuckets - 1; ++i)
+                {
+                    int64_t cumulative = (i + 1) * m_count / numBuckets;
+                    m_buckets[i] = cumulative - previous;
+                    previous = cumulative;
+                }
+                m_buckets[numBuckets - 1] = m_count - previous;
+            }
+            histOut.setHistogram(m_buckets, m_min, m_max, posCount, zeroCount, negCount, infCount, negInfCount, nanCount);
+        }
+    };
+
+    void writeHistogram(QDataStream& stream, const Histogram& hist)
+    {
+        const vector<int64_t>& counts = hist.getHistogramCounts();
+        float histMin, histMax;
+        hist.getRange(histMin, histMax);
+        int64_t posCount, zeroCount, negCount, infCount, negInfCount, nanCount;
+        hist.getCounts(posCount, zeroCount, negCount, infCount, negInfCount, nanCount);
+        stream << (qint32)counts.size() << histMin << histMax;
+        stream << (qint64)posCount << (qint64)zeroCount << (qint64)negCount << (qint64)infCount << (qint64)negInfCount << (qint64)nanCount;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            stream << (qint64)counts[i];
+        }
+    }
+
+    bool readHistogram(QDataStream& stream, const int& expectedBuckets, Histogram& histOut)
+    {
+        qint32 numBuckets = -1;
+        float histMin = 0.0f, histMax = 0.0f;
+        qint64 classCounts[6];
+        stream >> numBuckets >> histMin >> histMax;
+        for (int i = 0; i < 6; ++i)
+        {
+            stream >> classCounts[i];
+        }
+        if (stream.status() != QDataStream::Ok || numBuckets != expectedBuckets) return false;
+        vector<int64_t> counts(numBuckets);
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            qint64 temp;
+            stream >> temp;
+            counts[i] = temp;
+        }
+        if (stream.status() != QDataStream::Ok) return false;
+        histOut.setHistogram(counts, histMin, histMax, classCounts[0], classCounts[1], classCounts[2], classCounts[3], classCounts[4], classCounts[5]);
+        return true;
+    }
+}
+
+//the same classification and arithmetic as FastStatistics::update(), so the results match it
+struct CiftiStatisticsExtension::SummaryAccumulator
+{
+    HistogramAccumulator m_pos, m_neg, m_abs, m_all;//m_all is all finite values, for the display histogram and the min and max
+    int64_t m_zeroCount, m_infCount, m_negInfCount, m_nanCount;
+    double m_sum, m_sum2;
+    float m_mean;
+    SummaryAccumulator()
+    {
+        m_zeroCount = 0;
+        m_infCount = 0;
+        m_negInfCount = 0;
+        m_nanCount = 0;
+        m_sum = 0.0;
+        m_sum2 = 0.0;
+        m_mean = 0.0f;
+    }
+    void firstPass(const float& value)
+    {
+        if (value != value)
+        {
+            ++m_nanCount;
+            return;
+        }
+        if (value == 0.0f)
+        {
+            ++m_zeroCount;
+        } else if (value * 2.0f == value) {
+            if (value < 0.0f)
+            {
+                ++m_negInfCount;
+            } else {
+                ++m_infCount;
+            }
+            return;
+        } else if (value < 0.0f) {
+            m_neg.observe(value);
+            m_abs.observe(-value);
+        } else {
+            m_pos.observe(value);
+            m_abs.observe(value);
+        }
+        m_all.observe(value);
+        m_sum += value;
+    }
+    void startSecondPass(const int& percentileBuckets)
+    {
+        m_mean = m_sum / m_all.m_count;//NaN when there are no finite values, like FastStatistics
+        m_pos.startBinning(percentileBuckets);
+        m_neg.startBinning(percentileBuckets);
+        m_abs.startBinning(percentileBuckets);
+        m_all.startBinning(NUM_DISPLAY_BUCKETS);
+    }
+    void secondPass(const float& value)
+    {
+        if (value != value) return;
+        if (value != 0.0f && value * 2.0f == value) return;
+        float tempf = value - m_mean;
+        m_sum2 += tempf * tempf;
+        if (value < 0.0f)
+        {
+            m_neg.bin(value);
+            m_abs.bin(-value);
+        } else if (value > 0.0f) {
+            m_pos.bin(value);
+            m_abs.bin(value);
+        }
+        m_all.bin(value);
+    }
+    void finish(Summary& summaryOut)
+    {
+        int64_t totalGood = m_all.m_count;
+        summaryOut.m_min = m_all.m_min;
+        summaryOut.m_max = m_all.m_max;
+        summaryOut.m_mean = m_mean;
+        summaryOut.m_stdDevPop = 0.0f;
+        summaryOut.m_stdDevSample = 0.0f;
+        if (totalGood > 0)
+        {
+            summaryOut.m_stdDevPop = sqrt(m_sum2 / totalGood);
+            if (totalGood > 1)
+            {
+                summaryOut.m_stdDevSample = sqrt(m_sum2 / (totalGood - 1));
+            }
+        }
+        summaryOut.m_zeroCount = m_zeroCount;
+        summaryOut.m_infCount = m_infCount;
+        summaryOut.m_negInfCount = m_negInfCount;
+        summaryOut.m_nanCount = m_nanCount;
+        m_pos.finish(summaryOut.m_posPercentHist, m_pos.m_count, 0, 0, 0, 0, 0);
+        m_neg.finish(summaryOut.m_negPercentHist, 0, 0, m_neg.m_count, 0, 0, 0);
+        m_abs.finish(summaryOut.m_absPercentHist, m_abs.m_count, 0, 0, 0, 0, 0);
+        m_all.finish(summaryOut.m_displayHist, m_pos.m_count, m_zeroCount, m_neg.m_count, m_infCount, m_negInfCount, m_nanCount);
+    }
+};
+
+CiftiStatisticsExtension::DataFingerprint::DataFingerprint()
+{
+    m_datatype = 0;
+    m_sclSlope = 0.0;
+    m_sclInter = 0.0;
+    m_dataOffset = 0;
+    m_firstRowCheck = 0;
+    m_lastRowCheck = 0;
+}
+
+void CiftiStatisticsExtension::DataFingerprint::setFromHeader(const NiftiHeader& header)
+{
+    m_datatype = header.getDataType();
+    header.getDataScaling(m_sclSlope, m_sclInter);//sets 1 and 0 when there is no scaling
+    m_dataOffset = header.getDataOffset();
+}
+
+bool CiftiStatisticsExtension::DataFingerprint::sameHeaderFields(const DataFingerprint& rhs) const
+{
+    return m_datatype == rhs.m_datatype && m_sclSlope == rhs.m_sclSlope && m_sclInter == rhs.m_sclInter && m_dataOffset == rhs.m_dataOffset;
+}
+
+uint32_t CiftiStatisticsExtension::getRowCheck(const float* rowData, const int64_t& rowLength)
+{
+    const Bytef* bytes = (const Bytef*)rowData;
+    int64_t remaining = rowLength * (int64_t)sizeof(float);
+    const int64_t MAX_CHUNK = 1<<30;//crc32 takes a uInt length
+    uLong ret = crc32(0L, Z_NULL, 0);
+    while (remaining > 0)
+    {
+        uInt chunk = (uInt)min(MAX_CHUNK, remaining);
+        ret = crc32(ret, bytes, chunk);
+        bytes += chunk;
+        remaining -= chunk;
+    }
+    return (uint32_t)ret;
+}
+
+void CiftiStatisticsExtension::writeFingerprint(QDataStream& stream, const DataFingerprint& fingerprint)
+{
+    stream << (qint32)fingerprint.m_datatype;
+    writeDouble(stream, fingerprint.m_sclSlope);
+    writeDouble(stream, fingerprint.m_sclInter);
+    stream << (qint64)fingerprint.m_dataOffset << (quint32)fingerprint.m_firstRowCheck << (quint32)fingerprint.m_lastRowCheck;
+}
+
+bool CiftiStatisticsExtension::readPreamble(QDataStream& stream, int64_t& rowLengthOut, int64_t& numRowsOut, int32_t& computedOut, int32_t& numMapsOut, DataFingerprint& fingerprintOut)
+{
+    char magic[sizeof(STATISTICS_MAGIC)];
+    if (stream.readRawData(magic, sizeof(STATISTICS_MAGIC)) != (int)sizeof(STATISTICS_MAGIC) || memcmp(magic, STATISTICS_MAGIC, sizeof(STATISTICS_MAGIC)) != 0) return false;
+    qint64 rowLength = -1, numRows = -1, dataOffset = -1;
+    qint32 computed = 0, numMaps = -1, datatype = 0;
+    quint32 firstRowCheck = 0, lastRowCheck = 0;
+    stream >> rowLength >> numRows >> computed >> numMaps >> datatype;
+    readDouble(stream, fingerprintOut.m_sclSlope);
+    readDouble(stream, fingerprintOut.m_sclInter);
+    stream >> dataOffset >> firstRowCheck >> lastRowCheck;
+    if (stream.status() != QDataStream::Ok) return false;
+    rowLengthOut = rowLength;
+    numRowsOut = numRows;
+    computedOut = computed;
+    numMapsOut = numMaps;
+    fingerprintOut.m_datatype = datatype;
+    fingerprintOut.m_dataOffset = dataOffset;
+    fingerprintOut.m_firstRowCheck = firstRowCheck;
+    fingerprintOut.m_lastRowCheck = lastRowCheck;
+    return true;
+}
+
+bool CiftiStatisticsExtension::shouldStoreMapSummaries(const CiftiXML& xml)
+{
+    if (xml.getNumberOfDimensions() != 2) return false;
+    CiftiMappingType::MappingType rowType = xml.getMappingType(CiftiXML::ALONG_ROW);
+    if (rowType != CiftiMappingType::SCALARS && rowType != CiftiMappingType::SERIES) return false;
+    return xml.getDimensionLength(CiftiXML::ALONG_ROW) <= MAX_MAP_SUMMARIES;
+}
+
+int CiftiStatisticsExtension::getFilePercentileBuckets(const vector<int64_t>& dims)
+{
+    return (int)min(NUM_BUCKETS_PERCENTILE_HIST, dims[0] * dims[1]);
+}
+
+int CiftiStatisticsExtension::getMapPercentileBuckets(const vector<int64_t>& dims)
+{
+    return (int)min((int64_t)NUM_MAP_PERCENTILE_BUCKETS, dims[1]);
+}
+
+int64_t CiftiStatisticsExtension::getSummarySize(const int& percentileBuckets)
+{
+    return 5 * 4 + 4 * 8 + 3 * getHistogramSize(percentileBuckets) + getHistogramSize(NUM_DISPLAY_BUCKETS);
+}
+
+int64_t CiftiStatisticsExtension::getExtensionSize(const vector<int64_t>& dims, const bool& withMapSummaries)
+{
+    CaretAssert(dims.size() == 2);
+    int64_t ret = HEADER_SIZE + getSummarySize(getFilePercentileBuckets(dims));
+    if (withMapSummaries)
+    {
+        ret += dims[0] * getSummarySize(getMapPercentileBuckets(dims));
+    }
+    return ret;
+}
+
+vector<char> CiftiStatisticsExtension::makePlaceholder(const vector<int64_t>& dims, const bool& withMapSummaries)
+{
+    CaretAssert(dims.size() == 2);
+    vector<char> ret(getExtensionSize(dims, withMapSummaries), 0);
+    QByteArray headerBytes;
+    QDataStream stream(&headerBytes, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData(STATISTICS_MAGIC, sizeof(STATISTICS_MAGIC));
+    stream << (qint64)dims[0] << (qint64)dims[1] << (qint32)0 << (qint32)(withMapSummaries ? dims[0] : 0);//not computed
+    writeFingerprint(stream, DataFingerprint());
+    CaretAssert(headerBytes.size() == HEADER_SIZE);
+    memcpy(ret.data(), headerBytes.constData(), headerBytes.size());
+    return ret;
+}
+
+void CiftiStatisticsExtension::compute(const CiftiFile::ReadImplInterface* data, const vector<int64_t>& dims, const bool& withMapSummaries, const NiftiHeader& header)
+{
+    CaretAssert(dims.size() == 2);
+    int64_t rowLength = dims[0], numRows = dims[1];
+    DataFingerprint fingerprint;
+    fingerprint.setFromHeader(header);
+    SummaryAccumulator fileAccum;
+    vector<SummaryAccumulator> mapAccums;
+    if (withMapSummaries) mapAccums.resize(rowLength);
+    vector<float> scratchRow(rowLength);
+    vector<int64_t> indexSelect(1);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+        {
+            fileAccum.startSecondPass(getFilePercentileBuckets(dims));
+            for (size_t j = 0; j < mapAccums.size(); ++j)
+            {
+                mapAccums[j].startSecondPass(getMapPercentileBuckets(dims));
+            }
+        }
+        for (int64_t row = 0; row < numRows; ++row)
+        {
+            indexSelect[0] = row;
+            const float* rowData = data->getRowPointer(indexSelect);
+            if (rowData == NULL)
+            {
+                data->getRow(scratchRow.data(), indexSelect, false);
+                rowData = scratchRow.data();
+            }
+            if (pass == 0)
+            {
+                if (row == 0) fingerprint.m_firstRowCheck = getRowCheck(rowData, rowLength);
+                if (row == numRows - 1) fingerprint.m_lastRowCheck = getRowCheck(rowData, rowLength);
+            }
+            for (int64_t j = 0; j < rowLength; ++j)
+            {
+                if (pass == 0)
+                {
+                    fileAccum.firstPass(rowData[j]);
+                } else {
+                    fileAccum.secondPass(rowData[j]);
+                }
+            }
+            for (size_t j = 0; j < mapAccums.size(); ++j)
+            {
+                if (pass == 0)
+                {
+                    mapAccums[j].firstPass(rowData[j]);
+                } else {
+                    mapAccums[j].secondPass(rowData[j]);
+                }
+            }
+        }
+    }
+    m_dims = dims;
+    m_fingerprint = fingerprint;
+    fileAccum.finish(m_fileSummary);
+    m_mapSummaries.resize(mapAccums.size());
+    for (size_t j = 0; j < mapAccums.size(); ++j)
+    {
+        mapAccums[j].finish(m_mapSummaries[j]);
+    }
+}
+
+void CiftiStatisticsExtension::writeSummary(QDataStream& stream, const Summary& summary)
+{
+    stream << summary.m_min << summary.m_max << summary.m_mean << summary.m_stdDevPop << summary.m_stdDevSample;
+    stream << (qint64)summary.m_zeroCount << (qint64)summary.m_infCount << (qint64)summary.m_negInfCount << (qint64)summary.m_nanCount;
+    writeHistogram(stream, summary.m_posPercentHist);
+    writeHistogram(stream, summary.m_negPercentHist);
+    writeHistogram(stream, summary.m_absPercentHist);
+    writeHistogram(stream, summary.m_displayHist);
+}
+
+bool CiftiStatisticsExtension::readSummary(QDataStream& stream, const int& percentileBuckets, Summary& summaryOut)
+{
+    qint64 counts[4];
+    stream >> summaryOut.m_min >> summaryOut.m_max >> summaryOut.m_mean >> summaryOut.m_stdDevPop >> summaryOut.m_stdDevSample;
+    stream >> counts[0] >> counts[1] >> counts[2] >> counts[3];
+    if (stream.status() != QDataStream::Ok) return false;
+    summaryOut.m_zeroCount = counts[0];
+    summaryOut.m_infCount = counts[1];
+    summaryOut.m_negInfCount = counts[2];
+    summaryOut.m_nanCount = counts[3];
+    if (!readHistogram(stream, percentileBuckets, summaryOut.m_posPercentHist)) return false;
+    if (!readHistogram(stream, percentileBuckets, summaryOut.m_negPercentHist)) return false;
+    if (!readHistogram(stream, percentileBuckets, summaryOut.m_absPercentHist)) return false;
+    return readHistogram(stream, NUM_DISPLAY_BUCKETS, summaryOut.m_displayHist);
+}
+
+void CiftiStatisticsExtension::writeToBytes(vector<char>& bytesOut) const
+{
+    CaretAssert(m_dims.size() == 2);
+    QByteArray outBytes;
+    QDataStream stream(&outBytes, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream.writeRawData(STATISTICS_MAGIC, sizeof(STATISTICS_MAGIC));
+    stream << (qint64)m_dims[0] << (qint64)m_dims[1] << (qint32)1 << (qint32)m_mapSummaries.size();
+    writeFingerprint(stream, m_fingerprint);
+    writeSummary(stream, m_fileSummary);
+    for (size_t i = 0; i < m_mapSummaries.size(); ++i)
+    {
+        writeSummary(stream, m_mapSummaries[i]);
+    }
+    CaretAssert(outBytes.size() == getExtensionSize(m_dims, !m_mapSummaries.empty()));
+    bytesOut.assign(outBytes.constData(), outBytes.constData() + outBytes.size());
+}
+
+bool CiftiStatisticsExtension::matchesHeader(const vector<char>& bytes, const NiftiHeader& header)
+{
+    QByteArray inBytes = QByteArray::fromRawData(bytes.data(), (int)bytes.size());//extensions are under 2GB
+    QDataStream stream(inBytes);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    int64_t rowLength, numRows;
+    int32_t computed, numMaps;
+    DataFingerprint stored, current;
+    if (!readPreamble(stream, rowLength, numRows, computed, numMaps, stored) || computed == 0) return true;//let readFromBytes reject it
+    current.setFromHeader(header);
+    if (!stored.sameHeaderFields(current))
+    {
+        CaretLogWarning("ignoring statistics extension in cifti file, the datatype, scaling, or data offset has changed since it was written");
+        return false;
+    }
+    return true;
+}
+
+bool CiftiStatisticsExtension::readFromBytes(const vector<char>& bytes, const vector<int64_t>& dims, const CiftiFile::ReadImplInterface* data)
+{
+    if (dims.size() != 2 || data == NULL) return false;
+    QByteArray inBytes = QByteArray::fromRawData(bytes.data(), (int)bytes.size());//extensions are under 2GB
+    QDataStream stream(inBytes);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    int64_t rowLength = -1, numRows = -1;
+    int32_t computed = 0, numMaps = -1;
+    DataFingerprint fingerprint;
+    if (!readPreamble(stream, rowLength, numRows, computed, numMaps, fingerprint))
+    {
+        CaretLogWarning("ignoring unrecognized statistics extension in cifti file");
+        return false;
+    }
+    if (computed == 0) return false;//placeholder, the writer didn't finish
+    if (rowLength != dims[0] || numRows != dims[1])
+    {
+        CaretLogWarning("ignoring statistics extension in cifti file, its dimensions don't match the data");
+        return false;
+    }
+    try
+    {//only the end rows, rereading everything would defeat the purpose
+        vector<float> scratchRow(rowLength);
+        vector<int64_t> indexSelect(1, 0);
+        data->getRow(scratchRow.data(), indexSelect, false);
+        bool changed = (getRowCheck(scratchRow.data(), rowLength) != fingerprint.m_firstRowCheck);
+        indexSelect[0] = numRows - 1;
+        data->getRow(scratchRow.data(), indexSelect, false);
+        changed = changed || (getRowCheck(scratchRow.data(), rowLength) != fingerprint.m_lastRowCheck);
+        if (changed)
+        {
+            CaretLogWarning("ignoring statistics extension in cifti file, the data has changed since it was written");
+            return false;
+        }
+    } catch (DataFileException& e) {
+        CaretLogWarning("ignoring statistics extension in cifti file, unable to check the data: " + e.whatString());
+        return false;
+    }
+    if (numMaps != 0 && numMaps != rowLength)
+    {
+        CaretLogWarning("ignoring corrupted statistics extension in cifti file");
+        return false;
+    }
+    Summary fileSummary;
+    vector<Summary> mapSummaries(numMaps);
+    bool ok = readSummary(stream, getFilePercentileBuckets(dims), fileSummary);
+    for (qint32 i = 0; ok && i < numMaps; ++i)
+    {
+        ok = readSummary(stream, getMapPercentileBuckets(dims), mapSummaries[i]);
+    }
+    if (!ok)
+    {
+        CaretLogWarning("ignoring corrupted statistics extension in cifti file");
+        return false;
+    }
+    m_dims = dims;
+    m_fingerprint = fingerprint;
+    m_fileSummary = fileSummary;
+    m_mapSummaries.swap(mapSummaries);
+    return true;
+}
+
+void CiftiStatisticsExtension::makeStatistics(const Summary& summary, FastStatistics& statsOut)
+{
+    statsOut.setStatistics(summary.m_min, summary.m_max, summary.m_mean, summary.m_stdDevPop, summary.m_stdDevSample,
+                           summary.m_zeroCount, summary.m_infCount, summary.m_negInfCount, summary.m_nanCount,
+                           summary.m_posPercentHist, summary.m_negPercentHist, summary.m_absPercentHist);
+}
+
+void CiftiStatisticsExtension::getMapStatistics(const int64_t& map, FastStatistics& statsOut) const
+{
+    CaretAssertVectorIndex(m_mapSummaries, map);
+    makeStatistics(m_mapSummaries[map], statsOut);
+}
+
+const Histogram& CiftiStatisticsExtension::getMapHistogram(const int64_t& map) const
+{
+    CaretAssertVectorIndex(m_mapSummaries, map);
+    return m_mapSummaries[map].m_displayHist;
+}
@@ -0,0 +1,117 @@
+#ifndef __CIFTI_STATISTICS_EXTENSION_H__
+#define __CIFTI_STATISTICS_EXTENSION_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiFile.h"
+#include "FastStatistics.h"
+#include "Histogram.h"
+
+#include "stdint.h"
+#include <vector>
+
+class QDataStream;
+
+namespace caret
+{
+
+    class NiftiHeader;
+
+    ///file-wide and per-map summaries of a 2D cifti matrix, stored in a NIfTI extension by the writer so that readers don't need a pass over all of the data
+    ///they are what FastStatistics and a display Histogram would compute from the same data, except that the percentile histograms of single maps are coarse
+    class CiftiStatisticsExtension
+    {
+        struct Summary
+        {
+            float m_min, m_max, m_mean, m_stdDevPop, m_stdDevSample;
+            int64_t m_zeroCount, m_infCount, m_negInfCount, m_nanCount;
+            Histogram m_posPercentHist, m_negPercentHist, m_absPercentHist, m_displayHist;
+        };
+        struct DataFingerprint
+        {//cheap to check, catches other programs rewriting the header scaling or the data without updating the extension
+            int32_t m_datatype;
+            double m_sclSlope, m_sclInter;
+            int64_t m_dataOffset;
+            uint32_t m_firstRowCheck, m_lastRowCheck;//crc32 of the values as read, in native byte order
+            DataFingerprint();
+            void setFromHeader(const NiftiHeader& header);
+            bool sameHeaderFields(const DataFingerprint& rhs) const;
+        };
+        std::vector<int64_t> m_dims;
+        DataFingerprint m_fingerprint;
+        Summary m_fileSummary;
+        std::vector<Summary> m_mapSummaries;//maps are columns, empty if the writer didn't store them
+
+        static int64_t getSummarySize(const int& percentileBuckets);
+        static int getFilePercentileBuckets(const std::vector<int64_t>& dims);
+        static int getMapPercentileBuckets(const std::vector<int64_t>& dims);
+        struct SummaryAccumulator;//defined in the .cxx
+
+        static uint32_t getRowCheck(const float* rowData, const int64_t& rowLength);
+        static void writeFingerprint(QDataStream& stream, const DataFingerprint& fingerprint);
+        static bool readPreamble(QDataStream& stream, int64_t& rowLengthOut, int64_t& numRowsOut, int32_t& computedOut, int32_t& numMapsOut, DataFingerprint& fingerprintOut);
+        static void makeStatistics(const Summary& summary, FastStatistics& statsOut);
+        static void writeSummary(QDataStream& stream, const Summary& summary);
+        static bool readSummary(QDataStream& stream, const int& percentileBuckets, Summary& summaryOut);
+    public:
+        static const int32_t NIFTI_ECODE_WORKBENCH_STATISTICS;
+        static const int NUM_DISPLAY_BUCKETS;
+        static const int NUM_MAP_PERCENTILE_BUCKETS;
+        static const int64_t MAX_MAP_SUMMARIES;
+
+        ///whether a writer should store per-map summaries for this xml: 2D, with scalar or series maps along the row, and not too many of them
+        static bool shouldStoreMapSummaries(const CiftiXML& xml);
+
+        ///bytes the extension needs, so that space can be reserved in the header before the data is written
+        static int64_t getExtensionSize(const std::vector<int64_t>& dims, const bool& withMapSummaries);
+
+        ///extension contents for data that hasn't been summarized yet, readers ignore it
+        static std::vector<char> makePlaceholder(const std::vector<int64_t>& dims, const bool& withMapSummaries);
+
+        ///reads the rows of a 2D matrix twice, like FastStatistics does with its data, header is what the data was written with
+        void compute(const CiftiFile::ReadImplInterface* data, const std::vector<int64_t>& dims, const bool& withMapSummaries, const NiftiHeader& header);
+
+        void writeToBytes(std::vector<char>& bytesOut) const;
+
+        ///false when the header datatype, scaling, or data offset differ from when the extension was computed, placeholders pass, readFromBytes rejects them
+        static bool matchesHeader(const std::vector<char>& bytes, const NiftiHeader& header);
+
+        ///returns false for placeholders, extensions written for other dimensions, corrupted extensions, and when the first or last row of data has changed
+        ///does not check the header fields, see matchesHeader()
+        bool readFromBytes(const std::vector<char>& bytes, const std::vector<int64_t>& dims, const CiftiFile::ReadImplInterface* data);
+
+        void getFileStatistics(FastStatistics& statsOut) const { makeStatistics(m_fileSummary, statsOut); }
+
+        ///uses NUM_DISPLAY_BUCKETS
+        const Histogram& getFileHistogram() const { return m_fileSummary.m_displayHist; }
+
+        bool hasMapSummaries() const { return !m_mapSummaries.empty(); }
+
+        ///percentiles are interpolated from NUM_MAP_PERCENTILE_BUCKETS buckets rather than the up to 10000 FastStatistics uses
+        void getMapStatistics(const int64_t& map, FastStatistics& statsOut) const;
+
+        ///uses NUM_DISPLAY_BUCKETS
+        const Histogram& getMapHistogram(const int64_t& map) const;
+    };
+
+}
+
+#endif //__CIFTI_STATISTICS_EXTENSION_H__
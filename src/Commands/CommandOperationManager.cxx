@@ -177,6 +177,7 @@
 #include "OperationConvertWarpfield.h"
 #include "OperationEstimateFiberBinghams.h"
 #include "OperationFileConvert.h"
+#include "OperationFileGzipIndex.h"
 #include "OperationFileInformation.h"
 #include "OperationFociCreate.h"
 #include "OperationFociGetProjectionVertex.h"
@@ -232,6 +233,7 @@
 #include "OperationVolumeReorient.h"
 #include "OperationVolumeSetSpace.h"
 #include "OperationVolumeStats.h"
+#include "OperationVolumeToSurfaceApplyWeights.h"
 #include "OperationVolumeWeightedStats.h"
 #include "OperationWbsparseMergeDense.h"
 #include "OperationZipSceneFile.h"
@@ -251,9 +253,13 @@
 #include "CommandUnitTest.h"
 #include "ProgramParameters.h"
 
+#include "CaretBinaryFile.h"
 #include "CaretLogger.h"
+#include "CiftiFile.h"
 #include "dot_wrapper.h"
 #include "CaretCommandGlobalOptions.h"
+#include "GiftiFile.h"
+#include "SurfaceResamplingHelper.h"
 
 #include <iostream>
 #include <map>
@@ -441,6 +447,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoOperationConvertWarpfield()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationEstimateFiberBinghams()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationFileConvert()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationFileGzipIndex()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationFileInformation()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationFociCreate()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationFociGetProjectionVertex()));
@@ -493,6 +500,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeReorient()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeSetSpace()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeStats()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeToSurfaceApplyWeights()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeWeightedStats()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationWbsparseMergeDense()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationZipSceneFile()));
@@ -629,6 +637,29 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
     {
         caret_global_command_options.m_ciftiReadMemory = true;
     }
+    if (getGlobalOption(parameters, "-nifti-read-mmap", 0, globalOptionArgs))
+    {
+        caret_global_command_options.m_niftiReadMmap = true;
+    }
+    if (getGlobalOption(parameters, "-parallel-gzip", 0, globalOptionArgs))
+    {
+        CaretBinaryFile::setParallelCompression(true);
+    }
+    if (getGlobalOption(parameters, "-cifti-write-statistics", 0, globalOptionArgs))
+    {
+        CiftiFile::setWriteStatistics(true);
+    }
+    if (getGlobalOption(parameters, "-gifti-threads", 1, globalOptionArgs))
+    {
+        bool valid = false;
+        const int numThreads = globalOptionArgs[0].toInt(&valid);
+        if (!valid || numThreads < 1) throw CommandException("-gifti-threads requires a positive integer, got '" + globalOptionArgs[0] + "'");
+        GiftiFile::setMaximumDataArrayThreads(numThreads);
+    }
+    if (getGlobalOption(parameters, "-resample-weight-cache", 1, globalOptionArgs))
+    {
+        SurfaceResamplingHelper::setWeightCacheDirectory(globalOptionArgs[0]);
+    }
 
     const uint64_t numberOfCommands = this->commandOperations.size();
     const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
@@ -783,7 +814,20 @@ AString CommandOperationManager::doCompletion(ProgramParameters& parameters, con
         return "";
     }
     /*OptionInfo ciftiReadMemInfo = */parseGlobalOption(parameters, "-cifti-read-memory", 0, globalOptionArgs, true);
-    ret = "wordlist -disable-provenance\\ -logging\\ -simd\\ -cifti-output-datatype\\ -cifti-output-range\\ -nifti-output-datatype\\ -nifti-output-range\\ -cifti-read-memory";//we could prevent suggesting an already-provided global option, but that would be a bit surprising
+    /*OptionInfo niftiReadMmapInfo = */parseGlobalOption(parameters, "-nifti-read-mmap", 0, globalOptionArgs, true);
+    /*OptionInfo parallelGzipInfo = */parseGlobalOption(parameters, "-parallel-gzip", 0, globalOptionArgs, true);
+    /*OptionInfo ciftiWriteStatsInfo = */parseGlobalOption(parameters, "-cifti-write-statistics", 0, globalOptionArgs, true);
+    OptionInfo giftiThreadsInfo = parseGlobalOption(parameters, "-gifti-threads", 1, globalOptionArgs, true);
+    if (giftiThreadsInfo.specified && !giftiThreadsInfo.complete)
+    {
+        return "";
+    }
+    OptionInfo resampleCacheInfo = parseGlobalOption(parameters, "-resample-weight-cache", 1, globalOptionArgs, true);
+    if (resampleCacheInfo.specified && !resampleCacheInfo.complete)
+    {
+        return "fileglob */";//files never match with a trailing slash, the completion script adds directories
+    }
+    ret = "wordlist -disable-provenance\\ -logging\\ -simd\\ -cifti-output-datatype\\ -cifti-output-range\\ -nifti-output-datatype\\ -nifti-output-range\\ -cifti-read-memory\\ -nifti-read-mmap\\ -parallel-gzip\\ -cifti-write-statistics\\ -gifti-threads\\ -resample-weight-cache";//we could prevent suggesting an already-provided global option, but that would be a bit surprising
     const uint64_t numberOfCommands = this->commandOperations.size();
     const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
     if (!parameters.hasNext())
@@ -1182,6 +1226,32 @@ void CommandOperationManager::printGlobalOptions()
     cout << "                                        avoid hitting limits on number of open" << endl;
     cout << "                                        files" << endl;
     cout << endl;
+    cout << "   -nifti-read-mmap                  memory map uncompressed, native-endian" << endl;
+    cout << "                                        cifti and volume inputs, so that" << endl;
+    cout << "                                        processes reading the same file share" << endl;
+    cout << "                                        the OS page cache instead of copying," << endl;
+    cout << "                                        do not modify input files while in use" << endl;
+    cout << endl;
+    cout << "   -parallel-gzip                    compress .gz outputs using all threads," << endl;
+    cout << "                                        and decompress .gz inputs in a separate" << endl;
+    cout << "                                        read-ahead thread" << endl;
+    cout << endl;
+    cout << "   -cifti-write-statistics           store statistics and histograms of the" << endl;
+    cout << "                                        data in uncompressed 2D cifti outputs," << endl;
+    cout << "                                        so that wb_view doesn't need to read" << endl;
+    cout << "                                        all of the data to get them" << endl;
+    cout << endl;
+    cout << "   -gifti-threads <num>              use at most this many threads to compress" << endl;
+    cout << "                                        and decompress the data arrays of gifti" << endl;
+    cout << "                                        files (default and upper limit is the" << endl;
+    cout << "                                        OpenMP maximum, see -parallel-help)" << endl;
+    cout << endl;
+    cout << "   -resample-weight-cache <directory>" << endl;
+    cout << "                                     save surface resampling weights in the" << endl;
+    cout << "                                        directory, and reuse them when" << endl;
+    cout << "                                        resampling between the same spheres" << endl;
+    cout << "                                        (and areas and roi) again" << endl;
+    cout << endl;
     cout << "   -cifti-output-datatype <type>     deprecated, only affects cifti outputs" << endl;
     cout << "   -cifti-output-range <min> <max>   deprecated, only affects cifti outputs" << endl;
     cout << endl;
@@ -28,14 +28,28 @@
 #include "CaretAssert.h"
 #include "CaretBinaryFile.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "DataFileException.h"
+#include "GzipIndex.h"
 
 #include <QDir>
 #include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
 #include "zlib.h"
 
 #include <cstdio>
+#include <cstring>
 #include <algorithm>
+#include <deque>
+#include <vector>
+
+#ifndef CARET_OS_WINDOWS
+#include <cerrno>
+#include <unistd.h>
+#endif
 
 using namespace caret;
 using namespace std;
@@ -61,19 +75,120 @@ namespace caret
     };
     
     const int64_t ZFileImpl::CHUNK_SIZE = 1<<26;//64MiB, large enough for good performance, small enough for zlib, must convert to uint32
+    
+    //read-only gzip access using a GzipIndex, so that seeking backwards doesn't restart decompression from the beginning
+    class IndexedZFileImpl : public CaretBinaryFile::ImplInterface
+    {
+        CaretPointer<GzipIndex> m_index;
+        QFile m_file;
+        z_stream m_strm;
+        bool m_strmInit, m_rawMode;//raw mode is for restarting inside a deflate stream, gzip mode is for the header of a following gzip member
+        int64_t m_pos;
+        std::vector<unsigned char> m_inBuffer, m_skipBuffer;
+        const static int64_t CHUNK_SIZE;
+        bool refill();
+        void restartAt(const GzipIndex::AccessPoint& point);
+        bool nextMember();
+        int64_t decompress(unsigned char* dataOut, const int64_t& count);
+    public:
+        IndexedZFileImpl(const CaretPointer<GzipIndex>& index);
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);
+        int64_t pos() { return m_pos; }
+        int64_t size() { return m_index->getUncompressedSize(); }
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void write(const void* dataIn, const int64_t& count);
+        ~IndexedZFileImpl();
+    };
+    
+    const int64_t IndexedZFileImpl::CHUNK_SIZE = 1<<20;//1MiB of compressed input at a time, seeks usually only need a fraction of a span
+    
+    //write-only, compresses independent blocks on all threads and stitches them into a single gzip member, like pigz
+    class ParallelZWriteImpl : public CaretBinaryFile::ImplInterface
+    {
+        QFile m_file;
+        std::vector<unsigned char> m_pending;//uncompressed data waiting for a full batch
+        std::vector<unsigned char> m_dictionary;//last 32KiB of already compressed data, to prime the first block of the next batch
+        uLong m_crc;
+        int64_t m_pos;
+        int64_t m_batchSize;
+        const static int64_t BLOCK_SIZE;
+        void compressPending(const bool& last);
+    public:
+        ParallelZWriteImpl() { m_crc = 0; m_pos = 0; m_batchSize = 0; }
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);
+        int64_t pos() { return m_pos; }
+        int64_t size() { return -1; }
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void write(const void* dataIn, const int64_t& count);
+        ~ParallelZWriteImpl();
+    };
+    
+    const int64_t ParallelZWriteImpl::BLOCK_SIZE = 1<<20;//1MiB, the dictionary priming makes the ratio nearly identical to single-threaded gzwrite
+    
+    //read-only, runs gzread in another thread ahead of the caller, so decompression overlaps with whatever the caller does with the data
+    class ReadAheadZFileImpl : public CaretBinaryFile::ImplInterface
+    {
+        class DecompressThread : public QThread
+        {
+            ReadAheadZFileImpl* m_parent;
+        public:
+            DecompressThread(ReadAheadZFileImpl* parent) { m_parent = parent; }
+            void run() { m_parent->decompressLoop(); }
+        };
+        gzFile m_zfile;
+        CaretPointer<DecompressThread> m_thread;
+        QMutex m_mutex;//protects everything below that the thread touches
+        QWaitCondition m_chunkReady, m_chunkTaken;
+        std::deque<std::vector<char> > m_chunks;
+        bool m_stopRequested, m_finished, m_error;
+        std::vector<char> m_current;//only used by the caller's thread, so it can be copied from without the lock
+        int64_t m_currentUsed;
+        int64_t m_pos;
+        const static int64_t CHUNK_SIZE;
+        const static int MAX_CHUNKS;
+        void decompressLoop();
+        void startThread();
+        void stopThread();
+        int64_t consume(char* dataOut, const int64_t& count);//dataOut can be NULL to skip
+    public:
+        ReadAheadZFileImpl();
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);
+        int64_t pos() { return m_pos; }
+        int64_t size() { return -1; }
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void write(const void* dataIn, const int64_t& count);
+        ~ReadAheadZFileImpl();
+    };
+    
+    const int64_t ReadAheadZFileImpl::CHUNK_SIZE = 1<<23;//8MiB
+    const int ReadAheadZFileImpl::MAX_CHUNKS = 4;
 #endif //ZLIB_VERSION
 
     class QFileImpl : public CaretBinaryFile::ImplInterface
     {
         QFile m_file;
+        bool m_readOnly;//pread bypasses QFile's buffering, so only allow it when nothing can be waiting to be written
+        std::vector<uchar*> m_mappings;//unmapped on close
         const static int64_t CHUNK_SIZE;
     public:
+        QFileImpl() { m_readOnly = false; }
         void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
         void close();
         void seek(const int64_t& position);
         int64_t pos();
         int64_t size() { return m_file.size(); }
         void read(void* dataOut, const int64_t& count, int64_t* numRead);
+#ifndef CARET_OS_WINDOWS
+        bool supportsReadAt() { return m_readOnly && m_file.isOpen(); }
+        void readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead);
+#endif
+        const char* mapForRead(const int64_t& position, const int64_t& count);
         void write(const void* dataIn, const int64_t& count);
     };
     
@@ -84,11 +199,28 @@ CaretBinaryFile::ImplInterface::~ImplInterface()
 {
 }
 
+void CaretBinaryFile::ImplInterface::readAt(void*, const int64_t&, const int64_t&, int64_t*)
+{
+    throw DataFileException("positional reading is not supported for file '" + m_fileName + "'");//callers should check supportsReadAt() first
+}
+
+bool CaretBinaryFile::s_parallelCompression = false;
+
 CaretBinaryFile::CaretBinaryFile(const QString& filename, const OpenMode& fileMode)
 {
     open(filename, fileMode);
 }
 
+void CaretBinaryFile::setParallelCompression(const bool& enabled)
+{
+    s_parallelCompression = enabled;
+}
+
+bool CaretBinaryFile::getParallelCompression()
+{
+    return s_parallelCompression;
+}
+
 void CaretBinaryFile::close()
 {
     m_curMode = NONE;
@@ -120,7 +252,27 @@ void CaretBinaryFile::open(const QString& filename, const OpenMode& opmode)
     if (filename.endsWith(".gz"))
     {
 #ifdef ZLIB_VERSION
-        m_impl.grabNew(new ZFileImpl());
+        CaretPointer<GzipIndex> myIndex;
+        if (opmode == READ)
+        {//use a random access index if someone has built one (wb_command -file-gzip-index)
+            myIndex.grabNew(new GzipIndex());
+            if (!myIndex->readIndex(GzipIndex::getIndexFileName(filename), filename))
+            {
+                myIndex.grabNew(NULL);
+            }
+        } else {//any index for the old contents is wrong now
+            GzipIndex::removeIndexFile(filename);
+        }
+        if (myIndex != NULL)
+        {
+            m_impl.grabNew(new IndexedZFileImpl(myIndex));
+        } else if (s_parallelCompression && opmode == READ) {
+            m_impl.grabNew(new ReadAheadZFileImpl());
+        } else if (s_parallelCompression && opmode == WRITE_TRUNCATE) {
+            m_impl.grabNew(new ParallelZWriteImpl());
+        } else {
+            m_impl.grabNew(new ZFileImpl());
+        }
 #else //ZLIB_VERSION
         throw DataFileException("can't open .gz file '" + filename + "', compiled without zlib support");
 #endif //ZLIB_VERSION
@@ -138,6 +290,28 @@ void CaretBinaryFile::read(void* dataOut, const int64_t& count, int64_t* numRead
     m_impl->read(dataOut, count, numRead);
 }
 
+bool CaretBinaryFile::supportsReadAt()
+{
+    if (!getOpenForRead()) return false;
+    return m_impl->supportsReadAt();
+}
+
+void CaretBinaryFile::readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead)
+{
+    CaretAssert(position >= 0);
+    CaretAssert(count >= 0);
+    if (!getOpenForRead()) throw DataFileException("file is not open for reading");
+    m_impl->readAt(dataOut, position, count, numRead);
+}
+
+const char* CaretBinaryFile::mapForRead(const int64_t& position, const int64_t& count)
+{
+    CaretAssert(position >= 0);
+    if (!getOpenForRead()) throw DataFileException("file is not open for reading");
+    if (count <= 0) return NULL;
+    return m_impl->mapForRead(position, count);
+}
+
 void CaretBinaryFile::seek(const int64_t& position)
 {
     CaretAssert(position >= 0);
@@ -283,12 +457,491 @@ ZFileImpl::~ZFileImpl()
         CaretLogSevere("caught unknown exception type while closing a compressed file");
     }
 }
+
+IndexedZFileImpl::IndexedZFileImpl(const CaretPointer<GzipIndex>& index)
+{
+    CaretAssert(index != NULL && index->getNumberOfAccessPoints() > 0);
+    m_index = index;
+    m_strmInit = false;
+    m_rawMode = true;
+    m_pos = 0;
+}
+
+void IndexedZFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    close();
+    m_fileName = filename;
+    if (opmode != CaretBinaryFile::READ) throw DataFileException("indexed compressed file only supports READ mode");//CaretBinaryFile::open shouldn't let this happen
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly)) throw DataFileException("failed to open compressed file '" + filename + "'");
+    memset(&m_strm, 0, sizeof(z_stream));
+    if (inflateInit2(&m_strm, -15) != Z_OK) throw DataFileException("failed to initialize zlib for file '" + filename + "'");
+    m_strmInit = true;
+    m_inBuffer.resize(CHUNK_SIZE);
+    restartAt(m_index->getAccessPoint(0));
+}
+
+void IndexedZFileImpl::close()
+{
+    if (m_strmInit)
+    {
+        inflateEnd(&m_strm);
+        m_strmInit = false;
+    }
+    m_file.close();
+}
+
+bool IndexedZFileImpl::refill()
+{
+    int64_t numRead = m_file.read((char*)m_inBuffer.data(), CHUNK_SIZE);
+    if (numRead < 0) throw DataFileException("error while reading compressed file '" + m_fileName + "'");
+    m_strm.next_in = m_inBuffer.data();
+    m_strm.avail_in = (uInt)numRead;
+    return numRead > 0;
+}
+
+void IndexedZFileImpl::restartAt(const GzipIndex::AccessPoint& point)
+{
+    if (inflateReset2(&m_strm, -15) != Z_OK) throw DataFileException("failed to reset zlib for compressed file '" + m_fileName + "'");
+    if (!m_file.seek(point.m_compressedOffset - (point.m_bits ? 1 : 0))) throw DataFileException("seek failed in compressed file '" + m_fileName + "'");
+    m_strm.avail_in = 0;
+    if (point.m_bits != 0)
+    {//the block starts partway through the previous byte
+        if (!refill()) throw DataFileException("premature end of file in compressed file '" + m_fileName + "'");
+        int partial = m_strm.next_in[0];
+        ++m_strm.next_in;
+        --m_strm.avail_in;
+        inflatePrime(&m_strm, point.m_bits, partial >> (8 - point.m_bits));
+    }
+    if (!point.m_window.empty())
+    {
+        if (inflateSetDictionary(&m_strm, point.m_window.data(), point.m_window.size()) != Z_OK)
+        {
+            throw DataFileException("failed to restore decompression state for compressed file '" + m_fileName + "'");
+        }
+    }
+    m_rawMode = true;
+    m_pos = point.m_uncompressedOffset;
+}
+
+bool IndexedZFileImpl::nextMember()
+{//at the end of a deflate stream, check for another concatenated gzip member, like gzread does
+    if (m_rawMode)
+    {//raw inflate doesn't consume the gzip trailer
+        for (int i = 0; i < 8; ++i)
+        {
+            if (m_strm.avail_in == 0 && !refill()) return false;
+            ++m_strm.next_in;
+            --m_strm.avail_in;
+        }
+    }
+    if (m_strm.avail_in == 0 && !refill()) return false;
+    if (m_strm.next_in[0] != 0x1f) return false;//trailing garbage, gzread ignores it too
+    if (inflateReset2(&m_strm, 31) != Z_OK) throw DataFileException("failed to reset zlib for compressed file '" + m_fileName + "'");
+    m_rawMode = false;
+    return true;
+}
+
+int64_t IndexedZFileImpl::decompress(unsigned char* dataOut, const int64_t& count)
+{
+    int64_t total = 0;
+    while (total < count)
+    {
+        if (m_strm.avail_in == 0) refill();//let inflate decide whether running out of input is a problem
+        uInt outSize = (uInt)min(count - total, (int64_t)(1<<30));
+        m_strm.next_out = dataOut + total;
+        m_strm.avail_out = outSize;
+        int ret = inflate(&m_strm, Z_NO_FLUSH);
+        int64_t produced = outSize - m_strm.avail_out;
+        total += produced;
+        m_pos += produced;
+        if (ret == Z_STREAM_END)
+        {
+            if (!nextMember()) break;
+            continue;
+        }
+        if (ret == Z_BUF_ERROR) break;//no progress possible, end of file
+        if (ret != Z_OK) throw DataFileException("error while reading compressed file '" + m_fileName + "', file may be corrupted");
+    }
+    return total;
+}
+
+void IndexedZFileImpl::seek(const int64_t& position)
+{
+    if (position == m_pos) return;
+    if (position > m_index->getUncompressedSize()) throw DataFileException("seek past end of compressed file '" + m_fileName + "'");
+    const GzipIndex::AccessPoint& point = m_index->getAccessPoint(position);
+    if (position < m_pos || point.m_uncompressedOffset > m_pos)
+    {//decompressing forward from the current position is cheaper when there is no closer access point
+        restartAt(point);
+    }
+    const int64_t SKIP_CHUNK = 1<<16;
+    m_skipBuffer.resize(SKIP_CHUNK);
+    while (m_pos < position)
+    {
+        int64_t toSkip = min(position - m_pos, SKIP_CHUNK);
+        if (decompress(m_skipBuffer.data(), toSkip) != toSkip) throw DataFileException("seek failed in compressed file '" + m_fileName + "'");
+    }
+}
+
+void IndexedZFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (!m_strmInit) throw DataFileException("read called on unopened IndexedZFileImpl");//shouldn't happen
+    int64_t totalRead = decompress((unsigned char*)dataOut, count);
+    if (numRead == NULL)
+    {
+        if (totalRead != count) throw DataFileException("premature end of file in compressed file '" + m_fileName + "'");
+    } else {
+        *numRead = totalRead;
+    }
+}
+
+void IndexedZFileImpl::write(const void*, const int64_t&)
+{
+    throw DataFileException("indexed compressed file '" + m_fileName + "' is read-only");//shouldn't happen
+}
+
+IndexedZFileImpl::~IndexedZFileImpl()
+{
+    close();//doesn't throw
+}
+
+void ParallelZWriteImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    close();
+    m_fileName = filename;
+    if (opmode != CaretBinaryFile::WRITE_TRUNCATE) throw DataFileException("parallel compressed file only supports WRITE_TRUNCATE mode");//CaretBinaryFile::open shouldn't let this happen
+    remove(QDir::toNativeSeparators(filename).toLocal8Bit());//same as ZFileImpl
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) throw DataFileException("failed to open compressed file '" + filename + "', unable to create file");
+    const unsigned char header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255 };//deflate, no flags, no mtime, unknown OS
+    if (m_file.write((const char*)header, 10) != 10) throw DataFileException("failed to write to compressed file '" + m_fileName + "'");
+    m_crc = crc32(0L, Z_NULL, 0);
+    m_pos = 0;
+    m_pending.clear();
+    m_dictionary.clear();
+    int numThreads = 1;
+#ifdef CARET_OMP
+    numThreads = omp_get_max_threads();
+#endif
+    m_batchSize = BLOCK_SIZE * 2 * numThreads;//enough blocks to keep all threads busy despite uneven compression speed
+    m_pending.reserve(m_batchSize);
+}
+
+void ParallelZWriteImpl::compressPending(const bool& last)
+{
+    int64_t numBlocks = (m_pending.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if (last && numBlocks == 0) numBlocks = 1;//still need the final block marker
+    vector<vector<unsigned char> > outBlocks(numBlocks);
+    vector<uLong> blockCRCs(numBlocks);
+    vector<char> blockFailed(numBlocks, 0);//can't throw out of an omp loop
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t b = 0; b < numBlocks; ++b)
+    {
+        int64_t blockStart = b * BLOCK_SIZE;
+        int64_t blockLength = min(BLOCK_SIZE, (int64_t)m_pending.size() - blockStart);
+        unsigned char* blockData = m_pending.data() + blockStart;
+        z_stream strm;
+        memset(&strm, 0, sizeof(z_stream));
+        if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            blockFailed[b] = 1;
+            continue;
+        }
+        int ret = Z_OK;
+        if (b == 0)
+        {
+            if (!m_dictionary.empty()) ret = deflateSetDictionary(&strm, m_dictionary.data(), m_dictionary.size());
+        } else {//the previous block's input is already available, so blocks don't need to wait for each other
+            int64_t dictLength = min((int64_t)GzipIndex::WINDOW_SIZE, blockStart);
+            ret = deflateSetDictionary(&strm, blockData - dictLength, dictLength);
+        }
+        vector<unsigned char>& outBlock = outBlocks[b];
+        outBlock.resize(deflateBound(&strm, blockLength) + 64);//bound doesn't count the sync marker
+        strm.next_in = blockData;
+        strm.avail_in = (uInt)blockLength;
+        strm.next_out = outBlock.data();
+        strm.avail_out = (uInt)outBlock.size();
+        bool isFinal = last && (b == numBlocks - 1);
+        if (ret == Z_OK) ret = deflate(&strm, isFinal ? Z_FINISH : Z_SYNC_FLUSH);//sync flush ends on a byte boundary, so blocks can be concatenated
+        if ((isFinal ? ret != Z_STREAM_END : ret != Z_OK) || strm.avail_in != 0 || strm.avail_out == 0)
+        {
+            blockFailed[b] = 1;
+        }
+        outBlock.resize(outBlock.size() - strm.avail_out);
+        deflateEnd(&strm);
+        blockCRCs[b] = crc32(0L, blockData, (uInt)blockLength);
+    }
+    for (int64_t b = 0; b < numBlocks; ++b)
+    {
+        if (blockFailed[b]) throw DataFileException("error while compressing data for file '" + m_fileName + "'");
+        int64_t blockLength = min(BLOCK_SIZE, (int64_t)m_pending.size() - b * BLOCK_SIZE);
+        m_crc = crc32_combine(m_crc, blockCRCs[b], blockLength);
+        if (m_file.write((const char*)outBlocks[b].data(), outBlocks[b].size()) != (int64_t)outBlocks[b].size())
+        {
+            throw DataFileException("failed to write to compressed file '" + m_fileName + "'");
+        }
+    }
+    int64_t dictLength = min((int64_t)GzipIndex::WINDOW_SIZE, (int64_t)m_pending.size());
+    if (dictLength == GzipIndex::WINDOW_SIZE)
+    {
+        m_dictionary.assign(m_pending.end() - dictLength, m_pending.end());
+    } else {//short batch, keep the tail of the previous dictionary too
+        m_dictionary.insert(m_dictionary.end(), m_pending.begin(), m_pending.end());
+        if ((int64_t)m_dictionary.size() > GzipIndex::WINDOW_SIZE)
+        {
+            m_dictionary.erase(m_dictionary.begin(), m_dictionary.end() - GzipIndex::WINDOW_SIZE);
+        }
+    }
+    m_pending.clear();
+}
+
+void ParallelZWriteImpl::write(const void* dataIn, const int64_t& count)
+{
+    if (!m_file.isOpen()) throw DataFileException("write called on unopened ParallelZWriteImpl");//shouldn't happen
+    const unsigned char* charData = (const unsigned char*)dataIn;
+    int64_t total = 0;
+    while (total < count)
+    {
+        int64_t toCopy = min(count - total, m_batchSize - (int64_t)m_pending.size());
+        m_pending.insert(m_pending.end(), charData + total, charData + total + toCopy);
+        total += toCopy;
+        m_pos += toCopy;
+        if ((int64_t)m_pending.size() == m_batchSize) compressPending(false);
+    }
+}
+
+void ParallelZWriteImpl::seek(const int64_t& position)
+{//like gzseek when writing, only allow going forward, and fill with zeros
+    if (position == m_pos) return;
+    if (position < m_pos) throw DataFileException("can't seek backwards in compressed file '" + m_fileName + "' while writing");
+    vector<char> zeros(min(position - m_pos, BLOCK_SIZE), 0);
+    while (m_pos < position)
+    {
+        write(zeros.data(), min(position - m_pos, (int64_t)zeros.size()));
+    }
+}
+
+void ParallelZWriteImpl::read(void*, const int64_t&, int64_t*)
+{
+    throw DataFileException("parallel compressed file '" + m_fileName + "' is write-only");//shouldn't happen
+}
+
+void ParallelZWriteImpl::close()
+{
+    if (!m_file.isOpen()) return;
+    try
+    {
+        compressPending(true);
+        unsigned char trailer[8];
+        for (int i = 0; i < 4; ++i)
+        {//little endian crc, then length mod 2^32
+            trailer[i] = (m_crc >> (8 * i)) & 0xff;
+            trailer[i + 4] = (m_pos >> (8 * i)) & 0xff;
+        }
+        if (m_file.write((const char*)trailer, 8) != 8) throw DataFileException("failed to write to compressed file '" + m_fileName + "'");
+        if (!m_file.flush()) throw DataFileException("failed to flush file '" + m_fileName + "' before closing, data may be corrupted");
+    } catch (...) {
+        m_file.close();
+        throw;
+    }
+    m_file.close();
+}
+
+ParallelZWriteImpl::~ParallelZWriteImpl()
+{
+    try//throwing from a destructor is a bad idea
+    {
+        close();
+    } catch (CaretException& e) {
+        CaretLogSevere(e.whatString());
+    } catch (exception& e) {
+        CaretLogSevere(e.what());
+    } catch (...) {
+        CaretLogSevere("caught unknown exception type while closing a compressed file");
+    }
+}
+
+ReadAheadZFileImpl::ReadAheadZFileImpl()
+{
+    m_zfile = NULL;
+    m_stopRequested = false;
+    m_finished = false;
+    m_error = false;
+    m_currentUsed = 0;
+    m_pos = 0;
+}
+
+void ReadAheadZFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    close();
+    m_fileName = filename;
+    if (opmode != CaretBinaryFile::READ) throw DataFileException("read-ahead compressed file only supports READ mode");//CaretBinaryFile::open shouldn't let this happen
+#if !defined(CARET_OS_MACOSX) && ZLIB_VERNUM > 0x1232
+    m_zfile = gzopen64(filename.toLocal8Bit().constData(), "rb");
+#else
+    m_zfile = gzopen(filename.toLocal8Bit().constData(), "rb");
+#endif
+    if (m_zfile == NULL)
+    {
+        if (!QFile::exists(filename))
+        {
+            throw DataFileException("failed to open compressed file '" + filename + "', file does not exist, or folder permissions prevent seeing it");
+        }
+        throw DataFileException("failed to open compressed file '" + filename + "'");
+    }
+    m_pos = 0;
+    startThread();
+}
+
+void ReadAheadZFileImpl::decompressLoop()
+{
+    while (true)
+    {
+        {
+            QMutexLocker myLock(&m_mutex);
+            while (!m_stopRequested && (int)m_chunks.size() >= MAX_CHUNKS) m_chunkTaken.wait(&m_mutex);
+            if (m_stopRequested) return;
+        }
+        vector<char> chunk(CHUNK_SIZE);
+        int readret = gzread(m_zfile, chunk.data(), CHUNK_SIZE);//gzFile is only touched by this thread while it is running
+        QMutexLocker myLock(&m_mutex);
+        if (readret < 0) m_error = true;
+        if (readret > 0)
+        {
+            chunk.resize(readret);
+            m_chunks.push_back(vector<char>());
+            m_chunks.back().swap(chunk);
+        }
+        if (readret < CHUNK_SIZE) m_finished = true;//gzread only returns short at end of file or error
+        m_chunkReady.wakeAll();
+        if (m_finished) return;
+    }
+}
+
+void ReadAheadZFileImpl::startThread()
+{
+    m_stopRequested = false;
+    m_finished = false;
+    m_error = false;
+    m_chunks.clear();
+    m_current.clear();
+    m_currentUsed = 0;
+    m_thread.grabNew(new DecompressThread(this));
+    m_thread->start();
+}
+
+void ReadAheadZFileImpl::stopThread()
+{
+    if (m_thread == NULL) return;
+    {
+        QMutexLocker myLock(&m_mutex);
+        m_stopRequested = true;
+        m_chunkTaken.wakeAll();
+    }
+    m_thread->wait();
+    m_thread.grabNew(NULL);
+}
+
+int64_t ReadAheadZFileImpl::consume(char* dataOut, const int64_t& count)
+{
+    int64_t total = 0;
+    while (total < count)
+    {
+        if (m_currentUsed == (int64_t)m_current.size())
+        {
+            QMutexLocker myLock(&m_mutex);
+            while (m_chunks.empty() && !m_finished) m_chunkReady.wait(&m_mutex);
+            if (m_chunks.empty()) break;
+            m_current.swap(m_chunks.front());
+            m_chunks.pop_front();
+            m_currentUsed = 0;
+            m_chunkTaken.wakeAll();
+        }
+        int64_t toCopy = min(count - total, (int64_t)m_current.size() - m_currentUsed);
+        if (dataOut != NULL) memcpy(dataOut + total, m_current.data() + m_currentUsed, toCopy);
+        m_currentUsed += toCopy;
+        total += toCopy;
+    }
+    m_pos += total;
+    return total;
+}
+
+void ReadAheadZFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (m_zfile == NULL) throw DataFileException("read called on unopened ReadAheadZFileImpl");//shouldn't happen
+    int64_t totalRead = consume((char*)dataOut, count);
+    if (numRead == NULL)
+    {
+        if (totalRead != count)
+        {
+            QMutexLocker myLock(&m_mutex);
+            if (m_error) throw DataFileException("error while reading compressed file '" + m_fileName + "'");
+            throw DataFileException("premature end of file in compressed file '" + m_fileName + "'");
+        }
+    } else {
+        *numRead = totalRead;
+    }
+}
+
+void ReadAheadZFileImpl::seek(const int64_t& position)
+{
+    if (m_zfile == NULL) throw DataFileException("seek called on unopened ReadAheadZFileImpl");//shouldn't happen
+    if (position == m_pos) return;
+    if (position > m_pos)
+    {//the data is probably already decompressed, or being decompressed, so just skip it
+        int64_t toSkip = position - m_pos;//consume() changes m_pos
+        if (consume(NULL, toSkip) != toSkip) throw DataFileException("seek failed in compressed file '" + m_fileName + "'");
+        return;
+    }
+    stopThread();
+#if !defined(CARET_OS_MACOSX) && ZLIB_VERNUM > 0x1232
+    int64_t ret = gzseek64(m_zfile, position, SEEK_SET);
+#else
+    int64_t ret = gzseek(m_zfile, position, SEEK_SET);
+#endif
+    if (ret != position) throw DataFileException("seek failed in compressed file '" + m_fileName + "'");
+    m_pos = position;
+    startThread();
+}
+
+void ReadAheadZFileImpl::write(const void*, const int64_t&)
+{
+    throw DataFileException("read-ahead compressed file '" + m_fileName + "' is read-only");//shouldn't happen
+}
+
+void ReadAheadZFileImpl::close()
+{
+    stopThread();
+    m_chunks.clear();
+    m_current.clear();
+    m_currentUsed = 0;
+    if (m_zfile == NULL) return;
+    int ret = gzclose(m_zfile);
+    m_zfile = NULL;
+    if (ret != 0) throw DataFileException("error closing compressed file '" + m_fileName + "'");
+}
+
+ReadAheadZFileImpl::~ReadAheadZFileImpl()
+{
+    try//throwing from a destructor is a bad idea
+    {
+        close();
+    } catch (CaretException& e) {
+        CaretLogSevere(e.whatString());
+    } catch (exception& e) {
+        CaretLogSevere(e.what());
+    } catch (...) {
+        CaretLogSevere("caught unknown exception type while closing a compressed file");
+    }
+}
 #endif //ZLIB_VERSION
 
 void QFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
 {
     close();//don't need to, but just because
     m_fileName = filename;
+    m_readOnly = (opmode == CaretBinaryFile::READ);
     QIODevice::OpenMode mode = QIODevice::NotOpen;//means 0
     if (opmode & CaretBinaryFile::READ) mode |= QIODevice::ReadOnly;
     if (opmode & CaretBinaryFile::WRITE) mode |= QIODevice::WriteOnly;
@@ -328,6 +981,11 @@ void QFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& o
 void QFileImpl::close()
 {
     if (!m_file.isOpen()) return; //not sure what flush() does if file isn't open, so let's not try it
+    for (int i = 0; i < (int)m_mappings.size(); ++i)
+    {
+        m_file.unmap(m_mappings[i]);
+    }
+    m_mappings.clear();
     //WARNING: QFileDevice::close() calls flush, ignores if it fails, then closes
     //so flush manually and check its error condition instead
     if (!m_file.flush()) throw DataFileException("failed to flush file '" + m_file.fileName() + "' before closing, data may be corrupted");
@@ -357,6 +1015,48 @@ void QFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
     }
 }
 
+#ifndef CARET_OS_WINDOWS
+void QFileImpl::readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead)
+{
+    CaretAssert(m_readOnly);
+    int fd = m_file.handle();
+    if (fd == -1) throw DataFileException("readAt called on unopened QFileImpl");//shouldn't happen
+    int64_t total = 0;
+    int64_t readret = -1;
+    while (total < count)
+    {
+        int64_t maxToRead = min(count - total, CHUNK_SIZE);
+        readret = pread(fd, ((char*)dataOut) + total, maxToRead, position + total);
+        if (readret < 0 && errno == EINTR) continue;
+        if (readret < 1) break;//0 or -1 means eof or error
+        total += readret;
+    }
+    if (numRead == NULL)
+    {
+        if (total != count)
+        {
+            if (readret < 0) throw DataFileException("error while reading file '" + m_fileName + "'");
+            throw DataFileException("premature end of file in '" + m_fileName + "'");
+        }
+    } else {
+        *numRead = total;
+    }
+}
+#endif
+
+const char* QFileImpl::mapForRead(const int64_t& position, const int64_t& count)
+{
+    if (!m_readOnly || !m_file.isOpen()) return NULL;//a writable mapping could see half-written data, don't bother
+    uchar* ret = m_file.map(position, count);
+    if (ret == NULL)
+    {
+        CaretLogFine("failed to memory map file '" + m_fileName + "': " + m_file.errorString());
+        return NULL;
+    }
+    m_mappings.push_back(ret);
+    return (const char*)ret;
+}
+
 void QFileImpl::seek(const int64_t& position)
 {
     if (m_file.pos() == position) return; //QFile::seek always does a flush in qt5, so try to avoid calling it
@@ -54,8 +54,14 @@ namespace caret {
         void seek(const int64_t& position);
         int64_t pos();
         void read(void* dataOut, const int64_t& count, int64_t* numRead = NULL);//throw if numRead is NULL and (error or end of file reached early)
+        bool supportsReadAt();//whether readAt() can be used, currently only uncompressed files opened for read only, on non-windows
+        void readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead = NULL);//doesn't use or change the current position, safe to call from multiple threads at once
         void write(const void* dataIn, const int64_t& count);//failure to complete write is always an exception
+        const char* mapForRead(const int64_t& position, const int64_t& count);//returns NULL if the file can't be memory mapped (compressed, open for writing, or OS failure), mapping is valid until the file is closed
         int64_t size();//may return -1 if size cannot be determined efficiently
+        ///compress .gz output on multiple threads, and decompress .gz input in a separate read-ahead thread
+        static void setParallelCompression(const bool& enabled);
+        static bool getParallelCompression();
         class ImplInterface
         {
         protected:
@@ -68,12 +74,16 @@ namespace caret {
             virtual int64_t pos() = 0;
             virtual int64_t size() = 0;
             virtual void read(void* dataOut, const int64_t& count, int64_t* numRead) = 0;
+            virtual bool supportsReadAt() { return false; }
+            virtual void readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead);
+            virtual const char* mapForRead(const int64_t&, const int64_t&) { return NULL; }
             virtual void write(const void* dataIn, const int64_t& count) = 0;
             virtual ~ImplInterface();
         };
     private:
         CaretPointer<ImplInterface> m_impl;
         OpenMode m_curMode;//so implementation classes don't have to track it
+        static bool s_parallelCompression;
     };
 } //namespace caret
 
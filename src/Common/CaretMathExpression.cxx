@@ -22,12 +22,16 @@
 #include "CaretException.h"
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
+#include "CaretOMP.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
 using namespace std;
 
+const int CaretMathExpression::BLOCK_SIZE = 256;//small enough that the registers for a typical expression stay in L1/L2
+
 CaretMathExpression::CaretMathExpression(const AString& expression)
 {
     m_input = expression;
@@ -39,6 +43,8 @@ CaretMathExpression::CaretMathExpression(const AString& expression)
         throw CaretException("extra characters on end of expression: '" + m_input.mid(m_position) + "'");
     }
     CaretLogFiner("parsed '" + expression + "' as '" + toString() + "'");
+    m_numRegisters = 1;
+    compileNode(m_root, 0);
 }
 
 double CaretMathExpression::evaluate(const vector<float>& variableValues) const
@@ -47,6 +53,270 @@ double CaretMathExpression::evaluate(const vector<float>& variableValues) const
     return m_root->eval(variableValues);
 }
 
+void CaretMathExpression::evaluateArray(const vector<const float*>& variableData, float* output, const int64_t& count, const vector<int64_t>& variableStrides) const
+{
+    CaretAssert(variableData.size() == m_varNames.size());
+    CaretAssert(variableStrides.empty() || variableStrides.size() == variableData.size());
+    int64_t numBlocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+#pragma omp CARET_PAR if (numBlocks > 1)
+    {
+        vector<double> registers(m_numRegisters * BLOCK_SIZE);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t block = 0; block < numBlocks; ++block)
+        {
+            int64_t start = block * BLOCK_SIZE;
+            int blockCount = (int)min((int64_t)BLOCK_SIZE, count - start);
+            runProgram(variableData, variableStrides, start, blockCount, registers.data());
+            for (int i = 0; i < blockCount; ++i)
+            {
+                output[start + i] = (float)registers[i];//result is always in register 0
+            }
+        }
+    }
+}
+
+void CaretMathExpression::addInstruction(const Instruction::OpCode& op, const int& dest, const int& arg1, const int& arg2)
+{
+    Instruction newInst;
+    newInst.m_op = op;
+    newInst.m_dest = dest;
+    newInst.m_arg1 = arg1;
+    newInst.m_arg2 = arg2;
+    newInst.m_numArgs = 0;
+    newInst.m_varIndex = -1;
+    newInst.m_constVal = 0.0;
+    newInst.m_function = MathFunctionEnum::INVALID;
+    m_program.push_back(newInst);
+    m_numRegisters = max(m_numRegisters, max(dest, max(arg1, arg2)) + 1);
+}
+
+void CaretMathExpression::compileNode(const MathNode* node, const int& destReg)
+{//result goes in destReg, registers above it are scratch, so the register count is bounded by the depth of the tree
+    int end = (int)node->m_arguments.size();
+    switch (node->m_type)
+    {
+        case MathNode::OR:
+        case MathNode::AND:
+            compileNode(node->m_arguments[0], destReg);
+            for (int i = 1; i < end; ++i)
+            {//no lazy evaluation, there are no side effects, and we want straight-line loops
+                compileNode(node->m_arguments[i], destReg + 1);
+                addInstruction(node->m_type == MathNode::OR ? Instruction::OR : Instruction::AND, destReg, destReg, destReg + 1);
+            }
+            break;
+        case MathNode::EQUAL:
+            compileNode(node->m_arguments[0], destReg);
+            for (int i = 1; i < end; ++i)
+            {
+                compileNode(node->m_arguments[i], destReg + 1);
+                addInstruction(node->m_invert[i] ? Instruction::NOT_EQUAL : Instruction::EQUAL, destReg, destReg, destReg + 1);
+            }
+            break;
+        case MathNode::GREATERLESS:
+            compileNode(node->m_arguments[0], destReg);
+            for (int i = 1; i < end; ++i)
+            {
+                compileNode(node->m_arguments[i], destReg + 1);
+                Instruction::OpCode op;
+                if (node->m_inclusive[i])
+                {
+                    op = node->m_invert[i] ? Instruction::LESS_EQUAL : Instruction::GREATER_EQUAL;
+                } else {
+                    op = node->m_invert[i] ? Instruction::LESS : Instruction::GREATER;
+                }
+                addInstruction(op, destReg, destReg, destReg + 1);
+            }
+            break;
+        case MathNode::ADDSUB:
+            compileNode(node->m_arguments[0], destReg);
+            for (int i = 1; i < end; ++i)
+            {
+                compileNode(node->m_arguments[i], destReg + 1);
+                addInstruction(node->m_invert[i] ? Instruction::SUBTRACT : Instruction::ADD, destReg, destReg, destReg + 1);
+            }
+            break;
+        case MathNode::MULTDIV:
+            compileNode(node->m_arguments[0], destReg);
+            for (int i = 1; i < end; ++i)
+            {
+                compileNode(node->m_arguments[i], destReg + 1);
+                addInstruction(node->m_invert[i] ? Instruction::DIVIDE : Instruction::MULTIPLY, destReg, destReg, destReg + 1);
+            }
+            break;
+        case MathNode::NOT:
+            compileNode(node->m_arguments[0], destReg);
+            addInstruction(Instruction::NOT, destReg, destReg);
+            break;
+        case MathNode::NEGATE:
+            compileNode(node->m_arguments[0], destReg);
+            addInstruction(Instruction::NEGATE, destReg, destReg);
+            break;
+        case MathNode::POW:
+            compileNode(node->m_arguments[0], destReg);
+            compileNode(node->m_arguments[1], destReg + 1);
+            addInstruction(Instruction::POW, destReg, destReg, destReg + 1);
+            break;
+        case MathNode::FUNC:
+            CaretAssert(end <= 3);
+            for (int i = 0; i < end; ++i)
+            {
+                compileNode(node->m_arguments[i], destReg + i);
+            }
+            addInstruction(Instruction::FUNC, destReg, destReg, destReg + end - 1);
+            m_program.back().m_numArgs = end;
+            m_program.back().m_function = node->m_function;
+            break;
+        case MathNode::VAR:
+            addInstruction(Instruction::LOAD_VAR, destReg);
+            m_program.back().m_varIndex = node->m_varIndex;
+            break;
+        case MathNode::CONST:
+            addInstruction(Instruction::LOAD_CONST, destReg);
+            m_program.back().m_constVal = node->m_constVal;
+            break;
+        case MathNode::INVALID:
+            CaretAssertMessage(0, "parsing left INVALID MathNode");
+            throw CaretException("parsing problem in CaretMathExpression");
+    }
+}
+
+void CaretMathExpression::runProgram(const vector<const float*>& variableData, const vector<int64_t>& variableStrides,
+                                     const int64_t& start, const int& count, double* registers) const
+{//the arithmetic here must stay identical to MathNode::eval, so that both give the same answers
+    int numInst = (int)m_program.size();
+    for (int inst = 0; inst < numInst; ++inst)
+    {
+        const Instruction& myInst = m_program[inst];
+        double* dest = registers + myInst.m_dest * BLOCK_SIZE;
+        const double* arg1 = registers + max(myInst.m_arg1, 0) * BLOCK_SIZE;
+        const double* arg2 = registers + max(myInst.m_arg2, 0) * BLOCK_SIZE;
+        switch (myInst.m_op)
+        {
+            case Instruction::LOAD_VAR:
+            {
+                int64_t stride = (variableStrides.empty() ? 1 : variableStrides[myInst.m_varIndex]);
+                const float* varData = variableData[myInst.m_varIndex] + start * stride;
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = varData[i * stride];
+                }
+                break;
+            }
+            case Instruction::LOAD_CONST:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = myInst.m_constVal;
+                }
+                break;
+            case Instruction::OR:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = (arg1[i] > 0.0 || arg2[i] > 0.0) ? 1.0 : 0.0;
+                }
+                break;
+            case Instruction::AND:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = (arg1[i] > 0.0 && arg2[i] > 0.0) ? 1.0 : 0.0;
+                }
+                break;
+            case Instruction::EQUAL:
+            case Instruction::NOT_EQUAL:
+            {
+                double trueVal = (myInst.m_op == Instruction::EQUAL ? 1.0 : 0.0);
+                for (int i = 0; i < count; ++i)
+                {
+                    float adjust = min(abs(arg1[i]), abs(arg2[i])) / 1000000;//same fudge factor as eval
+                    bool equal = (arg1[i] >= arg2[i] - adjust) && (arg1[i] <= arg2[i] + adjust);
+                    dest[i] = equal ? trueVal : 1.0 - trueVal;
+                }
+                break;
+            }
+            case Instruction::GREATER:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = (arg1[i] > arg2[i] ? 1.0 : 0.0);
+                }
+                break;
+            case Instruction::LESS:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = (arg1[i] < arg2[i] ? 1.0 : 0.0);
+                }
+                break;
+            case Instruction::GREATER_EQUAL:
+                for (int i = 0; i < count; ++i)
+                {
+                    float adjust = min(abs(arg1[i]), abs(arg2[i])) / 1000000;
+                    dest[i] = (arg1[i] >= arg2[i] - adjust ? 1.0 : 0.0);
+                }
+                break;
+            case Instruction::LESS_EQUAL:
+                for (int i = 0; i < count; ++i)
+                {
+                    float adjust = min(abs(arg1[i]), abs(arg2[i])) / 1000000;
+                    dest[i] = (arg1[i] <= arg2[i] + adjust ? 1.0 : 0.0);
+                }
+                break;
+            case Instruction::ADD:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = arg1[i] + arg2[i];
+                }
+                break;
+            case Instruction::SUBTRACT:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = arg1[i] - arg2[i];
+                }
+                break;
+            case Instruction::MULTIPLY:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = arg1[i] * arg2[i];
+                }
+                break;
+            case Instruction::DIVIDE:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = arg1[i] / arg2[i];
+                }
+                break;
+            case Instruction::NOT:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = (arg1[i] > 0.0) ? 0.0 : 1.0;
+                }
+                break;
+            case Instruction::NEGATE:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = -arg1[i];
+                }
+                break;
+            case Instruction::POW:
+                for (int i = 0; i < count; ++i)
+                {
+                    dest[i] = pow(arg1[i], arg2[i]);
+                }
+                break;
+            case Instruction::FUNC:
+            {//function calls cost more than the switch in applyFunction, so don't specialize the loops
+                double args[3];
+                for (int i = 0; i < count; ++i)
+                {
+                    for (int j = 0; j < myInst.m_numArgs; ++j)
+                    {
+                        args[j] = arg1[j * BLOCK_SIZE + i];
+                    }
+                    dest[i] = applyFunction(myInst.m_function, args, myInst.m_numArgs);
+                }
+                break;
+            }
+        }
+    }
+}
+
 vector<AString> CaretMathExpression::getVarNames() const
 {
     vector<AString> ret(m_varNames.size());
@@ -216,182 +486,13 @@ double CaretMathExpression::MathNode::eval(const vector<float>& values) const
         }
         case FUNC:
         {
-            switch (m_function)//this could be (partly) moved into MathFunctionEnum, but it wouldn't strictly be an enum class then
+            CaretAssert(m_arguments.size() <= 3);
+            double args[3];
+            for (int i = 0; i < (int)m_arguments.size(); ++i)
             {
-                case MathFunctionEnum::SIN:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = sin(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::COS:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = cos(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::TAN:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = tan(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::ASIN:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = asin(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::ACOS:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = acos(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::ATAN:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = atan(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::SINH:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = sinh(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::COSH:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = cosh(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::TANH:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = tanh(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::ASINH:
-                {
-                    CaretAssert(m_arguments.size() == 1);
-                    //ret = asinh(m_arguments[0].eval(values));//will work, and be preferred, when we use c++11, but doesn't work on windows with previous standard
-                    double arg = m_arguments[0]->eval(values);
-                    if (arg > 0)
-                    {
-                        ret = log(arg + sqrt(arg * arg + 1));
-                    } else {
-                        ret = -log(-arg + sqrt(arg * arg + 1));//special case negative for stability in large negatives
-                    }
-                    break;
-                }
-                case MathFunctionEnum::ACOSH:
-                {
-                    CaretAssert(m_arguments.size() == 1);
-                    //ret = acosh(m_arguments[0].eval(values));
-                    double arg = m_arguments[0]->eval(values);
-                    ret = log(arg + sqrt(arg * arg - 1));
-                    break;
-                }
-                case MathFunctionEnum::ATANH:
-                {
-                    CaretAssert(m_arguments.size() == 1);
-                    //ret = atanh(m_arguments[0].eval(values));
-                    double arg = m_arguments[0]->eval(values);
-                    ret = 0.5 * log((1 + arg) / (1 - arg));
-                    break;
-                }
-                case MathFunctionEnum::SINC:
-                {
-                    CaretAssert(m_arguments.size() == 1);
-                    double arg = m_arguments[0]->eval(values);
-                    if (arg == 0.0)//assume sin(x) behaves well for very small x
-                    {
-                        ret = 1.0;
-                    } else {
-                        ret = sin(arg) / arg;
-                    }
-                    break;
-                }
-                case MathFunctionEnum::LN:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = log(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::EXP:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = exp(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::LOG:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = log10(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::LOG2:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = log2(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::SQRT:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = sqrt(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::ABS:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = abs(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::FLOOR:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = floor(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::ROUND:
-                {
-                    CaretAssert(m_arguments.size() == 1);
-                    double temp = m_arguments[0]->eval(values);//windows doesn't use c99 when compiling c++ earlier than c++11, so implement manually
-                    if (temp > 0.0)
-                    {
-                        ret = floor(temp + 0.5);
-                    } else {
-                        ret = ceil(temp - 0.5);
-                    }
-                    break;
-                }
-                case MathFunctionEnum::CEIL:
-                    CaretAssert(m_arguments.size() == 1);
-                    ret = ceil(m_arguments[0]->eval(values));
-                    break;
-                case MathFunctionEnum::ATAN2:
-                    CaretAssert(m_arguments.size() == 2);
-                    ret = atan2(m_arguments[0]->eval(values), m_arguments[1]->eval(values));
-                    break;
-                case MathFunctionEnum::MIN:
-                {
-                    CaretAssert(m_arguments.size() == 2);
-                    ret = m_arguments[0]->eval(values);
-                    double other = m_arguments[1]->eval(values);
-                    if (ret > other) ret = other;
-                    break;
-                }
-                case MathFunctionEnum::MAX:
-                {
-                    CaretAssert(m_arguments.size() == 2);
-                    ret = m_arguments[0]->eval(values);
-                    double other = m_arguments[1]->eval(values);
-                    if (ret < other) ret = other;
-                    break;
-                }
-                case MathFunctionEnum::MOD:
-                {
-                    CaretAssert(m_arguments.size() == 2);
-                    double second = m_arguments[1]->eval(values);
-                    if (second == 0.0)
-                    {
-                        ret = 0.0;
-                    } else {
-                        double first = m_arguments[0]->eval(values);
-                        ret = first - second * floor(first / second);
-                    }
-                    break;
-                }
-                case MathFunctionEnum::CLAMP:
-                {
-                    CaretAssert(m_arguments.size() == 3);
-                    ret = m_arguments[0]->eval(values);
-                    double low = m_arguments[1]->eval(values);
-                    double high = m_arguments[2]->eval(values);
-                    if (ret < low)
-                    {
-                        ret = low;
-                    }
-                    if (ret > high)
-                    {
-                        ret = high;
-                    }
-                    break;
-                }
-                case MathFunctionEnum::INVALID:
-                    CaretAssertMessage(0, "MathNode is type FUNC but INVALID function");
-                    throw CaretException("parsing problem in CaretMathExpression");
+                args[i] = m_arguments[i]->eval(values);
             }
+            ret = applyFunction(m_function, args, (int)m_arguments.size());
             break;
         }
         case VAR:
@@ -408,6 +509,188 @@ double CaretMathExpression::MathNode::eval(const vector<float>& values) const
     return ret;
 }
 
+double CaretMathExpression::applyFunction(const MathFunctionEnum::Enum& function, const double* args, const int& numArgs)
+{
+    double ret = 0.0;
+    switch (function)//this could be (partly) moved into MathFunctionEnum, but it wouldn't strictly be an enum class then
+    {
+        case MathFunctionEnum::SIN:
+            CaretAssert(numArgs == 1);
+            ret = sin(args[0]);
+            break;
+        case MathFunctionEnum::COS:
+            CaretAssert(numArgs == 1);
+            ret = cos(args[0]);
+            break;
+        case MathFunctionEnum::TAN:
+            CaretAssert(numArgs == 1);
+            ret = tan(args[0]);
+            break;
+        case MathFunctionEnum::ASIN:
+            CaretAssert(numArgs == 1);
+            ret = asin(args[0]);
+            break;
+        case MathFunctionEnum::ACOS:
+            CaretAssert(numArgs == 1);
+            ret = acos(args[0]);
+            break;
+        case MathFunctionEnum::ATAN:
+            CaretAssert(numArgs == 1);
+            ret = atan(args[0]);
+            break;
+        case MathFunctionEnum::SINH:
+            CaretAssert(numArgs == 1);
+            ret = sinh(args[0]);
+            break;
+        case MathFunctionEnum::COSH:
+            CaretAssert(numArgs == 1);
+            ret = cosh(args[0]);
+            break;
+        case MathFunctionEnum::TANH:
+            CaretAssert(numArgs == 1);
+            ret = tanh(args[0]);
+            break;
+        case MathFunctionEnum::ASINH:
+        {
+            CaretAssert(numArgs == 1);
+            //ret = asinh(args[0]);//will work, and be preferred, when we use c++11, but doesn't work on windows with previous standard
+            double arg = args[0];
+            if (arg > 0)
+            {
+                ret = log(arg + sqrt(arg * arg + 1));
+            } else {
+                ret = -log(-arg + sqrt(arg * arg + 1));//special case negative for stability in large negatives
+            }
+            break;
+        }
+        case MathFunctionEnum::ACOSH:
+        {
+            CaretAssert(numArgs == 1);
+            //ret = acosh(args[0]);
+            double arg = args[0];
+            ret = log(arg + sqrt(arg * arg - 1));
+            break;
+        }
+        case MathFunctionEnum::ATANH:
+        {
+            CaretAssert(numArgs == 1);
+            //ret = atanh(args[0]);
+            double arg = args[0];
+            ret = 0.5 * log((1 + arg) / (1 - arg));
+            break;
+        }
+        case MathFunctionEnum::SINC:
+        {
+            CaretAssert(numArgs == 1);
+            double arg = args[0];
+            if (arg == 0.0)//assume sin(x) behaves well for very small x
+            {
+                ret = 1.0;
+            } else {
+                ret = sin(arg) / arg;
+            }
+            break;
+        }
+        case MathFunctionEnum::LN:
+            CaretAssert(numArgs == 1);
+            ret = log(args[0]);
+            break;
+        case MathFunctionEnum::EXP:
+            CaretAssert(numArgs == 1);
+            ret = exp(args[0]);
+            break;
+        case MathFunctionEnum::LOG:
+            CaretAssert(numArgs == 1);
+            ret = log10(args[0]);
+            break;
+        case MathFunctionEnum::LOG2:
+            CaretAssert(numArgs == 1);
+            ret = log2(args[0]);
+            break;
+        case MathFunctionEnum::SQRT:
+            CaretAssert(numArgs == 1);
+            ret = sqrt(args[0]);
+            break;
+        case MathFunctionEnum::ABS:
+            CaretAssert(numArgs == 1);
+            ret = abs(args[0]);
+            break;
+        case MathFunctionEnum::FLOOR:
+            CaretAssert(numArgs == 1);
+            ret = floor(args[0]);
+            break;
+        case MathFunctionEnum::ROUND:
+        {
+            CaretAssert(numArgs == 1);
+            double temp = args[0];//windows doesn't use c99 when compiling c++ earlier than c++11, so implement manually
+            if (temp > 0.0)
+            {
+                ret = floor(temp + 0.5);
+            } else {
+                ret = ceil(temp - 0.5);
+            }
+            break;
+        }
+        case MathFunctionEnum::CEIL:
+            CaretAssert(numArgs == 1);
+            ret = ceil(args[0]);
+            break;
+        case MathFunctionEnum::ATAN2:
+            CaretAssert(numArgs == 2);
+            ret = atan2(args[0], args[1]);
+            break;
+        case MathFunctionEnum::MIN:
+        {
+            CaretAssert(numArgs == 2);
+            ret = args[0];
+            double other = args[1];
+            if (ret > other) ret = other;
+            break;
+        }
+        case MathFunctionEnum::MAX:
+        {
+            CaretAssert(numArgs == 2);
+            ret = args[0];
+            double other = args[1];
+            if (ret < other) ret = other;
+            break;
+        }
+        case MathFunctionEnum::MOD:
+        {
+            CaretAssert(numArgs == 2);
+            double second = args[1];
+            if (second == 0.0)
+            {
+                ret = 0.0;
+            } else {
+                double first = args[0];
+                ret = first - second * floor(first / second);
+            }
+            break;
+        }
+        case MathFunctionEnum::CLAMP:
+        {
+            CaretAssert(numArgs == 3);
+            ret = args[0];
+            double low = args[1];
+            double high = args[2];
+            if (ret < low)
+            {
+                ret = low;
+            }
+            if (ret > high)
+            {
+                ret = high;
+            }
+            break;
+        }
+        case MathFunctionEnum::INVALID:
+            CaretAssertMessage(0, "MathNode is type FUNC but INVALID function");
+            throw CaretException("parsing problem in CaretMathExpression");
+    }
+    return ret;
+}
+
 AString CaretMathExpression::MathNode::toString(const std::vector<AString>& varNames, bool addParens) const
 {
     AString ret = "";
@@ -26,6 +26,7 @@
 #include "MathFunctionEnum.h"
 
 #include <map>
+#include <stdint.h>
 #include <vector>
 
 namespace caret {
@@ -63,6 +64,44 @@ class CaretMathExpression
         double eval(const std::vector<float>& values) const;
         AString toString(const std::vector<AString>& varNames, bool addParens = true) const;
     };
+    struct Instruction
+    {//flat register program compiled from the tree, each instruction operates on a block of elements at a time
+        enum OpCode
+        {
+            LOAD_VAR,
+            LOAD_CONST,
+            OR,
+            AND,
+            EQUAL,
+            NOT_EQUAL,
+            GREATER,
+            LESS,
+            GREATER_EQUAL,
+            LESS_EQUAL,
+            ADD,
+            SUBTRACT,
+            MULTIPLY,
+            DIVIDE,
+            NOT,
+            NEGATE,
+            POW,
+            FUNC
+        };
+        OpCode m_op;
+        int m_dest, m_arg1, m_arg2;//FUNC uses consecutive registers starting at m_arg1
+        int m_numArgs;
+        int m_varIndex;
+        double m_constVal;
+        MathFunctionEnum::Enum m_function;
+    };
+    static const int BLOCK_SIZE;
+    std::vector<Instruction> m_program;
+    int m_numRegisters;
+    void compileNode(const MathNode* node, const int& destReg);
+    void addInstruction(const Instruction::OpCode& op, const int& dest, const int& arg1 = -1, const int& arg2 = -1);
+    void runProgram(const std::vector<const float*>& variableData, const std::vector<int64_t>& variableStrides,
+                    const int64_t& start, const int& count, double* registers) const;
+    static double applyFunction(const MathFunctionEnum::Enum& function, const double* args, const int& numArgs);
     std::map<AString, int> m_varNames;
     AString m_input;
     int m_position, m_end;
@@ -87,6 +126,9 @@ public:
     static bool getNamedConstant(const AString& name, double& valueOut);
     CaretMathExpression(const AString& expression);
     double evaluate(const std::vector<float>& variableValues) const;
+    ///evaluate count elements at once, variable i uses variableData[i][j * stride], where stride defaults to 1 (use 0 to repeat one value), runs in parallel
+    void evaluateArray(const std::vector<const float*>& variableData, float* output, const int64_t& count,
+                       const std::vector<int64_t>& variableStrides = std::vector<int64_t>()) const;
     std::vector<AString> getVarNames() const;
     AString toString() const;//the expression, with a lot of parentheses added
 };
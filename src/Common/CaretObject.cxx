@@ -25,10 +25,28 @@
 #include "CaretObject.h"
 #undef __CARET_OBJECT_DECLARE_H__
 
+#include "CaretMutex.h"
 #include "SystemUtilities.h"
 
 using namespace caret;
 
+#ifndef NDEBUG
+namespace
+{
+    /**
+     * Objects are created and destroyed on worker threads (file reading,
+     * GIFTI encoding, image writing), so the tracker map needs a lock.
+     * A function static is constructed on first use, so this is also
+     * safe for CaretObjects that are constructed during static initialization.
+     */
+    CaretMutex& getAllocatedObjectsMutex()
+    {
+        static CaretMutex theMutex;
+        return theMutex;
+    }
+}
+#endif
+
 /**
  * Constructor.
  *
@@ -58,7 +76,11 @@ CaretObject::~CaretObject()
      * Erase returns the number of objects deleted.
      * If zero, then the object has already been deleted.
      */
-    uint64_t numDeleted = CaretObject::allocatedObjects.erase(this);
+    uint64_t numDeleted = 0;
+    {
+        CaretMutexLocker locked(&getAllocatedObjectsMutex());
+        numDeleted = CaretObject::allocatedObjects.erase(this);
+    }
     if (numDeleted <= 0) {
         std::cerr << "Destructor for a CaretObject called but the object is not allocated "
                   << "and this implies that the object has already been deleted.";
@@ -81,6 +103,7 @@ CaretObject::initializeMembersCaretObject()
 #ifndef NDEBUG
     SystemBacktrace myBacktrace;
     SystemUtilities::getBackTrace(myBacktrace);
+    CaretMutexLocker locked(&getAllocatedObjectsMutex());
     CaretObject::allocatedObjects.insert(
                std::make_pair(this,
                               myBacktrace));
@@ -134,6 +157,7 @@ CaretObject::printListOfObjectsNotDeleted(const bool showCallStack)
 {
     int count = 0;
     
+    CaretMutexLocker locked(&getAllocatedObjectsMutex());
     if (CaretObject::allocatedObjects.empty() == false) {
         std::cout << "These Caret Objects were not deleted:" << std::endl;
         for (CARET_OBJECT_TRACKER_MAP_ITERATOR iter = CaretObject::allocatedObjects.begin();
@@ -0,0 +1,279 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretTriangleBVH.h"
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct BuildTask
+    {
+        int64_t m_begin, m_end;
+        int64_t m_parent;//interior node whose second child this is, -1 for root and first children
+    };
+    
+    struct Bin
+    {
+        float m_min[3], m_max[3];
+        int64_t m_count;
+        Bin() { m_count = 0; m_min[0] = m_min[1] = m_min[2] = numeric_limits<float>::max(); m_max[0] = m_max[1] = m_max[2] = -numeric_limits<float>::max(); }
+        void expand(const float* minIn, const float* maxIn)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                m_min[i] = min(m_min[i], minIn[i]);
+                m_max[i] = max(m_max[i], maxIn[i]);
+            }
+        }
+        float halfArea() const
+        {
+            if (m_count == 0) return 0.0f;
+            float dx = m_max[0] - m_min[0], dy = m_max[1] - m_min[1], dz = m_max[2] - m_min[2];
+            return dx * dy + dy * dz + dz * dx;
+        }
+    };
+    
+    //entry distance of ray into box, or false if it misses the box or enters beyond maxDist
+    bool rayBoxEntry(const float boxMin[3], const float boxMax[3], const double origin[3], const double invDir[3], const double& maxDist, double& entryOut)
+    {
+        double tNear = 0.0, tFar = maxDist;
+        for (int i = 0; i < 3; ++i)
+        {
+            double t1 = (boxMin[i] - origin[i]) * invDir[i];
+            double t2 = (boxMax[i] - origin[i]) * invDir[i];
+            if (t1 > t2) swap(t1, t2);
+            if (t1 > tNear) tNear = t1;//comparisons written so NaN (origin on the slab with zero direction) doesn't shrink the interval
+            if (t2 < tFar) tFar = t2;
+            if (tNear > tFar) return false;
+        }
+        entryOut = tNear;
+        return true;
+    }
+}
+
+CaretTriangleBVH::CaretTriangleBVH(const float* coordsIn, const int64_t numCoords, const int32_t* trianglesIn, const int64_t numTriangles)
+{
+    m_coords.assign(coordsIn, coordsIn + numCoords * 3);
+    m_triangles.assign(trianglesIn, trianglesIn + numTriangles * 3);
+    vector<float> centroids(numTriangles * 3), triMin(numTriangles * 3), triMax(numTriangles * 3);
+    for (int64_t t = 0; t < numTriangles; ++t)
+    {
+        const int32_t* tri = trianglesIn + t * 3;
+        for (int i = 0; i < 3; ++i)
+        {
+            CaretAssert(tri[i] >= 0 && tri[i] < numCoords);
+            float a = coordsIn[tri[0] * 3 + i], b = coordsIn[tri[1] * 3 + i], c = coordsIn[tri[2] * 3 + i];
+            triMin[t * 3 + i] = min(a, min(b, c));
+            triMax[t * 3 + i] = max(a, max(b, c));
+            centroids[t * 3 + i] = (triMin[t * 3 + i] + triMax[t * 3 + i]) * 0.5f;
+        }
+    }
+    build(centroids, triMin, triMax);
+}
+
+void CaretTriangleBVH::build(const vector<float>& centroids, const vector<float>& triMin, const vector<float>& triMax)
+{//top down, binned surface area heuristic, nodes in depth-first order so the first child of an interior node immediately follows it
+    int64_t numTriangles = getNumberOfTriangles();
+    m_nodes.clear();
+    m_order.resize(numTriangles);
+    for (int64_t t = 0; t < numTriangles; ++t) m_order[t] = t;
+    if (numTriangles == 0) return;
+    m_nodes.reserve(2 * (numTriangles / LEAF_SIZE + 1));
+    vector<BuildTask> tasks;
+    BuildTask rootTask = { 0, numTriangles, -1 };
+    tasks.push_back(rootTask);
+    while (!tasks.empty())
+    {
+        BuildTask task = tasks.back();
+        tasks.pop_back();
+        int64_t nodeIndex = (int64_t)m_nodes.size();
+        if (task.m_parent >= 0) m_nodes[task.m_parent].m_start = nodeIndex;
+        Node thisNode;
+        Bin bounds, centroidBounds;
+        for (int64_t i = task.m_begin; i < task.m_end; ++i)
+        {
+            int64_t t = m_order[i];
+            bounds.expand(&triMin[t * 3], &triMax[t * 3]);
+            centroidBounds.expand(&centroids[t * 3], &centroids[t * 3]);
+        }
+        bounds.m_count = task.m_end - task.m_begin;
+        for (int i = 0; i < 3; ++i)
+        {
+            thisNode.m_min[i] = bounds.m_min[i];
+            thisNode.m_max[i] = bounds.m_max[i];
+        }
+        thisNode.m_start = task.m_begin;
+        thisNode.m_count = (int32_t)bounds.m_count;
+        m_nodes.push_back(thisNode);
+        if (bounds.m_count <= LEAF_SIZE) continue;
+        int bestAxis = -1, bestSplit = -1;
+        float bestCost = numeric_limits<float>::max();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float extent = centroidBounds.m_max[axis] - centroidBounds.m_min[axis];
+            if (!(extent > 0.0f)) continue;
+            Bin bins[NUM_BINS];
+            float scale = NUM_BINS / extent;
+            for (int64_t i = task.m_begin; i < task.m_end; ++i)
+            {
+                int64_t t = m_order[i];
+                int bin = min(NUM_BINS - 1, (int)((centroids[t * 3 + axis] - centroidBounds.m_min[axis]) * scale));
+                bins[bin].expand(&triMin[t * 3], &triMax[t * 3]);
+                ++bins[bin].m_count;
+            }
+            float rightArea[NUM_BINS];
+            int64_t rightCount[NUM_BINS];
+            Bin accum;
+            for (int b = NUM_BINS - 1; b > 0; --b)
+            {
+                accum.expand(bins[b].m_min, bins[b].m_max);
+                accum.m_count += bins[b].m_count;
+                rightArea[b] = accum.halfArea();
+                rightCount[b] = accum.m_count;
+            }
+            accum = Bin();
+            for (int b = 0; b < NUM_BINS - 1; ++b)
+            {//split between bin b and b + 1
+                accum.expand(bins[b].m_min, bins[b].m_max);
+                accum.m_count += bins[b].m_count;
+                if (accum.m_count == 0 || rightCount[b + 1] == 0) continue;
+                float cost = accum.halfArea() * accum.m_count + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+        if (bestAxis == -1)
+        {//all centroids identical, can't split them spatially
+            continue;
+        }
+        int64_t* beginPtr = m_order.data() + task.m_begin, *endPtr = m_order.data() + task.m_end;
+        float axisMin = centroidBounds.m_min[bestAxis], scale = NUM_BINS / (centroidBounds.m_max[bestAxis] - axisMin);
+        int64_t* midPtr = partition(beginPtr, endPtr, [&](const int64_t& t)
+        {
+            return min(NUM_BINS - 1, (int)((centroids[t * 3 + bestAxis] - axisMin) * scale)) <= bestSplit;
+        });
+        int64_t mid = task.m_begin + (midPtr - beginPtr);
+        CaretAssert(mid > task.m_begin && mid < task.m_end);
+        m_nodes.back().m_count = 0;
+        BuildTask second = { mid, task.m_end, nodeIndex }, first = { task.m_begin, mid, -1 };
+        tasks.push_back(second);
+        tasks.push_back(first);//processed next, so it becomes nodeIndex + 1
+    }
+}
+
+bool CaretTriangleBVH::intersectTriangle(const int64_t triangle, const double origin[3], const double direction[3], const double& maxDist, RayHit& hitOut) const
+{//Moller-Trumbore, accepts both windings since surfaces can be viewed from either side
+    const double EDGE_TOLERANCE = 1e-9;//don't let a ray exactly on a shared edge miss both triangles
+    const int32_t* tri = m_triangles.data() + triangle * 3;
+    const float* v0 = m_coords.data() + tri[0] * 3, *v1 = m_coords.data() + tri[1] * 3, *v2 = m_coords.data() + tri[2] * 3;
+    double e1[3] = { (double)v1[0] - v0[0], (double)v1[1] - v0[1], (double)v1[2] - v0[2] };
+    double e2[3] = { (double)v2[0] - v0[0], (double)v2[1] - v0[1], (double)v2[2] - v0[2] };
+    double p[3] = { direction[1] * e2[2] - direction[2] * e2[1], direction[2] * e2[0] - direction[0] * e2[2], direction[0] * e2[1] - direction[1] * e2[0] };
+    double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (det == 0.0 || !(abs(det) > 0.0)) return false;//parallel, degenerate, or NaN
+    double invDet = 1.0 / det;
+    double s[3] = { origin[0] - v0[0], origin[1] - v0[1], origin[2] - v0[2] };
+    double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+    if (u < -EDGE_TOLERANCE || u > 1.0 + EDGE_TOLERANCE) return false;
+    double q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+    double v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * invDet;
+    if (v < -EDGE_TOLERANCE || u + v > 1.0 + EDGE_TOLERANCE) return false;
+    double t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+    if (t < 0.0 || t > maxDist) return false;
+    hitOut.m_triangle = triangle;
+    hitOut.m_distance = (float)t;
+    hitOut.m_barycentric[0] = (float)(1.0 - u - v);
+    hitOut.m_barycentric[1] = (float)u;
+    hitOut.m_barycentric[2] = (float)v;
+    for (int i = 0; i < 3; ++i)
+    {
+        hitOut.m_xyz[i] = (float)(origin[i] + t * direction[i]);
+    }
+    return true;
+}
+
+bool CaretTriangleBVH::closestRayHit(const float origin[3], const float direction[3], RayHit& hitOut, const function<bool(const RayHit&)>& acceptHit) const
+{
+    hitOut = RayHit();
+    if (m_nodes.empty()) return false;
+    double dOrigin[3] = { origin[0], origin[1], origin[2] }, dDir[3] = { direction[0], direction[1], direction[2] }, invDir[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        invDir[i] = 1.0 / dDir[i];//infinity for zero components is what the slab test wants
+    }
+    double bestDist = numeric_limits<double>::max(), entry;
+    bool found = false;
+    vector<int64_t> stack;
+    stack.reserve(64);
+    if (rayBoxEntry(m_nodes[0].m_min, m_nodes[0].m_max, dOrigin, invDir, bestDist, entry)) stack.push_back(0);
+    RayHit tempHit;
+    while (!stack.empty())
+    {
+        const Node& thisNode = m_nodes[stack.back()];
+        int64_t thisIndex = stack.back();
+        stack.pop_back();
+        if (!rayBoxEntry(thisNode.m_min, thisNode.m_max, dOrigin, invDir, bestDist, entry)) continue;//best may have improved since push
+        if (thisNode.m_count > 0)
+        {
+            for (int64_t i = thisNode.m_start; i < thisNode.m_start + thisNode.m_count; ++i)
+            {
+                if (intersectTriangle(m_order[i], dOrigin, dDir, bestDist, tempHit) && (!acceptHit || acceptHit(tempHit)))
+                {
+                    bestDist = tempHit.m_distance;
+                    hitOut = tempHit;
+                    found = true;
+                }
+            }
+        } else {
+            int64_t first = thisIndex + 1, second = thisNode.m_start;
+            double firstEntry, secondEntry;
+            bool firstHit = rayBoxEntry(m_nodes[first].m_min, m_nodes[first].m_max, dOrigin, invDir, bestDist, firstEntry);
+            bool secondHit = rayBoxEntry(m_nodes[second].m_min, m_nodes[second].m_max, dOrigin, invDir, bestDist, secondEntry);
+            if (firstHit && secondHit)
+            {//visit the nearer child first, so the farther one is more likely to be culled
+                if (firstEntry <= secondEntry)
+                {
+                    stack.push_back(second);
+                    stack.push_back(first);
+                } else {
+                    stack.push_back(first);
+                    stack.push_back(second);
+                }
+            } else if (firstHit) {
+                stack.push_back(first);
+            } else if (secondHit) {
+                stack.push_back(second);
+            }
+        }
+    }
+    return found;
+}
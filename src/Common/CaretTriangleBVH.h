@@ -0,0 +1,72 @@
+#ifndef __CARET_TRIANGLE_BVH_H__
+#define __CARET_TRIANGLE_BVH_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <functional>
+#include <vector>
+
+#include <stdint.h>
+
+namespace caret {
+    
+    ///bounding volume hierarchy over the triangles of a mesh, for ray casting
+    class CaretTriangleBVH
+    {
+    public:
+        struct RayHit
+        {
+            int64_t m_triangle;
+            float m_distance;//in units of the direction vector's length
+            float m_barycentric[3];//weights of the triangle's three vertices, in triangle order
+            float m_xyz[3];
+            RayHit() { m_triangle = -1; m_distance = -1.0f; }
+        };
+        
+        ///copies the coordinates and triangles, so the mesh can change without affecting the BVH
+        CaretTriangleBVH(const float* coordsIn, const int64_t numCoords, const int32_t* trianglesIn, const int64_t numTriangles);
+        
+        ///closest intersection with distance >= 0 along the ray, from either side of the triangle, optionally only considering hits that acceptHit returns true for
+        bool closestRayHit(const float origin[3], const float direction[3], RayHit& hitOut,
+                           const std::function<bool(const RayHit&)>& acceptHit = std::function<bool(const RayHit&)>()) const;
+        
+        int64_t getNumberOfTriangles() const { return (int64_t)(m_triangles.size() / 3); }
+    private:
+        struct Node
+        {
+            float m_min[3], m_max[3];
+            int64_t m_start;//leaf: first position in m_order, interior: index of second child (first child is the next node)
+            int32_t m_count;//0 for interior nodes
+        };
+        std::vector<Node> m_nodes;
+        std::vector<int64_t> m_order;//triangle indices, grouped by leaf
+        std::vector<float> m_coords;
+        std::vector<int32_t> m_triangles;
+        static const int32_t LEAF_SIZE = 4;
+        static const int32_t NUM_BINS = 16;
+        
+        void build(const std::vector<float>& centroids, const std::vector<float>& triMin, const std::vector<float>& triMax);
+        bool intersectTriangle(const int64_t triangle, const double origin[3], const double direction[3], const double& maxDist, RayHit& hitOut) const;
+    };
+    
+}
+
+#endif //__CARET_TRIANGLE_BVH_H__
@@ -162,6 +162,32 @@ void FastStatistics::update(const float* data, const int64_t& dataCount)
     }
 }
 
+void FastStatistics::setStatistics(const float& minVal, const float& maxVal, const float& mean, const float& stdDevPop, const float& stdDevSample,
+                                   const int64_t& zeroCount, const int64_t& infCount, const int64_t& negInfCount, const int64_t& nanCount,
+                                   const Histogram& posPercentHist, const Histogram& negPercentHist, const Histogram& absPercentHist)
+{
+    reset();
+    m_min = minVal;
+    m_max = maxVal;
+    m_mean = mean;
+    m_stdDevPop = stdDevPop;
+    m_stdDevSample = stdDevSample;
+    m_zeroCount = zeroCount;
+    m_infCount = infCount;
+    m_negInfCount = negInfCount;
+    m_nanCount = nanCount;
+    m_posPercentHist = posPercentHist;
+    m_negPercentHist = negPercentHist;
+    m_absPercentHist = absPercentHist;
+    int64_t junk;
+    posPercentHist.getCounts(m_posCount, junk, junk, junk, junk, junk);
+    negPercentHist.getCounts(junk, junk, m_negCount, junk, junk, junk);
+    absPercentHist.getCounts(m_absCount, junk, junk, junk, junk, junk);//absolute values are all positive
+    posPercentHist.getRange(m_leastPos, m_mostPos);//empty histograms have a zero range, which is what update() uses when there are none
+    negPercentHist.getRange(m_mostNeg, m_leastNeg);
+    absPercentHist.getRange(m_leastAbs, m_mostAbs);
+}
+
 void FastStatistics::update(const float* data, const int64_t& dataCount, const float& minThreshInclusive, const float& maxThreshInclusive)
 {
     reset();
@@ -46,6 +46,12 @@ namespace caret
         
         void update(const float* data, const int64_t& dataCount);
         
+        ///restore statistics that were computed elsewhere (stored in a file, for instance), the percentile histograms must be of the positive, negative, and absolute values, as update() makes them
+        ///the counts and extremes of each sign are taken from the percentile histograms
+        void setStatistics(const float& minVal, const float& maxVal, const float& mean, const float& stdDevPop, const float& stdDevSample,
+                           const int64_t& zeroCount, const int64_t& infCount, const int64_t& negInfCount, const int64_t& nanCount,
+                           const Histogram& posPercentHist, const Histogram& negPercentHist, const Histogram& absPercentHist);
+        
         ///statistics and display are really not that related, so for now, only include a continuous clipping range, excluding the middle from data will do weird things to standard deviation
         void update(const float* data, const int64_t& dataCount, const float& minThreshInclusive, const float& maxThreshInclusive);
         
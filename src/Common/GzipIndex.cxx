@@ -0,0 +1,297 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GzipIndex.h"
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "DataFileException.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include "zlib.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace caret;
+using namespace std;
+
+const int64_t GzipIndex::DEFAULT_SPAN = 1<<22;//4MiB, an index entry costs up to 32KiB, so this keeps the index under 1% of the uncompressed size
+const int32_t GzipIndex::WINDOW_SIZE = 1<<15;//maximum deflate distance
+
+namespace
+{
+    const char INDEX_MAGIC[8] = { 'W', 'B', 'G', 'Z', 'I', 'D', 'X', '2' };
+    const int64_t INPUT_CHUNK = 1<<20;
+    const int64_t HEAD_CHECK_SIZE = 1<<12;
+    
+    //size and modification time can match after a rewrite (same size output, restored or coarse timestamps), so also check some content
+    //the last 8 bytes are the CRC32 and length of the final gzip member's data, so this is cheap and still covers the whole stream in most cases
+    bool getContentCheck(const QString& gzFileName, int64_t& headCheckOut, int64_t& tailCheckOut)
+    {
+        QFile inFile(gzFileName);
+        if (!inFile.open(QIODevice::ReadOnly)) return false;
+        int64_t fileSize = inFile.size();
+        if (fileSize < 18) return false;//smallest possible gzip file, 10 byte header and 8 byte trailer
+        vector<unsigned char> head(min(fileSize, HEAD_CHECK_SIZE));
+        if (inFile.read((char*)head.data(), head.size()) != (qint64)head.size()) return false;
+        headCheckOut = crc32(crc32(0L, Z_NULL, 0), head.data(), head.size());
+        unsigned char tail[8];
+        if (!inFile.seek(fileSize - 8) || inFile.read((char*)tail, 8) != 8) return false;
+        tailCheckOut = 0;
+        for (int i = 7; i >= 0; --i)
+        {
+            tailCheckOut = (tailCheckOut << 8) | tail[i];
+        }
+        return true;
+    }
+}
+
+GzipIndex::GzipIndex()
+{
+    m_uncompressedSize = -1;
+    m_compressedSize = -1;
+    m_compressedModified = -1;
+    m_span = DEFAULT_SPAN;
+    m_headCheck = -1;
+    m_tailCheck = -1;
+}
+
+QString GzipIndex::getIndexFileName(const QString& gzFileName)
+{
+    return gzFileName + "idx";//foo.nii.gz -> foo.nii.gzidx, so that it sorts next to the file
+}
+
+void GzipIndex::removeIndexFile(const QString& gzFileName)
+{
+    QString indexFileName = getIndexFileName(gzFileName);
+    if (QFile::exists(indexFileName) && !QFile::remove(indexFileName))
+    {//readIndex will still reject it, as long as the new file's content differs
+        CaretLogWarning("failed to remove gzip index file '" + indexFileName + "' for rewritten file");
+    }
+}
+
+void GzipIndex::build(const QString& gzFileName, const int64_t& span)
+{
+    if (span < WINDOW_SIZE) throw DataFileException(gzFileName, "gzip index span must be at least 32KiB");
+    QFile inFile(gzFileName);
+    if (!inFile.open(QIODevice::ReadOnly)) throw DataFileException(gzFileName, "failed to open file for reading");
+    m_points.clear();
+    m_span = span;
+    z_stream strm;
+    memset(&strm, 0, sizeof(z_stream));
+    if (inflateInit2(&strm, 47) != Z_OK) throw DataFileException(gzFileName, "failed to initialize zlib");//47: 15 bit window, automatic gzip/zlib header detection
+    vector<unsigned char> input(INPUT_CHUNK), window(WINDOW_SIZE);
+    int64_t totalIn = 0, totalOut = 0, lastPoint = 0;
+    int ret = Z_OK;
+    strm.avail_out = 0;
+    try
+    {
+        while (true)
+        {
+            if (strm.avail_in == 0)
+            {
+                int64_t numRead = inFile.read((char*)input.data(), INPUT_CHUNK);
+                if (numRead < 0) throw DataFileException(gzFileName, "error while reading file");
+                if (numRead == 0) throw DataFileException(gzFileName, "premature end of compressed file");
+                strm.avail_in = (uInt)numRead;
+                strm.next_in = input.data();
+            }
+            if (strm.avail_out == 0)
+            {//decompress into the window as a circular buffer, we only need the output for the access points
+                strm.avail_out = WINDOW_SIZE;
+                strm.next_out = window.data();
+            }
+            totalIn += strm.avail_in;
+            totalOut += strm.avail_out;
+            ret = inflate(&strm, Z_BLOCK);//stop at the end of each deflate block
+            totalIn -= strm.avail_in;
+            totalOut -= strm.avail_out;
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR) throw DataFileException(gzFileName, "file is not a valid gzip file, or is corrupted");
+            if (ret == Z_MEM_ERROR) throw DataFileException(gzFileName, "zlib ran out of memory while building index");
+            if (ret == Z_STREAM_END)
+            {//handle concatenated gzip members the way gzread does, ignore trailing garbage
+                if (strm.avail_in == 0)
+                {
+                    int64_t numRead = inFile.read((char*)input.data(), INPUT_CHUNK);
+                    if (numRead < 0) throw DataFileException(gzFileName, "error while reading file");
+                    strm.avail_in = (uInt)numRead;
+                    strm.next_in = input.data();
+                }
+                if (strm.avail_in == 0 || strm.next_in[0] != 0x1f) break;
+                if (inflateReset2(&strm, 31) != Z_OK) throw DataFileException(gzFileName, "failed to reset zlib stream");
+                continue;
+            }
+            //data_type bit 128 means we are at the end of a block or the header, 64 means it is the final block
+            if ((strm.data_type & 128) && !(strm.data_type & 64) && (m_points.empty() || totalOut - lastPoint > span))
+            {
+                AccessPoint newPoint;
+                newPoint.m_uncompressedOffset = totalOut;
+                newPoint.m_compressedOffset = totalIn;
+                newPoint.m_bits = strm.data_type & 7;
+                int64_t windowUsed = min(totalOut, (int64_t)WINDOW_SIZE);
+                newPoint.m_window.resize(windowUsed);
+                int64_t circPos = WINDOW_SIZE - strm.avail_out;//next write position in the circular buffer
+                for (int64_t i = 0; i < windowUsed; ++i)
+                {
+                    newPoint.m_window[i] = window[(circPos - windowUsed + i + WINDOW_SIZE) % WINDOW_SIZE];
+                }
+                m_points.push_back(newPoint);
+                lastPoint = totalOut;
+            }
+        }
+    } catch (...) {
+        inflateEnd(&strm);
+        m_points.clear();
+        throw;
+    }
+    inflateEnd(&strm);
+    if (!getContentCheck(gzFileName, m_headCheck, m_tailCheck))
+    {
+        m_points.clear();
+        throw DataFileException(gzFileName, "failed to read file for gzip index content check");
+    }
+    m_uncompressedSize = totalOut;
+    QFileInfo gzInfo(gzFileName);
+    m_compressedSize = gzInfo.size();
+    m_compressedModified = gzInfo.lastModified().toMSecsSinceEpoch();
+    CaretLogFine("built gzip index for '" + gzFileName + "' with " + QString::number(m_points.size()) + " access points");
+}
+
+void GzipIndex::writeIndex(const QString& indexFileName) const
+{
+    if (m_uncompressedSize < 0) throw DataFileException(indexFileName, "gzip index has not been built");
+    QFile outFile(indexFileName);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) throw DataFileException(indexFileName, "failed to open file for writing");
+    QDataStream outStream(&outFile);
+    outStream.setByteOrder(QDataStream::LittleEndian);
+    outStream.writeRawData(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    outStream << (qint64)m_compressedSize << (qint64)m_compressedModified << (qint64)m_headCheck << (qint64)m_tailCheck << (qint64)m_uncompressedSize << (qint64)m_span << (qint64)m_points.size();
+    vector<unsigned char> packed(compressBound(WINDOW_SIZE));
+    for (size_t i = 0; i < m_points.size(); ++i)
+    {
+        const AccessPoint& thisPoint = m_points[i];
+        uLongf packedSize = packed.size();
+        if (!thisPoint.m_window.empty())
+        {//windows usually compress well, and are most of the index size
+            if (compress2(packed.data(), &packedSize, thisPoint.m_window.data(), thisPoint.m_window.size(), Z_BEST_SPEED) != Z_OK)
+            {
+                throw DataFileException(indexFileName, "failed to compress gzip index window");
+            }
+        } else {
+            packedSize = 0;
+        }
+        outStream << (qint64)thisPoint.m_uncompressedOffset << (qint64)thisPoint.m_compressedOffset << (qint32)thisPoint.m_bits
+                  << (qint32)thisPoint.m_window.size() << (qint32)packedSize;
+        outStream.writeRawData((const char*)packed.data(), packedSize);
+    }
+    if (outStream.status() != QDataStream::Ok || !outFile.flush()) throw DataFileException(indexFileName, "error writing gzip index file");
+    outFile.close();
+}
+
+bool GzipIndex::readIndex(const QString& indexFileName, const QString& gzFileName)
+{
+    m_points.clear();
+    m_uncompressedSize = -1;
+    QFile inFile(indexFileName);
+    if (!inFile.exists() || !inFile.open(QIODevice::ReadOnly)) return false;
+    QDataStream inStream(&inFile);
+    inStream.setByteOrder(QDataStream::LittleEndian);
+    char magic[sizeof(INDEX_MAGIC)];
+    if (inStream.readRawData(magic, sizeof(INDEX_MAGIC)) != (int)sizeof(INDEX_MAGIC) || memcmp(magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+    {
+        CaretLogWarning("ignoring gzip index file '" + indexFileName + "', unrecognized format");
+        return false;
+    }
+    qint64 compSize, compModified, headCheck, tailCheck, uncompSize, span, numPoints;
+    inStream >> compSize >> compModified >> headCheck >> tailCheck >> uncompSize >> span >> numPoints;
+    QFileInfo gzInfo(gzFileName);
+    int64_t curHeadCheck = -1, curTailCheck = -1;
+    if (compSize != gzInfo.size() || compModified != gzInfo.lastModified().toMSecsSinceEpoch() ||
+        !getContentCheck(gzFileName, curHeadCheck, curTailCheck) || headCheck != curHeadCheck || tailCheck != curTailCheck)
+    {//don't trust an index for a file that has changed, it would silently return the wrong data
+        CaretLogWarning("ignoring gzip index file '" + indexFileName + "', the compressed file has changed since it was indexed");
+        return false;
+    }
+    const qint64 minPointBytes = 8 + 8 + 4 + 4 + 4;//offsets, bits and sizes, the window may be empty
+    if (inStream.status() != QDataStream::Ok || numPoints < 1 || uncompSize < 0 || numPoints > (inFile.size() - inFile.pos()) / minPointBytes)
+    {//check the count against the file size before allocating for it
+        CaretLogWarning("ignoring gzip index file '" + indexFileName + "', file is corrupted");
+        return false;
+    }
+    vector<unsigned char> packed(compressBound(WINDOW_SIZE));
+    m_points.resize(numPoints);
+    for (qint64 i = 0; i < numPoints; ++i)
+    {
+        AccessPoint& thisPoint = m_points[i];
+        qint64 uncompOffset, compOffset;
+        qint32 bits, windowSize, packedSize;
+        inStream >> uncompOffset >> compOffset >> bits >> windowSize >> packedSize;
+        if (inStream.status() != QDataStream::Ok || bits < 0 || bits > 7 || windowSize < 0 || windowSize > WINDOW_SIZE ||
+            packedSize < 0 || packedSize > (qint32)packed.size() || (i > 0 && uncompOffset < m_points[i - 1].m_uncompressedOffset))
+        {
+            CaretLogWarning("ignoring gzip index file '" + indexFileName + "', file is corrupted");
+            m_points.clear();
+            return false;
+        }
+        thisPoint.m_uncompressedOffset = uncompOffset;
+        thisPoint.m_compressedOffset = compOffset;
+        thisPoint.m_bits = bits;
+        thisPoint.m_window.resize(windowSize);
+        if (windowSize > 0)
+        {
+            uLongf unpackedSize = windowSize;
+            if (inStream.readRawData((char*)packed.data(), packedSize) != packedSize ||
+                uncompress(thisPoint.m_window.data(), &unpackedSize, packed.data(), packedSize) != Z_OK || (qint32)unpackedSize != windowSize)
+            {
+                CaretLogWarning("ignoring gzip index file '" + indexFileName + "', file is corrupted");
+                m_points.clear();
+                return false;
+            }
+        }
+    }
+    m_compressedSize = compSize;
+    m_compressedModified = compModified;
+    m_headCheck = headCheck;
+    m_tailCheck = tailCheck;
+    m_uncompressedSize = uncompSize;
+    m_span = span;
+    return true;
+}
+
+const GzipIndex::AccessPoint& GzipIndex::getAccessPoint(const int64_t& uncompressedOffset) const
+{
+    CaretAssert(!m_points.empty());
+    int64_t low = 0, high = (int64_t)m_points.size();//binary search for last point with offset <= requested
+    while (high - low > 1)
+    {
+        int64_t mid = (low + high) / 2;
+        if (m_points[mid].m_uncompressedOffset <= uncompressedOffset)
+        {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return m_points[low];
+}
@@ -0,0 +1,84 @@
+#ifndef __GZIP_INDEX_H__
+#define __GZIP_INDEX_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <QString>
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    /**
+     * Random access index for an ordinary gzip file, stored in a sidecar file.
+     *
+     * Records deflate block boundaries at roughly every "span" bytes of uncompressed
+     * data, along with the 32KiB of output preceding each one, so that decompression
+     * can be restarted from the nearest access point instead of from the beginning
+     * of the file (the technique from zlib's examples/zran.c).  The gzip file itself
+     * is not modified, so other software can still read it.
+     */
+    class GzipIndex
+    {
+    public:
+        struct AccessPoint
+        {
+            int64_t m_uncompressedOffset;
+            int64_t m_compressedOffset;//offset of the first byte that is entirely in the new block
+            int32_t m_bits;//number of bits of the block that are in the previous byte, 0-7
+            std::vector<unsigned char> m_window;//uncompressed data preceding the access point, up to 32KiB
+        };
+
+        static const int64_t DEFAULT_SPAN;
+        static const int32_t WINDOW_SIZE;
+
+        GzipIndex();
+
+        ///the sidecar filename that CaretBinaryFile looks for when opening a .gz file for reading
+        static QString getIndexFileName(const QString& gzFileName);
+
+        ///decompress the entire file once, recording access points - throws DataFileException
+        void build(const QString& gzFileName, const int64_t& span = DEFAULT_SPAN);
+
+        ///remove the sidecar file if there is one, for when the gzip file is rewritten
+        static void removeIndexFile(const QString& gzFileName);
+
+        ///write to a sidecar file, including the size, modification time and a content check of the gzip file - throws DataFileException
+        void writeIndex(const QString& indexFileName) const;
+
+        ///returns false if the index file doesn't exist, is unreadable, or doesn't match the current gzip file
+        bool readIndex(const QString& indexFileName, const QString& gzFileName);
+
+        int64_t getUncompressedSize() const { return m_uncompressedSize; }
+        int64_t getNumberOfAccessPoints() const { return (int64_t)m_points.size(); }
+
+        ///the last access point at or before the given uncompressed offset
+        const AccessPoint& getAccessPoint(const int64_t& uncompressedOffset) const;
+    private:
+        std::vector<AccessPoint> m_points;
+        int64_t m_uncompressedSize, m_compressedSize, m_compressedModified, m_span;
+        int64_t m_headCheck, m_tailCheck;//CRC32 of the start of the gzip file, and its last 8 bytes (the gzip trailer)
+    };
+
+} //namespace caret
+
+#endif //__GZIP_INDEX_H__
@@ -326,6 +326,36 @@ void Histogram::update(const float* data, const int64_t& dataCount, float mostPo
     }
 }
 
+void Histogram::setHistogram(const vector<int64_t>& bucketCounts, const float& bucketMin, const float& bucketMax,
+                             const int64_t& posCount, const int64_t& zeroCount, const int64_t& negCount,
+                             const int64_t& infCount, const int64_t& negInfCount, const int64_t& nanCount)
+{
+    int numBuckets = (int)bucketCounts.size();
+    resize(numBuckets);
+    reset();
+    m_posCount = posCount;
+    m_zeroCount = zeroCount;
+    m_negCount = negCount;
+    m_infCount = infCount;
+    m_negInfCount = negInfCount;
+    m_nanCount = nanCount;
+    m_bucketMin = bucketMin;
+    m_bucketMax = bucketMax;
+    m_buckets = bucketCounts;
+    computeCumulative();
+    if (m_bucketMax > m_bucketMin)
+    {//display stays zeroed when the range is zero, like update()
+        float bucketsize = (m_bucketMax - m_bucketMin) / numBuckets;
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            m_display[i] = m_buckets[i] / bucketsize;
+            if (m_display[i] > m_displayHeightMax) {
+                m_displayHeightMax = m_display[i];
+            }
+        }
+    }
+}
+
 void Histogram::computeCumulative()
 {
     int numBuckets = (int)m_buckets.size();
@@ -71,6 +71,17 @@ namespace caret
                     float mostNegativeValueInclusive,
                     const bool& includeZeroValues);
         
+        ///restore a histogram that was computed elsewhere (stored in a file, for instance), cumulative and display values are recomputed
+        void setHistogram(const std::vector<int64_t>& bucketCounts,
+                          const float& bucketMin,
+                          const float& bucketMax,
+                          const int64_t& posCount,
+                          const int64_t& zeroCount,
+                          const int64_t& negCount,
+                          const int64_t& infCount,
+                          const int64_t& negInfCount,
+                          const int64_t& nanCount);
+        
         ///get raw counts (useful mathematically)
         const std::vector<int64_t>& getHistogramCounts() const { return m_buckets; }
         
@@ -0,0 +1,241 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ReductionAccumulator.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+#include "MathFunctions.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace caret;
+using namespace std;
+
+ReductionAccumulator::ReductionAccumulator(const ReductionEnum::Enum& type, const bool& onlyNumeric)
+{//don't throw here, algorithms construct these inside omp regions
+    m_type = type;
+    m_onlyNumeric = onlyNumeric;
+    reset();
+}
+
+void ReductionAccumulator::reset()
+{
+    m_position = 0;
+    m_count = 0;
+    m_nonzero = 0;
+    m_extremeIndex = -1;
+    m_sum = 0.0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_product = 1.0;
+    m_extreme = 0.0f;
+    m_values.clear();//doesn't change allocation
+    m_histogram.clear();
+}
+
+void ReductionAccumulator::reserve(const int64_t& numValues)
+{
+    if (m_type == ReductionEnum::MEDIAN) m_values.reserve(numValues);
+}
+
+void ReductionAccumulator::addValue(const float& value)
+{
+    int64_t position = m_position;
+    ++m_position;
+    if (m_onlyNumeric && !MathFunctions::isNumeric(value)) return;
+    ++m_count;
+    switch (m_type)
+    {
+        case ReductionEnum::INVALID:
+            break;
+        case ReductionEnum::MEAN:
+        case ReductionEnum::SUM:
+            m_sum += value;
+            break;
+        case ReductionEnum::STDEV:
+        case ReductionEnum::SAMPSTDEV:
+        case ReductionEnum::VARIANCE:
+        case ReductionEnum::TSNR:
+        case ReductionEnum::COV:
+        {
+            m_sum += value;//keep the plain sum too, so the mean is exactly what reduce() would use
+            double delta = value - m_mean;
+            m_mean += delta / m_count;
+            m_m2 += delta * (value - m_mean);
+            break;
+        }
+        case ReductionEnum::L2NORM:
+            m_sum += value * value;
+            break;
+        case ReductionEnum::PRODUCT:
+            m_product *= value;
+            break;
+        case ReductionEnum::MAX:
+        case ReductionEnum::INDEXMAX:
+            if (m_count == 1 || value > m_extreme)
+            {
+                m_extreme = value;
+                m_extremeIndex = position;
+            }
+            break;
+        case ReductionEnum::MIN:
+        case ReductionEnum::INDEXMIN:
+            if (m_count == 1 || value < m_extreme)
+            {
+                m_extreme = value;
+                m_extremeIndex = position;
+            }
+            break;
+        case ReductionEnum::MEDIAN:
+            m_values.push_back(value);
+            break;
+        case ReductionEnum::MODE:
+            ++m_histogram[value];
+            break;
+        case ReductionEnum::COUNT_NONZERO:
+            if (value != 0.0f) ++m_nonzero;
+            break;
+    }
+}
+
+void ReductionAccumulator::addValues(const float* data, const int64_t& numElems)
+{
+    for (int64_t i = 0; i < numElems; ++i)
+    {
+        addValue(data[i]);
+    }
+}
+
+void ReductionAccumulator::merge(const ReductionAccumulator& rhs)
+{
+    CaretAssert(rhs.m_type == m_type && rhs.m_onlyNumeric == m_onlyNumeric);
+    if (rhs.m_count > 0)
+    {
+        int64_t newCount = m_count + rhs.m_count;
+        double delta = rhs.m_mean - m_mean;//Chan et al. pairwise combination
+        m_mean += delta * rhs.m_count / newCount;
+        m_m2 += rhs.m_m2 + delta * delta * m_count * rhs.m_count / newCount;
+        m_sum += rhs.m_sum;
+        m_product *= rhs.m_product;
+        m_nonzero += rhs.m_nonzero;
+        bool useRight = (m_count == 0);
+        switch (m_type)
+        {
+            case ReductionEnum::MAX:
+            case ReductionEnum::INDEXMAX:
+                useRight = useRight || rhs.m_extreme > m_extreme;
+                break;
+            case ReductionEnum::MIN:
+            case ReductionEnum::INDEXMIN:
+                useRight = useRight || rhs.m_extreme < m_extreme;
+                break;
+            default:
+                break;
+        }
+        if (useRight)
+        {
+            m_extreme = rhs.m_extreme;
+            m_extremeIndex = rhs.m_extremeIndex + m_position;
+        }
+        m_values.insert(m_values.end(), rhs.m_values.begin(), rhs.m_values.end());
+        for (unordered_map<float, int64_t>::const_iterator iter = rhs.m_histogram.begin(); iter != rhs.m_histogram.end(); ++iter)
+        {
+            m_histogram[iter->first] += iter->second;
+        }
+        m_count = newCount;
+    }
+    m_position += rhs.m_position;
+}
+
+float ReductionAccumulator::getResult() const
+{
+    if (m_type == ReductionEnum::INVALID) throw CaretException("reduction requested with 'INVALID' method");
+    if (m_count == 0)
+    {
+        if (m_onlyNumeric) throw CaretException("all input values to reduction were non-numeric");
+        throw CaretException("reduction requested on zero elements");
+    }
+    switch (m_type)
+    {
+        case ReductionEnum::INVALID:
+            break;
+        case ReductionEnum::SUM:
+            return m_sum;
+        case ReductionEnum::MEAN:
+            return m_sum / m_count;
+        case ReductionEnum::STDEV:
+            return sqrt(m_m2 / m_count);
+        case ReductionEnum::VARIANCE:
+            return m_m2 / m_count;
+        case ReductionEnum::SAMPSTDEV:
+        case ReductionEnum::TSNR:
+        case ReductionEnum::COV:
+        {
+            if (m_count < 2) throw CaretException("taking the sample standard deviation of 1 element would require dividing by zero");
+            double sampstdev = sqrt(m_m2 / (m_count - 1));
+            double mean = m_sum / m_count;
+            if (m_type == ReductionEnum::TSNR) return mean / sampstdev;
+            if (m_type == ReductionEnum::COV) return sampstdev / mean;
+            return sampstdev;
+        }
+        case ReductionEnum::L2NORM:
+            return sqrt(m_sum);
+        case ReductionEnum::PRODUCT:
+            return m_product;
+        case ReductionEnum::MAX:
+        case ReductionEnum::MIN:
+            return m_extreme;
+        case ReductionEnum::INDEXMAX:
+        case ReductionEnum::INDEXMIN:
+            return m_extremeIndex + 1;//1-based, to match gui and column arguments
+        case ReductionEnum::MEDIAN:
+        {//selection instead of sorting, the order statistics are the same
+            int64_t half = m_count / 2;
+            nth_element(m_values.begin(), m_values.begin() + half, m_values.end());
+            float upper = m_values[half];
+            if ((m_count & 1) == 0)//if even, average middle two
+            {
+                float lower = *max_element(m_values.begin(), m_values.begin() + half);
+                return (lower + upper) / 2.0f;
+            }
+            return upper;
+        }
+        case ReductionEnum::MODE:
+        {
+            int64_t bestCount = 0;
+            float bestVal = -1.0f;
+            for (unordered_map<float, int64_t>::const_iterator iter = m_histogram.begin(); iter != m_histogram.end(); ++iter)
+            {//ties go to the lowest value, same as reduce()
+                if (iter->second > bestCount || (iter->second == bestCount && iter->first < bestVal))
+                {
+                    bestVal = iter->first;
+                    bestCount = iter->second;
+                }
+            }
+            return bestVal;
+        }
+        case ReductionEnum::COUNT_NONZERO:
+            return m_nonzero;
+    }
+    CaretAssertMessage(false, "unhandled reduction type");
+    return 0.0f;
+}
@@ -0,0 +1,59 @@
+#ifndef __REDUCTION_ACCUMULATOR_H__
+#define __REDUCTION_ACCUMULATOR_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ReductionEnum.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace caret {
+    
+    ///streaming version of ReductionOperation::reduce, values are added one at a time (or in chunks), and accumulators for pieces of the data can be merged
+    class ReductionAccumulator
+    {
+        ReductionEnum::Enum m_type;
+        bool m_onlyNumeric;
+        int64_t m_position, m_count, m_nonzero, m_extremeIndex;//position counts non-numeric values too, for INDEXMAX/INDEXMIN
+        double m_sum, m_mean, m_m2, m_product;//m_mean and m_m2 are Welford running mean and sum of squared residuals
+        float m_extreme;
+        mutable std::vector<float> m_values;//MEDIAN, the selection reorders it
+        std::unordered_map<float, int64_t> m_histogram;//MODE
+    public:
+        ReductionAccumulator(const ReductionEnum::Enum& type = ReductionEnum::MEAN, const bool& onlyNumeric = false);
+        ///clear the values, but keep any allocations
+        void reset();
+        ///preallocate for the number of values, only matters for MEDIAN
+        void reserve(const int64_t& numValues);
+        void addValue(const float& value);
+        void addValues(const float* data, const int64_t& numElems);
+        ///combine with an accumulator of values that come after the values in this one (order only matters for INDEXMAX/INDEXMIN)
+        void merge(const ReductionAccumulator& rhs);
+        ///same results and exceptions as ReductionOperation::reduce (or reduceOnlyNumeric), except the non-MEAN sum-based types use Welford's method, which may differ in the last bits
+        float getResult() const;
+        int64_t getNumberOfValues() const { return m_count; }
+    };
+    
+}
+
+#endif //__REDUCTION_ACCUMULATOR_H__
@@ -0,0 +1,259 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TfcePermutationHelper.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <string>
+
+using namespace caret;
+using namespace std;
+
+TfcePermutationHelper::TfcePermutationHelper(const vector<int64_t>& neighborStart, const vector<int64_t>& neighbors, const float* elementSizes, const float& param_e, const float& param_h)
+{
+    CaretAssert(!neighborStart.empty());
+    m_numElements = (int64_t)neighborStart.size() - 1;
+    m_neighborStart = neighborStart.data();
+    m_neighbors = neighbors.data();
+    m_elementSizes = elementSizes;
+    m_param_e = param_e;
+    m_param_h = param_h;
+    m_order.resize(m_numElements);
+    m_parent.resize(m_numElements);
+    m_clusterCount.resize(m_numElements);
+    m_accumVal.resize(m_numElements);
+    m_totalSize.resize(m_numElements);
+    m_bestOffset.resize(m_numElements);
+    m_lastVal.resize(m_numElements);
+    m_negated.resize(m_numElements);
+}
+
+int64_t TfcePermutationHelper::findRoot(int64_t element)
+{
+    while (m_parent[element] != element)
+    {
+        m_parent[element] = m_parent[m_parent[element]];//path halving
+        element = m_parent[element];
+    }
+    return element;
+}
+
+void TfcePermutationHelper::updateCluster(const int64_t& root, const float& bottomVal)
+{//same slice integration as AlgorithmMetricTFCE/AlgorithmVolumeTFCE
+    if (bottomVal != m_lastVal[root])
+    {
+        CaretAssert(bottomVal < m_lastVal[root]);
+        double integrated_h = m_param_h + 1.0f;
+        m_accumVal[root] += pow(m_totalSize[root], (double)m_param_e) * (pow((double)m_lastVal[root], integrated_h) - pow((double)bottomVal, integrated_h)) / integrated_h;
+        m_lastVal[root] = bottomVal;
+    }
+}
+
+double TfcePermutationHelper::maxPositive(const float* data, const float* roiData)
+{//the maximum is always at a peak (the first element of a cluster), and all peaks in a cluster share its integral from then on,
+    //so each cluster only needs to track how far its best peak is above the cluster's own accumulated value, instead of per-element values
+    int64_t numUsed = 0;
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {
+        m_parent[i] = -1;
+        if ((roiData == NULL || roiData[i] > 0.0f) && data[i] > 0.0f)
+        {
+            m_order[numUsed] = i;
+            ++numUsed;
+        }
+    }
+    sort(m_order.begin(), m_order.begin() + numUsed, [data](const int64_t& left, const int64_t& right) { return data[left] > data[right]; });
+    for (int64_t k = 0; k < numUsed; ++k)
+    {
+        int64_t element = m_order[k];
+        float value = data[element];
+        m_touching.clear();//doesn't change allocation
+        for (int64_t n = m_neighborStart[element]; n < m_neighborStart[element + 1]; ++n)
+        {
+            int64_t neighbor = m_neighbors[n];
+            if (m_parent[neighbor] != -1)
+            {
+                int64_t root = findRoot(neighbor);
+                if (find(m_touching.begin(), m_touching.end(), root) == m_touching.end()) m_touching.push_back(root);
+            }
+        }
+        switch (m_touching.size())
+        {
+            case 0://new cluster
+                m_parent[element] = element;
+                m_clusterCount[element] = 1;
+                m_accumVal[element] = 0.0;
+                m_totalSize[element] = m_elementSizes[element];
+                m_lastVal[element] = value;
+                m_bestOffset[element] = 0.0;
+                break;
+            case 1:
+            {
+                int64_t root = m_touching[0];
+                updateCluster(root, value);
+                m_totalSize[root] += m_elementSizes[element];
+                ++m_clusterCount[root];
+                m_parent[element] = root;
+                break;
+            }
+            default://merge into the largest cluster
+            {
+                int64_t merged = m_touching[0];
+                for (size_t i = 1; i < m_touching.size(); ++i)
+                {
+                    if (m_clusterCount[m_touching[i]] > m_clusterCount[merged]) merged = m_touching[i];
+                }
+                updateCluster(merged, value);
+                for (size_t i = 0; i < m_touching.size(); ++i)
+                {
+                    int64_t root = m_touching[i];
+                    if (root == merged) continue;
+                    updateCluster(root, value);
+                    m_bestOffset[merged] = max(m_bestOffset[merged], m_accumVal[root] + m_bestOffset[root] - m_accumVal[merged]);
+                    m_totalSize[merged] += m_totalSize[root];
+                    m_clusterCount[merged] += m_clusterCount[root];
+                    m_parent[root] = merged;
+                }
+                m_totalSize[merged] += m_elementSizes[element];
+                ++m_clusterCount[merged];
+                m_parent[element] = merged;
+                break;
+            }
+        }
+    }
+    double ret = 0.0;
+    for (int64_t k = 0; k < numUsed; ++k)
+    {
+        int64_t element = m_order[k];
+        if (m_parent[element] == element)
+        {
+            updateCluster(element, 0.0f);//include the to-zero slice
+            ret = max(ret, m_accumVal[element] + m_bestOffset[element]);
+        }
+    }
+    return ret;
+}
+
+void TfcePermutationHelper::computeExtremes(const float* data, const float* roiData, float& maxOut, float& minOut)
+{
+    maxOut = (float)maxPositive(data, roiData);
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {
+        m_negated[i] = -data[i];
+    }
+    minOut = (float)-maxPositive(m_negated.data(), roiData);
+}
+
+void TfcePermutationHelper::signFlipTStatistic(const vector<const float*>& inputs, const float* signs, const int64_t& numElements, float* tOut)
+{
+    int numInputs = (int)inputs.size();
+    CaretAssert(numInputs > 1);
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < numInputs; ++j)
+        {
+            sum += signs[j] * (double)inputs[j][i];
+        }
+        double mean = sum / numInputs;
+        double sum2 = 0.0;
+        for (int j = 0; j < numInputs; ++j)
+        {//two-pass like FastStatistics, the sum of squares minus sum times mean cancels badly when the mean is large compared to the spread
+            double diff = signs[j] * (double)inputs[j][i] - mean;
+            sum2 += diff * diff;
+        }
+        double variance = sum2 / (numInputs - 1);
+        if (variance > 0.0)
+        {
+            tOut[i] = mean / sqrt(variance / numInputs);
+        } else {
+            tOut[i] = 0.0f;
+        }
+    }
+}
+
+void TfcePermutationHelper::randomSignFlips(const int& numPermutations, const int& numInputs, const uint32_t& seed, vector<vector<float> >& signsOut)
+{
+    CaretAssert(numPermutations > 0);
+    mt19937 myRand(seed);
+    signsOut.resize(numPermutations);
+    signsOut[0].assign(numInputs, 1.0f);
+    for (int p = 1; p < numPermutations; ++p)
+    {
+        signsOut[p].resize(numInputs);
+        for (int j = 0; j < numInputs; ++j)
+        {
+            signsOut[p][j] = (myRand() & 1) ? 1.0f : -1.0f;
+        }
+    }
+}
+
+void TfcePermutationHelper::readSignFlips(const AString& fileName, const int& numInputs, vector<vector<float> >& signsOut)
+{
+    ifstream inputFile(fileName.toLocal8Bit().constData());
+    if (!inputFile.good()) throw CaretException("failed to open sign flip file '" + fileName + "'");
+    signsOut.clear();
+    string inputLine;
+    while (getline(inputFile, inputLine))
+    {
+#if QT_VERSION >= 0x060000
+        QStringList tokens = QString(inputLine.c_str()).split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+#else
+        QStringList tokens = QString(inputLine.c_str()).split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
+#endif
+        if (tokens.empty()) continue;
+        if (tokens.size() != numInputs)
+        {
+            throw CaretException("line " + AString::number(signsOut.size() + 1) + " of sign flip file has " + AString::number(tokens.size()) +
+                                 " values, expected " + AString::number(numInputs));
+        }
+        signsOut.push_back(vector<float>(numInputs));
+        for (int j = 0; j < numInputs; ++j)
+        {
+            bool ok = false;
+            float value = tokens[j].toFloat(&ok);
+            if (!ok || (value != 1.0f && value != -1.0f)) throw CaretException("sign flip file contains '" + tokens[j] + "', values must be 1 or -1");
+            signsOut.back()[j] = value;
+        }
+    }
+    if (signsOut.empty()) throw CaretException("sign flip file '" + fileName + "' contains no permutations");
+}
+
+void TfcePermutationHelper::writeNullDistribution(const AString& fileName, const vector<float>& maxVals, const vector<float>& minVals)
+{
+    CaretAssert(maxVals.size() == minVals.size());
+    ofstream outFile(fileName.toLocal8Bit().constData());
+    if (!outFile) throw CaretException("failed to open null distribution file '" + fileName + "' for writing");
+    outFile.precision(9);
+    for (size_t i = 0; i < maxVals.size(); ++i)
+    {
+        outFile << maxVals[i] << "\t" << minVals[i] << "\n";
+    }
+    if (!outFile) throw CaretException("error writing null distribution file '" + fileName + "'");
+}
@@ -0,0 +1,62 @@
+#ifndef __TFCE_PERMUTATION_HELPER_H__
+#define __TFCE_PERMUTATION_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+    
+    ///computes only the extreme TFCE values of a map, for building a max-statistic null distribution over many permutations
+    class TfcePermutationHelper
+    {
+        const int64_t* m_neighborStart, *m_neighbors;
+        const float* m_elementSizes;
+        int64_t m_numElements;
+        float m_param_e, m_param_h;
+        std::vector<int64_t> m_order, m_parent, m_clusterCount, m_touching;//working memory is kept between calls, so a helper per thread does no allocation after the first map
+        std::vector<double> m_accumVal, m_totalSize, m_bestOffset;
+        std::vector<float> m_lastVal, m_negated;
+        int64_t findRoot(int64_t element);
+        void updateCluster(const int64_t& root, const float& bottomVal);
+        double maxPositive(const float* data, const float* roiData);
+    public:
+        ///neighbors of element i are neighbors[neighborStart[i]] through neighbors[neighborStart[i + 1] - 1], the arrays must outlive the helper
+        TfcePermutationHelper(const std::vector<int64_t>& neighborStart, const std::vector<int64_t>& neighbors, const float* elementSizes, const float& param_e, const float& param_h);
+        ///the largest TFCE value of the positive data, and the most negative TFCE value of the negative data
+        void computeExtremes(const float* data, const float* roiData, float& maxOut, float& minOut);
+        
+        ///one-sample t-statistic after multiplying each input by its sign
+        static void signFlipTStatistic(const std::vector<const float*>& inputs, const float* signs, const int64_t& numElements, float* tOut);
+        ///the first permutation is the unpermuted data
+        static void randomSignFlips(const int& numPermutations, const int& numInputs, const uint32_t& seed, std::vector<std::vector<float> >& signsOut);
+        ///text file, one permutation per line, with a 1 or -1 for each input - throws CaretException
+        static void readSignFlips(const AString& fileName, const int& numInputs, std::vector<std::vector<float> >& signsOut);
+        ///text file, one line per permutation with the maximum and minimum - throws CaretException
+        static void writeNullDistribution(const AString& fileName, const std::vector<float>& maxVals, const std::vector<float>& minVals);
+    };
+    
+}
+
+#endif //__TFCE_PERMUTATION_HELPER_H__
@@ -43,6 +43,7 @@
 #include "CiftiParcelScalarFile.h"
 #include "CiftiParcelSeriesFile.h"
 #include "CiftiScalarDataSeriesFile.h"
+#include "CiftiStatisticsExtension.h"
 #include "CaretTemporaryFile.h"
 #include "CiftiXML.h"
 #include "ConnectivityDataLoaded.h"
@@ -1595,6 +1596,13 @@ CiftiMappableDataFile::setMapData(const int32_t mapIndex,
     m_forceUpdateOfGroupAndNameHierarchy = true;
     
     m_mapContent[mapIndex]->updateForChangeInMapData();
+    
+    /*
+     * File statistics include this map
+     */
+    m_fileFastStatistics.grabNew(NULL);
+    m_fileHistogram.grabNew(NULL);
+    m_fileHistorgramLimitedValues.grabNew(NULL);
 }
 
 /**
@@ -2601,10 +2609,18 @@ CiftiMappableDataFile::getMapFastStatistics(const int32_t mapIndex)
                                    mapIndex);
             
             if ( ! m_mapContent[mapIndex]->isFastStatisticsValid()) {
-                std::vector<float> data;
-                getMapData(mapIndex,
-                           data);
-                m_mapContent[mapIndex]->updateFastStatistics(data);
+                const CiftiStatisticsExtension* storedStatistics = getStoredMapStatistics();
+                if (storedStatistics != NULL) {
+                    m_mapContent[mapIndex]->m_fastStatistics.grabNew(new FastStatistics());
+                    storedStatistics->getMapStatistics(mapIndex,
+                                                       *m_mapContent[mapIndex]->m_fastStatistics);
+                }
+                else {
+                    std::vector<float> data;
+                    getMapData(mapIndex,
+                               data);
+                    m_mapContent[mapIndex]->updateFastStatistics(data);
+                }
             }
             
             fastStatsOut =  m_mapContent[mapIndex]->m_fastStatistics;
@@ -2642,11 +2658,19 @@ CiftiMappableDataFile::getMapHistogram(const int32_t mapIndex)
         }
         
         if ( ! m_mapContent[mapIndex]->isHistogramValid(numberOfBuckets)) {
-            std::vector<float> data;
-            getMapData(mapIndex,
-                       data);
-            m_mapContent[mapIndex]->updateHistogram(numberOfBuckets,
-                                                    data);
+            const CiftiStatisticsExtension* storedStatistics = getStoredMapStatistics();
+            if ((storedStatistics != NULL)
+                && (numberOfBuckets == CiftiStatisticsExtension::NUM_DISPLAY_BUCKETS)) {
+                m_mapContent[mapIndex]->m_histogram.grabNew(new Histogram(storedStatistics->getMapHistogram(mapIndex)));
+                m_mapContent[mapIndex]->m_histogramNumberOfBuckets = numberOfBuckets;
+            }
+            else {
+                std::vector<float> data;
+                getMapData(mapIndex,
+                           data);
+                m_mapContent[mapIndex]->updateHistogram(numberOfBuckets,
+                                                        data);
+            }
         }
         
         histogramOut = m_mapContent[mapIndex]->m_histogram;
@@ -2753,12 +2777,22 @@ const FastStatistics*
 CiftiMappableDataFile::getFileFastStatistics()
 {
     if (m_fileFastStatistics == NULL) {
-        std::vector<float> fileData;
-        getFileData(fileData);
-        if ( ! fileData.empty()) {
+        /*
+         * Statistics stored by the writer avoid reading all of the data
+         */
+        const CiftiStatisticsExtension* storedStatistics = m_ciftiFile->getStoredStatistics();
+        if (storedStatistics != NULL) {
             m_fileFastStatistics.grabNew(new FastStatistics());
-            m_fileFastStatistics->update(&fileData[0],
-                                         fileData.size());
+            storedStatistics->getFileStatistics(*m_fileFastStatistics);
+        }
+        else {
+            std::vector<float> fileData;
+            getFileData(fileData);
+            if ( ! fileData.empty()) {
+                m_fileFastStatistics.grabNew(new FastStatistics());
+                m_fileFastStatistics->update(&fileData[0],
+                                             fileData.size());
+            }
         }
     }
     
@@ -2788,18 +2822,26 @@ CiftiMappableDataFile::getFileHistogram()
         updateHistogramFlag = true;
     }
     if (updateHistogramFlag) {
-        std::vector<float> fileData;
-        getFileData(fileData);
-        
-        if ( ! fileData.empty()) {
-            if (m_fileHistogram == NULL) {
-                m_fileHistogram.grabNew(new Histogram(numberOfBuckets));
-            }
-            m_fileHistogram->update(numberOfBuckets,
-                                    &fileData[0],
-                                    fileData.size());
+        const CiftiStatisticsExtension* storedStatistics = m_ciftiFile->getStoredStatistics();
+        if ((storedStatistics != NULL)
+            && (numberOfBuckets == CiftiStatisticsExtension::NUM_DISPLAY_BUCKETS)) {
+            m_fileHistogram.grabNew(new Histogram(storedStatistics->getFileHistogram()));
             m_fileHistogramNumberOfBuckets = numberOfBuckets;
         }
+        else {
+            std::vector<float> fileData;
+            getFileData(fileData);
+            
+            if ( ! fileData.empty()) {
+                if (m_fileHistogram == NULL) {
+                    m_fileHistogram.grabNew(new Histogram(numberOfBuckets));
+                }
+                m_fileHistogram->update(numberOfBuckets,
+                                        &fileData[0],
+                                        fileData.size());
+                m_fileHistogramNumberOfBuckets = numberOfBuckets;
+            }
+        }
     }
     return m_fileHistogram;
 }
@@ -7367,6 +7409,34 @@ CiftiMappableDataFile::getMapIntervalStartAndStep(float& firstMapUnitsValueOut,
     mapIntervalStepValueOut = m_mappingTimeStep;
 }
 
+/**
+ * Get the statistics stored in the file by its writer, but only when
+ * they contain summaries of individual maps (maps are the columns of
+ * the matrix, along the row).
+ *
+ * @return
+ *    The stored statistics or NULL if the file has no usable
+ *    per-map summaries.
+ */
+const CiftiStatisticsExtension*
+CiftiMappableDataFile::getStoredMapStatistics() const
+{
+    CaretAssert(m_ciftiFile);
+    
+    if (m_dataReadingAccessMethod != DATA_ACCESS_FILE_COLUMNS_OR_XML_ALONG_ROW) {
+        return NULL;
+    }
+    
+    const CiftiStatisticsExtension* storedStatistics = m_ciftiFile->getStoredStatistics();
+    if (storedStatistics != NULL) {
+        if (storedStatistics->hasMapSummaries()) {
+            return storedStatistics;
+        }
+    }
+    
+    return NULL;
+}
+
 /**
  * Get the minimum and maximum values from ALL maps in this file.
  * Note that not all files (due to size of file) are able to provide
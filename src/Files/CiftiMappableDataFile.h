@@ -43,6 +43,7 @@ namespace caret {
     class CiftiFile;
     class CiftiParcelsMap;
     class CiftiScalarsMap;
+    class CiftiStatisticsExtension;
     class CiftiXML;
     class FastStatistics;
     class GraphicsPrimitive;
@@ -945,6 +946,8 @@ namespace caret {
         
         bool m_blockInvalidateColorsInAllMapsFlag = false;
         
+        const CiftiStatisticsExtension* getStoredMapStatistics() const;
+        
         // ADD_NEW_MEMBERS_HERE
         
     };
@@ -37,6 +37,7 @@
 #include "CaretPreferences.h"
 #include "CziImage.h"
 #include "CziImageLoaderMultiResolution.h"
+#include "CziSubBlockCache.h"
 #include "CziUtilities.h"
 #include "DataFileContentInformation.h"
 #include "DataFileException.h"
@@ -127,6 +128,14 @@ CziImageFile::resetPrivate()
     m_scalingTileAccessor.reset();
     m_pyramidLayerTileAccessor.reset();
 
+    /*
+     * Prefetching must finish before the reader is closed
+     */
+    if (m_subBlockCache) {
+        m_subBlockCache->cancelPrefetching();
+    }
+    m_subBlockCache.reset();
+    
     if (m_reader) {
         m_reader->Close();
     }
@@ -409,7 +418,14 @@ CziImageFile::readFile(const AString& filename)
         readPyramidInfo(subBlockStatistics);
         
         
-        m_pyramidLayerTileAccessor = m_reader->CreateSingleChannelPyramidLayerTileAccessor();
+        /*
+         * Accessors read sub-blocks through the cache so that decoded
+         * tiles are reused when panning and zooming
+         */
+        m_subBlockCache.reset(new CziSubBlockCache(m_reader));
+        
+        m_pyramidLayerTileAccessor = std::dynamic_pointer_cast<libCZI::ISingleChannelPyramidLayerTileAccessor>(libCZI::CreateAccesor(m_subBlockCache,
+                                                                                                                                    libCZI::AccessorType::SingleChannelPyramidLayerTileAccessor));
         if ( ! m_pyramidLayerTileAccessor) {
             m_errorMessage = "Creating pyramid layer tile accessor for reading CZI file failed.";
             m_status = Status::ERRORED;
@@ -417,7 +433,8 @@ CziImageFile::readFile(const AString& filename)
         }
         
         
-        m_scalingTileAccessor = m_reader->CreateSingleChannelScalingTileAccessor();
+        m_scalingTileAccessor = std::dynamic_pointer_cast<libCZI::ISingleChannelScalingTileAccessor>(libCZI::CreateAccesor(m_subBlockCache,
+                                                                                                                          libCZI::AccessorType::SingleChannelScalingTileAccessor));
         if ( ! m_scalingTileAccessor) {
             m_errorMessage = "Creating single channel scaling tile accessor for reading CZI file failed.";
             m_status = Status::ERRORED;
@@ -854,6 +871,9 @@ CziImageFile::zoomToMatchPixelDimension(const QRectF& regionOfInterestToRead,
  *    Maximum width and height of output image
  * @param errorMessageOut
  *    Contains information about any errors
+ * @param prefetchNeighborsFlag
+ *    If true, tiles around the region are decoded in the background for
+ *    the next pan or zoom
  * @return
  *    Pointer to CziImage or NULL if there is an error.
  */
@@ -864,7 +884,8 @@ CziImageFile::readFromCziImageFile(const ImageDataFormat imageDataFormat,
                                    const QRectF& regionOfInterestIn,
                                    const QRectF& frameRegionOfInterest,
                                    const int64_t outputImageWidthHeightMaximum,
-                                   AString& errorMessageOut)
+                                   AString& errorMessageOut,
+                                   const bool prefetchNeighborsFlag)
 {
     errorMessageOut.clear();
     
@@ -920,6 +941,7 @@ CziImageFile::readFromCziImageFile(const ImageDataFormat imageDataFormat,
     CaretAssert(m_scalingTileAccessor);
     
     std::shared_ptr<libCZI::IBitmapData> bitmapDataRead;
+    std::vector<libCZI::CDimCoordinate> planeCoordinatesRead;
     
     /*
      * "Tinting" applys coloring functions in the CZI library similar
@@ -955,6 +977,7 @@ CziImageFile::readFromCziImageFile(const ImageDataFormat imageDataFormat,
                                                             [&](int chIdx)->bool
                                                             {
             libCZI::CDimCoordinate planeCoord{ { libCZI::DimensionIndex::C, chIdx } };
+            planeCoordinatesRead.push_back(planeCoord);
             actvChBms.emplace_back(m_scalingTileAccessor->Get(intRectROI,
                                                               &planeCoord,
                                                               zoomToRead,
@@ -1010,6 +1033,7 @@ CziImageFile::readFromCziImageFile(const ImageDataFormat imageDataFormat,
                                                     &coordinate,
                                                     zoomToRead,
                                                     &scstaOptions);
+        planeCoordinatesRead.push_back(coordinate);
     }
 
     if ( ! bitmapDataRead) {
@@ -1018,6 +1042,13 @@ CziImageFile::readFromCziImageFile(const ImageDataFormat imageDataFormat,
         return NULL;
     }
     
+    if (prefetchNeighborsFlag) {
+        CaretAssert(m_subBlockCache);
+        m_subBlockCache->prefetchNeighbors(intRectROI,
+                                           planeCoordinatesRead,
+                                           zoomToRead);
+    }
+    
     const bool removeGrayFlag(false);
     if (removeGrayFlag) {
         uint8_t backRGB[3] = { 0, 0, 0 };
@@ -2221,7 +2252,8 @@ CziImageFile::getPixelRGBA(const int32_t tabIndex,
              * NOTE: This reader fails if the image Gray16 as it will not convert
              * Gray16 to Bgr24.
              */
-            auto singleChannelTileAccessor = m_reader->CreateSingleChannelTileAccessor();
+            auto singleChannelTileAccessor = std::dynamic_pointer_cast<libCZI::ISingleChannelTileAccessor>(libCZI::CreateAccesor(m_subBlockCache,
+                                                                                                                                libCZI::AccessorType::SingleChannelTileAccessor));
             if (singleChannelTileAccessor) {
                 const std::array<float, 3> prefBackFloatRGB = getPreferencesImageBackgroundFloatRGB();
                 
@@ -54,6 +54,7 @@ namespace caret {
     class CziImage;
     class CziImageLoaderBase;
     class CziImageLoaderMultiResolution;
+    class CziSubBlockCache;
     class GraphicsObjectToWindowTransform;
     class Matrix4x4;
     class RectangleTransform;
@@ -378,7 +379,8 @@ namespace caret {
                                        const QRectF& regionOfInterest,
                                        const QRectF& frameRegionOfInterest,
                                        const int64_t outputImageWidthHeightMaximum,
-                                       AString& errorMessageOut);
+                                       AString& errorMessageOut,
+                                       const bool prefetchNeighborsFlag = false);
         
         enum class QImagePixelFormat {
             RGB,
@@ -432,6 +434,8 @@ namespace caret {
         
         std::shared_ptr<libCZI::ICZIReader> m_reader;
 
+        std::shared_ptr<CziSubBlockCache> m_subBlockCache;
+
         std::shared_ptr<libCZI::ISingleChannelScalingTileAccessor> m_scalingTileAccessor;
         
         std::shared_ptr<libCZI::ISingleChannelPyramidLayerTileAccessor> m_pyramidLayerTileAccessor;
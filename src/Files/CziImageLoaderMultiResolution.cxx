@@ -933,7 +933,8 @@ CziImageLoaderMultiResolution::loadImageForPyrmaidLayerForPixelCoords(const CziI
                                                                  rectToLoad,
                                                                  cziSceneInfo.m_logicalRectangle,
                                                                  m_cziImageFile->getPreferencesImageDimension(),
-                                                                 errorMessage);
+                                                                 errorMessage,
+                                                                 true);
     
     if (cziDebugFlag) std::cout << "Time to load CZI Image: (ms): " << timer.getElapsedTimeMilliseconds() << std::endl;
     
@@ -1112,7 +1113,8 @@ CziImageLoaderMultiResolution::loadImageForPyrmaidLayerForPlaneCoords(const CziI
                                                                  logicalRectToLoad,
                                                                  cziSceneInfo.m_logicalRectangle,
                                                                  m_cziImageFile->getPreferencesImageDimension(),
-                                                                 errorMessage);
+                                                                 errorMessage,
+                                                                 true);
     
     if (cziDebugFlag) std::cout << "Time to load CZI Image: (ms): " << timer.getElapsedTimeMilliseconds() << std::endl;
     
@@ -1285,7 +1287,8 @@ CziImageLoaderMultiResolution::loadImageForPyrmaidLayerForStereotaxicCoords(cons
                                                                  logicalRectToLoad,
                                                                  cziSceneInfo.m_logicalRectangle,
                                                                  m_cziImageFile->getPreferencesImageDimension(),
-                                                                 errorMessage);
+                                                                 errorMessage,
+                                                                 true);
     
     if (cziDebugFlag) std::cout << "Time to load CZI Image: (ms): " << timer.getElapsedTimeMilliseconds() << std::endl;
     
@@ -0,0 +1,494 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __CZI_SUB_BLOCK_CACHE_DECLARE__
+#include "CziSubBlockCache.h"
+#undef __CZI_SUB_BLOCK_CACHE_DECLARE__
+
+#include <algorithm>
+#include <limits>
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+using namespace caret;
+
+/**
+ * \class caret::CziSubBlockCache
+ * \brief Least recently used cache of decoded CZI sub-blocks with background prefetching
+ * \ingroup Files
+ *
+ * Sits between a CZI reader and the libCZI accessors so that pan and zoom reuse
+ * sub-blocks (tiles of a pyramid layer) that were already read and decoded (JPEG-XR
+ * decoding is the expensive part of reading a CZI region).  After a region is
+ * read, the tiles surrounding it and the tiles of the adjacent pyramid layers
+ * may be decoded on a thread pool so that the next pan or zoom finds them ready.
+ */
+
+/**
+ * A sub-block whose bitmap has already been decoded.  The libCZI accessors
+ * only read from the bitmap returned by CreateBitmap() so it is shared
+ * by all users of the sub-block.
+ */
+class CziSubBlockCache::CachedSubBlock : public libCZI::ISubBlock {
+public:
+    CachedSubBlock(std::shared_ptr<libCZI::ISubBlock> subBlock,
+                   std::shared_ptr<libCZI::IBitmapData> bitmap)
+    : m_subBlock(subBlock),
+    m_bitmap(bitmap) { }
+
+    virtual const libCZI::SubBlockInfo& GetSubBlockInfo() const override {
+        return m_subBlock->GetSubBlockInfo();
+    }
+
+    virtual void DangerousGetRawData(MemBlkType type, const void*& ptr, size_t& size) const override {
+        m_subBlock->DangerousGetRawData(type, ptr, size);
+    }
+
+    virtual std::shared_ptr<const void> GetRawData(MemBlkType type, size_t* ptrSize) override {
+        return m_subBlock->GetRawData(type, ptrSize);
+    }
+
+    virtual std::shared_ptr<libCZI::IBitmapData> CreateBitmap() override {
+        return m_bitmap;
+    }
+
+    std::shared_ptr<libCZI::ISubBlock> m_subBlock;
+
+    std::shared_ptr<libCZI::IBitmapData> m_bitmap;
+};
+
+namespace {
+    /**
+     * Decodes one sub-block on the prefetch thread pool
+     */
+    class PrefetchRunnable : public QRunnable {
+    public:
+        PrefetchRunnable(std::function<void()> function)
+        : m_function(function) { }
+
+        virtual void run() override {
+            m_function();
+        }
+
+    private:
+        std::function<void()> m_function;
+    };
+}
+
+/**
+ * Constructor.
+ * @param repository
+ *    Repository (usually the CZI reader) that sub-blocks are read from
+ * @param memoryBudgetBytes
+ *    Maximum bytes of sub-block data kept in the cache.  Zero disables caching.
+ */
+CziSubBlockCache::CziSubBlockCache(std::shared_ptr<libCZI::ISubBlockRepository> repository,
+                                   const int64_t memoryBudgetBytes)
+: m_repository(repository),
+m_memoryBudgetBytes(memoryBudgetBytes)
+{
+    CaretAssert(m_repository);
+    /*
+     * Leave a core for the user interface
+     */
+    m_prefetchThreadPool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+/**
+ * Destructor.
+ */
+CziSubBlockCache::~CziSubBlockCache()
+{
+    cancelPrefetching();
+}
+
+/**
+ * Enumerate all sub-blocks (passed to the repository)
+ */
+void
+CziSubBlockCache::EnumerateSubBlocks(std::function<bool(int index, const libCZI::SubBlockInfo& info)> funcEnum)
+{
+    m_repository->EnumerateSubBlocks(funcEnum);
+}
+
+/**
+ * Enumerate a subset of sub-blocks (passed to the repository)
+ */
+void
+CziSubBlockCache::EnumSubset(const libCZI::IDimCoordinate* planeCoordinate,
+                             const libCZI::IntRect* roi,
+                             bool onlyLayer0,
+                             std::function<bool(int index, const libCZI::SubBlockInfo& info)> funcEnum)
+{
+    m_repository->EnumSubset(planeCoordinate, roi, onlyLayer0, funcEnum);
+}
+
+/**
+ * Get a sub-block with its bitmap decoded.  If the sub-block is not in the cache
+ * it is read and decoded, unless prefetching is already decoding it, in which
+ * case this waits for the prefetch to finish.
+ * @param index
+ *    Index of the sub-block
+ * @return
+ *    The sub-block or an empty pointer if there is no sub-block for the index
+ */
+std::shared_ptr<libCZI::ISubBlock>
+CziSubBlockCache::ReadSubBlock(int index)
+{
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        while (m_decodingIndices.find(index) != m_decodingIndices.end()) {
+            m_decodedCondition.wait(&m_cacheMutex);
+        }
+        auto iter = m_entries.find(index);
+        if (iter != m_entries.end()) {
+            m_lruList.splice(m_lruList.begin(), m_lruList, iter->second.m_lruIterator);
+            m_statistics.m_hitCount++;
+            return iter->second.m_subBlock;
+        }
+        m_statistics.m_missCount++;
+        m_decodingIndices.insert(index);
+    }
+
+    std::shared_ptr<CachedSubBlock> subBlock;
+    try {
+        subBlock = readAndDecodeSubBlock(index);
+    }
+    catch (...) {
+        QMutexLocker locker(&m_cacheMutex);
+        m_decodingIndices.erase(index);
+        m_decodedCondition.wakeAll();
+        throw;
+    }
+
+    insertSubBlock(index, subBlock);
+    return subBlock;
+}
+
+/**
+ * Get information about a sub-block in a channel (passed to the repository)
+ */
+bool
+CziSubBlockCache::TryGetSubBlockInfoOfArbitrarySubBlockInChannel(int channelIndex,
+                                                                libCZI::SubBlockInfo& info)
+{
+    return m_repository->TryGetSubBlockInfoOfArbitrarySubBlockInChannel(channelIndex, info);
+}
+
+/**
+ * @return Sub-block statistics (passed to the repository)
+ */
+libCZI::SubBlockStatistics
+CziSubBlockCache::GetStatistics()
+{
+    return m_repository->GetStatistics();
+}
+
+/**
+ * @return Pyramid statistics (passed to the repository)
+ */
+libCZI::PyramidStatistics
+CziSubBlockCache::GetPyramidStatistics()
+{
+    return m_repository->GetPyramidStatistics();
+}
+
+/**
+ * Decode, in the background, the sub-blocks that are likely to be needed after
+ * the user pans or zooms away from the region that was just read.  Any prefetching
+ * that has not started for a previous region is abandoned.
+ * @param roi
+ *    Region that was read, in logical coordinates
+ * @param planeCoordinates
+ *    Plane coordinates that were read (one for each channel that was composited)
+ * @param zoom
+ *    Zoom that the region was read with
+ */
+void
+CziSubBlockCache::prefetchNeighbors(const libCZI::IntRect& roi,
+                                    const std::vector<libCZI::CDimCoordinate>& planeCoordinates,
+                                    const float zoom)
+{
+    if ((m_memoryBudgetBytes <= 0)
+        || (roi.w <= 0)
+        || (roi.h <= 0)
+        || (zoom <= 0.0f)) {
+        return;
+    }
+
+    m_prefetchThreadPool.clear();
+
+    /*
+     * Tiles adjacent to the region at the same resolution (panning) are
+     * decoded first, then the next coarser layer (zooming out), then
+     * the next finer layer in the center of the region (zooming in)
+     */
+    const libCZI::IntRect panRegion {
+        roi.x - roi.w,
+        roi.y - roi.h,
+        roi.w * 3,
+        roi.h * 3
+    };
+    prefetchRegion(panRegion,
+                   planeCoordinates,
+                   zoom,
+                   2);
+
+    prefetchRegion(panRegion,
+                   planeCoordinates,
+                   zoom * 0.5f,
+                   1);
+
+    if (zoom < 1.0f) {
+        const libCZI::IntRect zoomInRegion {
+            roi.x + roi.w / 4,
+            roi.y + roi.h / 4,
+            std::max(1, roi.w / 2),
+            std::max(1, roi.h / 2)
+        };
+        prefetchRegion(zoomInRegion,
+                       planeCoordinates,
+                       std::min(1.0f, zoom * 2.0f),
+                       0);
+    }
+}
+
+/**
+ * Queue decoding of the sub-blocks that the scaling tile accessor would use to
+ * draw a region at a zoom.  The accessor draws the layer with the smallest zoom that
+ * is at least the requested zoom and ignores layers with twice that zoom or more.
+ * @param roi
+ *    The region in logical coordinates
+ * @param planeCoordinates
+ *    The plane coordinates
+ * @param zoom
+ *    The zoom
+ * @param priority
+ *    Priority in the thread pool
+ */
+void
+CziSubBlockCache::prefetchRegion(const libCZI::IntRect& roi,
+                                 const std::vector<libCZI::CDimCoordinate>& planeCoordinates,
+                                 const float zoom,
+                                 const int priority)
+{
+    for (const auto& planeCoordinate : planeCoordinates) {
+        std::vector<std::pair<int, float>> indexAndZoom;
+        float startZoom(std::numeric_limits<float>::max());
+        m_repository->EnumSubset(&planeCoordinate,
+                                 &roi,
+                                 false,
+                                 [&](int index, const libCZI::SubBlockInfo& info)->bool {
+            const float subBlockZoom(libCZI::Utils::CalcZoom(info.logicalRect, info.physicalSize));
+            if (subBlockZoom >= zoom) {
+                indexAndZoom.push_back(std::make_pair(index, subBlockZoom));
+                startZoom = std::min(startZoom, subBlockZoom);
+            }
+            return true;
+        });
+        
+        QMutexLocker locker(&m_cacheMutex);
+        for (const auto& iz : indexAndZoom) {
+            if (iz.second >= startZoom * 1.9f) {
+                continue;
+            }
+            const int index(iz.first);
+            if ((m_entries.find(index) != m_entries.end())
+                || (m_decodingIndices.find(index) != m_decodingIndices.end())) {
+                continue;
+            }
+            m_prefetchThreadPool.start(new PrefetchRunnable([this, index]() { prefetchSubBlock(index); }),
+                                       priority);
+        }
+    }
+}
+
+/**
+ * Read and decode a sub-block on a prefetch thread, unless it was read since
+ * it was queued.  Errors are only logged since the sub-block will be read
+ * again, and the error reported, if it is needed.
+ * @param index
+ *    Index of the sub-block
+ */
+void
+CziSubBlockCache::prefetchSubBlock(const int index)
+{
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        if ((m_entries.find(index) != m_entries.end())
+            || (m_decodingIndices.find(index) != m_decodingIndices.end())) {
+            return;
+        }
+        m_decodingIndices.insert(index);
+    }
+
+    std::shared_ptr<CachedSubBlock> subBlock;
+    try {
+        subBlock = readAndDecodeSubBlock(index);
+    }
+    catch (const std::exception& e) {
+        CaretLogFine("Prefetching CZI sub-block "
+                     + AString::number(index)
+                     + " failed: "
+                     + QString(e.what()));
+    }
+    catch (...) {
+        CaretLogFine("Prefetching CZI sub-block "
+                     + AString::number(index)
+                     + " failed");
+    }
+
+    if (subBlock) {
+        {
+            QMutexLocker locker(&m_cacheMutex);
+            m_statistics.m_prefetchCount++;
+        }
+        insertSubBlock(index, subBlock);
+    }
+    else {
+        QMutexLocker locker(&m_cacheMutex);
+        m_decodingIndices.erase(index);
+        m_decodedCondition.wakeAll();
+    }
+}
+
+/**
+ * Read a sub-block from the repository and decode its bitmap.  Reading is
+ * serialized; decoding is not.
+ * @param index
+ *    Index of the sub-block
+ * @return
+ *    The decoded sub-block or an empty pointer if there is no sub-block for the index
+ */
+std::shared_ptr<CziSubBlockCache::CachedSubBlock>
+CziSubBlockCache::readAndDecodeSubBlock(const int index)
+{
+    std::shared_ptr<libCZI::ISubBlock> subBlock;
+    {
+        QMutexLocker locker(&m_readMutex);
+        subBlock = m_repository->ReadSubBlock(index);
+    }
+    if ( ! subBlock) {
+        return std::shared_ptr<CachedSubBlock>();
+    }
+
+    std::shared_ptr<libCZI::IBitmapData> bitmap(subBlock->CreateBitmap());
+    return std::make_shared<CachedSubBlock>(subBlock,
+                                            bitmap);
+}
+
+/**
+ * Add a decoded sub-block to the cache, removing least recently used sub-blocks
+ * as needed to stay within the memory budget, and wake anyone waiting for it.
+ * @param index
+ *    Index of the sub-block
+ * @param subBlock
+ *    The decoded sub-block (may be empty)
+ */
+void
+CziSubBlockCache::insertSubBlock(const int index,
+                                 std::shared_ptr<CachedSubBlock>& subBlock)
+{
+    QMutexLocker locker(&m_cacheMutex);
+    m_decodingIndices.erase(index);
+    m_decodedCondition.wakeAll();
+
+    if (( ! subBlock)
+        || (m_memoryBudgetBytes <= 0)) {
+        return;
+    }
+
+    int64_t numBytes(0);
+    const void* rawPtr(NULL);
+    size_t rawSize(0);
+    subBlock->DangerousGetRawData(libCZI::ISubBlock::Data, rawPtr, rawSize);
+    numBytes += rawSize;
+    if (subBlock->m_bitmap) {
+        libCZI::BitmapLockInfo lockInfo(subBlock->m_bitmap->Lock());
+        numBytes += lockInfo.size;
+        subBlock->m_bitmap->Unlock();
+    }
+
+    m_lruList.push_front(index);
+    Entry entry;
+    entry.m_subBlock     = subBlock;
+    entry.m_lruIterator  = m_lruList.begin();
+    entry.m_bytes        = numBytes;
+    m_entries[index] = entry;
+    m_statistics.m_bytesUsed += numBytes;
+
+    /*
+     * Always keep the newest sub-block, even if it alone exceeds the budget
+     */
+    while ((m_statistics.m_bytesUsed > m_memoryBudgetBytes)
+           && (m_lruList.size() > 1)) {
+        const int oldestIndex(m_lruList.back());
+        m_lruList.pop_back();
+        auto iter = m_entries.find(oldestIndex);
+        CaretAssert(iter != m_entries.end());
+        m_statistics.m_bytesUsed -= iter->second.m_bytes;
+        m_entries.erase(iter);
+        m_statistics.m_evictionCount++;
+    }
+}
+
+/**
+ * Wait until all queued prefetching has finished.
+ */
+void
+CziSubBlockCache::waitForPrefetching()
+{
+    m_prefetchThreadPool.waitForDone();
+}
+
+/**
+ * Abandon queued prefetching and wait for any sub-blocks being prefetched.
+ * Must be called before the repository is closed.
+ */
+void
+CziSubBlockCache::cancelPrefetching()
+{
+    m_prefetchThreadPool.clear();
+    m_prefetchThreadPool.waitForDone();
+}
+
+/**
+ * @return Counts of sub-block requests since the cache was created
+ */
+CziSubBlockCache::Statistics
+CziSubBlockCache::getStatistics() const
+{
+    QMutexLocker locker(&m_cacheMutex);
+    return m_statistics;
+}
+
+/**
+ * @return Maximum bytes of sub-block data kept in the cache
+ */
+int64_t
+CziSubBlockCache::getMemoryBudgetBytes() const
+{
+    return m_memoryBudgetBytes;
+}
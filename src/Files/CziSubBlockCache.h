@@ -0,0 +1,166 @@
+#ifndef __CZI_SUB_BLOCK_CACHE_H__
+#define __CZI_SUB_BLOCK_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "libCZI.h"
+
+namespace caret {
+
+    class CziSubBlockCache : public libCZI::ISubBlockRepository {
+
+    public:
+        /**
+         * Counts of sub-block requests since the cache was created
+         */
+        struct Statistics {
+            /** Requests for a sub-block that was already decoded */
+            int64_t m_hitCount = 0;
+
+            /** Requests for a sub-block that had to be read and decoded */
+            int64_t m_missCount = 0;
+
+            /** Sub-blocks read and decoded by prefetching */
+            int64_t m_prefetchCount = 0;
+
+            /** Sub-blocks removed to stay within the memory budget */
+            int64_t m_evictionCount = 0;
+
+            /** Bytes of sub-block data currently in the cache */
+            int64_t m_bytesUsed = 0;
+        };
+
+        static const int64_t DEFAULT_MEMORY_BUDGET_BYTES;
+
+        CziSubBlockCache(std::shared_ptr<libCZI::ISubBlockRepository> repository,
+                         const int64_t memoryBudgetBytes = DEFAULT_MEMORY_BUDGET_BYTES);
+
+        virtual ~CziSubBlockCache();
+
+        CziSubBlockCache(const CziSubBlockCache&) = delete;
+
+        CziSubBlockCache& operator=(const CziSubBlockCache&) = delete;
+
+        virtual void EnumerateSubBlocks(std::function<bool(int index, const libCZI::SubBlockInfo& info)> funcEnum) override;
+
+        virtual void EnumSubset(const libCZI::IDimCoordinate* planeCoordinate,
+                                const libCZI::IntRect* roi,
+                                bool onlyLayer0,
+                                std::function<bool(int index, const libCZI::SubBlockInfo& info)> funcEnum) override;
+
+        virtual std::shared_ptr<libCZI::ISubBlock> ReadSubBlock(int index) override;
+
+        virtual bool TryGetSubBlockInfoOfArbitrarySubBlockInChannel(int channelIndex,
+                                                                     libCZI::SubBlockInfo& info) override;
+
+        virtual libCZI::SubBlockStatistics GetStatistics() override;
+
+        virtual libCZI::PyramidStatistics GetPyramidStatistics() override;
+
+        void prefetchNeighbors(const libCZI::IntRect& roi,
+                               const std::vector<libCZI::CDimCoordinate>& planeCoordinates,
+                               const float zoom);
+
+        void waitForPrefetching();
+
+        void cancelPrefetching();
+
+        Statistics getStatistics() const;
+
+        int64_t getMemoryBudgetBytes() const;
+
+        // ADD_NEW_METHODS_HERE
+
+    private:
+        class CachedSubBlock;
+
+        /**
+         * A decoded sub-block and its position in the least recently used list
+         */
+        struct Entry {
+            std::shared_ptr<CachedSubBlock> m_subBlock;
+
+            std::list<int>::iterator m_lruIterator;
+
+            int64_t m_bytes;
+        };
+
+        void prefetchRegion(const libCZI::IntRect& roi,
+                            const std::vector<libCZI::CDimCoordinate>& planeCoordinates,
+                            const float zoom,
+                            const int priority);
+
+        void prefetchSubBlock(const int index);
+
+        std::shared_ptr<CachedSubBlock> readAndDecodeSubBlock(const int index);
+
+        void insertSubBlock(const int index,
+                            std::shared_ptr<CachedSubBlock>& subBlock);
+
+        std::shared_ptr<libCZI::ISubBlockRepository> m_repository;
+
+        const int64_t m_memoryBudgetBytes;
+
+        /** Sub-blocks in the cache, key is the sub-block index (one tile of one pyramid layer) */
+        std::unordered_map<int, Entry> m_entries;
+
+        /** Indices of cached sub-blocks, most recently used first */
+        std::list<int> m_lruList;
+
+        /** Indices of sub-blocks being read and decoded */
+        std::set<int> m_decodingIndices;
+
+        Statistics m_statistics;
+
+        /** Protects the entries, LRU list, decoding indices, and statistics */
+        mutable QMutex m_cacheMutex;
+
+        /** Signaled when a sub-block finishes decoding */
+        QWaitCondition m_decodedCondition;
+
+        /** Serializes reading from the file since libCZI streams are not thread-safe */
+        QMutex m_readMutex;
+
+        QThreadPool m_prefetchThreadPool;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __CZI_SUB_BLOCK_CACHE_DECLARE__
+    const int64_t CziSubBlockCache::DEFAULT_MEMORY_BUDGET_BYTES = 256 * 1024 * 1024;
+#endif // __CZI_SUB_BLOCK_CACHE_DECLARE__
+
+} // namespace
+#endif  //__CZI_SUB_BLOCK_CACHE_H__
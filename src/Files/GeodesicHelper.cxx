@@ -39,8 +39,9 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
     TopologyHelper topoHelpIn(topoBase);//leave this building one privately, to not introduce even worse dependencies regarding SurfaceFile
     m_corrAreaSmallestFactor = 1.0f;
     numNodes = surfaceIn->getNumberOfNodes();
-    nodeNeighbors.resize(numNodes);
-    distances.resize(numNodes);
+    vector<vector<int32_t> > neighLists(numNodes), neigh2Lists(numNodes);//build per-node first, then pack into the CSR members
+    vector<vector<float> > distLists(numNodes), dist2Lists(numNodes);
+    vector<vector<CrawlInfo> > pathInfoLists(numNodes);
     nodeCoords.resize(numNodes);
     vector<float> sqrtCorrAreas;//each edge has 2 vertices that influence it - assume that each influences a piece of the edge with a ratio depending on the square roots of the vertex areas
     vector<float> sqrtVertAreas;//we also assume isometric expansion at each vertex
@@ -61,17 +62,17 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
     bool firstCorrArea = true;//if all corrected vertex areas are significantly larger than 1, we can make A* faster by multiplying all euclidean distances by it, so find the actual smallest
     for (int32_t i = 0; i < numNodes; ++i)
     {//get neighbors
-        vector<int32_t>& neighbors = nodeNeighbors[i];
+        vector<int32_t>& neighbors = neighLists[i];
         neighbors = topoHelpIn.getNodeNeighbors(i);
         nodeCoords[i] = surfaceIn->getCoordinate(i);
         const Vector3D baseCoord = nodeCoords[i];
         int numNeigh = (int)neighbors.size();
-        distances[i].resize(numNeigh);
+        distLists[i].resize(numNeigh);
         for (int32_t j = 0; j < numNeigh; ++j)
         {
             Vector3D neighCoord = surfaceIn->getCoordinate(neighbors[j]);
             tempvec = baseCoord - neighCoord;
-            distances[i][j] = tempvec.length();//precompute for speed in other calls
+            distLists[i][j] = tempvec.length();//precompute for speed in other calls
             if (correctedAreas != NULL)
             {
                 float correctionFactor = (sqrtCorrAreas[i] + sqrtCorrAreas[neighbors[j]]) / (sqrtVertAreas[i] + sqrtVertAreas[neighbors[j]]);
@@ -80,11 +81,11 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
                     m_corrAreaSmallestFactor = correctionFactor;//if this is zero anywhere, it just means that the euclidean part of the heuristic must be ignored (worst case, it does dijkstra)
                     firstCorrArea = false;
                 }
-                distances[i][j] *= correctionFactor;
+                distLists[i][j] *= correctionFactor;
             }
             if (i < neighbors[j])
             {
-                nodeSpacingAccum += distances[i][j];
+                nodeSpacingAccum += distLists[i][j];
                 ++numEdges;
             }
         }//so few floating point operations, this should turn out symmetric
@@ -92,9 +93,6 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
     m_avgNodeSpacing = nodeSpacingAccum / numEdges;
     std::vector<int32_t> tempneigh2;
     std::vector<float> tempdist2;
-    nodeNeighbors2.resize(numNodes);
-    distances2.resize(numNodes);
-    neighbors2PathInfo.resize(numNodes);
     const vector<TopologyEdgeInfo>& myEdgeInfo = topoHelpIn.getEdgeInfo();
     CaretAssert(numEdges == (int32_t)myEdgeInfo.size());//SurfaceFile checks for triangles with duplicated nodes
     for (int i = 0; i < numEdges; ++i)
@@ -116,12 +114,12 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
         tempInfo.edgeNodes[0] = neigh1Node;
         tempInfo.edgeNodes[1] = neigh2Node;
         const int32_t num_reserve = 8;//uses 8 in case it is used on a mesh with haphazard topology
-        nodeNeighbors2[baseNode].reserve(num_reserve);//reserve should be fast if capacity is already num_reserve, and better than reallocating at 2 and 4, if vector allocation is naive doubling
-        nodeNeighbors2[farNode].reserve(num_reserve);//in the extremely rare case of a node with more than num_reserve neighbors, a second allocation plus copy isn't much of a cost
-        distances2[baseNode].reserve(num_reserve);
-        distances2[farNode].reserve(num_reserve);
-        neighbors2PathInfo[baseNode].reserve(num_reserve);
-        neighbors2PathInfo[farNode].reserve(num_reserve);
+        neigh2Lists[baseNode].reserve(num_reserve);//reserve should be fast if capacity is already num_reserve, and better than reallocating at 2 and 4, if vector allocation is naive doubling
+        neigh2Lists[farNode].reserve(num_reserve);//in the extremely rare case of a node with more than num_reserve neighbors, a second allocation plus copy isn't much of a cost
+        dist2Lists[baseNode].reserve(num_reserve);
+        dist2Lists[farNode].reserve(num_reserve);
+        pathInfoLists[baseNode].reserve(num_reserve);
+        pathInfoLists[farNode].reserve(num_reserve);
         Vector3D abhat = (neigh2Coord - neigh1Coord).normal(&abmag);//a is neigh1, b is neigh2, b - a = (vector)ab
         Vector3D ac = farCoord - neigh1Coord;//c is farnode, c - a = (vector)ac
         Vector3D ad = abhat * abhat.dot(ac);//d is the point on the shared edge that farnode (c) is closest to
@@ -151,16 +149,38 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
             tempInfo.pieceDists[1] *= correctionFactor;
         }//for now, assume it only depends on the expansion of the endpoints, and affects each part equally
         tempInfo.pieceDists[0] = tempf - tempInfo.pieceDists[1];
-        nodeNeighbors2[farNode].push_back(baseNode);//record it at both ends, because we are looping through edges
-        distances2[farNode].push_back(tempf);
-        neighbors2PathInfo[farNode].push_back(tempInfo);
+        neigh2Lists[farNode].push_back(baseNode);//record it at both ends, because we are looping through edges
+        dist2Lists[farNode].push_back(tempf);
+        pathInfoLists[farNode].push_back(tempInfo);
         
         float tempf2 = tempInfo.pieceDists[0];//swap the piece distances around for the baseNode info
         tempInfo.pieceDists[0] = tempInfo.pieceDists[1];
         tempInfo.pieceDists[1] = tempf2;
-        nodeNeighbors2[baseNode].push_back(farNode);
-        distances2[baseNode].push_back(tempf);
-        neighbors2PathInfo[baseNode].push_back(tempInfo);
+        neigh2Lists[baseNode].push_back(farNode);
+        dist2Lists[baseNode].push_back(tempf);
+        pathInfoLists[baseNode].push_back(tempInfo);
+    }
+    neighOffsets.resize(numNodes + 1);
+    neigh2Offsets.resize(numNodes + 1);
+    neighOffsets[0] = 0;
+    neigh2Offsets[0] = 0;
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        neighOffsets[i + 1] = neighOffsets[i] + neighLists[i].size();
+        neigh2Offsets[i + 1] = neigh2Offsets[i] + neigh2Lists[i].size();
+    }
+    nodeNeighbors.reserve(neighOffsets[numNodes]);
+    distances.reserve(neighOffsets[numNodes]);
+    nodeNeighbors2.reserve(neigh2Offsets[numNodes]);
+    distances2.reserve(neigh2Offsets[numNodes]);
+    neighbors2PathInfo.reserve(neigh2Offsets[numNodes]);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        nodeNeighbors.insert(nodeNeighbors.end(), neighLists[i].begin(), neighLists[i].end());
+        distances.insert(distances.end(), distLists[i].begin(), distLists[i].end());
+        nodeNeighbors2.insert(nodeNeighbors2.end(), neigh2Lists[i].begin(), neigh2Lists[i].end());
+        distances2.insert(distances2.end(), dist2Lists[i].begin(), dist2Lists[i].end());
+        neighbors2PathInfo.insert(neighbors2PathInfo.end(), pathInfoLists[i].begin(), pathInfoLists[i].end());
     }
 }
 
@@ -171,6 +191,8 @@ GeodesicHelper::GeodesicHelper(const CaretPointer<const GeodesicHelperBase>& bas
     numNodes = m_myBase->numNodes;
     m_avgNodeSpacing = m_myBase->m_avgNodeSpacing;
     m_corrAreaSmallestFactor = m_myBase->m_corrAreaSmallestFactor;
+    neighOffsets = m_myBase->neighOffsets.data();
+    neigh2Offsets = m_myBase->neigh2Offsets.data();
     distances = m_myBase->distances.data();
     distances2 = m_myBase->distances2.data();
     nodeNeighbors = m_myBase->nodeNeighbors.data();
@@ -232,14 +254,14 @@ void GeodesicHelper::dijkstra(const int32_t root, const float maxdist, std::vect
         nodes.push_back(whichnode);
         dists.push_back(output[whichnode]);
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4)
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];//isn't precomputation wonderful
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j];//isn't precomputation wonderful
                 if (tempf <= maxdist)
                 {//keep it off the heap if it is too far
                     if (!(marked[whichneigh] & 4))
@@ -259,14 +281,14 @@ void GeodesicHelper::dijkstra(const int32_t root, const float maxdist, std::vect
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neigh2Offsets[whichnode];
+            numNeigh = (int32_t)(neigh2Offsets[whichnode + 1] - neigh2Offsets[whichnode]);
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neigh2Offsets[whichnode] + j];
                     if (tempf <= maxdist)
                     {//keep it off the heap if it is too far
                         if (!(marked[whichneigh] & 4))
@@ -305,14 +327,14 @@ void GeodesicHelper::dijkstra(const int32_t root, bool smooth)
     {
         whichnode = m_active.pop();
         marked[whichnode] |= 1;
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j];
                 if (!(marked[whichneigh] & 4))
                 {
                     marked[whichneigh] |= 4;
@@ -328,14 +350,14 @@ void GeodesicHelper::dijkstra(const int32_t root, bool smooth)
         }
         if (smooth)
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neigh2Offsets[whichnode];
+            numNeigh = (int32_t)(neigh2Offsets[whichnode + 1] - neigh2Offsets[whichnode]);
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neigh2Offsets[whichnode] + j];
                     if (!(marked[whichneigh] & 4))
                     {
                         marked[whichneigh] |= 4;
@@ -456,14 +478,14 @@ void GeodesicHelper::dijkstra(const int32_t root, const std::vector<int32_t>& in
             --remain;
         }
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4), so already in changed list
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];//isn't precomputation wonderful
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j];//isn't precomputation wonderful
                 if (!(marked[whichneigh] & 4))
                 {
                     if (!marked[whichneigh])
@@ -483,14 +505,14 @@ void GeodesicHelper::dijkstra(const int32_t root, const std::vector<int32_t>& in
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neigh2Offsets[whichnode];
+            numNeigh = (int32_t)(neigh2Offsets[whichnode + 1] - neigh2Offsets[whichnode]);
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neigh2Offsets[whichnode] + j];
                     if (!(marked[whichneigh] & 4))
                     {
                         if (!marked[whichneigh])
@@ -552,14 +574,14 @@ int32_t GeodesicHelper::dijkstra(const vector<int32_t>& startList, const vector<
             break;
         }
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4), so already in changed list
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j];
                 if (tempf <= maxDist)
                 {
                     if (!(marked[whichneigh] & 4))
@@ -582,14 +604,14 @@ int32_t GeodesicHelper::dijkstra(const vector<int32_t>& startList, const vector<
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neigh2Offsets[whichnode];
+            numNeigh = (int32_t)(neigh2Offsets[whichnode + 1] - neigh2Offsets[whichnode]);
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neigh2Offsets[whichnode] + j];
                     if (tempf <= maxDist)
                     {
                         if (!(marked[whichneigh] & 4))
@@ -640,14 +662,14 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, const floa
             break;
         }
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4), so already in changed list
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];//isn't precomputation wonderful
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j];//isn't precomputation wonderful
                 if (tempf <= maxdist)
                 {
                     if (!(marked[whichneigh] & 4))
@@ -670,14 +692,14 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, const floa
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neigh2Offsets[whichnode];
+            numNeigh = (int32_t)(neigh2Offsets[whichnode + 1] - neigh2Offsets[whichnode]);
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];//isn't precomputation wonderful
+                    tempf = output[whichnode] + distances2[neigh2Offsets[whichnode] + j];//isn't precomputation wonderful
                     if (tempf <= maxdist)
                     {
                         if (!(marked[whichneigh] & 4))
@@ -727,14 +749,14 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, bool smoot
             break;
         }
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4), so already in changed list
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];//isn't precomputation wonderful
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j];//isn't precomputation wonderful
                 if (!(marked[whichneigh] & 4))
                 {
                     parent[whichneigh] = whichnode;
@@ -754,14 +776,14 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, bool smoot
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neigh2Offsets[whichnode];
+            numNeigh = (int32_t)(neigh2Offsets[whichnode + 1] - neigh2Offsets[whichnode]);
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];//isn't precomputation wonderful
+                    tempf = output[whichnode] + distances2[neigh2Offsets[whichnode] + j];//isn't precomputation wonderful
                     if (!(marked[whichneigh] & 4))
                     {
                         parent[whichneigh] = whichnode;
@@ -806,14 +828,14 @@ void GeodesicHelper::aStar(const int32_t root, const int32_t endpoint, bool smoo
         whichnode = m_active.pop();//we use a modifiable heap, so we don't need to check for duplicates
         marked[whichnode] |= 1;//frozen - will already be in changed list, due to being in heap
         if (whichnode == endpoint) break;
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (int32_t j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j];
                 if (!(marked[whichneigh] & 4))
                 {
                     heurVal[whichneigh] = m_corrAreaSmallestFactor * (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -831,14 +853,14 @@ void GeodesicHelper::aStar(const int32_t root, const int32_t endpoint, bool smoo
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neigh2Offsets[whichnode];
+            numNeigh = (int32_t)(neigh2Offsets[whichnode + 1] - neigh2Offsets[whichnode]);
             for (int32_t j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neigh2Offsets[whichnode] + j];
                     if (!(marked[whichneigh] & 4))
                     {
                         heurVal[whichneigh] = m_corrAreaSmallestFactor * (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -908,14 +930,14 @@ void GeodesicHelper::aStarLine(const int32_t& root, const int32_t& endpoint, con
         whichnode = m_active.pop();//we use a modifiable heap, so we don't need to check for duplicates
         marked[whichnode] |= 1;//frozen - will already be in changed list, due to being in heap
         if (whichnode == endpoint) break;
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (int32_t j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j] + penaltyScale * distances[whichnode][j] * (linePenalty(nodeCoords[whichnode], linep1, linep2, segment) + linePenalty(nodeCoords[whichneigh], linep1, linep2, segment));
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j] + penaltyScale * distances[neighOffsets[whichnode] + j] * (linePenalty(nodeCoords[whichnode], linep1, linep2, segment) + linePenalty(nodeCoords[whichneigh], linep1, linep2, segment));
                 if (!(marked[whichneigh] & 4))
                 {
                     remainEucl = (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -956,14 +978,14 @@ void GeodesicHelper::aStarData(const int32_t& root, const int32_t& endpoint, con
         whichnode = m_active.pop();//we use a modifiable heap, so we don't need to check for duplicates
         marked[whichnode] |= 1;//frozen - will already be in changed list, due to being in heap
         if (whichnode == endpoint) break;
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighOffsets[whichnode];
+        numNeigh = (int32_t)(neighOffsets[whichnode + 1] - neighOffsets[whichnode]);
         for (int32_t j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if ((roiData == NULL || roiData[whichneigh] > 0.0f) && !(marked[whichneigh] & 1))
             {//skip floating point math if frozen or outside roi
-                tempf = output[whichnode] + distances[whichnode][j] * (1.0f + followStrength * (data[whichnode] + data[whichneigh]));//integrate 1 + strength * value to get distance plus path-integrated data
+                tempf = output[whichnode] + distances[neighOffsets[whichnode] + j] * (1.0f + followStrength * (data[whichnode] + data[whichneigh]));//integrate 1 + strength * value to get distance plus path-integrated data
                 if (!(marked[whichneigh] & 4))
                 {
                     heurVal[whichneigh] = m_corrAreaSmallestFactor * (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -981,16 +1003,16 @@ void GeodesicHelper::aStarData(const int32_t& root, const int32_t& endpoint, con
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
-            const GeodesicHelperBase::CrawlInfo* pathInfo = neighbors2PathInfo[whichnode].data();
+            neighbors = nodeNeighbors2 + neigh2Offsets[whichnode];
+            numNeigh = (int32_t)(neigh2Offsets[whichnode + 1] - neigh2Offsets[whichnode]);
+            const GeodesicHelperBase::CrawlInfo* pathInfo = neighbors2PathInfo + neigh2Offsets[whichnode];
             for (int32_t j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if ((roiData == NULL || roiData[whichneigh] > 0.0f) && !(marked[whichneigh] & 1))
                 {//skip floating point math if frozen or outside roi
-                    tempf = output[whichnode] + distances2[whichnode][j] + followStrength * (data[whichnode] * pathInfo[j].pieceDists[0] + data[whichneigh] * pathInfo[j].pieceDists[1]
-                                + distances2[whichnode][j] * (data[pathInfo[j].edgeNodes[0]] * pathInfo[j].edgeWeight + data[pathInfo[j].edgeNodes[1]] * (1.0f - pathInfo[j].edgeWeight)));
+                    tempf = output[whichnode] + distances2[neigh2Offsets[whichnode] + j] + followStrength * (data[whichnode] * pathInfo[j].pieceDists[0] + data[whichneigh] * pathInfo[j].pieceDists[1]
+                                + distances2[neigh2Offsets[whichnode] + j] * (data[pathInfo[j].edgeNodes[0]] * pathInfo[j].edgeWeight + data[pathInfo[j].edgeNodes[1]] * (1.0f - pathInfo[j].edgeWeight)));
                     if (!(marked[whichneigh] & 4))
                     {
                         heurVal[whichneigh] = m_corrAreaSmallestFactor * (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -0,0 +1,134 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GeodesicNeighborhoodIndex.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+#include "CaretOMP.h"
+#include "GeodesicHelper.h"
+#include "SurfaceFile.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int32_t BATCH_SIZE = 4096;//enough nodes to keep every thread busy, few enough that the per-batch lists stay small
+}
+
+GeodesicNeighborhoodIndex::GeodesicNeighborhoodIndex(const SurfaceFile* surfaceIn, const float& maxDist, const float* correctedAreas, const bool& smooth)
+{
+    CaretAssert(surfaceIn != NULL);
+    m_numNodes = surfaceIn->getNumberOfNodes();
+    m_maxDist = maxDist;
+    m_smooth = smooth;
+    if (correctedAreas != NULL)
+    {
+        m_correctedAreas.assign(correctedAreas, correctedAreas + m_numNodes);
+    }
+    m_geoBase.grabNew(new GeodesicHelperBase(surfaceIn, correctedAreas));
+    m_offsets.resize(m_numNodes + 1);
+    m_offsets[0] = 0;
+    vector<vector<int32_t> > batchNodes(min(BATCH_SIZE, m_numNodes));
+    vector<vector<float> > batchDists(batchNodes.size());
+#pragma omp CARET_PAR
+    {
+        GeodesicHelper myGeoHelp(m_geoBase);
+        for (int32_t batchStart = 0; batchStart < m_numNodes; batchStart += BATCH_SIZE)//every thread runs this loop, the worksharing constructs inside keep them in step
+        {
+            int32_t batchEnd = min(batchStart + BATCH_SIZE, m_numNodes);
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int32_t i = batchStart; i < batchEnd; ++i)
+            {
+                myGeoHelp.getNodesToGeoDist(i, m_maxDist, batchNodes[i - batchStart], batchDists[i - batchStart], m_smooth);
+            }
+#pragma omp CARET_SINGLE
+            {
+                for (int32_t i = batchStart; i < batchEnd; ++i)
+                {
+                    m_offsets[i + 1] = m_offsets[i] + batchNodes[i - batchStart].size();
+                }
+                m_nodes.resize(m_offsets[batchEnd]);
+                m_distances.resize(m_offsets[batchEnd]);
+            }
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int32_t i = batchStart; i < batchEnd; ++i)
+            {
+                const vector<int32_t>& thisNodes = batchNodes[i - batchStart];
+                const vector<float>& thisDists = batchDists[i - batchStart];
+                copy(thisNodes.begin(), thisNodes.end(), m_nodes.begin() + m_offsets[i]);
+                copy(thisDists.begin(), thisDists.end(), m_distances.begin() + m_offsets[i]);
+            }
+        }
+    }
+}
+
+bool GeodesicNeighborhoodIndex::canAnswer(const float& maxDist, const float* correctedAreas, const bool& smooth) const
+{
+    if (maxDist > m_maxDist || smooth != m_smooth) return false;
+    if (correctedAreas == NULL) return m_correctedAreas.empty();
+    if (m_correctedAreas.empty()) return false;
+    return equal(m_correctedAreas.begin(), m_correctedAreas.end(), correctedAreas);
+}
+
+int64_t GeodesicNeighborhoodIndex::getNumberOfNeighbors(const int32_t& node, const float& maxDist) const
+{
+    CaretAssert(node >= 0 && node < m_numNodes);
+    if (maxDist > m_maxDist)
+    {
+        CaretAssert(false);
+        throw CaretException("requested geodesic neighborhood is larger than the precomputed neighborhoods");
+    }
+    const float* start = m_distances.data() + m_offsets[node], *end = m_distances.data() + m_offsets[node + 1];
+    if (maxDist == m_maxDist) return end - start;
+    return upper_bound(start, end, maxDist) - start;//distances are sorted, so a smaller radius is a prefix
+}
+
+void GeodesicNeighborhoodIndex::getNodesToGeoDist(const int32_t& node, const float& maxDist, vector<int32_t>& neighborsOut, vector<float>& distsOut) const
+{
+    int64_t count = getNumberOfNeighbors(node, maxDist);
+    const int32_t* neighbors = getNeighbors(node);
+    const float* dists = getDistances(node);
+    neighborsOut.assign(neighbors, neighbors + count);
+    distsOut.assign(dists, dists + count);
+}
+
+int32_t GeodesicNeighborhoodIndex::getClosestNodeInRoi(const int32_t& node, const char* roi, const float& maxDist, float& distOut) const
+{
+    int64_t count = getNumberOfNeighbors(node, maxDist);
+    const int32_t* neighbors = getNeighbors(node);
+    for (int64_t i = 0; i < count; ++i)
+    {
+        if (roi[neighbors[i]] != 0)//first hit is the closest
+        {
+            distOut = getDistances(node)[i];
+            return neighbors[i];
+        }
+    }
+    return -1;
+}
+
+int64_t GeodesicNeighborhoodIndex::getMemoryUsage() const
+{
+    return m_offsets.size() * sizeof(int64_t) + m_nodes.size() * sizeof(int32_t) + m_distances.size() * sizeof(float) + m_correctedAreas.size() * sizeof(float);
+}
@@ -0,0 +1,80 @@
+#ifndef __GEODESIC_NEIGHBORHOOD_INDEX_H__
+#define __GEODESIC_NEIGHBORHOOD_INDEX_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <vector>
+#include <stdint.h>
+
+#include "CaretPointer.h"
+
+namespace caret {
+
+    class GeodesicHelperBase;
+    class SurfaceFile;
+
+    //NOTE: like GeodesicHelperBase, this takes a snapshot of the surface in the constructor, get it from SurfaceFile so that it is dropped when the surface changes
+
+    class GeodesicNeighborhoodIndex
+    {//all nodes within a fixed geodesic distance of every node, computed once so that several algorithms can reuse the same neighborhoods
+        CaretPointer<const GeodesicHelperBase> m_geoBase;//for queries the index can't answer
+        //compressed sparse row layout, neighborhood of node i is at [m_offsets[i], m_offsets[i + 1]), sorted by increasing distance, starting with node i itself
+        std::vector<int64_t> m_offsets;
+        std::vector<int32_t> m_nodes;
+        std::vector<float> m_distances;
+        std::vector<float> m_correctedAreas;//empty when not corrected, kept so the surface can tell which index was requested
+        int32_t m_numNodes;
+        float m_maxDist;
+        bool m_smooth;
+        GeodesicNeighborhoodIndex();
+        GeodesicNeighborhoodIndex(const GeodesicNeighborhoodIndex&);
+        GeodesicNeighborhoodIndex& operator=(const GeodesicNeighborhoodIndex&);
+    public:
+        ///runs the restricted dijkstra from every node in parallel - NOTE: corrected areas are only an APPROXIMATE correction, see GeodesicHelperBase
+        GeodesicNeighborhoodIndex(const SurfaceFile* surfaceIn, const float& maxDist, const float* correctedAreas = NULL, const bool& smooth = true);
+
+        ///whether this index contains every neighborhood that a GeodesicHelper with these settings would compute, up to maxDist
+        bool canAnswer(const float& maxDist, const float* correctedAreas, const bool& smooth = true) const;
+
+        ///same output as GeodesicHelper::getNodesToGeoDist, maxDist must not exceed the distance the index was built with
+        void getNodesToGeoDist(const int32_t& node, const float& maxDist, std::vector<int32_t>& neighborsOut, std::vector<float>& distsOut) const;
+
+        ///number of neighborhood entries within maxDist, for use with getNeighbors and getDistances
+        int64_t getNumberOfNeighbors(const int32_t& node, const float& maxDist) const;
+        const int32_t* getNeighbors(const int32_t& node) const { return m_nodes.data() + m_offsets[node]; }
+        const float* getDistances(const int32_t& node) const { return m_distances.data() + m_offsets[node]; }
+
+        ///closest node with nonzero roi value within maxDist, returns -1 if none
+        int32_t getClosestNodeInRoi(const int32_t& node, const char* roi, const float& maxDist, float& distOut) const;
+
+        ///for making GeodesicHelpers that give consistent answers for queries outside the index
+        const CaretPointer<const GeodesicHelperBase>& getGeodesicHelperBase() const { return m_geoBase; }
+
+        int32_t getNumberOfNodes() const { return m_numNodes; }
+        float getMaxDistance() const { return m_maxDist; }
+        bool isSmooth() const { return m_smooth; }
+        bool hasCorrectedAreas() const { return !m_correctedAreas.empty(); }
+        int64_t getMemoryUsage() const;
+    };
+
+} //namespace caret
+
+#endif //__GEODESIC_NEIGHBORHOOD_INDEX_H__
@@ -25,6 +25,7 @@
 #include "SurfaceFile.h"
 #include "MetricFile.h"
 #include "GeodesicHelper.h"
+#include "GeodesicNeighborhoodIndex.h"
 #include "TopologyHelper.h"
 #include "CaretOMP.h"
 #include <cmath>
@@ -32,6 +33,26 @@
 using namespace std;
 using namespace caret;
 
+namespace
+{
+    CaretPointer<const GeodesicHelperBase> getGeodesicBase(const SurfaceFile* mySurf, const CaretPointer<const GeodesicNeighborhoodIndex>& myNeighborhoods, const float* nodeAreas)
+    {
+        if (myNeighborhoods != NULL) return myNeighborhoods->getGeodesicHelperBase();//consistent with the neighborhoods
+        return CaretPointer<const GeodesicHelperBase>(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
+    }
+    
+    void getNodesToGeoDist(const CaretPointer<const GeodesicNeighborhoodIndex>& myNeighborhoods, const CaretPointer<GeodesicHelper>& myGeoHelp, const int32_t& node,
+                           const float& maxDist, vector<int32_t>& nodesOut, vector<float>& distsOut)
+    {//without a cached index, only search from the vertices that are asked for, so ROI smoothing doesn't pay for the whole surface
+        if (myNeighborhoods != NULL)
+        {
+            myNeighborhoods->getNodesToGeoDist(node, maxDist, nodesOut, distsOut);
+        } else {
+            myGeoHelp->getNodesToGeoDist(node, maxDist, nodesOut, distsOut, true);
+        }
+    }
+}
+
 MetricSmoothingObject::MetricSmoothingObject(const SurfaceFile* mySurf, const float& kernel, const MetricFile* myRoi, Method myMethod, const float* nodeAreas)
 {
     CaretAssert(mySurf != NULL);
@@ -283,7 +304,8 @@ void MetricSmoothingObject::precomputeWeightsGeoGauss(const SurfaceFile* mySurf,
     float myGeoDist = myKernel * 3.0f;
     float gaussianDenom = -0.5f / myKernel / myKernel;
     m_weightLists.resize(numNodes);
-    CaretPointer<GeodesicHelperBase> myGeoBase(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(myGeoDist, nodeAreas);//only reuse neighborhoods something else cached, caching them here would keep a second copy of the weights around
+    CaretPointer<const GeodesicHelperBase> myGeoBase = getGeodesicBase(mySurf, myNeighborhoods, nodeAreas);
 #pragma omp CARET_PAR
     {
         CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();//don't really need one per thread here, but good practice in case we want getNeighborsToDepth
@@ -292,7 +314,7 @@ void MetricSmoothingObject::precomputeWeightsGeoGauss(const SurfaceFile* mySurf,
 #pragma omp CARET_FOR schedule(dynamic)
         for (int32_t i = 0; i < numNodes; ++i)
         {
-            myGeoHelp->getNodesToGeoDist(i, myGeoDist, m_weightLists[i].m_nodes, distances, true);
+            getNodesToGeoDist(myNeighborhoods, myGeoHelp, i, myGeoDist, m_weightLists[i].m_nodes, distances);
             if (distances.size() < 7)
             {
                 m_weightLists[i].m_nodes = myTopoHelp->getNodeNeighbors(i);
@@ -319,7 +341,8 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGauss(const SurfaceFile* mySu
     float gaussianDenom = -0.5f / myKernel / myKernel;
     m_weightLists.resize(numNodes);
     const float* myRoiColumn = theRoi->getValuePointerForColumn(0);
-    CaretPointer<GeodesicHelperBase> myGeoBase(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(myGeoDist, nodeAreas);//only reuse neighborhoods something else cached, caching them here would keep a second copy of the weights around
+    CaretPointer<const GeodesicHelperBase> myGeoBase = getGeodesicBase(mySurf, myNeighborhoods, nodeAreas);
 #pragma omp CARET_PAR
     {
         CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
@@ -331,7 +354,7 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGauss(const SurfaceFile* mySu
         {
             if (myRoiColumn[i] > 0.0f)
             {
-                myGeoHelp->getNodesToGeoDist(i, myGeoDist, nodes, distances, true);
+                getNodesToGeoDist(myNeighborhoods, myGeoHelp, i, myGeoDist, nodes, distances);
                 if (distances.size() < 7)
                 {
                     nodes = myTopoHelp->getNodeNeighbors(i);
@@ -364,7 +387,8 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussArea(const SurfaceFile* myS
     float gaussianDenom = -0.5f / myKernel / myKernel;
     vector<WeightList> tempList;//this is used to compute scattering kernels because it is easier to normalize scattering kernels correctly, and then convert to gathering kernels
     tempList.resize(numNodes);
-    CaretPointer<GeodesicHelperBase> myGeoBase(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(myGeoDist, nodeAreas);//only reuse neighborhoods something else cached, caching them here would keep a second copy of the weights around
+    CaretPointer<const GeodesicHelperBase> myGeoBase = getGeodesicBase(mySurf, myNeighborhoods, nodeAreas);
 #pragma omp CARET_PAR
     {
         CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();//don't really need one per thread here, but good practice in case we want getNeighborsToDepth
@@ -373,7 +397,7 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussArea(const SurfaceFile* myS
 #pragma omp CARET_FOR schedule(dynamic)
         for (int32_t i = 0; i < numNodes; ++i)
         {
-            myGeoHelp->getNodesToGeoDist(i, myGeoDist, tempList[i].m_nodes, distances, true);
+            getNodesToGeoDist(myNeighborhoods, myGeoHelp, i, myGeoDist, tempList[i].m_nodes, distances);
             const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
             if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
             {
@@ -428,7 +452,8 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussArea(const SurfaceFile*
     vector<WeightList> tempList;//this is used to compute scattering kernels because it is easier to normalize scattering kernels correctly, and then convert to gathering kernels
     tempList.resize(numNodes);
     const float* myRoiColumn = theRoi->getValuePointerForColumn(0);
-    CaretPointer<GeodesicHelperBase> myGeoBase(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(myGeoDist, nodeAreas);//only reuse neighborhoods something else cached, caching them here would keep a second copy of the weights around
+    CaretPointer<const GeodesicHelperBase> myGeoBase = getGeodesicBase(mySurf, myNeighborhoods, nodeAreas);
 #pragma omp CARET_PAR
     {
         CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
@@ -440,7 +465,7 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussArea(const SurfaceFile*
         {
             if (myRoiColumn[i] > 0.0f)//we don't need to scatter from things outside the ROI
             {
-                myGeoHelp->getNodesToGeoDist(i, myGeoDist, nodes, distances, true);
+                getNodesToGeoDist(myNeighborhoods, myGeoHelp, i, myGeoDist, nodes, distances);
                 const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
                 if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
                 {
@@ -499,7 +524,8 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussEqual(const SurfaceFile* my
     float gaussianDenom = -0.5f / myKernel / myKernel;
     vector<WeightList> tempList;//this is used to compute scattering kernels because it is easier to normalize scattering kernels correctly, and then convert to gathering kernels
     tempList.resize(numNodes);
-    CaretPointer<GeodesicHelperBase> myGeoBase(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(myGeoDist, nodeAreas);//only reuse neighborhoods something else cached, caching them here would keep a second copy of the weights around
+    CaretPointer<const GeodesicHelperBase> myGeoBase = getGeodesicBase(mySurf, myNeighborhoods, nodeAreas);
 #pragma omp CARET_PAR
     {
         CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();//don't really need one per thread here, but good practice in case we want getNeighborsToDepth
@@ -508,7 +534,7 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussEqual(const SurfaceFile* my
 #pragma omp CARET_FOR schedule(dynamic)
         for (int32_t i = 0; i < numNodes; ++i)
         {
-            myGeoHelp->getNodesToGeoDist(i, myGeoDist, tempList[i].m_nodes, distances, true);
+            getNodesToGeoDist(myNeighborhoods, myGeoHelp, i, myGeoDist, tempList[i].m_nodes, distances);
             const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
             if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
             {
@@ -563,7 +589,8 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussEqual(const SurfaceFile*
     vector<WeightList> tempList;//this is used to compute scattering kernels because it is easier to normalize scattering kernels correctly, and then convert to gathering kernels
     tempList.resize(numNodes);
     const float* myRoiColumn = theRoi->getValuePointerForColumn(0);
-    CaretPointer<GeodesicHelperBase> myGeoBase(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
+    CaretPointer<const GeodesicNeighborhoodIndex> myNeighborhoods = mySurf->findGeodesicNeighborhoodIndex(myGeoDist, nodeAreas);//only reuse neighborhoods something else cached, caching them here would keep a second copy of the weights around
+    CaretPointer<const GeodesicHelperBase> myGeoBase = getGeodesicBase(mySurf, myNeighborhoods, nodeAreas);
 #pragma omp CARET_PAR
     {
         CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
@@ -575,7 +602,7 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussEqual(const SurfaceFile*
         {
             if (myRoiColumn[i] > 0.0f)//we don't need to scatter from things outside the ROI
             {
-                myGeoHelp->getNodesToGeoDist(i, myGeoDist, nodes, distances, true);
+                getNodesToGeoDist(myNeighborhoods, myGeoHelp, i, myGeoDist, nodes, distances);
                 const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
                 if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
                 {
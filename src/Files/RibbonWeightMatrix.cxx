@@ -0,0 +1,209 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "RibbonWeightMatrix.h"
+
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "DataFileException.h"
+
+#include <QDataStream>
+#include <QFile>
+
+#include <cstring>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const char RIBBON_WEIGHTS_MAGIC[8] = { 'W', 'B', 'R', 'I', 'B', 'W', 'T', '1' };
+}
+
+RibbonWeightMatrix::RibbonWeightMatrix(const vector<vector<VoxelWeight> >& vertexWeights, const VolumeSpace& volSpace, const StructureEnum::Enum& structure)
+{
+    m_volSpace = volSpace;
+    m_structure = structure;
+    int64_t numVertices = (int64_t)vertexWeights.size();
+    m_rowOffsets.resize(numVertices + 1);
+    m_rowOffsets[0] = 0;
+    for (int64_t i = 0; i < numVertices; ++i)
+    {
+        m_rowOffsets[i + 1] = m_rowOffsets[i] + vertexWeights[i].size();
+    }
+    m_voxelIndices.resize(m_rowOffsets[numVertices]);
+    m_weights.resize(m_rowOffsets[numVertices]);
+    for (int64_t i = 0; i < numVertices; ++i)
+    {
+        int64_t base = m_rowOffsets[i];
+        const vector<VoxelWeight>& thisWeights = vertexWeights[i];
+        for (size_t j = 0; j < thisWeights.size(); ++j)
+        {
+            m_voxelIndices[base + j] = m_volSpace.getIndex(thisWeights[j].ijk);
+            m_weights[base + j] = thisWeights[j].weight;
+        }
+    }
+    computeWeightSums();
+}
+
+void RibbonWeightMatrix::computeWeightSums()
+{
+    int64_t numVertices = (int64_t)m_rowOffsets.size() - 1;
+    m_weightSums.resize(numVertices);
+    for (int64_t i = 0; i < numVertices; ++i)
+    {
+        float totalWeight = 0.0f;
+        for (int64_t j = m_rowOffsets[i]; j < m_rowOffsets[i + 1]; ++j)
+        {
+            totalWeight += m_weights[j];
+        }
+        m_weightSums[i] = totalWeight;
+    }
+}
+
+void RibbonWeightMatrix::apply(const float* frame, float* vertexValuesOut) const
+{
+    int64_t numVertices = getNumberOfVertices();
+#pragma omp CARET_PARFOR schedule(dynamic, 256)
+    for (int64_t i = 0; i < numVertices; ++i)
+    {
+        if (m_weightSums[i] != 0.0f)
+        {
+            float accum = 0.0f;
+            for (int64_t j = m_rowOffsets[i]; j < m_rowOffsets[i + 1]; ++j)
+            {
+                accum += m_weights[j] * frame[m_voxelIndices[j]];
+            }
+            vertexValuesOut[i] = accum / m_weightSums[i];
+        } else {
+            vertexValuesOut[i] = 0.0f;
+        }
+    }
+}
+
+void RibbonWeightMatrix::writeFile(const AString& filename) const
+{
+    QFile outFile(filename);
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        throw DataFileException(filename, "failed to open ribbon weights file for writing");
+    }
+    QDataStream outStream(&outFile);
+    outStream.setByteOrder(QDataStream::LittleEndian);
+    outStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    outStream.writeRawData(RIBBON_WEIGHTS_MAGIC, sizeof(RIBBON_WEIGHTS_MAGIC));
+    const int64_t* dims = m_volSpace.getDims();
+    outStream << (qint64)dims[0] << (qint64)dims[1] << (qint64)dims[2];
+    const vector<vector<float> >& sform = m_volSpace.getSform();
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            outStream << sform[i][j];
+        }
+    }
+    outStream << QString(StructureEnum::toName(m_structure));
+    int64_t numVertices = getNumberOfVertices();
+    outStream << (qint64)numVertices << (qint64)getNumberOfWeights();
+    for (int64_t i = 0; i < numVertices; ++i)
+    {
+        outStream << (qint32)(m_rowOffsets[i + 1] - m_rowOffsets[i]);
+        for (int64_t j = m_rowOffsets[i]; j < m_rowOffsets[i + 1]; ++j)
+        {
+            outStream << (qint64)m_voxelIndices[j] << m_weights[j];
+        }
+    }
+    if (outStream.status() != QDataStream::Ok || !outFile.flush())
+    {
+        throw DataFileException(filename, "error writing ribbon weights file");
+    }
+}
+
+void RibbonWeightMatrix::readFile(const AString& filename)
+{
+    QFile inFile(filename);
+    if (!inFile.open(QIODevice::ReadOnly))
+    {
+        throw DataFileException(filename, "failed to open ribbon weights file for reading");
+    }
+    QDataStream inStream(&inFile);
+    inStream.setByteOrder(QDataStream::LittleEndian);
+    inStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    char magic[sizeof(RIBBON_WEIGHTS_MAGIC)];
+    if (inStream.readRawData(magic, sizeof(RIBBON_WEIGHTS_MAGIC)) != (int)sizeof(RIBBON_WEIGHTS_MAGIC) || memcmp(magic, RIBBON_WEIGHTS_MAGIC, sizeof(RIBBON_WEIGHTS_MAGIC)) != 0)
+    {
+        throw DataFileException(filename, "file is not a ribbon weights file");
+    }
+    qint64 dimsIn[3];
+    inStream >> dimsIn[0] >> dimsIn[1] >> dimsIn[2];
+    float sform[12];
+    for (int i = 0; i < 12; ++i)
+    {
+        inStream >> sform[i];
+    }
+    QString structureName;
+    qint64 numVertices = -1, numWeights = -1;
+    inStream >> structureName >> numVertices >> numWeights;
+    const qint64 remainingBytes = inFile.size() - inFile.pos(), vertexBytes = 4, weightBytes = 8 + 4;//check counts against the file size before allocating for them
+    if (inStream.status() != QDataStream::Ok || dimsIn[0] < 1 || dimsIn[1] < 1 || dimsIn[2] < 1 ||
+        numVertices < 0 || numWeights < 0 || numVertices > remainingBytes / vertexBytes ||
+        numWeights > (remainingBytes - numVertices * vertexBytes) / weightBytes)
+    {
+        throw DataFileException(filename, "ribbon weights file is corrupted");
+    }
+    int64_t dims[3] = { dimsIn[0], dimsIn[1], dimsIn[2] };
+    int64_t frameSize = dims[0] * dims[1] * dims[2];
+    bool ok = false;
+    StructureEnum::Enum structure = StructureEnum::fromName(structureName, &ok);
+    if (!ok) structure = StructureEnum::INVALID;
+    vector<int64_t> rowOffsets(numVertices + 1), voxelIndices(numWeights);
+    vector<float> weights(numWeights);
+    rowOffsets[0] = 0;
+    for (qint64 i = 0; i < numVertices; ++i)
+    {
+        qint32 count = -1;
+        inStream >> count;
+        if (inStream.status() != QDataStream::Ok || count < 0 || rowOffsets[i] + count > numWeights)
+        {
+            throw DataFileException(filename, "ribbon weights file is corrupted");
+        }
+        rowOffsets[i + 1] = rowOffsets[i] + count;
+        for (int64_t j = rowOffsets[i]; j < rowOffsets[i + 1]; ++j)
+        {
+            qint64 voxel;
+            inStream >> voxel >> weights[j];
+            if (voxel < 0 || voxel >= frameSize)
+            {
+                throw DataFileException(filename, "ribbon weights file contains a voxel outside its volume space");
+            }
+            voxelIndices[j] = voxel;
+        }
+    }
+    if (inStream.status() != QDataStream::Ok || rowOffsets[numVertices] != numWeights)
+    {
+        throw DataFileException(filename, "ribbon weights file is corrupted");
+    }
+    m_volSpace.setSpace(dims, sform);
+    m_structure = structure;
+    m_rowOffsets.swap(rowOffsets);
+    m_voxelIndices.swap(voxelIndices);
+    m_weights.swap(weights);
+    computeWeightSums();
+}
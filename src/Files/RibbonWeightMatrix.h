@@ -0,0 +1,68 @@
+#ifndef __RIBBON_WEIGHT_MATRIX_H__
+#define __RIBBON_WEIGHT_MATRIX_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+#include "RibbonMappingHelper.h"
+#include "StructureEnum.h"
+#include "VolumeSpace.h"
+
+#include "stdint.h"
+#include <vector>
+
+namespace caret
+{
+
+    ///vertex by voxel sparse matrix of ribbon mapping weights, so that mapping a volume frame is a sparse matrix-vector product
+    class RibbonWeightMatrix
+    {
+        VolumeSpace m_volSpace;
+        StructureEnum::Enum m_structure;
+        //compressed sparse row layout, weights of vertex i are at [m_rowOffsets[i], m_rowOffsets[i + 1])
+        std::vector<int64_t> m_rowOffsets;
+        std::vector<int64_t> m_voxelIndices;//into a single frame, as from VolumeSpace::getIndex
+        std::vector<float> m_weights;
+        std::vector<float> m_weightSums;//summed in the same order as the original per-vertex loop, so results are identical
+        void computeWeightSums();
+    public:
+        RibbonWeightMatrix() { m_structure = StructureEnum::INVALID; }
+        RibbonWeightMatrix(const std::vector<std::vector<VoxelWeight> >& vertexWeights, const VolumeSpace& volSpace, const StructureEnum::Enum& structure = StructureEnum::INVALID);
+
+        ///binary format, throws DataFileException on error
+        void readFile(const AString& filename);
+        void writeFile(const AString& filename) const;
+
+        const VolumeSpace& getVolumeSpace() const { return m_volSpace; }
+        StructureEnum::Enum getStructure() const { return m_structure; }
+        int64_t getNumberOfVertices() const { return (int64_t)m_weightSums.size(); }
+        int64_t getNumberOfWeights() const { return (int64_t)m_weights.size(); }
+
+        ///vertices whose weights sum to zero get zero, like the ribbon mapping algorithm does
+        bool hasWeights(const int64_t& vertex) const { return m_weightSums[vertex] != 0.0f; }
+
+        ///weighted average of the voxels for each vertex, vertexValuesOut must have room for getNumberOfVertices() values
+        void apply(const float* frame, float* vertexValuesOut) const;
+    };
+
+}
+
+#endif //__RIBBON_WEIGHT_MATRIX_H__
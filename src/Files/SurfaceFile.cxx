@@ -44,7 +44,9 @@
 #include "Vector3D.h"
 
 #include "CaretPointLocator.h"
+#include "CaretTriangleBVH.h"
 #include "GeodesicHelper.h"
+#include "GeodesicNeighborhoodIndex.h"
 #include "PlainTextStringBuilder.h"
 #include "SignedDistanceHelper.h"
 #include "TopologyHelper.h"
@@ -811,6 +813,68 @@ CaretPointer<GeodesicHelper> SurfaceFile::getGeodesicHelper() const
     return ret;//so we are already safe by here, at the expense of a second copy constructor/operator= of a CaretPointer
 }
 
+const float* SurfaceFile::getDistinctCorrectedAreas(const float* correctedAreas) const
+{
+    if (correctedAreas == NULL) return NULL;
+    std::vector<float> myAreas;
+    computeNodeAreas(myAreas);
+    if (std::equal(myAreas.begin(), myAreas.end(), correctedAreas)) return NULL;//the correction factors would all be exactly 1, so share the uncorrected neighborhoods
+    return correctedAreas;
+}
+
+CaretPointer<const GeodesicNeighborhoodIndex> SurfaceFile::findGeodesicNeighborhoodIndex(const float& maxDist, const float* correctedAreas) const
+{//for callers that only need a few neighborhoods, and shouldn't pay for computing all of them
+    const float* myAreas = getDistinctCorrectedAreas(correctedAreas);
+    CaretMutexLocker myLock(&m_geoNeighborhoodMutex);
+    for (size_t i = 0; i < m_geoNeighborhoods.size(); ++i)
+    {
+        if (m_geoNeighborhoods[i]->canAnswer(maxDist, myAreas))
+        {
+            return m_geoNeighborhoods[i];
+        }
+    }
+    return CaretPointer<const GeodesicNeighborhoodIndex>();
+}
+
+CaretPointer<const GeodesicNeighborhoodIndex> SurfaceFile::getGeodesicNeighborhoodIndex(const float& maxDist, const float* correctedAreas) const
+{
+    const int64_t MAX_CACHED_BYTES = ((int64_t)1) << 30;//these can be as large as the smoothing weights, so bound the total size rather than the count
+    const float* myAreas = getDistinctCorrectedAreas(correctedAreas);
+    CaretMutexLocker myLock(&m_geoNeighborhoodMutex);//keep locked while building, so that concurrent requests don't compute the same neighborhoods twice
+    for (size_t i = 0; i < m_geoNeighborhoods.size(); ++i)
+    {
+        if (m_geoNeighborhoods[i]->canAnswer(maxDist, myAreas))
+        {
+            CaretPointer<const GeodesicNeighborhoodIndex> ret = m_geoNeighborhoods[i];
+            m_geoNeighborhoods.erase(m_geoNeighborhoods.begin() + i);
+            m_geoNeighborhoods.push_back(ret);
+            return ret;
+        }
+    }
+    CaretPointer<const GeodesicNeighborhoodIndex> ret(new GeodesicNeighborhoodIndex(this, maxDist, myAreas));
+    for (size_t i = 0; i < m_geoNeighborhoods.size();)
+    {//the new one can answer anything a smaller one with the same areas could
+        if (m_geoNeighborhoods[i]->getMaxDistance() <= maxDist && m_geoNeighborhoods[i]->canAnswer(0.0f, myAreas, ret->isSmooth()))
+        {
+            m_geoNeighborhoods.erase(m_geoNeighborhoods.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+    int64_t cachedBytes = ret->getMemoryUsage();
+    for (size_t i = 0; i < m_geoNeighborhoods.size(); ++i)
+    {
+        cachedBytes += m_geoNeighborhoods[i]->getMemoryUsage();
+    }
+    while (!m_geoNeighborhoods.empty() && cachedBytes > MAX_CACHED_BYTES)
+    {//least recently used first, the new one is always kept because the caller holds it anyway
+        cachedBytes -= m_geoNeighborhoods[0]->getMemoryUsage();
+        m_geoNeighborhoods.erase(m_geoNeighborhoods.begin());
+    }
+    m_geoNeighborhoods.push_back(ret);
+    return ret;
+}
+
 void SurfaceFile::getTopologyHelper(CaretPointer<TopologyHelper>& helpOut, bool infoSorted) const
 {
     {
@@ -909,6 +973,16 @@ void SurfaceFile::invalidateHelpers()
         CaretMutexLocker myLock3(&m_locatorMutex);
         m_locator.grabNew(NULL);
     }
+    if (m_triangleBVH != NULL)
+    {
+        CaretMutexLocker myLock5(&m_triangleBVHMutex);
+        m_triangleBVH.grabNew(NULL);
+    }
+    if (!m_geoNeighborhoods.empty())
+    {
+        CaretMutexLocker myLock6(&m_geoNeighborhoodMutex);
+        m_geoNeighborhoods.clear();
+    }
 }
 
 /**
@@ -1404,6 +1478,19 @@ CaretPointer<const CaretPointLocator> SurfaceFile::getPointLocator() const
     return m_locator;
 }
 
+CaretPointer<const CaretTriangleBVH> SurfaceFile::getTriangleBVH() const
+{//built on first use, rebuilt after coordinates or triangles change
+    if (m_triangleBVH == NULL)
+    {
+        CaretMutexLocker myLock(&m_triangleBVHMutex);
+        if (m_triangleBVH == NULL)
+        {
+            m_triangleBVH.grabNew(new CaretTriangleBVH(getCoordinateData(), getNumberOfNodes(), trianglePointer, getNumberOfTriangles()));
+        }
+    }
+    return m_triangleBVH;
+}
+
 void SurfaceFile::clearCachedHelpers() const
 {
     {
@@ -1428,6 +1515,14 @@ void SurfaceFile::clearCachedHelpers() const
         CaretMutexLocker locked(&m_locatorMutex);
         m_locator.grabNew(NULL);
     }
+    {
+        CaretMutexLocker locked(&m_triangleBVHMutex);
+        m_triangleBVH.grabNew(NULL);
+    }
+    {
+        CaretMutexLocker locked(&m_geoNeighborhoodMutex);
+        m_geoNeighborhoods.clear();
+    }
 }
 
 /**
@@ -37,10 +37,12 @@ namespace caret {
 
     class BoundingBox;
     class CaretPointLocator;
+    class CaretTriangleBVH;
     class DescriptiveStatistics;
     class FastStatistics;
     class GeodesicHelper;
     class GeodesicHelperBase;
+    class GeodesicNeighborhoodIndex;
     class GiftiDataArray;
     class GraphicsPrimitiveV3fN3fC4f;
     class Matrix4x4;
@@ -136,12 +138,18 @@ namespace caret {
         
         void getGeodesicHelper(CaretPointer<GeodesicHelper>& helpOut) const;
         
+        CaretPointer<const GeodesicNeighborhoodIndex> getGeodesicNeighborhoodIndex(const float& maxDist, const float* correctedAreas = NULL) const;
+        
+        CaretPointer<const GeodesicNeighborhoodIndex> findGeodesicNeighborhoodIndex(const float& maxDist, const float* correctedAreas = NULL) const;
+        
         CaretPointer<SignedDistanceHelper> getSignedDistanceHelper() const;
         
         void getSignedDistanceHelper(CaretPointer<SignedDistanceHelper>& helpOut) const;
         
         CaretPointer<const CaretPointLocator> getPointLocator() const;
         
+        CaretPointer<const CaretTriangleBVH> getTriangleBVH() const;
+        
         void clearCachedHelpers() const;
         
         const BoundingBox* getBoundingBox() const;
@@ -333,12 +341,21 @@ namespace caret {
         ///used to search for the closest point in the surface
         mutable CaretPointer<CaretPointLocator> m_locator;
         
+        ///used to cast rays against the triangles, such as for identification
+        mutable CaretPointer<CaretTriangleBVH> m_triangleBVH;
+        
+        ///geodesic neighborhoods of every node, most recently used last
+        mutable std::vector<CaretPointer<const GeodesicNeighborhoodIndex> > m_geoNeighborhoods;
+        
+        ///areas equal to this surface's own areas don't change the geodesic distances
+        const float* getDistinctCorrectedAreas(const float* correctedAreas) const;
+        
         ///used to track when the surface file gets changed
         void invalidateHelpers();
         
         mutable BoundingBox* boundingBox;
         
-        mutable CaretMutex m_topoHelperMutex, m_geoHelperMutex, m_locatorMutex, m_distHelperMutex;
+        mutable CaretMutex m_topoHelperMutex, m_geoHelperMutex, m_locatorMutex, m_distHelperMutex, m_triangleBVHMutex, m_geoNeighborhoodMutex;
     };
 
 } // namespace
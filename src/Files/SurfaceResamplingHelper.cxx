@@ -36,17 +36,37 @@
 #include "TopologyHelper.h"
 #include "Vector3D.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
 #include <algorithm>
+#include <cstring>
 #include <set>
 #include <map>
 
 using namespace std;
 using namespace caret;
 
+AString SurfaceResamplingHelper::s_weightCacheDirectory;
+
+namespace
+{
+    const char WEIGHT_CACHE_MAGIC[8] = { 'W', 'B', 'R', 'S', 'W', 'T', '0', '1' };
+}
+
 SurfaceResamplingHelper::SurfaceResamplingHelper(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
                                                  const float* currentAreas, const float* newAreas, const float* currentRoi, const bool allowNonSphere)
 {
     m_nonsphereAllowed = allowNonSphere;
+    AString cacheFileName;
+    if (!s_weightCacheDirectory.isEmpty())
+    {//the key covers every input that affects the weights, so a hit can skip the sphere check and locator building too
+        cacheFileName = getWeightCacheFileName(myMethod, currentSphere, newSphere, currentAreas, newAreas, currentRoi, allowNonSphere);
+        if (readWeightCache(cacheFileName, newSphere->getNumberOfNodes(), currentSphere->getNumberOfNodes())) return;
+    }
     SurfaceFile currentSphereMod, newSphereMod;
     const SurfaceFile* useCurrent = currentSphere, *useNew = newSphere;
     if (!allowNonSphere)
@@ -70,6 +90,141 @@ SurfaceResamplingHelper::SurfaceResamplingHelper(const SurfaceResamplingMethodEn
             computeWeightsBarycentric(useCurrent, useNew, currentRoi);
             break;
     }
+    if (!cacheFileName.isEmpty()) writeWeightCache(cacheFileName);
+}
+
+AString SurfaceResamplingHelper::getWeightCacheFileName(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
+                                                        const float* currentAreas, const float* newAreas, const float* currentRoi, const bool allowNonSphere)
+{
+    QCryptographicHash myHash(QCryptographicHash::Sha1);
+    myHash.addData(WEIGHT_CACHE_MAGIC, sizeof(WEIGHT_CACHE_MAGIC));//so a format change can't collide with old entries
+    int32_t header[5] = { (int32_t)myMethod, allowNonSphere ? 1 : 0, currentSphere->getNumberOfNodes(), newSphere->getNumberOfNodes(), 0 };
+    if (myMethod == SurfaceResamplingMethodEnum::ADAP_BARY_AREA) header[4] |= 1;//areas aren't used for barycentric
+    if (currentRoi != NULL) header[4] |= 2;
+    myHash.addData((const char*)header, sizeof(header));
+    const SurfaceFile* surfaces[2] = { currentSphere, newSphere };
+    for (int i = 0; i < 2; ++i)
+    {
+        myHash.addData((const char*)surfaces[i]->getCoordinateData(), surfaces[i]->getNumberOfNodes() * 3 * sizeof(float));
+        int32_t numTris = surfaces[i]->getNumberOfTriangles();
+        myHash.addData((const char*)&numTris, sizeof(int32_t));
+        if (numTris > 0) myHash.addData((const char*)surfaces[i]->getTriangle(0), numTris * 3 * sizeof(int32_t));
+    }
+    if (header[4] & 1)
+    {
+        myHash.addData((const char*)currentAreas, currentSphere->getNumberOfNodes() * sizeof(float));
+        myHash.addData((const char*)newAreas, newSphere->getNumberOfNodes() * sizeof(float));
+    }
+    if (header[4] & 2)
+    {//only whether each vertex is inside matters
+        QByteArray roiBits(currentSphere->getNumberOfNodes(), 0);
+        for (int i = 0; i < currentSphere->getNumberOfNodes(); ++i)
+        {
+            if (currentRoi[i] > 0.0f) roiBits[i] = 1;
+        }
+        myHash.addData(roiBits);
+    }
+    return s_weightCacheDirectory + "/" + AString(myHash.result().toHex()) + ".wbresample";
+}
+
+bool SurfaceResamplingHelper::readWeightCache(const AString& fileName, const int& numNewNodes, const int& numCurrentNodes)
+{
+    QFile inFile(fileName);
+    if (!inFile.exists() || !inFile.open(QIODevice::ReadOnly)) return false;
+    QDataStream inStream(&inFile);
+    inStream.setByteOrder(QDataStream::LittleEndian);
+    inStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    char magic[sizeof(WEIGHT_CACHE_MAGIC)];
+    qint64 numNodes = -1, numElems = -1;
+    if (inStream.readRawData(magic, sizeof(WEIGHT_CACHE_MAGIC)) == (int)sizeof(WEIGHT_CACHE_MAGIC) && memcmp(magic, WEIGHT_CACHE_MAGIC, sizeof(WEIGHT_CACHE_MAGIC)) == 0)
+    {
+        inStream >> numNodes >> numElems;
+    }
+    if (inStream.status() != QDataStream::Ok || numNodes != numNewNodes || numElems < 0 || numElems > inFile.size())
+    {
+        CaretLogWarning("ignoring resampling weight cache file '" + fileName + "', file is corrupted");
+        return false;
+    }
+    CaretArray<WeightElem> storage(numElems);
+    CaretArray<WeightElem*> weights(numNodes + 1);
+    qint64 curpos = 0;
+    for (qint64 i = 0; i < numNodes; ++i)
+    {
+        qint32 count;
+        inStream >> count;
+        if (count < 0 || curpos + count > numElems)
+        {//the rest of the vertices would have no weights, don't let the total check below pass by coincidence
+            CaretLogWarning("ignoring resampling weight cache file '" + fileName + "', file is corrupted");
+            return false;
+        }
+        weights[i] = storage + curpos;
+        for (qint32 j = 0; j < count; ++j)
+        {
+            qint32 node;
+            float weight;
+            inStream >> node >> weight;
+            if (node < 0 || node >= numCurrentNodes) node = -1;//flag it, checked below
+            storage[curpos] = WeightElem(node, weight);
+            ++curpos;
+        }
+    }
+    bool valid = (inStream.status() == QDataStream::Ok && curpos == numElems);
+    for (qint64 i = 0; valid && i < numElems; ++i)
+    {
+        if (storage[i].node < 0) valid = false;
+    }
+    if (!valid)
+    {
+        CaretLogWarning("ignoring resampling weight cache file '" + fileName + "', file is corrupted");
+        return false;
+    }
+    weights[numNodes] = storage + numElems;
+    m_storagechunk = storage;
+    m_weights = weights;
+    CaretLogFine("loaded resampling weights from cache file '" + fileName + "'");
+    return true;
+}
+
+void SurfaceResamplingHelper::writeWeightCache(const AString& fileName) const
+{//failing to write the cache shouldn't fail the resampling, so only warn
+    QDir cacheDir(s_weightCacheDirectory);
+    if (!cacheDir.exists() && !cacheDir.mkpath("."))
+    {
+        CaretLogWarning("failed to create resampling weight cache directory '" + s_weightCacheDirectory + "'");
+        return;
+    }
+    QTemporaryFile tempFile(fileName + ".XXXXXX");//write then rename, so that concurrent processes never see a partial file
+    tempFile.setAutoRemove(true);
+    if (!tempFile.open())
+    {
+        CaretLogWarning("failed to create temporary file in resampling weight cache directory '" + s_weightCacheDirectory + "'");
+        return;
+    }
+    tempFile.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ReadGroup | QFile::ReadOther);//temporary files are owner-only, but the cache may be shared
+    QDataStream outStream(&tempFile);
+    outStream.setByteOrder(QDataStream::LittleEndian);
+    outStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    qint64 numNodes = (qint64)m_weights.size() - 1;
+    outStream.writeRawData(WEIGHT_CACHE_MAGIC, sizeof(WEIGHT_CACHE_MAGIC));
+    outStream << numNodes << (qint64)(m_weights[numNodes] - m_weights[0]);
+    for (qint64 i = 0; i < numNodes; ++i)
+    {
+        outStream << (qint32)(m_weights[i + 1] - m_weights[i]);
+        for (const WeightElem* elem = m_weights[i]; elem != m_weights[i + 1]; ++elem)
+        {
+            outStream << (qint32)elem->node << elem->weight;
+        }
+    }
+    if (outStream.status() != QDataStream::Ok || !tempFile.flush())
+    {
+        CaretLogWarning("error writing resampling weight cache file '" + tempFile.fileName() + "'");
+        return;
+    }
+    tempFile.close();
+    if (QFile::rename(tempFile.fileName(), fileName))
+    {
+        tempFile.setAutoRemove(false);
+    }//else another process probably wrote the same entry first, and the temporary file is removed
 }
 
 void SurfaceResamplingHelper::resampleNormal(const float* input, float* output, const float& invalidVal) const
@@ -93,6 +248,43 @@ void SurfaceResamplingHelper::resampleNormal(const float* input, float* output,
     }
 }
 
+void SurfaceResamplingHelper::resampleNormalInterleaved(const float* input, float* output, const int& numColumns, const float& invalidVal) const
+{//one pass over the weights for the whole block, with contiguous inner loops over columns that the compiler can vectorize
+    int numNodes = (int)m_weights.size() - 1;
+#pragma omp CARET_PAR
+    {
+        vector<double> accum(numColumns);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int i = 0; i < numNodes; ++i)
+        {
+            float* outRow = output + (int64_t)i * numColumns;
+            WeightElem* end = m_weights[i + 1], *elem = m_weights[i];
+            if (elem != end)
+            {
+                fill(accum.begin(), accum.end(), 0.0);
+                for (; elem != end; ++elem)
+                {
+                    const float* inRow = input + (int64_t)elem->node * numColumns;
+                    const float weight = elem->weight;
+                    for (int j = 0; j < numColumns; ++j)
+                    {
+                        accum[j] += inRow[j] * weight;//same arithmetic as resampleNormal, so results are identical
+                    }
+                }
+                for (int j = 0; j < numColumns; ++j)
+                {
+                    outRow[j] = accum[j];
+                }
+            } else {
+                for (int j = 0; j < numColumns; ++j)
+                {
+                    outRow[j] = invalidVal;
+                }
+            }
+        }
+    }
+}
+
 void SurfaceResamplingHelper::resample3DCoord(const float* input, float* output) const
 {
     int numNodes = (int)m_weights.size() - 1;
@@ -21,6 +21,7 @@
  */
 /*LICENSE_END*/
 
+#include "AString.h"
 #include "CaretPointer.h"
 #include "SurfaceResamplingMethodEnum.h"
 
@@ -43,6 +44,11 @@ namespace caret {
         CaretArray<WeightElem> m_storagechunk;
         CaretArray<WeightElem*> m_weights;
         bool m_nonsphereAllowed;
+        static AString s_weightCacheDirectory;
+        static AString getWeightCacheFileName(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
+                                              const float* currentAreas, const float* newAreas, const float* currentRoi, const bool allowNonSphere);
+        bool readWeightCache(const AString& fileName, const int& numNewNodes, const int& numCurrentNodes);
+        void writeWeightCache(const AString& fileName) const;
         static bool checkSphere(const SurfaceFile* surface);
         static void changeRadius(const float& radius, const SurfaceFile* input, SurfaceFile* output);
         void computeWeightsAdapBaryArea(const SurfaceFile* currentSphere, const SurfaceFile* newSphere, const float* currentAreas, const float* newAreas, const float* currentRoi);
@@ -55,6 +61,8 @@ namespace caret {
                                 const float* currentAreas = NULL, const float* newAreas = NULL, const float* currentRoi = NULL, const bool allowNonSphere = false);
         ///resample real-valued data by means of weights
         void resampleNormal(const float* input, float* output, const float& invalidVal = 0.0f) const;
+        ///resample a block of real-valued columns at once, input and output are vertex-major (numColumns consecutive values per vertex)
+        void resampleNormalInterleaved(const float* input, float* output, const int& numColumns, const float& invalidVal = 0.0f) const;
         ///resample 3D coordinate data by means of weights
         void resample3DCoord(const float* input, float* output) const;
         ///resample label-like data according to which value gets the largest weight sum
@@ -66,6 +74,10 @@ namespace caret {
         ///get the ROI of nodes that have data within the input ROI
         void getResampleValidROI(float* output) const;
         
+        ///directory in which to save computed weights and look for previously computed ones, empty (the default) disables the cache
+        static void setWeightCacheDirectory(const AString& directory) { s_weightCacheDirectory = directory; }
+        static AString getWeightCacheDirectory() { return s_weightCacheDirectory; }
+        
         ///resample a cut surface - not something you will apply multiple times, so static method
         static void resampleCutSurface(const SurfaceFile* cutSurfaceIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere, SurfaceFile* surfaceOut);
     };
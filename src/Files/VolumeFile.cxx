@@ -103,6 +103,7 @@ GroupAndNameHierarchyUserInterface()
     m_writingDType = NIFTI_TYPE_FLOAT32;
     m_minScalingVal = -1.0;//unused, but make them consistent
     m_maxScalingVal = 1.0;
+    m_readMemoryMapped = false;
     m_graphicsPrimitiveManager.reset(new VolumeGraphicsPrimitiveManager(this, this));
     validateMembers();
 }
@@ -122,6 +123,7 @@ GroupAndNameHierarchyUserInterface()
     m_writingDType = NIFTI_TYPE_FLOAT32;
     m_minScalingVal = -1.0;//unused, but make them consistent
     m_maxScalingVal = 1.0;
+    m_readMemoryMapped = false;
     m_graphicsPrimitiveManager.reset(new VolumeGraphicsPrimitiveManager(this, this));
     validateMembers();
 }
@@ -142,6 +144,7 @@ GroupAndNameHierarchyUserInterface()
     m_writingDType = NIFTI_TYPE_FLOAT32;
     m_minScalingVal = -1.0;//unused, but make them consistent
     m_maxScalingVal = 1.0;
+    m_readMemoryMapped = false;
     m_graphicsPrimitiveManager.reset(new VolumeGraphicsPrimitiveManager(this, this));
     validateMembers();
     setType(whatType);
@@ -292,6 +295,10 @@ void VolumeFile::readFile(const AString& filename)
         checkFileReadability(fileToRead);
         NiftiIO myIO;//begin nifti specific code - should this go somewhere else?
         myIO.openRead(fileToRead);
+        if (m_readMemoryMapped && !myIO.mapData())
+        {
+            CaretLogFine("unable to memory map volume file '" + fileToRead + "', using normal reads");
+        }
         const NiftiHeader& inHeader = myIO.getHeader();
         for (int i = 0; i < (int)inHeader.m_extensions.size(); ++i)
         {//check for actually being cifti
@@ -341,11 +348,18 @@ void VolumeFile::readFile(const AString& filename)
                 }
             }
         } else {//avoid the added allocation for separating components
-            vector<float> tempFrame(frameSize);
+            vector<float> tempFrame;
             for (MultiDimIterator<int64_t> myiter(extraDims); !myiter.atEnd(); ++myiter)
             {
-                myIO.readData(tempFrame.data(), fullDims, *myiter);
-                setFrame(tempFrame.data(), getBrickIndexFromNonSpatialIndexes(*myiter));
+                const float* mappedFrame = myIO.getMappedFloatData(fullDims, *myiter);
+                if (mappedFrame != NULL)
+                {//native float32 data, copy straight out of the page cache
+                    setFrame(mappedFrame, getBrickIndexFromNonSpatialIndexes(*myiter));
+                } else {
+                    tempFrame.resize(frameSize);
+                    myIO.readData(tempFrame.data(), fullDims, *myiter);
+                    setFrame(tempFrame.data(), getBrickIndexFromNonSpatialIndexes(*myiter));
+                }
             }
         }
         
@@ -472,6 +486,11 @@ VolumeFile::writeFile(const AString& filename)
     clearModified();
 }
 
+void VolumeFile::setReadMemoryMapped(const bool& memoryMap)
+{
+    m_readMemoryMapped = memoryMap;
+}
+
 void VolumeFile::setWritingDataTypeNoScaling(const int16_t& type)
 {
     m_writingDType = type;//could do some validation here
@@ -144,6 +144,8 @@ namespace caret {
 
         double m_minScalingVal, m_maxScalingVal;
         
+        bool m_readMemoryMapped;
+        
     protected:
         VolumeFile(const DataFileTypeEnum::Enum dataFileType);
         
@@ -218,6 +220,9 @@ namespace caret {
 
         virtual void writeFile(const AString& filename);
 
+        ///read uncompressed native-endian files through a memory map, if possible
+        void setReadMemoryMapped(const bool& memoryMap);
+
         ///data type and scaling options
         void setWritingDataTypeNoScaling(const int16_t& type = NIFTI_TYPE_FLOAT32);
         void setWritingDataTypeAndScaling(const int16_t& type, const double& minval, const double& maxval);
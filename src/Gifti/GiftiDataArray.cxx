@@ -29,11 +29,11 @@
 #include "ByteSwapping.h"
 #include "CaretAssert.h"
 #include "CaretLogger.h"
-#include "DataCompressZLib.h"
 
 //#include "FileUtilities.h"
 #include "FastStatistics.h"
 #include "GiftiDataArray.h"
+#include "GiftiEncodedDataDecoder.h"
 #include "GiftiFile.h"
 #include "GiftiMetaDataXmlElements.h"
 #include "GiftiXmlElements.h"
@@ -43,6 +43,8 @@
 #include "SystemUtilities.h"
 #include "XmlWriter.h"
 
+#include <zlib.h>
+
 using namespace caret;
 
 /**
@@ -589,17 +591,11 @@ GiftiDataArray::readFromText(const AString text,
                              const int64_t externalFileOffsetForReading,
                              const bool isReadOnlyMetaData)
 {
-   const NiftiDataTypeEnum::Enum requiredDataType = dataType;
-   dataType = dataTypeForReading;
-   encoding = encodingForReading;
-   endian   = dataEndianForReading;
-   arraySubscriptingOrder = arraySubscriptingOrderForReading;
-   setDimensions(dimensionsForReading);
-   if (dimensionsForReading.size() == 0) {
-      throw GiftiException("Data array has no dimensions.");
-   }
-   //setExternalFileInformation(externalFileNameForReading,
-   //                           externalFileOffsetForReading);//TSC: don't set the external filename on the array, because that is what it uses when writing the array
+   const NiftiDataTypeEnum::Enum requiredDataType = startReadingData(dataEndianForReading,
+                                                                     arraySubscriptingOrderForReading,
+                                                                     dataTypeForReading,
+                                                                     dimensionsForReading,
+                                                                     encodingForReading);
                               
    //
    // If NOT metadata only
@@ -654,73 +650,18 @@ GiftiDataArray::readFromText(const AString text,
             }
             break;
           case GiftiEncodingEnum::BASE64_BINARY:
-            {
-               //
-               // Decode the Base64 data using VTK's algorithm
-               //
-               const uint64_t numDecoded =
-                     Base64::decode((const unsigned char*)(text.toStdString().c_str()),
-                                                data.size(),
-                                                &data[0]);
-               if (numDecoded != data.size()) {
-                  std::ostringstream str;
-                  str << "Decoding of Base64 Binary data failed.\n"
-                   << "Decoded " << AString::number(numDecoded).toStdString() << " bytes but should be "
-                      << AString::number(static_cast<int>(data.size())).toStdString() << " bytes.";
-                  throw GiftiException(AString::fromStdString(str.str()));
-               }
-               
-               //
-               // Is byte swapping needed ?
-               //
-               if (endian != getSystemEndian()) {
-                  byteSwapData(getSystemEndian());
-               }
-            }
-            break;
           case GiftiEncodingEnum::GZIP_BASE64_BINARY:
             {
                //
-               // Decode the Base64 data using VTK's algorithm
-               //
-               std::vector<unsigned char> dataBuffer(text.size() - text.size() / 4 + 10);//generous constant to make up for integer rounding
-               //const char* textChars = text.toLatin1().constData();
-               const uint64_t numDecoded =
-                     Base64::decode((unsigned char*)text.toStdString().c_str(),
-                                                dataBuffer.size(),
-                                                dataBuffer.data());
-               if (numDecoded == 0) {
-                   std::ostringstream str;
-                   str << "Decoding of GZip Base64 Binary data failed."
-                   << "Decoded " << AString::number(numDecoded).toStdString() << " bytes but should be "
-                   << AString::number(static_cast<int>(data.size())).toStdString() << " bytes.";
-                   throw GiftiException(AString::fromStdString(str.str()));
-               }
-               
-               
+               // Base64 text is ASCII, decode (and uncompress) it straight into the array
                //
-               // Uncompress the data using VTK's algorithm
-               // 
-                DataCompressZLib compressor;
-                const uint64_t uncompressedDataLength = 
-                                   compressor.uncompressData(dataBuffer.data(),
-                                                          numDecoded,
-                                                          (unsigned char*)&data[0],
-                                                          data.size());
-               if (uncompressedDataLength != data.size()) {
-                  std::ostringstream str;
-                  str << "Decompression of Binary data failed.\n"
-                   << "Uncompressed " << AString::number(uncompressedDataLength).toStdString() << " bytes but should be "
-                   << AString::number(static_cast<uint64_t>(data.size())).toStdString() << " bytes.";
-                  throw GiftiException(AString::fromStdString(str.str()));
-               }
-               
-               //
-               // Is byte swapping needed ? 
-               //
-               if (endian != getSystemEndian()) {
-                  byteSwapData(getSystemEndian());
-               }
+               const QByteArray textBytes = text.toLatin1();
+               GiftiEncodedDataDecoder decoder(encoding,
+                                               data.data(),
+                                               data.size());
+               decoder.addText(textBytes.constData(),
+                               textBytes.size());
+               decoder.finish();
             }
             break;
           case GiftiEncodingEnum::EXTERNAL_FILE_BINARY:
@@ -783,18 +724,55 @@ GiftiDataArray::readFromText(const AString text,
                                          + AString::number(externalFileOffsetForReading)
                                          + " but failed");
                   }
-                  
-                  //
-                  // Is byte swapping needed ?
-                  //
-                  if (endian != getSystemEndian()) {
-                     byteSwapData(getSystemEndian());
-                  }
                }
             }
             break;
       }
+      
+      finishReadingData(requiredDataType);
+   } // If NOT metadata only
    
+   setModified();
+}
+
+/**
+ * set up the array for data that is about to be read, and allocate it.
+ * @return the data type the array must have after reading, pass it to finishReadingData().
+ */
+NiftiDataTypeEnum::Enum
+GiftiDataArray::startReadingData(const GiftiEndianEnum::Enum dataEndianForReading,
+                                 const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
+                                 const NiftiDataTypeEnum::Enum dataTypeForReading,
+                                 const std::vector<int64_t>& dimensionsForReading,
+                                 const GiftiEncodingEnum::Enum encodingForReading)
+{
+   const NiftiDataTypeEnum::Enum requiredDataType = dataType;
+   dataType = dataTypeForReading;
+   encoding = encodingForReading;
+   endian   = dataEndianForReading;
+   arraySubscriptingOrder = arraySubscriptingOrderForReading;
+   setDimensions(dimensionsForReading);
+   if (dimensionsForReading.size() == 0) {
+      throw GiftiException("Data array has no dimensions.");
+   }
+   //setExternalFileInformation(externalFileNameForReading,
+   //                           externalFileOffsetForReading);//TSC: don't set the external filename on the array, because that is what it uses when writing the array
+   return requiredDataType;
+}
+
+/**
+ * byte swap, convert data type, and fix indexing order of data that was just read.
+ */
+void
+GiftiDataArray::finishReadingData(const NiftiDataTypeEnum::Enum requiredDataType)
+{
+      //
+      // Is byte swapping needed ? (ASCII is read as native numbers)
+      //
+      if ((encoding != GiftiEncodingEnum::ASCII) && (endian != getSystemEndian())) {
+         byteSwapData(getSystemEndian());
+      }
+      
       //
       // Check if data type needs to be converted
       //
@@ -807,12 +785,9 @@ GiftiDataArray::readFromText(const AString text,
        //
        // Are array indices in opposite order
        //
-       if (arraySubscriptingOrderForReading == GiftiArrayIndexingOrderEnum::COLUMN_MAJOR_ORDER) {
+       if (arraySubscriptingOrder == GiftiArrayIndexingOrderEnum::COLUMN_MAJOR_ORDER) {
            convertArrayIndexingOrder();
        }
-   } // If NOT metadata only
-   
-   setModified();
 }
 
 /**
@@ -998,6 +973,53 @@ GiftiDataArray::convertArrayIndexingOrder()
     }
 }
 
+/**
+ * encode the data as base64 text, compressing it first for GZIP_BASE64_BINARY.
+ * Only reads the array, so that several arrays can be encoded at once.
+ * @param encodingForWriting
+ *    BASE64_BINARY or GZIP_BASE64_BINARY.
+ * @param textOut
+ *    Receives the null terminated text.
+ */
+void
+GiftiDataArray::encodeDataAsText(const GiftiEncodingEnum::Enum encodingForWriting,
+                                 std::vector<char>& textOut) const
+{
+    CaretAssert((encodingForWriting == GiftiEncodingEnum::BASE64_BINARY)
+                || (encodingForWriting == GiftiEncodingEnum::GZIP_BASE64_BINARY));
+    const unsigned char* dataToEncode = data.data();
+    uint64_t dataToEncodeLength = data.size();
+    
+    //
+    // Compress the data with zlib, called directly rather than through
+    // DataCompressZLib, which is a CaretObject, because this runs on
+    // several threads at once
+    //
+    std::vector<unsigned char> compressedDataBuffer;
+    if (encodingForWriting == GiftiEncodingEnum::GZIP_BASE64_BINARY) {
+        uLongf compressedDataBufferLength = compressBound(data.size());
+        compressedDataBuffer.resize(compressedDataBufferLength);
+        if (compress2(compressedDataBuffer.data(), &compressedDataBufferLength,
+                      data.data(), data.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+            throw GiftiException("Compression of GIFTI data array failed.");
+        }
+        dataToEncodeLength = compressedDataBufferLength;
+        dataToEncode = compressedDataBuffer.data();
+    }
+    
+    //
+    // Encode the data with VTK's Base64 algorithm
+    //
+    textOut.resize(dataToEncodeLength + dataToEncodeLength / 3 + 10);//generous constant for partial bytes, integer rounding, and possible "=" formatting
+    const uint64_t encodedLength =
+       Base64::encode(dataToEncode,
+                      dataToEncodeLength,
+                      (unsigned char*)textOut.data());
+    CaretAssert(encodedLength < textOut.size());
+    textOut.resize(encodedLength + 1);
+    textOut[encodedLength] = '\0';
+}
+
 /**
  * write the data as XML.
  * @param stream
@@ -1006,11 +1028,15 @@ GiftiDataArray::convertArrayIndexingOrder()
  *    Stream for external binary file.
  * @param encodingForWriting
  *    GIFTI encoding used when writing the data.
+ * @param encodedText
+ *    If not NULL, the data already encoded by encodeDataAsText() with
+ *    the same encoding.
  */
 void 
 GiftiDataArray::writeAsXML(std::ostream& stream, 
                            std::ostream* externalBinaryOutputStream,
-                           GiftiEncodingEnum::Enum encodingForWriting) 
+                           GiftiEncodingEnum::Enum encodingForWriting,
+                           const std::vector<char>* encodedText) 
                                                
 {
     this->encoding = encodingForWriting;
@@ -1167,66 +1193,18 @@ GiftiDataArray::writeAsXML(std::ostream& stream,
          }
          break;
        case GiftiEncodingEnum::BASE64_BINARY:
-         {
-            //
-            // Encode the data with VTK's Base64 algorithm
-            //
-            const uint64_t bufferLength = static_cast<uint64_t>(data.size() * 1.5);
-            char* buffer = new char[bufferLength];
-            const uint64_t compressedLength =
-               Base64::encode(&data[0],
-                                          data.size(),
-                                          (unsigned char*)buffer);
-            if (compressedLength >= bufferLength) {
-               throw GiftiException(
-                     "Base64 encoding buffer length ("
-                     + AString::number(bufferLength)
-                     + ") is too small but needs to be "
-                                    + AString::number(compressedLength));
-            }
-            buffer[compressedLength] = '\0';
-            
-            //
-            // Write the data  MUST BE NO space around data
-            //
-            xmlWriter.writeElementNoSpace(GiftiXmlElements::TAG_DATA, buffer);
-            
-            //
-            // Free memory
-            //
-            delete[] buffer;
-         }
-         break;
        case GiftiEncodingEnum::GZIP_BASE64_BINARY:
          {
-            //
-            // Compress the data with VTK's ZLIB algorithm
-            //
-             DataCompressZLib compressor;
-             uint64_t compressedDataBufferLength =
-                              compressor.getMaximumCompressionSpace(data.size());
-            std::vector<unsigned char> compressedDataBuffer(compressedDataBufferLength);
-            uint64_t compressedDataLength =
-                          compressor.compressData(&data[0], 
-                                               data.size(),
-                                               compressedDataBuffer.data(),
-                                               compressedDataBufferLength);
-            
-            //
-            // Encode the data with VTK's Base64 algorithm
-            //
-            std::vector<unsigned char> buffer(compressedDataLength + compressedDataLength / 3 + 10);//generous constant for partial bytes, integer rounding, and possible "=" formatting
-            const uint64_t compressedLength =
-               Base64::encode(compressedDataBuffer.data(),
-                                          compressedDataLength,
-                                          buffer.data());
-            buffer[compressedLength] = '\0';
-            
+             std::vector<char> localText;
+             if (encodedText == NULL) {
+                 this->encodeDataAsText(encoding, localText);
+                 encodedText = &localText;
+             }
+             
              //
              // Write the data  MUST BE NO space around data
              //
-             xmlWriter.writeElementNoSpace(GiftiXmlElements::TAG_DATA, (char*)buffer.data());
-             
+             xmlWriter.writeElementNoSpace(GiftiXmlElements::TAG_DATA, encodedText->data());
          }
          break;
        case GiftiEncodingEnum::EXTERNAL_FILE_BINARY:
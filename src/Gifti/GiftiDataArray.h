@@ -123,10 +123,15 @@ namespace caret {
                           const int64_t externalFileOffsetForReading,
                           const bool isReadOnlyMetaData);
         
-        // write the data as XML
+        // encode the data as base64 text, doesn't modify the array so different arrays may be encoded at the same time
+        void encodeDataAsText(const GiftiEncodingEnum::Enum encodingForWriting,
+                              std::vector<char>& textOut) const;
+        
+        // write the data as XML, encodedText is optional output of encodeDataAsText() for the same encoding
         void writeAsXML(std::ostream& stream, 
                         std::ostream* externalBinaryOutputStream,
-                        GiftiEncodingEnum::Enum encodingForWriting);
+                        GiftiEncodingEnum::Enum encodingForWriting,
+                        const std::vector<char>* encodedText = NULL);
         
         /// get endian
         GiftiEndianEnum::Enum getEndian() const { return endian; }
@@ -326,6 +331,16 @@ namespace caret {
         /// convert array indexing order of data
         void convertArrayIndexingOrder();
         
+        // set up and allocate the array for reading, returns the data type to pass to finishReadingData()
+        NiftiDataTypeEnum::Enum startReadingData(const GiftiEndianEnum::Enum dataEndianForReading,
+                                                 const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
+                                                 const NiftiDataTypeEnum::Enum dataTypeForReading,
+                                                 const std::vector<int64_t>& dimensionsForReading,
+                                                 const GiftiEncodingEnum::Enum encodingForReading);
+        
+        // byte swap, convert data type, and fix indexing order after the data has been read
+        void finishReadingData(const NiftiDataTypeEnum::Enum requiredDataType);
+        
         /// the data
         std::vector<uint8_t> data;
         
@@ -434,6 +449,9 @@ namespace caret {
         
         /// allow NodeDataFile access to protected elements
         friend class GiftiFile;
+        
+        /// decodes the data while parsing, without storing the element text
+        friend class GiftiFileSaxReader;
     };
     
 } // namespace
@@ -0,0 +1,276 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GiftiEncodedDataDecoder.h"
+
+#include "CaretAssert.h"
+#include "GiftiException.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <zlib.h>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const unsigned char B64_WHITESPACE = 0x80, B64_PAD = 0x81, B64_INVALID = 0xFF;//anything with the top bits set is not a base64 digit
+    const int64_t COMPRESSED_BUFFER_SIZE = 1 << 18;
+
+    struct Base64Table
+    {
+        unsigned char m_values[256];
+        Base64Table()
+        {
+            memset(m_values, B64_INVALID, sizeof(m_values));
+            const char* digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (int i = 0; i < 64; ++i)
+            {
+                m_values[(unsigned char)digits[i]] = i;
+            }
+            m_values[(unsigned char)' '] = B64_WHITESPACE;
+            m_values[(unsigned char)'\t'] = B64_WHITESPACE;
+            m_values[(unsigned char)'\n'] = B64_WHITESPACE;
+            m_values[(unsigned char)'\r'] = B64_WHITESPACE;
+            m_values[(unsigned char)'='] = B64_PAD;
+        }
+    };
+
+    const Base64Table& getBase64Table()
+    {
+        static const Base64Table ret;
+        return ret;
+    }
+}
+
+GiftiEncodedDataDecoder::GiftiEncodedDataDecoder(const GiftiEncodingEnum::Enum encoding, uint8_t* output, const int64_t& outputSize)
+{
+    CaretAssert(encoding == GiftiEncodingEnum::BASE64_BINARY || encoding == GiftiEncodingEnum::GZIP_BASE64_BINARY);
+    CaretAssert(output != NULL || outputSize == 0);
+    m_encoding = encoding;
+    m_output = output;
+    m_outputSize = outputSize;
+    m_outputUsed = 0;
+    m_quadCount = 0;
+    m_sawPadding = false;
+    m_compressedUsed = 0;
+    m_zStreamEnded = false;
+    if (m_encoding == GiftiEncodingEnum::GZIP_BASE64_BINARY)
+    {
+        m_compressed.resize(COMPRESSED_BUFFER_SIZE);
+        m_zStream.grabNew(new z_stream_s());//value initialized, so zalloc, zfree and opaque are null
+        if (inflateInit(m_zStream) != Z_OK)
+        {
+            m_zStream.grabNew(NULL);
+            throw GiftiException("Failed to initialize zlib for decompressing GIFTI data");
+        }
+    }
+}
+
+GiftiEncodedDataDecoder::~GiftiEncodedDataDecoder()
+{
+    if (m_zStream != NULL)
+    {
+        inflateEnd(m_zStream);
+    }
+}
+
+void GiftiEncodedDataDecoder::addText(const char* text, const int64_t& length)
+{
+    const unsigned char* ptr = (const unsigned char*)text;
+    int64_t remaining = length;
+    if (m_encoding == GiftiEncodingEnum::GZIP_BASE64_BINARY)
+    {
+        while (remaining > 0 && !m_sawPadding)
+        {
+            int64_t used = decodeText(ptr, remaining, m_compressed.data(), (int64_t)m_compressed.size(), m_compressedUsed);
+            ptr += used;
+            remaining -= used;
+            if (remaining > 0 && !m_sawPadding)
+            {
+                inflateCompressed();//buffer is full
+            }
+        }
+    } else {
+        int64_t used = decodeText(ptr, remaining, m_output, m_outputSize, m_outputUsed);
+        if (used < remaining && !m_sawPadding && m_outputUsed < m_outputSize)
+        {//last group of 3 bytes straddles the end of the array, like the old decoder, anything past the end is ignored
+            unsigned char lastGroup[3];
+            int64_t lastUsed = 0;
+            decodeText(ptr + used, remaining - used, lastGroup, 3, lastUsed);
+            int64_t toCopy = min(lastUsed, m_outputSize - m_outputUsed);
+            memcpy(m_output + m_outputUsed, lastGroup, toCopy);
+            m_outputUsed += toCopy;
+        }
+    }
+}
+
+int64_t GiftiEncodedDataDecoder::decodeText(const unsigned char* text, const int64_t& length, unsigned char* out, const int64_t& outSize, int64_t& outUsed)
+{
+    const unsigned char* table = getBase64Table().m_values;
+    int64_t i = 0;
+    while (i < length && !m_sawPadding && outSize - outUsed >= 3)
+    {
+        if (m_quadCount == 0)
+        {//fast path: whole groups of 4 digits with no whitespace or padding, which is nearly all of the text
+            int64_t maxGroups = min((length - i) / 4, (outSize - outUsed) / 3);
+            const unsigned char* inPtr = text + i;
+            unsigned char* outPtr = out + outUsed;
+            int64_t group = 0;
+            for (; group < maxGroups; ++group)
+            {
+                uint32_t a = table[inPtr[0]], b = table[inPtr[1]], c = table[inPtr[2]], d = table[inPtr[3]];
+                if ((a | b | c | d) & 0xC0) break;
+                uint32_t bits = (a << 18) | (b << 12) | (c << 6) | d;
+                outPtr[0] = (unsigned char)(bits >> 16);
+                outPtr[1] = (unsigned char)(bits >> 8);
+                outPtr[2] = (unsigned char)bits;
+                inPtr += 4;
+                outPtr += 3;
+            }
+            i += group * 4;
+            outUsed += group * 3;
+            if (i >= length || outSize - outUsed < 3) break;
+        }
+        unsigned char thisChar = text[i];
+        ++i;
+        unsigned char value = table[thisChar];
+        if (value == B64_WHITESPACE) continue;
+        if (value == B64_INVALID)
+        {
+            throw GiftiException("Decoding of Base64 Binary data failed, found invalid character with code " + AString::number((int)thisChar));
+        }
+        m_quad[m_quadCount] = thisChar;
+        ++m_quadCount;
+        if (m_quadCount == 4)
+        {
+            decodeQuad(out, outSize, outUsed);
+        }
+    }
+    return i;
+}
+
+void GiftiEncodedDataDecoder::decodeQuad(unsigned char* out, const int64_t& outSize, int64_t& outUsed)
+{
+    CaretAssert(m_quadCount == 4);
+    const unsigned char* table = getBase64Table().m_values;
+    int numBytes = 3;
+    if (m_quad[3] == '=') numBytes = 2;
+    if (m_quad[2] == '=')
+    {
+        if (m_quad[3] != '=') throw GiftiException("Decoding of Base64 Binary data failed, padding is followed by data");
+        numBytes = 1;
+    }
+    if (m_quad[0] == '=' || m_quad[1] == '=') throw GiftiException("Decoding of Base64 Binary data failed, found padding in the wrong place");
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        bits <<= 6;
+        if (m_quad[i] != '=') bits |= table[m_quad[i]];
+    }
+    unsigned char decoded[3] = { (unsigned char)(bits >> 16), (unsigned char)(bits >> 8), (unsigned char)bits };
+    int64_t toCopy = min((int64_t)numBytes, outSize - outUsed);
+    memcpy(out + outUsed, decoded, toCopy);
+    outUsed += toCopy;
+    m_quadCount = 0;
+    if (numBytes < 3) m_sawPadding = true;//end of the data, like the old decoder, ignore anything after it
+}
+
+void GiftiEncodedDataDecoder::inflateCompressed()
+{
+    CaretAssert(m_zStream != NULL);
+    z_stream_s& myStream = *m_zStream;
+    myStream.next_in = m_compressed.data();
+    myStream.avail_in = (uInt)m_compressedUsed;
+    while (myStream.avail_in > 0 && !m_zStreamEnded)
+    {
+        unsigned char overflow;
+        int64_t outLeft = m_outputSize - m_outputUsed;
+        if (outLeft == 0)
+        {//array is full, but the checksum at the end of the stream may still be waiting
+            myStream.next_out = &overflow;
+            myStream.avail_out = 1;
+        } else {
+            myStream.next_out = m_output + m_outputUsed;
+            myStream.avail_out = (uInt)min(outLeft, (int64_t)(1 << 30));//avail_out is only 32 bits
+        }
+        uInt availBefore = myStream.avail_out;
+        int ret = inflate(&myStream, Z_NO_FLUSH);
+        if (outLeft == 0 && myStream.avail_out == 0)
+        {
+            throw GiftiException("Decompression of Binary data failed.\nUncompressed data is larger than " + AString::number(m_outputSize) + " bytes.");
+        }
+        m_outputUsed += availBefore - myStream.avail_out;
+        if (ret == Z_STREAM_END)
+        {
+            m_zStreamEnded = true;
+        } else if (ret == Z_BUF_ERROR) {
+            break;//no progress possible, shouldn't happen while there is input
+        } else if (ret != Z_OK) {
+            throw GiftiException("Decompression of Binary data failed, zlib error " + AString::number(ret));
+        }
+    }
+    m_compressedUsed = 0;
+}
+
+void GiftiEncodedDataDecoder::finish()
+{
+    if (m_quadCount == 1)
+    {
+        throw GiftiException("Decoding of Base64 Binary data failed, the text ends in the middle of a group of characters");
+    }
+    if (m_quadCount > 1)
+    {//missing padding, decode what is there
+        while (m_quadCount < 4)
+        {
+            m_quad[m_quadCount] = '=';
+            ++m_quadCount;
+        }
+        if (m_encoding == GiftiEncodingEnum::GZIP_BASE64_BINARY)
+        {
+            if ((int64_t)m_compressed.size() - m_compressedUsed < 3) inflateCompressed();
+            decodeQuad(m_compressed.data(), (int64_t)m_compressed.size(), m_compressedUsed);
+        } else {
+            decodeQuad(m_output, m_outputSize, m_outputUsed);
+        }
+    }
+    if (m_encoding == GiftiEncodingEnum::GZIP_BASE64_BINARY)
+    {
+        inflateCompressed();
+        if (!m_zStreamEnded)
+        {
+            throw GiftiException("Decompression of Binary data failed.\nThe compressed data is incomplete, uncompressed "
+                                 + AString::number(m_outputUsed) + " bytes but should be " + AString::number(m_outputSize) + " bytes.");
+        }
+        if (m_outputUsed != m_outputSize)
+        {
+            throw GiftiException("Decompression of Binary data failed.\nUncompressed " + AString::number(m_outputUsed) +
+                                 " bytes but should be " + AString::number(m_outputSize) + " bytes.");
+        }
+    } else {
+        if (m_outputUsed != m_outputSize)
+        {
+            throw GiftiException("Decoding of Base64 Binary data failed.\nDecoded " + AString::number(m_outputUsed) +
+                                 " bytes but should be " + AString::number(m_outputSize) + " bytes.");
+        }
+    }
+}
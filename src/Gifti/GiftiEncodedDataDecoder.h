@@ -0,0 +1,73 @@
+#ifndef __GIFTI_ENCODED_DATA_DECODER_H__
+#define __GIFTI_ENCODED_DATA_DECODER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretPointer.h"
+#include "GiftiEncodingEnum.h"
+
+#include <stdint.h>
+#include <vector>
+
+struct z_stream_s;
+
+namespace caret {
+
+    /**
+     * Decodes the text of a base64 or gzip base64 DataArray in pieces, as the XML parser
+     * delivers it, directly into the array's data, so that the encoded text is never stored.
+     * Whitespace in the text is skipped.  Errors throw GiftiException.
+     */
+    class GiftiEncodedDataDecoder
+    {
+        GiftiEncodingEnum::Enum m_encoding;
+        uint8_t* m_output;
+        int64_t m_outputSize;
+        int64_t m_outputUsed;
+        unsigned char m_quad[4];//base64 characters of a group that was split between pieces of text
+        int m_quadCount;
+        bool m_sawPadding;
+        std::vector<unsigned char> m_compressed;//decoded base64 waiting to be inflated
+        int64_t m_compressedUsed;
+        CaretPointer<z_stream_s> m_zStream;
+        bool m_zStreamEnded;
+
+        int64_t decodeText(const unsigned char* text, const int64_t& length, unsigned char* out, const int64_t& outSize, int64_t& outUsed);
+        void decodeQuad(unsigned char* out, const int64_t& outSize, int64_t& outUsed);
+        void inflateCompressed();
+
+        GiftiEncodedDataDecoder(const GiftiEncodedDataDecoder&);
+        GiftiEncodedDataDecoder& operator=(const GiftiEncodedDataDecoder&);
+    public:
+        ///encoding must be BASE64_BINARY or GZIP_BASE64_BINARY, output must have room for outputSize bytes
+        GiftiEncodedDataDecoder(const GiftiEncodingEnum::Enum encoding, uint8_t* output, const int64_t& outputSize);
+        ~GiftiEncodedDataDecoder();
+
+        ///decode the next piece of the element text
+        void addText(const char* text, const int64_t& length);
+
+        ///decode anything left over, throws if the text did not contain exactly outputSize bytes of data
+        void finish();
+    };
+
+}
+
+#endif //__GIFTI_ENCODED_DATA_DECODER_H__
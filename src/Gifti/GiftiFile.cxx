@@ -25,6 +25,7 @@
 
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "DataFileException.h"
 #include "FileInformation.h"
 #include "GiftiEncodingEnum.h"
@@ -838,6 +839,23 @@ GiftiFile::removeDataArray(const GiftiDataArray* arrayPointer)
    }
 }
 
+/**
+ * get the number of threads to use for encoding and decoding data arrays.
+ * This is at most OpenMP's maximum, so it follows OMP_NUM_THREADS.
+ */
+int32_t
+GiftiFile::getDataArrayThreads()
+{
+    int32_t numThreads = 1;
+#ifdef CARET_OMP
+    numThreads = omp_get_max_threads();
+    if ((maximumDataArrayThreads > 0) && (maximumDataArrayThreads < numThreads)) {
+        numThreads = maximumDataArrayThreads;
+    }
+#endif
+    return numThreads;
+}
+
 /**
  * read the file.
  */
@@ -848,7 +866,7 @@ GiftiFile::readFile(const AString& filename)
     this->setFileName(filename);
     
     GiftiFileSaxReader saxReader(this);
-    std::unique_ptr<XmlSaxParser> parser(XmlSaxParser::createXmlParser());
+    std::unique_ptr<XmlSaxParser> parser(XmlSaxParser::createNativeXmlParser());//array data is decoded straight from the read buffer
     try {
         parser->parseFile(filename, &saxReader);
     }
@@ -927,9 +945,7 @@ GiftiFile::writeFile(const AString& filename)
         //
         // Write the data arrays
         //
-        for (int i = 0; i < numberOfDataArrays; i++) {
-            giftiFileWriter.writeDataArray(this->getDataArray(i));
-        }
+        giftiFileWriter.writeDataArrays(this->dataArrays);
         
         //
         // Finish writing the file
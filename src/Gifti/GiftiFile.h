@@ -169,6 +169,12 @@ class GiftiFile : public DataFile {
       /// get the current version for GiftiFiles
       static float getCurrentFileVersion() { return 1.0; }
       
+      /// set the maximum number of threads used to encode and decode data arrays, 0 (the default) for as many as OpenMP allows
+      static void setMaximumDataArrayThreads(const int32_t numThreads) { maximumDataArrayThreads = numThreads; }
+      
+      // get the number of threads to use for encoding and decoding data arrays
+      static int32_t getDataArrayThreads();
+      
       /// get the default data array intent
       NiftiIntentEnum::Enum getDefaultDataArrayIntent() const { return defaultDataArrayIntent; }
       
@@ -242,6 +248,9 @@ class GiftiFile : public DataFile {
     /** The default encoding for writing a GIFTI file. */
     static GiftiEncodingEnum::Enum defaultEncodingForWriting;
     
+    /** Maximum threads for encoding and decoding data arrays, limited by OpenMP's maximum. */
+    static int32_t maximumDataArrayThreads;
+    
       /*!!!! be sure to update copyHelperGiftiFile if new member added !!!!*/
    
    // 
@@ -251,6 +260,7 @@ class GiftiFile : public DataFile {
 
 #ifdef __GIFTI_FILE_MAIN__
     GiftiEncodingEnum::Enum GiftiFile::defaultEncodingForWriting = GiftiEncodingEnum::GZIP_BASE64_BINARY;
+    int32_t GiftiFile::maximumDataArrayThreads = 0;
 #endif // __GIFTI_FILE_MAIN__
     
 
@@ -18,10 +18,14 @@
  */
 /*LICENSE_END*/
 
+#include <cstring>
+#include <exception>
 #include <sstream>
 
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "FileInformation.h"
+#include "GiftiEncodedDataDecoder.h"
 #include "GiftiEndianEnum.h"
 #include "GiftiLabel.h"
 #include "GiftiFile.h"
@@ -36,6 +40,11 @@
 
 using namespace caret;
 
+namespace {
+    /// decode the collected text when it reaches this size, even if there are fewer arrays than threads, arrays this large are never collected
+    const int64_t BUFFERED_ARRAY_DATA_LIMIT = ((int64_t)1) << 28;
+}
+
 /**
  * constructor.
  */
@@ -50,6 +59,9 @@ GiftiFileSaxReader::GiftiFileSaxReader(GiftiFile* giftiFileIn)
     this->labelTableSaxReader = NULL;
     this->metaDataSaxReader = NULL;
     this->dataArrayDataHasBeenRead = false;
+    this->requiredDataTypeForDecoding = NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32;
+    this->bufferedArrayDataBytes = 0;
+    this->decodingThreads = GiftiFile::getDataArrayThreads();
 }
 
 /**
@@ -138,6 +150,7 @@ GiftiFileSaxReader::startElement(const AString& namespaceURI,
          }
          else if (qName == GiftiXmlElements::TAG_DATA) {
             this->state = STATE_DATA_ARRAY_DATA;
+            this->startDecodingArrayData();
          }
          else if (qName == GiftiXmlElements::TAG_COORDINATE_TRANSFORMATION_MATRIX) {
             this->state = STATE_DATA_ARRAY_MATRIX;
@@ -260,7 +273,15 @@ GiftiFileSaxReader::endElement(const AString& namespaceURI,
          }
          break;
       case STATE_DATA_ARRAY_DATA:
-           this->processArrayData();
+           if (this->dataDecoder != NULL) {
+               this->finishDecodingArrayData();
+           }
+           else if (this->currentBufferedArrayData != NULL) {
+               this->finishBufferingArrayData();
+           }
+           else {
+               this->processArrayData();
+           }
            break;
       case STATE_DATA_ARRAY_MATRIX:
          this->matrix = NULL;
@@ -531,13 +552,139 @@ GiftiFileSaxReader::processArrayData()
     }
 }
 
+/**
+ * for base64 encodings, set up to decode the array data as the parser
+ * delivers it, so that the text of a large array is never stored.  When
+ * several threads are allowed, the text of smaller arrays is collected
+ * instead, and groups of them are decoded at once by
+ * decodeBufferedArrayData().
+ */
+void
+GiftiFileSaxReader::startDecodingArrayData()
+{
+    CaretAssert(dataArray);
+    if (this->giftiFile->getReadMetaDataOnlyFlag()) {
+        return;
+    }
+    if ((this->encodingForReadingArrayData != GiftiEncodingEnum::BASE64_BINARY)
+        && (this->encodingForReadingArrayData != GiftiEncodingEnum::GZIP_BASE64_BINARY)) {
+        return;
+    }
+    try {
+        if (this->dataArrayDataHasBeenRead) {
+            this->decodeBufferedArrayData();//second Data element in one array, don't reallocate memory that is waiting to be decoded into
+        }
+        this->requiredDataTypeForDecoding = dataArray->startReadingData(this->endianForReadingArrayData,
+                                                                         arraySubscriptingOrderForReadingArrayData,
+                                                                         dataTypeForReadingArrayData,
+                                                                         dimensionsForReadingArrayData,
+                                                                         encodingForReadingArrayData);
+        if ((this->decodingThreads > 1)
+            && (static_cast<int64_t>(dataArray->data.size()) < BUFFERED_ARRAY_DATA_LIMIT)) {
+            this->currentBufferedArrayData.grabNew(new BufferedArrayData());
+            this->currentBufferedArrayData->dataArray = dataArray;
+            this->currentBufferedArrayData->encoding = encodingForReadingArrayData;
+            this->currentBufferedArrayData->requiredDataType = this->requiredDataTypeForDecoding;
+            return;
+        }
+        this->dataDecoder.grabNew(new GiftiEncodedDataDecoder(encodingForReadingArrayData,
+                                                              dataArray->data.data(),
+                                                              dataArray->data.size()));
+    }
+    catch (const GiftiException& e) {
+        throw XmlSaxParserException(e.whatString());
+    }
+}
+
+/**
+ * finish decoding array data that was decoded while parsing.
+ */
+void
+GiftiFileSaxReader::finishDecodingArrayData()
+{
+    this->dataArrayDataHasBeenRead = true;
+    
+    CaretAssert(dataArray);
+    try {
+        this->dataDecoder->finish();
+        this->dataDecoder.grabNew(NULL);
+        dataArray->finishReadingData(this->requiredDataTypeForDecoding);
+        dataArray->setModified();
+    }
+    catch (const GiftiException& e) {
+        this->dataDecoder.grabNew(NULL);
+        throw XmlSaxParserException(e.whatString());
+    }
+}
+
+/**
+ * finish collecting the text of array data, and decode the collected
+ * arrays if there are enough to keep the threads busy.
+ */
+void
+GiftiFileSaxReader::finishBufferingArrayData()
+{
+    this->dataArrayDataHasBeenRead = true;
+    
+    this->bufferedArrayDataBytes += this->currentBufferedArrayData->text.size();
+    this->bufferedArrayData.push_back(this->currentBufferedArrayData);
+    this->currentBufferedArrayData.grabNew(NULL);
+    if ((static_cast<int64_t>(this->bufferedArrayData.size()) >= this->decodingThreads * 2)
+        || (this->bufferedArrayDataBytes >= BUFFERED_ARRAY_DATA_LIMIT)) {
+        this->decodeBufferedArrayData();
+    }
+}
+
+/**
+ * decode the collected array data, one array per thread.
+ */
+void
+GiftiFileSaxReader::decodeBufferedArrayData()
+{
+    const int64_t numArrays = static_cast<int64_t>(this->bufferedArrayData.size());
+    std::vector<std::exception_ptr> failures(numArrays);//can't throw out of an omp loop, rethrow the first failure afterwards
+#pragma omp CARET_PARFOR schedule(dynamic) num_threads(this->decodingThreads)
+    for (int64_t i = 0; i < numArrays; i++) {
+        BufferedArrayData& buffered = *(this->bufferedArrayData[i]);
+        GiftiDataArray* gda = buffered.dataArray;
+        try {
+            GiftiEncodedDataDecoder decoder(buffered.encoding,
+                                            gda->data.data(),
+                                            gda->data.size());
+            decoder.addText(buffered.text.data(), buffered.text.size());
+            decoder.finish();
+            gda->finishReadingData(buffered.requiredDataType);
+            gda->setModified();
+        }
+        catch (...) {
+            failures[i] = std::current_exception();
+        }
+        std::vector<char>().swap(buffered.text);
+    }
+    this->bufferedArrayData.clear();
+    this->bufferedArrayDataBytes = 0;
+    for (int64_t i = 0; i < numArrays; i++) {
+        if (failures[i]) {
+            try {
+                std::rethrow_exception(failures[i]);
+            }
+            catch (const GiftiException& e) {
+                throw XmlSaxParserException(e.whatString());
+            }
+        }
+    }
+}
+
 /**
  * get characters in an element.
  */
 void 
 GiftiFileSaxReader::characters(const char* ch)
 {
-    if (this->metaDataSaxReader != NULL) {
+    if ((this->dataDecoder != NULL) || (this->currentBufferedArrayData != NULL)) {
+        this->characterData(ch, strlen(ch));
+    }
+    else if (this->metaDataSaxReader != NULL) {
         this->metaDataSaxReader->characters(ch);
     }
     else if (this->labelTableSaxReader != NULL) {
@@ -548,6 +695,29 @@ GiftiFileSaxReader::characters(const char* ch)
     }
 }
 
+/**
+ * get characters in an element, from a parser that doesn't null terminate them.
+ */
+void
+GiftiFileSaxReader::characterData(const char* ch, const int64_t& length)
+{
+    if (this->dataDecoder != NULL) {
+        try {
+            this->dataDecoder->addText(ch, length);
+        }
+        catch (const GiftiException& e) {
+            throw XmlSaxParserException(e.whatString());
+        }
+    }
+    else if (this->currentBufferedArrayData != NULL) {
+        std::vector<char>& text = this->currentBufferedArrayData->text;
+        text.insert(text.end(), ch, ch + length);
+    }
+    else {
+        this->characters(std::string(ch, length).c_str());
+    }
+}
+
 /**
  * a fatal error occurs.
  */
@@ -594,5 +764,6 @@ GiftiFileSaxReader::startDocument()
 void 
 GiftiFileSaxReader::endDocument()
 {
+    this->decodeBufferedArrayData();
 }
 
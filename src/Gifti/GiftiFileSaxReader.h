@@ -23,6 +23,7 @@
 /*LICENSE_END*/
 
 #include <stack>
+#include <vector>
 #include <AString.h>
 #include <stdint.h>
 
@@ -38,6 +39,7 @@
 namespace caret {
 
     class GiftiDataArray;
+    class GiftiEncodedDataDecoder;
     class GiftiFile;
     class GiftiLabelTableSaxReader;
     class GiftiMetaDataSaxReader;
@@ -64,6 +66,8 @@ namespace caret {
         
         void characters(const char* ch);
         
+        void characterData(const char* ch, const int64_t& length);
+        
         void fatalError(const XmlSaxParserException& e);
         
         void warning(const XmlSaxParserException& e);
@@ -103,6 +107,18 @@ namespace caret {
         // process the array data into numbers
         void processArrayData();
         
+        // start decoding base64 array data while parsing
+        void startDecodingArrayData();
+        
+        // finish decoding base64 array data
+        void finishDecodingArrayData();
+        
+        // finish collecting base64 array data that will be decoded later
+        void finishBufferingArrayData();
+        
+        // decode the collected base64 array data, on several threads
+        void decodeBufferedArrayData();
+        
         // create a data array
         void createDataArray(const XmlAttributes& attributes);
         
@@ -162,6 +178,32 @@ namespace caret {
         
         /// tracks if data has been read since external binary may not have DATA tag
         bool dataArrayDataHasBeenRead;
+        
+        /// decodes base64 data as it is parsed, instead of collecting it in elementText
+        CaretPointer<GiftiEncodedDataDecoder> dataDecoder;
+        
+        /// data type the array must have after decoding
+        NiftiDataTypeEnum::Enum requiredDataTypeForDecoding;
+        
+        /// base64 text of an array, collected so that several arrays can be decoded at once
+        struct BufferedArrayData {
+            GiftiDataArray* dataArray;//owned by this reader or already by the file
+            GiftiEncodingEnum::Enum encoding;
+            NiftiDataTypeEnum::Enum requiredDataType;
+            std::vector<char> text;
+        };
+        
+        /// the array whose text is being collected, instead of using dataDecoder
+        CaretPointer<BufferedArrayData> currentBufferedArrayData;
+        
+        /// arrays whose text has been collected but not decoded yet
+        std::vector<CaretPointer<BufferedArrayData> > bufferedArrayData;
+        
+        /// total size of the text in bufferedArrayData
+        int64_t bufferedArrayDataBytes;
+        
+        /// number of threads for decoding, text is only collected when this is more than one, and only for arrays smaller than the collection limit
+        int32_t decodingThreads;
     };
 
 } // namespace
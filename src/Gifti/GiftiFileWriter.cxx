@@ -19,6 +19,7 @@
  */
 /*LICENSE_END*/
 
+#include <exception>
 #include <fstream>
 #include <memory>
 
@@ -26,6 +27,7 @@
 #include "GiftiFileWriter.h"
 #undef __GIFTI_FILE_WRITER_DECLARE__
 
+#include "CaretOMP.h"
 #include "FileInformation.h"
 #include "GiftiDataArray.h"
 #include "GiftiXmlElements.h"
@@ -175,10 +177,13 @@ GiftiFileWriter::start(const int numberOfDataArrays,
  * Write a GIFTI Data Array.
  *
  * @param gda - The data array.
+ * @param encodedText - If not NULL, the array's data already encoded
+ *    with GiftiDataArray::encodeDataAsText() for this file's encoding.
  * @throws GiftiException - If an error occurs.
  */
 void 
-GiftiFileWriter::writeDataArray(GiftiDataArray* gda)
+GiftiFileWriter::writeDataArray(GiftiDataArray* gda,
+                                const std::vector<char>* encodedText)
 {
     this->verifyOpened();
     
@@ -221,7 +226,8 @@ GiftiFileWriter::writeDataArray(GiftiDataArray* gda)
         //
         gda->writeAsXML(*this->xmlFileOutputStream, 
                         this->externalFileOutputStream,
-                        this->encoding);
+                        this->encoding,
+                        encodedText);
         
         //
         // Increment counter of data arrays written
@@ -238,6 +244,63 @@ GiftiFileWriter::writeDataArray(GiftiDataArray* gda)
     }    
 }
 
+/**
+ * Write GIFTI Data Arrays in order.  For the base64 encodings, the arrays
+ * are compressed and encoded on several threads (see
+ * GiftiFile::getDataArrayThreads()), and each one is written as soon as
+ * it and all arrays before it are ready.
+ *
+ * @param dataArrays - The data arrays.
+ * @throws GiftiException - If an error occurs.
+ */
+void
+GiftiFileWriter::writeDataArrays(const std::vector<GiftiDataArray*>& dataArrays)
+{
+    const int64_t numArrays = static_cast<int64_t>(dataArrays.size());
+    const int32_t numThreads = GiftiFile::getDataArrayThreads();
+    if ((numThreads < 2) || (numArrays < 2)
+        || ((this->encoding != GiftiEncodingEnum::BASE64_BINARY)
+            && (this->encoding != GiftiEncodingEnum::GZIP_BASE64_BINARY))) {
+        for (int64_t i = 0; i < numArrays; i++) {
+            this->writeDataArray(dataArrays[i]);
+        }
+        return;
+    }
+    
+    std::exception_ptr failure;//can't throw out of an omp loop, so keep the first error and rethrow it afterwards
+#pragma omp CARET_PARFOR schedule(dynamic) ordered num_threads(numThreads)
+    for (int64_t i = 0; i < numArrays; i++) {
+        std::vector<char> encodedText;
+        std::exception_ptr encodeFailure;
+        try {
+            dataArrays[i]->encodeDataAsText(this->encoding, encodedText);
+        }
+        catch (...) {
+            encodeFailure = std::current_exception();
+        }
+#pragma omp ordered
+        {
+            if (!failure) {//later arrays are still encoded, but nothing more is written
+                if (encodeFailure) {
+                    failure = encodeFailure;
+                    this->closeFiles();
+                }
+                else {
+                    try {
+                        this->writeDataArray(dataArrays[i], &encodedText);
+                    }
+                    catch (...) {
+                        failure = std::current_exception();
+                    }
+                }
+            }
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
 /**
  * Finish writing the file. Closes any open files.
  * @throws GiftiException If file error or number of data arrays written
@@ -22,6 +22,7 @@
 /*LICENSE_END*/
 
 #include <fstream>
+#include <vector>
 
 #include "CaretObject.h"
 #include "GiftiFile.h"
@@ -45,7 +46,10 @@ namespace caret {
         void start(const int numberOfDataArrays,
                    GiftiMetaData* metadata,
                    GiftiLabelTable* labelTable);
-        void writeDataArray(GiftiDataArray* gda);
+        void writeDataArray(GiftiDataArray* gda,
+                            const std::vector<char>* encodedText = NULL);
+        
+        void writeDataArrays(const std::vector<GiftiDataArray*>& dataArrays);
         
         void finish();
         
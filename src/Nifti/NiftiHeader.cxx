@@ -1025,6 +1025,28 @@ void NiftiHeader::swapHeaderBytes(nifti_2_header& header)
     ByteSwapping::swap(header.intent_code);
 }
 
+int64_t NiftiHeader::getExtensionOffset(const int& index) const
+{
+    CaretAssert(index >= 0 && index < (int)m_extensions.size());
+    int64_t ret;
+    if (m_version == 2)
+    {
+        ret = 4 + sizeof(nifti_2_header);//the 4 is the extender bytes
+    } else {
+        ret = 4 + sizeof(nifti_1_header);
+    }
+    for (int i = 0; i < index; ++i)
+    {
+        int64_t thisSize = 8 + m_extensions[i]->m_bytes.size();//same padding as write(), extensions that were read already include their padding
+        if (thisSize % 16 != 0)
+        {
+            thisSize += 16 - (thisSize % 16);
+        }
+        ret += thisSize;
+    }
+    return ret + 8;//skip the size and ecode
+}
+
 void NiftiHeader::write(CaretBinaryFile& outFile, const int& version, const bool& swapEndian)
 {
     if (!canWriteVersion(version)) throw DataFileException("unable to write NIfTI version " + QString::number(version) + " for file " + outFile.getFilename());
@@ -58,6 +58,7 @@ namespace caret
         VolumeSpace getVolumeSpace() const;//convenience function
         double getTimeStep() const;//seconds
         int64_t getDataOffset() const { return m_header.vox_offset; }
+        int64_t getExtensionOffset(const int& index) const;//where the bytes of an extension start in the file, as last read or written
         int16_t getDataType() const { return m_header.datatype; }
         int32_t getIntentCode() const { return m_header.intent_code; }
         const char* getIntentName() const { return m_header.intent_name; }//NOTE: 16 BYTES, MAY NOT HAVE A NULL TERMINATOR
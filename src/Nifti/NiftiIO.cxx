@@ -27,6 +27,8 @@ using namespace caret;
 
 void NiftiIO::openRead(const QString& filename)
 {
+    m_readAt = false;
+    m_mapped = NULL;
     m_file.open(filename);
     m_header.read(m_file);
     if (m_header.getDataType() == DT_BINARY)
@@ -44,6 +46,7 @@ void NiftiIO::openRead(const QString& filename)
     {
         throw DataFileException("nifti file is truncated: " + filename);
     }
+    m_readAt = m_file.supportsReadAt();
 }
 
 void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const int& version, const bool& withRead, const bool& swapEndian)
@@ -52,6 +55,8 @@ void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const
     {
         throw DataFileException("writing NIFTI with binary datatype is unsupported");
     }
+    m_readAt = false;//file is also being written, so reads must go through the same buffered position as writes
+    m_mapped = NULL;
     if (withRead)
     {
         m_file.open(filename, CaretBinaryFile::READ_WRITE_TRUNCATE);//for cifti on-disk writing, replace structure with along row needs to RMW
@@ -65,16 +70,79 @@ void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const
 
 void NiftiIO::close()
 {
+    m_readAt = false;
+    m_mapped = NULL;//closing the file unmaps it
     m_file.close();
     m_dims.clear();
 }
 
+void NiftiIO::rewriteExtension(const int& index, const vector<char>& bytes)
+{
+    CaretAssert(index >= 0 && index < (int)m_header.m_extensions.size());
+    if (!m_file.getOpenForWrite()) throw DataFileException("nifti file '" + m_file.getFilename() + "' is not open for writing");
+    if (bytes.size() != m_header.m_extensions[index]->m_bytes.size())
+    {
+        throw DataFileException("internal error, nifti extension can't change size when rewritten");
+    }
+    CaretMutexLocker locked(&m_mutex);//writeData also moves the file position
+    m_file.seek(m_header.getExtensionOffset(index));
+    m_file.write(bytes.data(), bytes.size());
+    m_header.m_extensions[index]->m_bytes = bytes;
+}
+
 int NiftiIO::getNumComponents() const
 {
     return m_header.getNumComponents();
 }
 
-int NiftiIO::numBytesPerElem()
+bool NiftiIO::mapData()
+{
+    if (m_mapped != NULL) return true;
+    if (!m_file.getOpenForRead() || m_file.getOpenForWrite()) return false;
+    if (m_header.isSwapped()) return false;//conversion would need to swap in place
+    int64_t dataSize = numBytesPerElem() * getNumComponents();
+    for (int i = 0; i < (int)m_dims.size(); ++i)
+    {
+        dataSize *= m_dims[i];
+    }
+    m_mapped = m_file.mapForRead(m_header.getDataOffset(), dataSize);//returns NULL for compressed files
+    return m_mapped != NULL;
+}
+
+const float* NiftiIO::getMappedFloatData(const int& fullDims, const vector<int64_t>& indexSelect) const
+{
+    if (m_mapped == NULL) return NULL;
+    if (m_header.getDataType() != NIFTI_TYPE_FLOAT32) return NULL;
+    double mult, offset;
+    if (m_header.getDataScaling(mult, offset)) return NULL;
+    if (m_header.getDataOffset() % sizeof(float) != 0) return NULL;//the standard requires a multiple of 16, but don't trust that for alignment
+    int64_t numSkip = 0;
+    getSelection(fullDims, indexSelect, numSkip);
+    return ((const float*)m_mapped) + numSkip;
+}
+
+int64_t NiftiIO::getSelection(const int& fullDims, const vector<int64_t>& indexSelect, int64_t& numSkip) const
+{
+    CaretAssert(fullDims >= 0 && fullDims <= (int)m_dims.size());
+    CaretAssert((size_t)fullDims + indexSelect.size() == m_dims.size());//could be >=, but should catch more stupid mistakes as ==
+    int64_t numElems = getNumComponents();
+    int curDim;
+    for (curDim = 0; curDim < fullDims; ++curDim)
+    {
+        numElems *= m_dims[curDim];
+    }
+    int64_t numDimSkip = numElems;
+    numSkip = 0;
+    for (; curDim < (int)m_dims.size(); ++curDim)
+    {
+        CaretAssert(indexSelect[curDim - fullDims] >= 0 && indexSelect[curDim - fullDims] < m_dims[curDim]);
+        numSkip += indexSelect[curDim - fullDims] * numDimSkip;
+        numDimSkip *= m_dims[curDim];
+    }
+    return numElems;
+}
+
+int NiftiIO::numBytesPerElem() const
 {
     switch (m_header.getDataType())
     {
@@ -44,7 +44,12 @@ namespace caret
         std::vector<int64_t> m_dims;
         std::vector<char> m_scratch;//scratch memory for byteswapping, type conversion, etc
         CaretMutex m_mutex;//protect multithreaded calls from each other
-        int numBytesPerElem();//for resizing scratch
+        bool m_readAt;//file supports stateless positional reads, so readData doesn't need the mutex
+        const char* m_mapped;//start of the data section when memory mapped, otherwise NULL
+        int numBytesPerElem() const;//for resizing scratch
+        int64_t getSelection(const int& fullDims, const std::vector<int64_t>& indexSelect, int64_t& numSkip) const;//returns number of elements, numSkip is in elements
+        template<typename T>
+        void convertScratch(T* dataOut, char* scratch, const int64_t& numElems);//dispatch on the file datatype
         template<typename TO, typename FROM>
         void convertRead(TO* out, FROM* in, const int64_t& count);//for reading from file
         template<typename TO, typename FROM>
@@ -52,6 +57,7 @@ namespace caret
         template<typename TO, typename FROM>
         static TO clamp(const FROM& in);//deal with integer cast being undefined when converting from outside range
     public:
+        NiftiIO() { m_readAt = false; m_mapped = NULL; }
         void openRead(const QString& filename);
         void writeNew(const QString& filename, const NiftiHeader& header, const int& version = 1, const bool& withRead = false, const bool& swapEndian = false);
         QString getFilename() const { return m_file.getFilename(); }
@@ -59,8 +65,16 @@ namespace caret
         void close();
         const NiftiHeader& getHeader() const { return m_header; }
         void dropExtensions() { m_header.m_extensions.clear(); }
+        //overwrite the contents of an extension in a file opened with writeNew, the size can't change, as the data follows the extensions
+        void rewriteExtension(const int& index, const std::vector<char>& bytes);
         const std::vector<int64_t>& getDimensions() const { return m_dims; }
         int getNumComponents() const;
+        //memory map the data section, only possible for uncompressed, native endian files opened with openRead
+        //readData then converts directly from the mapping, without locking or scratch memory
+        bool mapData();
+        bool isMapped() const { return m_mapped != NULL; }
+        //pointer into the mapping for a selection, only when no conversion is needed (float32, unscaled, single component), otherwise NULL
+        const float* getMappedFloatData(const int& fullDims, const std::vector<int64_t>& indexSelect) const;
         //to read/write 1 frame of a standard volume file, call with fullDims = 3, indexSelect containing indexes for any of dims 4-7 that exist
         //NOTE: you need to provide storage for all components within the range, if getNumComponents() == 3 and fullDims == 0, you need 3 elements allocated
         template<typename T>
@@ -72,70 +86,81 @@ namespace caret
     template<typename T>
     void NiftiIO::readData(T* dataOut, const int& fullDims, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead)
     {
-        CaretAssert(fullDims >= 0 && fullDims <= (int)m_dims.size());
-        CaretAssert((size_t)fullDims + indexSelect.size() == m_dims.size());//could be >=, but should catch more stupid mistakes as ==
-        int64_t numElems = getNumComponents();//for now, calculate read size on the fly, as the read call will be the slowest part
-        int curDim;
-        for (curDim = 0; curDim < fullDims; ++curDim)
-        {
-            numElems *= m_dims[curDim];
+        int64_t numSkip = 0;
+        int64_t numElems = getSelection(fullDims, indexSelect, numSkip);//for now, calculate read size on the fly, as the read call will be the slowest part
+        if (m_mapped != NULL)
+        {//only mapped when native endian, so conversion doesn't modify the input
+            convertScratch(dataOut, const_cast<char*>(m_mapped + numSkip * numBytesPerElem()), numElems);
+            return;
         }
-        int64_t numDimSkip = numElems, numSkip = 0;
-        for (; curDim < (int)m_dims.size(); ++curDim)
-        {
-            CaretAssert(indexSelect[curDim - fullDims] >= 0 && indexSelect[curDim - fullDims] < m_dims[curDim]);
-            numSkip += indexSelect[curDim - fullDims] * numDimSkip;
-            numDimSkip *= m_dims[curDim];
+        int64_t readOffset = numSkip * numBytesPerElem() + m_header.getDataOffset();
+        if (m_readAt)
+        {//positional read with per-call scratch, so concurrent readers don't wait on each other
+            std::vector<char> scratch(numElems * numBytesPerElem());
+            int64_t numRead = 0;
+            m_file.readAt(scratch.data(), readOffset, scratch.size(), &numRead);
+            if ((numRead != (int64_t)scratch.size() && !tolerateShortRead) || numRead < 0)
+            {
+                throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");
+            }
+            convertScratch(dataOut, scratch.data(), numElems);
+            return;
         }
         CaretMutexLocker locked(&m_mutex);//protect starting with resizing until we are done converting, because we use an internal variable for scratch space
         //we can't guarantee that the output memory is enough to use as scratch space, as we might be doing a narrowing conversion
         //we are doing FILE ACCESS, so cpu performance isn't really something to worry about
         m_scratch.resize(numElems * numBytesPerElem());
-        m_file.seek(numSkip * numBytesPerElem() + m_header.getDataOffset());
+        m_file.seek(readOffset);
         int64_t numRead = 0;
         m_file.read(m_scratch.data(), m_scratch.size(), &numRead);
         if ((numRead != (int64_t)m_scratch.size() && !tolerateShortRead) || numRead < 0)//for now, assume read giving -1 is always a problem
         {
             throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");
         }
+        convertScratch(dataOut, m_scratch.data(), numElems);
+    }
+    
+    template<typename T>
+    void NiftiIO::convertScratch(T* dataOut, char* scratch, const int64_t& numElems)
+    {
         switch (m_header.getDataType())
         {
             case NIFTI_TYPE_UINT8:
             case NIFTI_TYPE_RGB24://handled by components
-                convertRead(dataOut, (uint8_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint8_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_INT8:
-                convertRead(dataOut, (int8_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int8_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_UINT16:
-                convertRead(dataOut, (uint16_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint16_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_INT16:
-                convertRead(dataOut, (int16_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int16_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_UINT32:
-                convertRead(dataOut, (uint32_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint32_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_INT32:
-                convertRead(dataOut, (int32_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int32_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_UINT64:
-                convertRead(dataOut, (uint64_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint64_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_INT64:
-                convertRead(dataOut, (int64_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int64_t*)scratch, numElems);
                 break;
             case NIFTI_TYPE_FLOAT32:
             case NIFTI_TYPE_COMPLEX64://components
-                convertRead(dataOut, (float*)m_scratch.data(), numElems);
+                convertRead(dataOut, (float*)scratch, numElems);
                 break;
             case NIFTI_TYPE_FLOAT64:
             case NIFTI_TYPE_COMPLEX128:
-                convertRead(dataOut, (double*)m_scratch.data(), numElems);
+                convertRead(dataOut, (double*)scratch, numElems);
                 break;
             case NIFTI_TYPE_FLOAT128:
             case NIFTI_TYPE_COMPLEX256:
-                convertRead(dataOut, (long double*)m_scratch.data(), numElems);
+                convertRead(dataOut, (long double*)scratch, numElems);
                 break;
             default:
                 CaretAssert(0);
@@ -146,21 +171,8 @@ namespace caret
     template<typename T>
     void NiftiIO::writeData(const T* dataIn, const int& fullDims, const std::vector<int64_t>& indexSelect)
     {
-        CaretAssert(fullDims >= 0 && fullDims <= (int)m_dims.size());
-        CaretAssert((size_t)fullDims + indexSelect.size() == m_dims.size());//could be >=, but should catch more stupid mistakes as ==
-        int64_t numElems = getNumComponents();//for now, calculate read size on the fly, as the read call will be the slowest part
-        int curDim;
-        for (curDim = 0; curDim < fullDims; ++curDim)
-        {
-            numElems *= m_dims[curDim];
-        }
-        int64_t numDimSkip = numElems, numSkip = 0;
-        for (; curDim < (int)m_dims.size(); ++curDim)
-        {
-            CaretAssert(indexSelect[curDim - fullDims] >= 0 && indexSelect[curDim - fullDims] < m_dims[curDim]);
-            numSkip += indexSelect[curDim - fullDims] * numDimSkip;
-            numDimSkip *= m_dims[curDim];
-        }
+        int64_t numSkip = 0;
+        int64_t numElems = getSelection(fullDims, indexSelect, numSkip);
         CaretMutexLocker locked(&m_mutex);//protect starting with resizing until we are done writing, because we use an internal variable for scratch space
         //we are doing FILE ACCESS, so cpu performance isn't really something to worry about
         m_scratch.resize(numElems * numBytesPerElem());
@@ -25,9 +25,11 @@
 #include "CaretLogger.h"
 #include "CaretOMP.h"
 #include "CiftiFile.h"
+#include "CiftiMultiFileRowReader.h"
 #include "MathFunctions.h"
 
 #include <algorithm>
+#include <memory>
 #include <vector>
 
 using namespace caret;
@@ -110,6 +112,7 @@ void OperationCiftiAverage::useParameters(OperationParameters* myParams, Progres
         totalRows *= firstdims[i];
     }
     int64_t chunkRows = -1;//invalid value
+    int blocksAhead = CiftiMultiFileRowReader::getDefaultBlocksAhead();//blocks of rows read from the input files while computing on the current one
     //checking first cifti for "in memory" should catch both -cifti-read-memory and possible future GUI-based operation
     if (myInstances[0]->getCifti(1)->isInMemory())
     {
@@ -123,6 +126,7 @@ void OperationCiftiAverage::useParameters(OperationParameters* myParams, Progres
             {//exclude needs to load some rows from all files, but can then compute one output row at a time
                 computeBytes = sizeof(float) * myInstances.size();//exclusion needs to measure across *files*, so we need to cache some rows from all files before we can start computing any output
             }//also, weights with exclusion needs to be tracked per element
+            computeBytes += sizeof(float) * (blocksAhead + 1);//blocks being read ahead, and the one being used
             for (size_t i = 0; i < firstdims.size(); ++i)
             {
                 computeBytes *= firstdims[i];
@@ -180,6 +184,13 @@ void OperationCiftiAverage::useParameters(OperationParameters* myParams, Progres
     }
     CiftiFile* ciftiOut = myParams->getOutputCifti(1);//need to get it after all the inputs in order for provenance to work with lazy loading
     ciftiOut->setCiftiXML(firstXML);
+    vector<const CiftiFile*> inputFiles;
+    for (size_t i = 0; i < myInstances.size(); ++i)
+    {
+        inputFiles.push_back(myInstances[i]->getCifti(1));
+    }
+    //keeps reads from several input files in flight while this thread computes and writes, each file's rows of a chunk are one block
+    CiftiMultiFileRowReader myReader(inputFiles, vector<int64_t>(firstdims.begin() + 1, firstdims.end()), chunkRows, blocksAhead);
     if (!exclude)
     {
         vector<float> scratchRow(firstdims[0], 0.0f);
@@ -196,7 +207,8 @@ void OperationCiftiAverage::useParameters(OperationParameters* myParams, Progres
             vector<vector<double> > weightAccum = accum;
             for (size_t i = 0; i < myInstances.size(); ++i)
             {
-                CiftiFile* thisCifti = myInstances[i]->getCifti(1);
+                shared_ptr<const CiftiMultiFileRowReader::Block> thisBlock = myReader.nextBlock();
+                CaretAssert(thisBlock->m_fileIndex == int64_t(i) && thisBlock->m_numRows == int64_t(rowIndices.size()));
                 float thisWeight = 1.0f;
                 OptionalParameter* weightOpt = myInstances[i]->getOptionalParameter(1);
                 if (weightOpt->m_present)
@@ -205,12 +217,12 @@ void OperationCiftiAverage::useParameters(OperationParameters* myParams, Progres
                 }
                 for (size_t j = 0; j < rowIndices.size(); ++j)
                 {
-                    thisCifti->getRow(scratchRow.data(), *(rowIndices[j]));
+                    const float* thisRow = thisBlock->getRow(j);
                     for (int64_t k = 0; k < firstdims[0]; ++k)
                     {
-                        if (MathFunctions::isNumeric(scratchRow[k]))
+                        if (MathFunctions::isNumeric(thisRow[k]))
                         {
-                            accum[j][k] += thisWeight * scratchRow[k];
+                            accum[j][k] += thisWeight * thisRow[k];
                             weightAccum[j][k] += thisWeight;
                         }
                     }
@@ -242,13 +254,14 @@ void OperationCiftiAverage::useParameters(OperationParameters* myParams, Progres
             }
             //chunk x files x rowlength
             vector<vector<vector<float> > > scratchRows(rowIndices.size(), vector<vector<float> >(myInstances.size(), vector<float>(firstdims[0])));
-            //parallel probably won't help here, and will hurt on spinning disks
             for (size_t i = 0; i < myInstances.size(); ++i)
             {
-                CiftiFile* thisCifti = myInstances[i]->getCifti(1);
+                shared_ptr<const CiftiMultiFileRowReader::Block> thisBlock = myReader.nextBlock();
+                CaretAssert(thisBlock->m_fileIndex == int64_t(i) && thisBlock->m_numRows == int64_t(rowIndices.size()));
                 for (size_t j = 0; j < rowIndices.size(); ++j)
                 {
-                    thisCifti->getRow(scratchRows[j][i].data(), *(rowIndices[j]));
+                    const float* thisRow = thisBlock->getRow(j);
+                    copy(thisRow, thisRow + firstdims[0], scratchRows[j][i].begin());
                 }
             }
             for (size_t j = 0; j < rowIndices.size(); ++j)
@@ -240,13 +240,23 @@ void OperationCiftiMath::useParameters(OperationParameters* myParams, ProgressOb
     }
     if (outXML.getNumberOfDimensions() < 1) throw OperationException("output must have at least 1 dimension");
     myCiftiOut->setCiftiXML(outXML);
-    vector<float> values(numVars), scratchRow(outDims[0]);
+    vector<float> scratchRow(outDims[0]);
     vector<vector<float> > inputRows(numVars);
     vector<vector<int64_t> > loadedRow(numVars);//to detect and prevent rereading the same row
+    vector<const float*> rowPointers(numVars);
+    vector<int64_t> rowStrides(numVars);
     for (int v = 0; v < numVars; ++v)
     {
         inputRows[v].resize(varCiftiFiles[v]->getCiftiXML().getDimensionLength(CiftiXML::ALONG_ROW));
         loadedRow[v].resize(varCiftiFiles[v]->getCiftiXML().getNumberOfDimensions() - 1, -1);//we always load a full row, so ignore first dim
+        if (selectInfo[v][0] == -1)
+        {
+            rowPointers[v] = inputRows[v].data();
+            rowStrides[v] = 1;
+        } else {//select along row, so use the same element for the entire output row
+            rowPointers[v] = inputRows[v].data() + selectInfo[v][0];
+            rowStrides[v] = 0;
+        }
     }
     for (MultiDimIterator<int64_t> iter(vector<int64_t>(outDims.begin() + 1, outDims.end())); !iter.atEnd(); ++iter)
     {
@@ -274,22 +284,16 @@ void OperationCiftiMath::useParameters(OperationParameters* myParams, ProgressOb
                 varCiftiFiles[v]->getRow(inputRows[v].data(), loadedRow[v]);
             }
         }
-        for (int j = 0; j < outDims[0]; ++j)
+        myExpr.evaluateArray(rowPointers, scratchRow.data(), outDims[0], rowStrides);
+        if (nanfix)
         {
-            for (int v = 0; v < numVars; ++v)//now we check for select along row
+            for (int64_t j = 0; j < outDims[0]; ++j)
             {
-                if (selectInfo[v][0] == -1)
+                if (scratchRow[j] != scratchRow[j])
                 {
-                    values[v] = inputRows[v][j];
-                } else {
-                    values[v] = inputRows[v][selectInfo[v][0]];
+                    scratchRow[j] = nanfixval;
                 }
             }
-            scratchRow[j] = (float)myExpr.evaluate(values);
-            if (nanfix && scratchRow[j] != scratchRow[j])
-            {
-                scratchRow[j] = nanfixval;
-            }
         }
         myCiftiOut->setRow(scratchRow.data(), *iter);
     }
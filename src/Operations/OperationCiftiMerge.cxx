@@ -25,8 +25,10 @@
 #include "CaretPointer.h"
 #include "CaretCommandGlobalOptions.h"
 #include "CiftiFile.h"
+#include "CiftiMultiFileRowReader.h"
 
 #include <algorithm>
+#include <memory>
 #include <vector>
 #include <utility>
 
@@ -262,7 +264,7 @@ void OperationCiftiMerge::useParameters(OperationParameters* myParams, ProgressO
         default:
             CaretAssert(false);
     }
-    int64_t curMergeIndex = 0, scratchRowLength = 0, shortestRow = -1; //shortest row is needed to figure out how many to read to reduce seek penalty from switching between files (for row merge)
+    int64_t curMergeIndex = 0, shortestRow = -1, longestRow = 0; //shortest row is needed to figure out how many to read to reduce seek penalty from switching between files (for row merge), longest for memory of blocks being read
     for (int i = 0; i < numInputs; ++i)
     {
         const CiftiFile* ciftiIn = myInputs[i]->getCifti(1);
@@ -273,11 +275,11 @@ void OperationCiftiMerge::useParameters(OperationParameters* myParams, ProgressO
         {
             shortestRow = thisRowLength;
         }
+        longestRow = max(longestRow, thisRowLength);
         const vector<ParameterComponent*>& indexOpts = myInputs[i]->getRepeatableParameterInstances(2);
         int numIndexOpts = (int)indexOpts.size();
         if (numIndexOpts > 0)
         {//already checked that this input has this mapping direction, above, not allowing "-index 1" on missing dimension
-            scratchRowLength = max(scratchRowLength, thisRowLength);//if we use the entire row, we don't need a separate scratch row for it
             if (doLoop)
             {
                 for (int j = 0; j < numIndexOpts; ++j)
@@ -404,6 +406,7 @@ void OperationCiftiMerge::useParameters(OperationParameters* myParams, ProgressO
     {
         int64_t curRowIndex = 0;
         int64_t chunkRows = -1;//invalid value
+        int blocksAhead = CiftiMultiFileRowReader::getDefaultBlocksAhead();//blocks of rows read from the input files while copying the current one
         //checking first cifti for "in memory" should catch both -cifti-read-memory and possible future GUI-based operation
         int64_t numRows = 1;
         for (int i = 1; i < outXML.getNumberOfDimensions(); ++i)
@@ -417,7 +420,7 @@ void OperationCiftiMerge::useParameters(OperationParameters* myParams, ProgressO
             if (memLimitGB > 0.0f)
             {
                 int64_t chunkMaxBytes = int64_t(memLimitGB * (1<<30));
-                int64_t computeBytes = sizeof(float) * numRows * numOutIndices;
+                int64_t computeBytes = sizeof(float) * numRows * (numOutIndices + (blocksAhead + 1) * longestRow);//output rows, plus blocks being read ahead and the one being used
                 int64_t numPasses = (computeBytes - 1) / chunkMaxBytes + 1;
                 chunkRows = (numRows - 1) / numPasses + 1;
             } else {//by default, do enough rows to read at least 10MB (assuming float) from each file before moving to the next
@@ -429,7 +432,13 @@ void OperationCiftiMerge::useParameters(OperationParameters* myParams, ProgressO
         }
         CaretAssert(chunkRows > 0);
         vector<vector<float> > outRows(chunkRows, vector<float>(numOutIndices));
-        vector<float> scratchRow(scratchRowLength);
+        vector<const CiftiFile*> inputFiles;
+        for (int i = 0; i < numInputs; ++i)
+        {
+            inputFiles.push_back(myInputs[i]->getCifti(1));
+        }
+        //keeps reads from several input files in flight while this thread copies and writes, each file's rows of a chunk are one block
+        CiftiMultiFileRowReader myReader(inputFiles, vector<int64_t>(ciftiOut->getDimensions().begin() + 1, ciftiOut->getDimensions().end()), chunkRows, blocksAhead);
         auto outputIterator = ciftiOut->getIteratorOverRows(); //starts at beginning
         for (int64_t chunkStart = 0; chunkStart < numRows; chunkStart += chunkRows)
         {
@@ -437,7 +446,8 @@ void OperationCiftiMerge::useParameters(OperationParameters* myParams, ProgressO
             int64_t chunkRowIndex = 0; //track position within the row, to update while looping through input files
             for (int i = 0; i < numInputs; ++i)
             {
-                auto inputIterator = outputIterator; //start wherever we don't yet have output for
+                shared_ptr<const CiftiMultiFileRowReader::Block> thisBlock = myReader.nextBlock(); //rows of this chunk from this file
+                CaretAssert(thisBlock->m_fileIndex == i && thisBlock->m_numRows == chunkEnd - chunkStart);
                 const CiftiFile* ciftiIn = myInputs[i]->getCifti(1);
                 const CiftiXML& thisXML = ciftiIn->getCiftiXML();
                 const vector<ParameterComponent*>& columnOpts = myInputs[i]->getRepeatableParameterInstances(2);
@@ -445,12 +455,9 @@ void OperationCiftiMerge::useParameters(OperationParameters* myParams, ProgressO
                 for (int64_t chunkIndex = 0; chunkIndex < chunkEnd - chunkStart; ++chunkIndex)
                 {
                     curRowIndex = chunkRowIndex;
+                    const float* inputRow = thisBlock->getRow(chunkIndex);
                     if (numColumnOpts > 0)
                     {
-                        auto inputSelect = *inputIterator;
-                        inputSelect.erase(inputSelect.begin() + (thisXML.getNumberOfDimensions() - 1), inputSelect.end()); //deal with files that are missing a dimension
-                        ciftiIn->getRow(scratchRow.data(), inputSelect); //get a row and...
-                        ++inputIterator; //advance
                         for (int j = 0; j < numColumnOpts; ++j)
                         {
                             int64_t initialRowIndex = thisXML.getMap(CiftiXML::ALONG_ROW)->getIndexFromNumberOrName(columnOpts[j]->getString(1));//this function has the 1-indexing convention built in
@@ -463,25 +470,25 @@ void OperationCiftiMerge::useParameters(OperationParameters* myParams, ProgressO
                                 {
                                     for (int64_t c = finalRowIndex; c >= initialRowIndex; --c)
                                     {
-                                        outRows[chunkIndex][curRowIndex] = scratchRow[c];
+                                        outRows[chunkIndex][curRowIndex] = inputRow[c];
                                         ++curRowIndex;
                                     }
                                 } else {
                                     for (int64_t c = initialRowIndex; c <= finalRowIndex; ++c)
                                     {
-                                        outRows[chunkIndex][curRowIndex] = scratchRow[c];
+                                        outRows[chunkIndex][curRowIndex] = inputRow[c];
                                         ++curRowIndex;
                                     }
                                 }
                             } else {
-                                outRows[chunkIndex][curRowIndex] = scratchRow[initialRowIndex];
+                                outRows[chunkIndex][curRowIndex] = inputRow[initialRowIndex];
                                 ++curRowIndex;
                             }
                         }
                     } else {
-                        ciftiIn->getRow(outRows[chunkIndex].data() + curRowIndex, *inputIterator); //get a row and...
-                        ++inputIterator; //advance
-                        curRowIndex += thisXML.getDimensionLength(CiftiXML::ALONG_ROW);
+                        int64_t thisRowLength = thisXML.getDimensionLength(CiftiXML::ALONG_ROW);
+                        copy(inputRow, inputRow + thisRowLength, outRows[chunkIndex].begin() + curRowIndex);
+                        curRowIndex += thisRowLength;
                     }
                 }
                 chunkRowIndex = curRowIndex;//done with chunk for this file, update position within row for next file
@@ -0,0 +1,76 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationFileGzipIndex.h"
+#include "OperationException.h"
+
+#include "GzipIndex.h"
+
+using namespace caret;
+using namespace std;
+
+AString OperationFileGzipIndex::getCommandSwitch()
+{
+    return "-file-gzip-index";
+}
+
+AString OperationFileGzipIndex::getShortDescription()
+{
+    return "BUILD A RANDOM ACCESS INDEX FOR A GZIPPED FILE";
+}
+
+OperationParameters* OperationFileGzipIndex::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    
+    ret->addStringParameter(1, "gzip-file", "the compressed file to index");
+    
+    OptionalParameter* spanOpt = ret->createOptionalParameter(2, "-span", "set the spacing of access points");
+    spanOpt->addDoubleParameter(1, "mebibytes", "amount of uncompressed data between access points, default 4");
+    
+    ret->setHelpText(
+        AString("Decompresses the entire file once and writes a sidecar file named <gzip-file>idx (for example, data.dtseries.nii.gzidx), ") +
+        "which workbench uses to read from any position in the compressed file without decompressing everything before it.  " +
+        "This makes row and column access on large gzipped cifti or volume files much faster.  " +
+        "The compressed file is not modified, and other software will still read it normally.\n\n" +
+        "Workbench deletes the index when it writes the compressed file.  " +
+        "If other software changes or replaces the compressed file, the index is ignored (with a warning) until this command is run again.  " +
+        "Each access point stores 32KiB of data, so smaller spans make seeks faster but the index larger."
+    );
+    return ret;
+}
+
+void OperationFileGzipIndex::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    AString gzFileName = myParams->getString(1);
+    int64_t span = GzipIndex::DEFAULT_SPAN;
+    OptionalParameter* spanOpt = myParams->getOptionalParameter(2);
+    if (spanOpt->m_present)
+    {
+        double spanMiB = spanOpt->getDouble(1);
+        if (!(spanMiB * 1024 * 1024 >= GzipIndex::WINDOW_SIZE)) throw OperationException("span must be at least 1/32 mebibyte");
+        span = (int64_t)(spanMiB * 1024 * 1024);
+    }
+    if (!gzFileName.endsWith(".gz")) throw OperationException("file '" + gzFileName + "' does not end in .gz, workbench would not read it as a compressed file");
+    GzipIndex myIndex;
+    myIndex.build(gzFileName, span);
+    myIndex.writeIndex(GzipIndex::getIndexFileName(gzFileName));
+}
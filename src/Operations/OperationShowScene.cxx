@@ -19,8 +19,12 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <cstdio>
+#include <deque>
 #include <fstream>
+#include <iostream>
+#include <memory>
 
 #ifdef HAVE_GLEW
 #include <GL/glew.h>
@@ -31,8 +35,12 @@
 #endif // HAVE_OSMESA
 
 #include <QDir>
+#include <QFileInfo>
 #include <QImage>
+#include <QImageWriter>
 #include <QColor>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
 
 
 #include "Brain.h"
@@ -43,7 +51,6 @@
 #include "CaretAssert.h"
 #include "CaretPreferences.h"
 #include "CaretLogger.h"
-#include "DataFileException.h"
 #include "EventBrowserTabGet.h"
 #include "EventBrowserWindowContent.h"
 #include "EventGraphicsOpenGLDeleteTextureName.h"
@@ -143,6 +150,11 @@ OperationShowScene::getParameters()
     connDbOpt->addStringParameter(1, "Username", "Connectome DB Username");
     connDbOpt->addStringParameter(2, "Password", "Connectome DB Password");
     
+    ret->createOptionalParameter(10, "-print-load-times", "Print the time to read and add each data file in the scene");
+    
+    OptionalParameter* batchOpt = ret->createOptionalParameter(11, "-batch", "Render additional scenes and maps listed in a file");
+    batchOpt->addStringParameter(1, "job-file", "text file containing one job per line");
+    
     AString helpText("DEPRECATED: this command may be removed in a future release, use -scene-capture-image.\n\n"
                      "Render content of browser windows displayed in a scene "
                      "into image file(s).  The image file name should be "
@@ -158,6 +170,29 @@ OperationShowScene::getParameters()
                      "the username and password stored in the user's preferences\n"
                      "is used.\n"
                      "\n"
+                     "The \"-print-load-times\" option prints, for each data file,\n"
+                     "the time spent reading it (on a worker thread for surface,\n"
+                     "metric, label, volume, and most CIFTI files, which are read\n"
+                     "in parallel) and the time spent adding it to the brain.\n"
+                     "\n"
+                     "The \"-batch\" option renders more images in the same process.\n"
+                     "Each line of the job file contains a job:\n"
+                     "    <scene-name-or-number> <image-file-name> [<map-yoking-roman-numeral> <map-index>]\n"
+                     "Fields are separated by spaces or tabs and a field containing\n"
+                     "spaces is enclosed in double quotes.  Blank lines and lines\n"
+                     "starting with \"#\" are ignored.  The scene and image on the\n"
+                     "command line, with \"-set-map-yoke\", are the first job and the\n"
+                     "jobs in the file follow, in order.  Data files loaded by a job\n"
+                     "are kept and used by the following jobs whose scenes contain\n"
+                     "them, instead of being read again.  However, a file whose\n"
+                     "palette was changed by a scene (or that is otherwise\n"
+                     "modified) is read again by the next job that restores a\n"
+                     "scene, so such files may be read more than once.  When\n"
+                     "consecutive jobs use the same scene and differ only in the\n"
+                     "selected map of a yoking group, the scene is not restored\n"
+                     "again.  Images are written on worker threads while rendering\n"
+                     "continues.\n"
+                     "\n"
                      "The image format is determined by the image file extension.\n"
                      "The available image formats may vary by operating system.\n"
                      "Image formats available on this system are:\n"
@@ -214,6 +249,99 @@ OperationShowScene::useParameters(OperationParameters* /*myParams*/,
     throw OperationException(getCommandNotAvailableMessage(OperationShowScene::getCommandSwitch()));
 }
 #else // HAVE_OSMESA
+/**
+ * A scene rendered into an image, with an optional map yoking selection
+ */
+class OperationShowScene::BatchJob {
+public:
+    /** Name or number (starting at one) of the scene */
+    AString m_sceneNameOrNumber;
+    
+    /** Absolute path of the output image */
+    AString m_imageFileName;
+    
+    /** Map yoking group whose map is selected (OFF if none) */
+    MapYokingGroupEnum::Enum m_mapYokingGroup = MapYokingGroupEnum::MAP_YOKING_GROUP_OFF;
+    
+    /** Index, starting at zero, of the selected map */
+    int32_t m_mapYokingMapIndex = -1;
+};
+
+/**
+ * Encodes and writes images on worker threads.  Each image is copied
+ * so that the caller may reuse or delete its buffer.  The number of
+ * images waiting to be written is limited to bound memory use.
+ * Workers only use QImage, so that no CaretObject (such as an
+ * ImageFile) is created while the main thread restores scenes.
+ */
+class OperationShowScene::ImageWriteQueue {
+public:
+    ImageWriteQueue()
+    : m_maximumPendingWrites(std::max(2, QThread::idealThreadCount()))
+    { }
+    
+    ~ImageWriteQueue() {
+        /*
+         * Writes are not cancelled, wait for them if an exception
+         * ended rendering
+         */
+        for (auto& f : m_pendingWrites) {
+            f.waitForFinished();
+        }
+    }
+    
+    void addImage(const AString& imageFileName,
+                  const int32_t imageIndex,
+                  const unsigned char* imageContent,
+                  const int32_t imageWidth,
+                  const int32_t imageHeight) {
+        while (static_cast<int32_t>(m_pendingWrites.size()) >= m_maximumPendingWrites) {
+            finishOldestWrite();
+        }
+        
+        const int64_t numberOfBytes = static_cast<int64_t>(imageWidth) * imageHeight * 4;
+        std::shared_ptr<std::vector<unsigned char>> imageCopy(new std::vector<unsigned char>(imageContent,
+                                                                                             imageContent + numberOfBytes));
+        const AString outputName = OperationShowScene::getImageFileNameForIndex(imageFileName,
+                                                                                 imageIndex);
+        m_pendingWrites.push_back(QtConcurrent::run([outputName, imageCopy, imageWidth, imageHeight]() {
+            AString errorMessage;
+            try {
+                OperationShowScene::writeImage(outputName,
+                                               imageCopy->data(),
+                                               imageWidth,
+                                               imageHeight);
+            }
+            catch (const CaretException& e) {
+                errorMessage = e.whatString();
+            }
+            return errorMessage;
+        }));
+    }
+    
+    void waitForAllWrites() {
+        while ( ! m_pendingWrites.empty()) {
+            finishOldestWrite();
+        }
+    }
+    
+private:
+    void finishOldestWrite() {
+        CaretAssert( ! m_pendingWrites.empty());
+        QFuture<AString> oldestWrite = m_pendingWrites.front();
+        m_pendingWrites.pop_front();
+        oldestWrite.waitForFinished();
+        const AString errorMessage = oldestWrite.result();
+        if ( ! errorMessage.isEmpty()) {
+            throw OperationException(errorMessage);
+        }
+    }
+    
+    const int32_t m_maximumPendingWrites;
+    
+    std::deque<QFuture<AString>> m_pendingWrites;
+};
+
 void
 OperationShowScene::useParameters(OperationParameters* myParams,
                                   ProgressObject* myProgObj)
@@ -286,88 +414,203 @@ OperationShowScene::useParameters(OperationParameters* myParams,
     }
     CaretDataFile::setFileReadingUsernameAndPassword(username,
                                                      password);
+    
+    const bool printLoadTimesFlag = myParams->getOptionalParameter(10)->m_present;
 
     /*
-     * Read the scene file and load the scene
+     * The first job is the scene and image from the command line.
+     * Additional jobs come from the batch job file.  Image file names
+     * are made absolute before any scene is restored since restoring
+     * a scene may change the current directory.
      */
-    SceneFile sceneFile;
-    sceneFile.readFile(sceneFileName);
-    Scene* scene = sceneFile.getSceneWithName(sceneNameOrNumber);
-    if (scene == NULL) {
-        bool valid = false;
-        const int32_t sceneIndexStartAtOne = sceneNameOrNumber.toInt(&valid);
-        if (valid) {
-            const int32_t sceneIndex = sceneIndexStartAtOne - 1;
-            if ((sceneIndex >= 0)
-                && (sceneIndex < sceneFile.getNumberOfScenes())) {
-                scene = sceneFile.getSceneAtIndex(sceneIndex);
-            }
-            else {
-                throw OperationException("Scene index is invalid");
-            }
-        }
-        else {
-            throw OperationException("Scene name is invalid");
-        }
+    std::vector<BatchJob> batchJobs;
+    BatchJob commandLineJob;
+    commandLineJob.m_sceneNameOrNumber  = sceneNameOrNumber;
+    commandLineJob.m_imageFileName      = imageFileName;
+    commandLineJob.m_mapYokingGroup     = mapYokingGroup;
+    commandLineJob.m_mapYokingMapIndex  = mapYokingMapIndex;
+    batchJobs.push_back(commandLineJob);
+    
+    OptionalParameter* batchOpt = myParams->getOptionalParameter(11);
+    if (batchOpt->m_present) {
+        readBatchJobFile(batchOpt->getString(1),
+                         batchJobs);
     }
     
     /*
-     * Enable voxel coloring since it is defaulted off for commands
+     * Read the scene file
      */
-    VolumeFile::setVoxelColoringEnabled(true);
-    
-    SceneAttributes sceneAttributes(SceneTypeEnum::SCENE_TYPE_FULL,
-                                    scene);
-    
-    if (doNotUseSceneColorsFlag) {
-        sceneAttributes.setUseSceneForegroundAndBackgroundColors(false);
-    }
+    SceneFile sceneFile;
+    sceneFile.readFile(sceneFileName);
     
     /*
-     * Restore the scene
+     * Find all scenes before rendering so that an invalid
+     * job is reported before any time is spent loading files
      */
-    const SceneClass* guiManagerClass = scene->getClassWithName("guiManager");
-    if (guiManagerClass->getName() != "guiManager") {
-        throw OperationException("Top level scene class should be guiManager but it is: "
-                                 + guiManagerClass->getName());
+    const int32_t numberOfJobs = static_cast<int32_t>(batchJobs.size());
+    std::vector<Scene*> jobScenes;
+    for (int32_t iJob = 0; iJob < numberOfJobs; iJob++) {
+        CaretAssertVectorIndex(batchJobs, iJob);
+        jobScenes.push_back(getSceneWithNameOrNumber(sceneFile,
+                                                     batchJobs[iJob].m_sceneNameOrNumber));
     }
     
-    SessionManager* sessionManager = SessionManager::get();
-    sessionManager->restoreFromScene(&sceneAttributes,
-                                     guiManagerClass->getClass("m_sessionManager"));
-    
     /*
-     * Get the error message but continue processing since the error
-     * may not affect the scene.  Print error message later.
+     * Enable voxel coloring since it is defaulted off for commands
      */
-    const AString sceneErrorMessage = sceneAttributes.getErrorMessage();
-    
-    if (sessionManager->getNumberOfBrains() <= 0) {
-        throw OperationException("Scene loading failure, SessionManager contains no Brains");
-    }
-    Brain* brain = SessionManager::get()->getBrain(0);
+    VolumeFile::setVoxelColoringEnabled(true);
     
-    const GapsAndMargins* gapsAndMargins = brain->getGapsAndMargins();
+    SessionManager* sessionManager = SessionManager::get();
     
     bool missingWindowMessageHasBeenDisplayed = false;
     
     /*
-     * Apply map yoking
+     * Images are encoded and written on worker threads while
+     * the next window or job is rendered
      */
-    if (mapYokingGroup != MapYokingGroupEnum::MAP_YOKING_GROUP_OFF) {
-        MapYokingGroupEnum::setSelectedMapIndex(mapYokingGroup, mapYokingMapIndex);
+    ImageWriteQueue imageWriteQueue;
+    
+    const Scene* restoredScene(NULL);
+    MapYokingGroupEnum::Enum restoredSceneMapYokingGroup = MapYokingGroupEnum::MAP_YOKING_GROUP_OFF;
+    
+    for (int32_t iJob = 0; iJob < numberOfJobs; iJob++) {
+        CaretAssertVectorIndex(batchJobs, iJob);
+        const BatchJob& job = batchJobs[iJob];
+        CaretAssertVectorIndex(jobScenes, iJob);
+        Scene* scene = jobScenes[iJob];
+        
+        /*
+         * A scene that is already restored is not restored again when
+         * the job changes nothing or only changes the selected map of the
+         * yoking group changed by the previous job.  Otherwise, the scene
+         * is restored.  Files that were loaded by a previous job and are
+         * also in this scene are not read again, unless they are modified,
+         * including palettes modified by a scene (see Brain::resetBrainKeepSceneFiles()).
+         */
+        bool restoreSceneFlag = true;
+        if (scene == restoredScene) {
+            if ((restoredSceneMapYokingGroup == MapYokingGroupEnum::MAP_YOKING_GROUP_OFF)
+                || (restoredSceneMapYokingGroup == job.m_mapYokingGroup)) {
+                restoreSceneFlag = false;
+            }
+        }
+        
+        if (restoreSceneFlag) {
+            SceneAttributes sceneAttributes(SceneTypeEnum::SCENE_TYPE_FULL,
+                                            scene);
+            
+            if (doNotUseSceneColorsFlag) {
+                sceneAttributes.setUseSceneForegroundAndBackgroundColors(false);
+            }
+            
+            /*
+             * Restore the scene
+             */
+            const SceneClass* guiManagerClass = scene->getClassWithName("guiManager");
+            if (guiManagerClass->getName() != "guiManager") {
+                throw OperationException("Top level scene class should be guiManager but it is: "
+                                         + guiManagerClass->getName());
+            }
+            
+            sessionManager->restoreFromScene(&sceneAttributes,
+                                             guiManagerClass->getClass("m_sessionManager"));
+            restoredScene = scene;
+            restoredSceneMapYokingGroup = MapYokingGroupEnum::MAP_YOKING_GROUP_OFF;
+            
+            /*
+             * Print the error message but continue processing since the error
+             * may not affect the scene.
+             */
+            const AString sceneErrorMessage = sceneAttributes.getErrorMessage();
+            if ( ! sceneErrorMessage.isEmpty()) {
+                std::cerr << "ERRORS loading scene "
+                          << job.m_sceneNameOrNumber
+                          << ", output image "
+                          << job.m_imageFileName
+                          << " may be incorrect." << std::endl;
+                std::cerr << sceneErrorMessage << std::endl;
+            }
+        }
+        
+        if (sessionManager->getNumberOfBrains() <= 0) {
+            throw OperationException("Scene loading failure, SessionManager contains no Brains");
+        }
+        Brain* brain = sessionManager->getBrain(0);
         
-        EventMapYokingSelectMap yokeEvent(mapYokingGroup,
-                                          NULL,
-                                          NULL,
-                                          NULL,
-                                          NULL,
-                                          mapYokingMapIndex,
-                                          MapYokingGroupEnum::MediaAllFramesStatus::ALL_FRAMES_OFF,
-                                          true);
-        EventManager::get()->sendEvent(yokeEvent.getPointer());
+        if (printLoadTimesFlag
+            && restoreSceneFlag) {
+            std::cout << brain->getDataFileLoadTimesReport() << std::endl;
+        }
+        
+        /*
+         * Apply map yoking
+         */
+        if (job.m_mapYokingGroup != MapYokingGroupEnum::MAP_YOKING_GROUP_OFF) {
+            MapYokingGroupEnum::setSelectedMapIndex(job.m_mapYokingGroup, job.m_mapYokingMapIndex);
+            
+            EventMapYokingSelectMap yokeEvent(job.m_mapYokingGroup,
+                                              NULL,
+                                              NULL,
+                                              NULL,
+                                              NULL,
+                                              job.m_mapYokingMapIndex,
+                                              MapYokingGroupEnum::MediaAllFramesStatus::ALL_FRAMES_OFF,
+                                              true);
+            EventManager::get()->sendEvent(yokeEvent.getPointer());
+            restoredSceneMapYokingGroup = job.m_mapYokingGroup;
+        }
+        
+        renderWindowsToImages(brain,
+                              job.m_imageFileName,
+                              userImageWidth,
+                              userImageHeight,
+                              useWindowSizeForImageSizeFlag,
+                              useWindowSizeParam->m_optionSwitch,
+                              (iJob == 0),
+                              missingWindowMessageHasBeenDisplayed,
+                              imageWriteQueue);
     }
     
+    imageWriteQueue.waitForAllWrites();
+}
+
+/**
+ * Render the content of each valid browser window into an image.
+ *
+ * @param brain
+ *     Brain that is drawn.
+ * @param imageFileName
+ *     Name of image file.  When there is more than one window, the window
+ *     number is inserted into the name of each window's image.
+ * @param userImageWidth
+ *     Width of image from the command line.
+ * @param userImageHeight
+ *     Height of image from the command line.
+ * @param useWindowSizeForImageSizeFlag
+ *     If true, use the window size from the scene for the image size.
+ * @param useWindowSizeSwitch
+ *     Switch for the option that uses the window size (for messages).
+ * @param logOpenGLInformationFlag
+ *     If true, log information about the OpenGL implementation.
+ * @param missingWindowMessageHasBeenDisplayedInOut
+ *     Set when the missing window size message is displayed so that
+ *     it is displayed only once.
+ * @param imageWriteQueue
+ *     Queue that encodes and writes the images.
+ */
+void
+OperationShowScene::renderWindowsToImages(Brain* brain,
+                                          const AString& imageFileName,
+                                          const int32_t userImageWidth,
+                                          const int32_t userImageHeight,
+                                          const bool useWindowSizeForImageSizeFlag,
+                                          const AString& useWindowSizeSwitch,
+                                          const bool logOpenGLInformationFlag,
+                                          bool& missingWindowMessageHasBeenDisplayedInOut,
+                                          ImageWriteQueue& imageWriteQueue)
+{
+    const GapsAndMargins* gapsAndMargins = brain->getGapsAndMargins();
+    
     std::vector<BrowserWindowContent*> allBrowserWindowContent;
     for (int32_t i = 0; i < BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_WINDOWS; i++) {
         std::unique_ptr<EventBrowserWindowContent> browserContentEvent = EventBrowserWindowContent::getWindowContent(i);
@@ -411,7 +654,7 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                 if ((imageWidth <= 0)
                     || (imageHeight <= 0)) {
                     const QString msg("Option "
-                                      + useWindowSizeParam->m_optionSwitch
+                                      + useWindowSizeSwitch
                                       + " is used but window size not found in scene and width="
                                       + QString::number(imageWidth)
                                       + " height="
@@ -421,9 +664,9 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                     throw OperationException(msg);
                 }
                 
-                if ( ! missingWindowMessageHasBeenDisplayed) {
+                if ( ! missingWindowMessageHasBeenDisplayedInOut) {
                     const QString msg("Option \""
-                                      + useWindowSizeParam->m_optionSwitch
+                                      + useWindowSizeSwitch
                                       + "\" is used but window size not found in scene.\n"
                                       "   Scene was created prior to implementation of this option.\n"
                                       "   Image size will be width="
@@ -438,7 +681,7 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                      * Avoid message being displayed more than once when
                      * there are more than one windows.
                      */
-                    missingWindowMessageHasBeenDisplayed = true;
+                    missingWindowMessageHasBeenDisplayedInOut = true;
                 }
             }
         }
@@ -516,7 +759,8 @@ OperationShowScene::useParameters(OperationParameters* myParams,
          */
         if (restoreToTabTiles) {
             CaretPointer<BrainOpenGL> brainOpenGL(createBrainOpenGL());
-            if (iWindow == 0) {
+            if (logOpenGLInformationFlag
+                && (iWindow == 0)) {
                 CaretLogConfig(brainOpenGL->getOpenGLInformation());
             }
 
@@ -597,11 +841,11 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                                                       ? iWindow
                                                       : -1);
                     
-                    writeImage(imageFileName,
-                               outputImageIndex,
-                               imageBuffer,
-                               imageWidth,
-                               imageHeight);
+                    imageWriteQueue.addImage(imageFileName,
+                                             outputImageIndex,
+                                             imageBuffer,
+                                             imageWidth,
+                                             imageHeight);
                     
                     for (std::vector<BrainOpenGLViewportContent*>::iterator vpIter = viewports.begin();
                          vpIter != viewports.end();
@@ -617,7 +861,8 @@ OperationShowScene::useParameters(OperationParameters* myParams,
         }
         else {
             CaretPointer<BrainOpenGL> brainOpenGL(createBrainOpenGL());
-            if (iWindow == 0) {
+            if (logOpenGLInformationFlag
+                && (iWindow == 0)) {
                 CaretLogFine(brainOpenGL->getOpenGLInformation());
                 
             }
@@ -658,11 +903,11 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                                               ? iWindow
                                               : -1);
             
-            writeImage(imageFileName,
-                       outputImageIndex,
-                       imageBuffer,
-                       imageWidth,
-                       imageHeight);
+            imageWriteQueue.addImage(imageFileName,
+                                     outputImageIndex,
+                                     imageBuffer,
+                                     imageWidth,
+                                     imageHeight);
         }
         
         /*
@@ -671,16 +916,143 @@ OperationShowScene::useParameters(OperationParameters* myParams,
         delete[] imageBuffer;
         OSMesaDestroyContext(mesaContext);
     }
+}
+
+/**
+ * Read the jobs in a batch job file.
+ *
+ * @param jobFileName
+ *     Name of the job file.
+ * @param jobsInOut
+ *     Jobs read from the file are added to this.
+ */
+void
+OperationShowScene::readBatchJobFile(const AString& jobFileName,
+                                     std::vector<BatchJob>& jobsInOut)
+{
+    std::ifstream jobFile(jobFileName.toLocal8Bit().constData());
+    if ( ! jobFile.good()) {
+        throw OperationException("error reading batch job file " + jobFileName);
+    }
     
-    /*
-     * Print error messages
-     */
-    if ( ! sceneErrorMessage.isEmpty()) {
-        std::cerr << "ERRORS loading scene, output image may be incorrect." << std::endl;
-        std::cerr << sceneErrorMessage << std::endl;
+    std::string textLine;
+    int32_t lineNumber = 0;
+    while (std::getline(jobFile, textLine)) {
+        lineNumber++;
+        const AString line = AString::fromStdString(textLine).trimmed();
+        if (line.isEmpty()
+            || line.startsWith("#")) {
+            continue;
+        }
+        
+        /*
+         * Split into fields at whitespace, text in double quotes is one field
+         */
+        std::vector<AString> fields;
+        AString field;
+        bool inQuotesFlag = false;
+        bool fieldStartedFlag = false;
+        for (const QChar c : line) {
+            if (c == '"') {
+                inQuotesFlag = ( ! inQuotesFlag);
+                fieldStartedFlag = true;
+            }
+            else if (c.isSpace()
+                     && ( ! inQuotesFlag)) {
+                if (fieldStartedFlag) {
+                    fields.push_back(field);
+                    field.clear();
+                    fieldStartedFlag = false;
+                }
+            }
+            else {
+                field.append(c);
+                fieldStartedFlag = true;
+            }
+        }
+        if (fieldStartedFlag) {
+            fields.push_back(field);
+        }
+        
+        const AString lineText(" on line "
+                               + AString::number(lineNumber)
+                               + " of batch job file "
+                               + jobFileName);
+        if (inQuotesFlag) {
+            throw OperationException("Missing closing double quote" + lineText);
+        }
+        if ((fields.size() != 2)
+            && (fields.size() != 4)) {
+            throw OperationException("Job must contain a scene and image file, optionally followed by a map yoking group and map index"
+                                     + lineText);
+        }
+        
+        BatchJob job;
+        job.m_sceneNameOrNumber = fields[0];
+        job.m_imageFileName     = FileInformation(fields[1]).getAbsoluteFilePath();
+        if (fields.size() == 4) {
+            bool validFlag = false;
+            job.m_mapYokingGroup = MapYokingGroupEnum::fromGuiName(fields[2], &validFlag);
+            if (( ! validFlag)
+                || (job.m_mapYokingGroup == MapYokingGroupEnum::MAP_YOKING_GROUP_OFF)) {
+                throw OperationException(fields[2]
+                                         + " does not identify a valid Map Yoking Group"
+                                         + lineText);
+            }
+            
+            /*
+             * Map indice in code start at zero
+             */
+            job.m_mapYokingMapIndex = fields[3].toInt(&validFlag) - 1;
+            if (( ! validFlag)
+                || (job.m_mapYokingMapIndex < 0)) {
+                throw OperationException("Map yoking map index must be one or greater"
+                                         + lineText);
+            }
+        }
+        
+        jobsInOut.push_back(job);
     }
 }
 
+/**
+ * Find a scene by its name or by its number.
+ *
+ * @param sceneFile
+ *     File containing the scene.
+ * @param sceneNameOrNumber
+ *     Name or number (starting at one) of the scene.
+ * @return
+ *     The scene.  An exception is thrown if the scene is not found.
+ */
+Scene*
+OperationShowScene::getSceneWithNameOrNumber(SceneFile& sceneFile,
+                                             const AString& sceneNameOrNumber)
+{
+    Scene* scene = sceneFile.getSceneWithName(sceneNameOrNumber);
+    if (scene == NULL) {
+        bool valid = false;
+        const int32_t sceneIndexStartAtOne = sceneNameOrNumber.toInt(&valid);
+        if (valid) {
+            const int32_t sceneIndex = sceneIndexStartAtOne - 1;
+            if ((sceneIndex >= 0)
+                && (sceneIndex < sceneFile.getNumberOfScenes())) {
+                scene = sceneFile.getSceneAtIndex(sceneIndex);
+            }
+            else {
+                throw OperationException("Scene index is invalid: "
+                                         + sceneNameOrNumber);
+            }
+        }
+        else {
+            throw OperationException("Scene name is invalid: "
+                                     + sceneNameOrNumber);
+        }
+    }
+    
+    return scene;
+}
+
 /**
  * Estimate the size of the graphics region from scenes that lack
  * an explicit entry for the graphics region size.  Scenes in version
@@ -866,29 +1238,19 @@ OperationShowScene::createBrainOpenGL()
 #endif // HAVE_OSMESA
 
 /**
- * Write the image data to a Image File.
+ * Get the name of the image file for a window.
  *
  * @param imageFileName
  *     Name of image file.
  * @param imageIndex
- *     Index of image.
- * @param imageContent
- *     content of image.
- * @param imageWidth
- *     width of image.
- * @param imageHeight
- *     height of image.
+ *     Index of image, if negative the name is not changed.
+ * @return
+ *     Name with the window number inserted before the extension.
  */
-void
-OperationShowScene::writeImage(const AString& imageFileName,
-                               const int32_t imageIndex,
-                               const unsigned char* imageContent,
-                               const int32_t imageWidth,
-                               const int32_t imageHeight)
+AString
+OperationShowScene::getImageFileNameForIndex(const AString& imageFileName,
+                                             const int32_t imageIndex)
 {
-    /*
-     * Create name of image
-     */
     QString outputName(imageFileName);
     if (imageIndex >= 0) {
         const AString imageNumber = QString("_%1").arg((int)(imageIndex + 1),
@@ -905,16 +1267,67 @@ OperationShowScene::writeImage(const AString& imageFileName,
                            + ".png");
         }
     }
+    return outputName;
+}
+
+/**
+ * Write the image data to an image file, with the same format settings
+ * as ImageFile::writeFile().  Only Qt image classes are used, since
+ * this runs on worker threads.
+ *
+ * @param outputName
+ *     Name of image file, from getImageFileNameForIndex().
+ * @param imageContent
+ *     content of image, RGBA with the origin at the bottom.
+ * @param imageWidth
+ *     width of image.
+ * @param imageHeight
+ *     height of image.
+ */
+void
+OperationShowScene::writeImage(const AString& outputName,
+                               const unsigned char* imageContent,
+                               const int32_t imageWidth,
+                               const int32_t imageHeight)
+{
+    if ((imageWidth <= 0)
+        || (imageHeight <= 0)) {
+        throw OperationException(outputName + "  Image width or height is zero.");
+    }
+    
+    QImage image(imageWidth,
+                 imageHeight,
+                 QImage::Format_ARGB32);
+    for (int y = 0; y < imageHeight; y++) {
+        QRgb* rgbScanLine = (QRgb*)image.scanLine(imageHeight - y - 1);
+        for (int x = 0; x < imageWidth; x++) {
+            const int64_t contentOffset = ((static_cast<int64_t>(y) * imageWidth) + x) * 4;
+            rgbScanLine[x] = qRgba(imageContent[contentOffset],
+                                   imageContent[contentOffset + 1],
+                                   imageContent[contentOffset + 2],
+                                   imageContent[contentOffset + 3]);
+        }
+    }
     
-    try {
-        ImageFile imageFile(imageContent,
-                            imageWidth,
-                            imageHeight,
-                            ImageFile::IMAGE_DATA_ORIGIN_AT_BOTTOM);
-        imageFile.writeFile(outputName);
+    QString format = QFileInfo(outputName).suffix().toUpper();
+    if (format == "JPG") {
+        format = "JPEG";
+    }
+    
+    QImageWriter writer(outputName, format.toLatin1());
+    if (writer.supportsOption(QImageIOHandler::Quality)) {
+        if (format.compare("png", Qt::CaseInsensitive) == 0) {
+            writer.setQuality(1);
+        }
+        else {
+            writer.setQuality(100);
+        }
+    }
+    if (writer.supportsOption(QImageIOHandler::CompressionRatio) && writer.compression() == 0) {
+        writer.setCompression(1);
     }
-    catch (const DataFileException& dfe) {
-        throw OperationException(dfe);
+    if ( ! writer.write(image)) {
+        throw OperationException(outputName + ": " + writer.errorString());
     }
 }
 
@@ -22,11 +22,16 @@
 /*LICENSE_END*/
 
 
+#include <vector>
+
 #include "AbstractOperation.h"
 
 namespace caret {
 
+    class Brain;
     class BrainOpenGLFixedPipeline;
+    class Scene;
+    class SceneFile;
     
     class OperationShowScene : public AbstractOperation {
 
@@ -45,13 +50,35 @@ namespace caret {
         static AString getCommandNotAvailableMessage(const AString& commandSwitch);
         
     private:
+        class BatchJob;
+        
+        class ImageWriteQueue;
+        
+        static void readBatchJobFile(const AString& jobFileName,
+                                     std::vector<BatchJob>& jobsInOut);
+        
+        static Scene* getSceneWithNameOrNumber(SceneFile& sceneFile,
+                                               const AString& sceneNameOrNumber);
+        
+        static void renderWindowsToImages(Brain* brain,
+                                          const AString& imageFileName,
+                                          const int32_t userImageWidth,
+                                          const int32_t userImageHeight,
+                                          const bool useWindowSizeForImageSizeFlag,
+                                          const AString& useWindowSizeSwitch,
+                                          const bool logOpenGLInformationFlag,
+                                          bool& missingWindowMessageHasBeenDisplayedInOut,
+                                          ImageWriteQueue& imageWriteQueue);
+        
         static BrainOpenGLFixedPipeline* createBrainOpenGL();
         
-        static void writeImage(const AString& imageFileName,
-                                  const int32_t imageIndex,
-                                  const unsigned char* imageContent,
-                                  const int32_t imageWidth,
-                                  const int32_t imageHeight);
+        static AString getImageFileNameForIndex(const AString& imageFileName,
+                                                const int32_t imageIndex);
+        
+        static void writeImage(const AString& outputName,
+                               const unsigned char* imageContent,
+                               const int32_t imageWidth,
+                               const int32_t imageHeight);
         
         static void estimateGraphicsSize(const SceneClass* windowSceneClass,
                                          float& estimatedWidthOut,
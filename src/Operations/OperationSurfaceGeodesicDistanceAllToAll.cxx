@@ -27,6 +27,8 @@
 #include "MetricFile.h"
 #include "SurfaceFile.h"
 
+#include <algorithm>
+
 using namespace caret;
 using namespace std;
 
@@ -58,6 +60,9 @@ OperationParameters* OperationSurfaceGeodesicDistanceAllToAll::getParameters()
     corrAreaOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
 
     ret->createOptionalParameter(6, "-naive", "use only neighbors, don't crawl triangles (not recommended)");
+    
+    OptionalParameter* memLimitOpt = ret->createOptionalParameter(7, "-mem-limit", "restrict memory usage");
+    memLimitOpt->addDoubleParameter(1, "limit-GB", "memory limit in gigabytes");
 
     ret->setHelpText(
         AString("Computes geodesic distance from every vertex to every vertex, outputting a single-hemisphere dconn file.  ") +
@@ -67,7 +72,9 @@ OperationParameters* OperationSurfaceGeodesicDistanceAllToAll::getParameters()
         "The -corrected-areas option should be used when the input is a group average surface - group average surfaces have " +
         "significantly less surface area than individual surfaces do, and therefore distances measured on them would be smaller than measuring them on individual surfaces.  " +
         "In this case, the input to this option should be a group average of the output of -surface-vertex-areas for each subject.\n\n" +
-        "If -naive is not specified, the algorithm uses not just immediate neighbors, but also neighbors derived from crawling across pairs of triangles that share an edge."
+        "If -naive is not specified, the algorithm uses not just immediate neighbors, but also neighbors derived from crawling across pairs of triangles that share an edge.\n\n" +
+        "Rows are computed in blocks and written to the output file in order while the next block is computed, so the full matrix never needs to fit in memory.  " +
+        "The -mem-limit option controls the size of these blocks, it does not include the output file itself when the output can't be written directly to disk."
     );
     return ret;
 }
@@ -82,7 +89,7 @@ void OperationSurfaceGeodesicDistanceAllToAll::useParameters(OperationParameters
     if (roiOpt->m_present)
     {
         MetricFile* roiMetric = roiOpt->getMetric(1);
-        if (roiMetric->getNumberOfNodes() != mySurf->getNumberOfNodes()) throw OperationException("corrected vertex areas metric does not match surface number of vertices");
+        if (roiMetric->getNumberOfNodes() != mySurf->getNumberOfNodes()) throw OperationException("roi metric does not match surface number of vertices");
         roiData = roiMetric->getValuePointerForColumn(0);
     }
     float distLimit = -1.0f;
@@ -105,6 +112,13 @@ void OperationSurfaceGeodesicDistanceAllToAll::useParameters(OperationParameters
         myHelp = mySurf->getGeodesicHelper();
     }
     bool naive = myParams->getOptionalParameter(6)->m_present;
+    float memLimitGB = -1.0f;
+    OptionalParameter* memLimitOpt = myParams->getOptionalParameter(7);
+    if (memLimitOpt->m_present)
+    {
+        memLimitGB = (float)memLimitOpt->getDouble(1);
+        if (memLimitGB < 0.0f) throw OperationException("memory limit cannot be negative");
+    }
     CiftiBrainModelsMap myMap;
     StructureEnum::Enum structure = mySurf->getStructure();
     myMap.addSurfaceModel(mySurf->getNumberOfNodes(), structure, roiData);
@@ -115,6 +129,22 @@ void OperationSurfaceGeodesicDistanceAllToAll::useParameters(OperationParameters
     myXML.setMap(CiftiXML::ALONG_ROW, myMap);
     myXML.setMap(CiftiXML::ALONG_COLUMN, myMap);
     ciftiOut->setCiftiXML(myXML);
+    int numThreads = 1;
+#ifdef CARET_OMP
+    numThreads = omp_get_max_threads();
+#endif
+    int64_t blockRows = 8 * numThreads;//plenty of rows per thread for dynamic scheduling to balance
+    if (memLimitGB >= 0.0f)
+    {//2 blocks of rows, plus the per-thread geodesic scratch arrays (about 8 values of 4 bytes per vertex, including the full-surface distance output)
+        int64_t helperBytes = numThreads * (int64_t)mySurf->getNumberOfNodes() * 8 * sizeof(float);
+        blockRows = ((int64_t)(memLimitGB * (1LL<<30)) - helperBytes) / (2 * mapLength * (int64_t)sizeof(float));
+        if (blockRows < 1) blockRows = 1;
+    }
+    blockRows = min(blockRows, mapLength);
+    int64_t numBlocks = (mapLength + blockRows - 1) / blockRows;
+    vector<float> blockStore[2];//compute into one while the other is written
+    blockStore[0].resize(blockRows * mapLength);
+    if (numBlocks > 1) blockStore[1].resize(blockRows * mapLength);
 #pragma omp CARET_PAR
     {
         CaretPointer<GeodesicHelper> privHelper;
@@ -124,30 +154,49 @@ void OperationSurfaceGeodesicDistanceAllToAll::useParameters(OperationParameters
         } else {
             privHelper = mySurf->getGeodesicHelper();
         }
-#pragma omp CARET_FOR schedule(dynamic)
-        for (int64_t i = 0; i < mapLength; ++i)
+        vector<float> outDists;
+        vector<int32_t> outNodes;
+        for (int64_t block = 0; block <= numBlocks; ++block)
         {
-            vector<float> outRow(mapLength, -1.0f), outDists;
-            vector<int32_t> outNodes;
-            if (distLimit > 0.0f)
-            {
-                privHelper->getNodesToGeoDist(surfMap[i].m_surfaceNode, distLimit, outNodes, outDists, !naive);
-                for (int j = 0; j < int(outNodes.size()); ++j)
-                {
-                    int64_t index = myMap.getIndexForNode(outNodes[j], structure);//-1 if outside ROI
-                    if (index >= 0) outRow[index] = outDists[j];
-                }
-            } else {
-                privHelper->getGeoFromNode(surfMap[i].m_surfaceNode, outDists, !naive);
-                for (int64_t j = 0; j < mapLength; ++j)
+            if (block > 0)
+            {//one thread writes the previous block in order, then joins the computation of this block
+#pragma omp CARET_SINGLE nowait
                 {
-                    outRow[j] = outDists[surfMap[j].m_surfaceNode];
+                    int64_t prevStart = (block - 1) * blockRows, prevEnd = min(prevStart + blockRows, mapLength);
+                    const float* prevData = blockStore[(block - 1) % 2].data();
+                    for (int64_t i = prevStart; i < prevEnd; ++i)
+                    {
+                        ciftiOut->setRow(prevData + (i - prevStart) * mapLength, i);
+                    }
                 }
             }
-#pragma omp critical
+            if (block < numBlocks)
             {
-                ciftiOut->setRow(outRow.data(), i);
+                int64_t blockStart = block * blockRows, blockEnd = min(blockStart + blockRows, mapLength);
+                float* blockData = blockStore[block % 2].data();
+#pragma omp CARET_FOR schedule(dynamic) nowait
+                for (int64_t i = blockStart; i < blockEnd; ++i)
+                {
+                    float* outRow = blockData + (i - blockStart) * mapLength;
+                    if (distLimit > 0.0f)
+                    {
+                        fill(outRow, outRow + mapLength, -1.0f);
+                        privHelper->getNodesToGeoDist(surfMap[i].m_surfaceNode, distLimit, outNodes, outDists, !naive);
+                        for (int j = 0; j < int(outNodes.size()); ++j)
+                        {
+                            int64_t index = myMap.getIndexForNode(outNodes[j], structure);//-1 if outside ROI
+                            if (index >= 0) outRow[index] = outDists[j];
+                        }
+                    } else {
+                        privHelper->getGeoFromNode(surfMap[i].m_surfaceNode, outDists, !naive);
+                        for (int64_t j = 0; j < mapLength; ++j)
+                        {
+                            outRow[j] = outDists[surfMap[j].m_surfaceNode];
+                        }
+                    }
+                }
             }
+#pragma omp barrier
         }
     }
 }
@@ -0,0 +1,119 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationVolumeToSurfaceApplyWeights.h"
+#include "OperationException.h"
+
+#include "MetricFile.h"
+#include "NiftiIO.h"
+#include "RibbonWeightMatrix.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString OperationVolumeToSurfaceApplyWeights::getCommandSwitch()
+{
+    return "-volume-to-surface-apply-weights";
+}
+
+AString OperationVolumeToSurfaceApplyWeights::getShortDescription()
+{
+    return "MAP VOLUME TO SURFACE WITH SAVED RIBBON WEIGHTS";
+}
+
+OperationParameters* OperationVolumeToSurfaceApplyWeights::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addStringParameter(1, "volume", "the volume file to map data from");//read one frame at a time rather than loading the whole file
+    
+    ret->addStringParameter(2, "weights", "the weights file from the -output-weights-matrix option of -volume-to-surface-mapping");
+    
+    ret->addMetricOutputParameter(3, "metric-out", "the output metric file");
+    
+    OptionalParameter* badVertOpt = ret->createOptionalParameter(4, "-bad-vertices-out", "output an ROI of which vertices don't have any voxel weights");
+    badVertOpt->addMetricOutputParameter(1, "roi-out", "the output metric file of vertices that have no data");
+    
+    ret->setHelpText(
+        AString("Maps every frame of a volume file to the surface using the ribbon constrained weights saved by -volume-to-surface-mapping, without computing them again.  ") +
+        "The volume file is read one frame at a time, so it does not need to fit in memory, and it must be in the same volume space as the volume used to compute the weights.  " +
+        "The output is the same as using -ribbon-constrained on this volume with the options that produced the weights file."
+    );
+    return ret;
+}
+
+void OperationVolumeToSurfaceApplyWeights::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    AString volumeName = myParams->getString(1);
+    AString weightsName = myParams->getString(2);
+    MetricFile* myMetricOut = myParams->getOutputMetric(3);
+    MetricFile* badVertices = NULL;
+    OptionalParameter* badVertOpt = myParams->getOptionalParameter(4);
+    if (badVertOpt->m_present)
+    {
+        badVertices = badVertOpt->getOutputMetric(1);
+    }
+    RibbonWeightMatrix myMatrix;
+    myMatrix.readFile(weightsName);
+    NiftiIO myIO;
+    myIO.openRead(volumeName);
+    const vector<int64_t>& myDims = myIO.getDimensions();
+    if (myDims.size() < 3) throw OperationException("input volume has fewer than 3 dimensions");
+    if (myIO.getNumComponents() != 1) throw OperationException("input volume must have only one component per voxel");
+    if (!myIO.getHeader().getVolumeSpace().matches(myMatrix.getVolumeSpace()))
+    {
+        throw OperationException("input volume is not in the same volume space as the weights");
+    }
+    int64_t numFrames = 1;
+    for (int i = 3; i < (int)myDims.size(); ++i)
+    {
+        numFrames *= myDims[i];
+    }
+    int64_t numNodes = myMatrix.getNumberOfVertices();
+    myMetricOut->setNumberOfNodesAndColumns(numNodes, numFrames);
+    myMetricOut->setStructure(myMatrix.getStructure());
+    vector<float> frame(myDims[0] * myDims[1] * myDims[2]), scratch(numNodes);
+    vector<int64_t> indexSelect(myDims.size() - 3, 0);//first of the non-spatial dimensions changes fastest, same as VolumeFile frames
+    for (int64_t thisCol = 0; thisCol < numFrames; ++thisCol)
+    {
+        myIO.readData(frame.data(), 3, indexSelect);
+        myMatrix.apply(frame.data(), scratch.data());
+        myMetricOut->setValuesForColumn(thisCol, scratch.data());
+        myMetricOut->setColumnName(thisCol, "frame " + AString::number(thisCol + 1) + " ribbon constrained");
+        for (int i = 0; i < (int)indexSelect.size(); ++i)
+        {
+            ++indexSelect[i];
+            if (indexSelect[i] < myDims[i + 3]) break;
+            indexSelect[i] = 0;
+        }
+    }
+    if (badVertices != NULL)
+    {
+        badVertices->setNumberOfNodesAndColumns(numNodes, 1);
+        badVertices->setStructure(myMatrix.getStructure());
+        for (int64_t i = 0; i < numNodes; ++i)
+        {
+            scratch[i] = (myMatrix.hasWeights(i) ? 0.0f : 1.0f);
+        }
+        badVertices->setValuesForColumn(0, scratch.data());
+    }
+}
@@ -30,6 +30,7 @@ namespace caret {
     struct CommandGlobalOptions
     {
         bool m_ciftiReadMemory = false;
+        bool m_niftiReadMmap = false;
         bool m_disableProvenance = false;
         int16_t m_volumeDType = NIFTI_TYPE_FLOAT32;
         int16_t m_ciftiDType = NIFTI_TYPE_FLOAT32;
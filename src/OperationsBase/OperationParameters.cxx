@@ -776,7 +776,7 @@ CiftiFile* ParameterComponent::getCifti(const int32_t key)
     {
         try
         {
-            myParam->lazyGet()->openFile(myParam->m_filename);
+            myParam->lazyGet()->openFile(myParam->m_filename, caret_global_command_options.m_niftiReadMmap);
             if (caret_global_command_options.m_ciftiReadMemory)
             {
                 myParam->m_parameter->convertToInMemory();
@@ -860,7 +860,8 @@ VolumeFile* ParameterComponent::getVolume(const int32_t key)
     {
         try
         {
-            myParam->lazyGet()->readFile(myParam->m_filename);
+            myParam->lazyGet()->setReadMemoryMapped(caret_global_command_options.m_niftiReadMmap);
+            myParam->m_parameter->readFile(myParam->m_filename);
             m_provHelper->addToProvenance(myParam->m_parameter->getFileMetaData(), myParam->m_filename);
         } catch (const bad_alloc&) {
             throw DataFileException(myParam->m_filename, CaretDataFileHelper::createBadAllocExceptionMessage(myParam->m_filename));
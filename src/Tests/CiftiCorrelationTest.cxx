@@ -0,0 +1,101 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiCorrelationTest.h"
+
+#include "AlgorithmCiftiCorrelation.h"
+#include "CiftiFile.h"
+#include "dot_wrapper.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+CiftiCorrelationTest::CiftiCorrelationTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void CiftiCorrelationTest::execute()
+{//compare the blocked correlation against one dsdot per pair of demeaned rows, the way it was computed before blocking
+    const int NUM_ROWS = 203, NUM_COLS = 37;//not multiples of the block sizes, so partial blocks and tiles are used
+    CiftiXML inXML;
+    inXML.setNumberOfDimensions(2);
+    CiftiBrainModelsMap colMap;
+    colMap.addSurfaceModel(NUM_ROWS, StructureEnum::CORTEX_LEFT);
+    CiftiSeriesMap rowMap;
+    rowMap.setLength(NUM_COLS);
+    inXML.setMap(CiftiXML::ALONG_COLUMN, colMap);
+    inXML.setMap(CiftiXML::ALONG_ROW, rowMap);
+    CiftiFile inFile;
+    inFile.setCiftiXML(inXML);
+    vector<vector<float> > demeaned(NUM_ROWS, vector<float>(NUM_COLS));
+    vector<double> rootResidSqr(NUM_ROWS);
+    vector<float> row(NUM_COLS);
+    for (int i = 0; i < NUM_ROWS; ++i)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < NUM_COLS; ++j)
+        {
+            row[j] = rand() / (float)RAND_MAX * 2.0f - 1.0f + (i % 7) * 0.1f;
+            sum += row[j];
+        }
+        inFile.setRow(row.data(), i);
+        float mean = sum / NUM_COLS;
+        for (int j = 0; j < NUM_COLS; ++j)
+        {
+            demeaned[i][j] = row[j] - mean;
+        }
+        rootResidSqr[i] = sqrt(dsdot(demeaned[i].data(), demeaned[i].data(), NUM_COLS));
+    }
+    const float memLimits[] = { -1.0f, 0.00005f };//everything at once, and a limit that forces several chunks
+    for (int test = 0; test < 2; ++test)
+    {
+        CiftiFile outFile;
+        AlgorithmCiftiCorrelation(NULL, &inFile, &outFile, NULL, false, memLimits[test]);
+        if (outFile.getNumberOfRows() != NUM_ROWS || outFile.getNumberOfColumns() != NUM_ROWS)
+        {
+            setFailed("correlation output has the wrong dimensions");
+            return;
+        }
+        vector<float> outRow(NUM_ROWS);
+        int numBad = 0;
+        float maxDiff = 0.0f;
+        for (int i = 0; i < NUM_ROWS; ++i)
+        {
+            outFile.getRow(outRow.data(), i);
+            for (int j = 0; j < NUM_ROWS; ++j)
+            {
+                double expected = 1.0;
+                if (i != j) expected = dsdot(demeaned[i].data(), demeaned[j].data(), NUM_COLS) / (rootResidSqr[i] * rootResidSqr[j]);
+                float diff = abs(outRow[j] - (float)expected);
+                if (!(diff <= 1e-5f)) ++numBad;//catch NaN
+                if (diff > maxDiff) maxDiff = diff;
+            }
+        }
+        if (numBad != 0)
+        {
+            setFailed(AString::number(numBad) + " correlation values differ from per-row dot products with memory limit " + AString::number(memLimits[test]) +
+                      ", max difference " + AString::number(maxDiff));
+        }
+    }
+}
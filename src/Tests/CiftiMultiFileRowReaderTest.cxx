@@ -0,0 +1,126 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiMultiFileRowReaderTest.h"
+
+#include "CiftiFile.h"
+#include "CiftiMultiFileRowReader.h"
+#include "ElapsedTimer.h"
+#include "SystemUtilities.h"
+
+#include <QFile>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+CiftiMultiFileRowReaderTest::CiftiMultiFileRowReaderTest(const AString& identifier, const bool& benchmark) : TestInterface(identifier, benchmark)
+{
+}
+
+void CiftiMultiFileRowReaderTest::execute()
+{//read the same chunks from several on-disk files, without and with reading ahead, check the values, and compare speed when benchmarking
+    const int64_t NUM_FILES = 4, NUM_ROWS = 1500, NUM_COLS = 2000, CHUNK_ROWS = 64;
+    const double MEBIBYTES = (NUM_FILES * NUM_ROWS * NUM_COLS * sizeof(float)) / (1024.0 * 1024.0);
+    AString baseName = SystemUtilities::getTempDirectory() + "/wb_ciftimultifilerowreader_" + SystemUtilities::createUniqueID();
+    vector<AString> inNames;
+    for (int64_t f = 0; f < NUM_FILES; ++f)
+    {
+        inNames.push_back(baseName + "_" + AString::number(f) + ".dscalar.nii");
+        CiftiXML inXML;
+        inXML.setNumberOfDimensions(2);
+        CiftiScalarsMap rowMap, colMap;
+        rowMap.setLength(NUM_COLS);
+        colMap.setLength(NUM_ROWS);
+        inXML.setMap(CiftiXML::ALONG_ROW, rowMap);
+        inXML.setMap(CiftiXML::ALONG_COLUMN, colMap);
+        CiftiFile inFile;
+        inFile.setWritingFile(inNames[f]);
+        inFile.setCiftiXML(inXML);
+        vector<float> row(NUM_COLS);
+        for (int64_t i = 0; i < NUM_ROWS; ++i)
+        {
+            for (int64_t j = 0; j < NUM_COLS; ++j)
+            {
+                row[j] = (f * NUM_ROWS + i) * NUM_COLS + j;//exactly representable in float32
+            }
+            inFile.setRow(row.data(), i);
+        }
+        inFile.close();
+    }
+    vector<unique_ptr<CiftiFile> > inFiles;
+    vector<const CiftiFile*> inFilePointers;
+    for (int64_t f = 0; f < NUM_FILES; ++f)
+    {
+        inFiles.push_back(unique_ptr<CiftiFile>(new CiftiFile()));
+        inFiles[f]->openFile(inNames[f]);
+        inFilePointers.push_back(inFiles[f].get());
+    }
+    for (int method = 0; method < 2; ++method)
+    {
+        CiftiMultiFileRowReader myReader(inFilePointers, vector<int64_t>(1, NUM_ROWS), CHUNK_ROWS, (method ? -1 : 0));
+        int64_t numBad = 0;
+        ElapsedTimer myTimer;
+        myTimer.start();
+        for (int64_t chunk = 0; chunk < myReader.getNumberOfChunks(); ++chunk)
+        {
+            for (int64_t f = 0; f < NUM_FILES; ++f)
+            {
+                shared_ptr<const CiftiMultiFileRowReader::Block> thisBlock = myReader.nextBlock();
+                if (thisBlock->m_chunkIndex != chunk || thisBlock->m_fileIndex != f)
+                {
+                    setFailed("block for chunk " + AString::number(thisBlock->m_chunkIndex) + ", file " + AString::number(thisBlock->m_fileIndex) +
+                              " returned when chunk " + AString::number(chunk) + ", file " + AString::number(f) + " was expected");
+                    break;
+                }
+                for (int64_t r = 0; r < thisBlock->m_numRows; ++r)
+                {
+                    const float* thisRow = thisBlock->getRow(r);
+                    int64_t i = thisBlock->m_firstRow + r;
+                    for (int64_t j = 0; j < NUM_COLS; ++j)
+                    {
+                        if (thisRow[j] != (f * NUM_ROWS + i) * NUM_COLS + j) ++numBad;
+                    }
+                }
+            }
+            if (failed()) break;
+        }
+        double seconds = myTimer.getElapsedTimeSeconds();
+        if (isBenchmark())
+        {
+            AString methodName = "no read ahead";
+            if (method) methodName = "read ahead " + AString::number(myReader.getBlocksAhead()) + " blocks";
+            cout << methodName.toStdString() << ": " << seconds << " seconds, " << MEBIBYTES / seconds << " MiB/s" << endl;
+        }
+        if (numBad != 0)
+        {
+            setFailed(AString::number(numBad) + " incorrect values with " + (method ? "reading ahead" : "no reading ahead"));
+        }
+        if (failed()) break;
+    }
+    for (int64_t f = 0; f < NUM_FILES; ++f)
+    {
+        inFiles[f]->close();
+        QFile::remove(inNames[f]);
+    }
+}
@@ -0,0 +1,269 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiParcellateTest.h"
+
+#include "AlgorithmCiftiParcellate.h"
+#include "CaretException.h"
+#include "CiftiFile.h"
+#include "GiftiLabelTable.h"
+#include "ReductionOperation.h"
+
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t NUM_VERTICES = 150;//more than one block of 64 rows
+    const int64_t NUM_MAPS = 1030;//more than one chunk of 1024 columns
+    const int NUM_KEYS = 4;//key 4 is in the label table, but no vertex uses it
+    const float EMPTY_FILL = -7.0f;
+    
+    void makeDataFile(CiftiFile& dataFile, const int& direction, const vector<vector<float> >& data)
+    {//data is [vertex][map]
+        CiftiXML dataXML;
+        dataXML.setNumberOfDimensions(2);
+        CiftiBrainModelsMap denseMap;
+        denseMap.addSurfaceModel(NUM_VERTICES, StructureEnum::CORTEX_LEFT);
+        CiftiScalarsMap mapsMap;
+        mapsMap.setLength(NUM_MAPS);
+        dataXML.setMap(direction, denseMap);
+        dataXML.setMap(1 - direction, mapsMap);
+        dataFile.setCiftiXML(dataXML);
+        if (direction == CiftiXML::ALONG_COLUMN)
+        {
+            for (int64_t i = 0; i < NUM_VERTICES; ++i)
+            {
+                dataFile.setRow(data[i].data(), i);
+            }
+        } else {
+            vector<float> row(NUM_VERTICES);
+            for (int64_t k = 0; k < NUM_MAPS; ++k)
+            {
+                for (int64_t i = 0; i < NUM_VERTICES; ++i)
+                {
+                    row[i] = data[i][k];
+                }
+                dataFile.setRow(row.data(), k);
+            }
+        }
+    }
+    
+    vector<vector<float> > getParcelValues(const CiftiFile& outFile, const int& direction)
+    {//[parcel][map]
+        int64_t numParcels = outFile.getCiftiXML().getDimensionLength(direction);
+        vector<vector<float> > ret(numParcels, vector<float>(NUM_MAPS));
+        if (direction == CiftiXML::ALONG_COLUMN)
+        {
+            for (int64_t p = 0; p < numParcels; ++p)
+            {
+                outFile.getRow(ret[p].data(), p);
+            }
+        } else {
+            vector<float> row(numParcels);
+            for (int64_t k = 0; k < NUM_MAPS; ++k)
+            {
+                outFile.getRow(row.data(), k);
+                for (int64_t p = 0; p < numParcels; ++p)
+                {
+                    ret[p][k] = row[p];
+                }
+            }
+        }
+        return ret;
+    }
+    
+    //the dense gather: each parcel's members in index order, reduced the same way as the general code path
+    vector<vector<float> > gatherParcellation(const vector<vector<float> >& data, const vector<int>& indexToParcel, const int& numParcels,
+                                              const vector<float>* weights, const ReductionEnum::Enum& method)
+    {
+        vector<vector<float> > ret(numParcels, vector<float>(NUM_MAPS, EMPTY_FILL));
+        vector<vector<int64_t> > members(numParcels);
+        for (int64_t j = 0; j < (int64_t)indexToParcel.size(); ++j)
+        {
+            if (indexToParcel[j] != -1) members[indexToParcel[j]].push_back(j);
+        }
+        for (int p = 0; p < numParcels; ++p)
+        {
+            int64_t numMembers = (int64_t)members[p].size();
+            if (numMembers == 0) continue;
+            vector<float> values(numMembers), memberWeights(numMembers);
+            for (int64_t m = 0; m < numMembers; ++m)
+            {
+                if (weights != NULL) memberWeights[m] = (*weights)[members[p][m]];
+            }
+            for (int64_t k = 0; k < NUM_MAPS; ++k)
+            {
+                for (int64_t m = 0; m < numMembers; ++m)
+                {
+                    values[m] = data[members[p][m]][k];
+                }
+                if (weights != NULL)
+                {
+                    ret[p][k] = ReductionOperation::reduceWeighted(values.data(), memberWeights.data(), numMembers, method);
+                } else {
+                    ret[p][k] = ReductionOperation::reduce(values.data(), numMembers, method);
+                }
+            }
+        }
+        return ret;
+    }
+    
+    void compareValues(TestInterface* test, const AString& condition, const vector<vector<float> >& sparse, const vector<vector<float> >& dense)
+    {//exactly equal, or both NaN
+        if (sparse.size() != dense.size())
+        {
+            test->setFailed(condition + ", sparse output has " + AString::number(sparse.size()) + " parcels, expected " + AString::number(dense.size()));
+            return;
+        }
+        for (size_t p = 0; p < sparse.size(); ++p)
+        {
+            for (int64_t k = 0; k < NUM_MAPS; ++k)
+            {
+                float sparseVal = sparse[p][k], denseVal = dense[p][k];
+                if (sparseVal != denseVal && !(sparseVal != sparseVal && denseVal != denseVal))
+                {
+                    test->setFailed(condition + ", parcel " + AString::number(p) + " map " + AString::number(k + 1) + " is " + AString::number(sparseVal) +
+                                    ", dense gather gives " + AString::number(denseVal));
+                    return;
+                }
+            }
+        }
+    }
+}
+
+CiftiParcellateTest::CiftiParcellateTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void CiftiParcellateTest::execute()
+{//MEAN and SUM on 2D files use a sparse matrix product, it must give exactly what gathering each parcel and reducing it gives
+    vector<float> labelCol(NUM_VERTICES), weightCol(NUM_VERTICES);
+    for (int64_t i = 0; i < NUM_VERTICES; ++i)
+    {
+        labelCol[i] = i % NUM_KEYS;//key 0 is unassigned, so those vertices are in no parcel
+        weightCol[i] = 0.5f + rand() / (float)RAND_MAX;
+    }
+    CiftiBrainModelsMap denseMap;
+    denseMap.addSurfaceModel(NUM_VERTICES, StructureEnum::CORTEX_LEFT);
+    CiftiFile labelFile, weightsFile;
+    {
+        CiftiXML labelXML;
+        labelXML.setNumberOfDimensions(2);
+        CiftiLabelsMap labelsMap;
+        labelsMap.setLength(1);
+        for (int key = 1; key <= NUM_KEYS; ++key)
+        {
+            labelsMap.getMapLabelTable(0)->setLabel(key, "parcel_" + AString::number(key), 1.0f, 1.0f, 1.0f, 1.0f);
+        }
+        labelXML.setMap(CiftiXML::ALONG_COLUMN, denseMap);
+        labelXML.setMap(CiftiXML::ALONG_ROW, labelsMap);
+        labelFile.setCiftiXML(labelXML);
+        labelFile.setColumn(labelCol.data(), 0);
+    }
+    {
+        CiftiXML weightsXML;
+        weightsXML.setNumberOfDimensions(2);
+        CiftiScalarsMap weightsMap;
+        weightsMap.setLength(1);
+        weightsXML.setMap(CiftiXML::ALONG_COLUMN, denseMap);
+        weightsXML.setMap(CiftiXML::ALONG_ROW, weightsMap);
+        weightsFile.setCiftiXML(weightsXML);
+        weightsFile.setColumn(weightCol.data(), 0);
+    }
+    try
+    {
+        checkDirection(CiftiXML::ALONG_COLUMN, labelFile, weightsFile);
+        checkDirection(CiftiXML::ALONG_ROW, labelFile, weightsFile);
+    } catch (CaretException& e) {
+        setFailed(e.whatString());
+    }
+}
+
+void CiftiParcellateTest::checkDirection(const int& direction, const CiftiFile& labelFile, const CiftiFile& weightsFile)
+{
+    vector<vector<float> > data(NUM_VERTICES, vector<float>(NUM_MAPS));
+    for (int64_t i = 0; i < NUM_VERTICES; ++i)
+    {
+        for (int64_t k = 0; k < NUM_MAPS; ++k)
+        {
+            data[i][k] = rand() / (float)RAND_MAX * 200.0f - 100.0f;
+        }
+    }
+    vector<float> weightCol(NUM_VERTICES);
+    weightsFile.getColumn(weightCol.data(), 0);
+    const ReductionEnum::Enum methods[2] = { ReductionEnum::MEAN, ReductionEnum::SUM };
+    AString directionName = (direction == CiftiXML::ALONG_COLUMN ? "along column" : "along row");
+    for (int nonfinite = 0; nonfinite < 2; ++nonfinite)
+    {
+        if (nonfinite)
+        {//vertices 6 and 10 have the same key, so that parcel also gets inf - inf, vertex 8 is in no parcel and must not affect anything
+            for (int64_t k = 0; k < NUM_MAPS; k += 3)
+            {
+                data[5][k] = numeric_limits<float>::quiet_NaN();
+                data[6][k] = numeric_limits<float>::infinity();
+                data[8][k] = numeric_limits<float>::quiet_NaN();
+            }
+            for (int64_t k = 0; k < NUM_MAPS; k += 2)
+            {
+                data[10][k] = -numeric_limits<float>::infinity();
+            }
+        }
+        CiftiFile dataFile;
+        makeDataFile(dataFile, direction, data);
+        vector<int> indexToParcel;
+        int numParcels = AlgorithmCiftiParcellate::parcellateMapping(&labelFile, dataFile.getCiftiXML().getBrainModelsMap(direction), indexToParcel).getLength();
+        if (numParcels != NUM_KEYS)
+        {
+            setFailed("parcellation has " + AString::number(numParcels) + " parcels, expected " + AString::number(NUM_KEYS) + ", including an empty one");
+            return;
+        }
+        for (int method = 0; method < 2; ++method)
+        {
+            for (int weighted = 0; weighted < 2; ++weighted)
+            {
+                AString condition = ReductionEnum::toName(methods[method]) + (weighted ? " weighted" : "") + (nonfinite ? " nonfinite" : "") + " parcellation " + directionName;
+                CiftiFile sparseOut, denseOut;
+                if (weighted)
+                {
+                    AlgorithmCiftiParcellate(NULL, &dataFile, &labelFile, direction, &sparseOut, &weightsFile, methods[method], -1.0f, -1.0f, false, false, EMPTY_FILL);
+                } else {
+                    AlgorithmCiftiParcellate(NULL, &dataFile, &labelFile, direction, &sparseOut, methods[method], -1.0f, -1.0f, false, false, EMPTY_FILL);
+                }
+                vector<vector<float> > sparseValues = getParcelValues(sparseOut, direction);
+                compareValues(this, condition, sparseValues, gatherParcellation(data, indexToParcel, numParcels, (weighted ? &weightCol : NULL), methods[method]));
+                if (!nonfinite)
+                {//-only-numeric doesn't use the sparse path, and doesn't change anything when everything is finite
+                    if (weighted)
+                    {
+                        AlgorithmCiftiParcellate(NULL, &dataFile, &labelFile, direction, &denseOut, &weightsFile, methods[method], -1.0f, -1.0f, true, false, EMPTY_FILL);
+                    } else {
+                        AlgorithmCiftiParcellate(NULL, &dataFile, &labelFile, direction, &denseOut, methods[method], -1.0f, -1.0f, true, false, EMPTY_FILL);
+                    }
+                    compareValues(this, condition + " compared to -only-numeric", sparseValues, getParcelValues(denseOut, direction));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,219 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiStatisticsExtensionTest.h"
+
+#include "CiftiFile.h"
+#include "CiftiStatisticsExtension.h"
+#include "FastStatistics.h"
+#include "Histogram.h"
+#include "SystemUtilities.h"
+#include "nifti2.h"
+
+#include <QFile>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct WriteStatisticsGuard
+    {//the setting is global, don't leave it on for the other tests, even if something throws
+        WriteStatisticsGuard() { CiftiFile::setWriteStatistics(true); }
+        ~WriteStatisticsGuard() { CiftiFile::setWriteStatistics(false); }
+    };
+
+    bool overwriteBytes(const AString& fileName, const int64_t& offset, const void* bytes, const int64_t& numBytes)
+    {//negative offset is from the end of the file
+        QFile myFile(fileName);
+        if (!myFile.open(QIODevice::ReadWrite)) return false;
+        if (!myFile.seek(offset < 0 ? myFile.size() + offset : offset)) return false;
+        return myFile.write((const char*)bytes, numBytes) == numBytes;
+    }
+
+    bool closeEnough(const float& a, const float& b)
+    {
+        if (a != a || b != b) return (a != a) && (b != b);
+        return abs(a - b) <= 1e-4f * max(1.0f, max(abs(a), abs(b)));
+    }
+
+    AString compareStatistics(const FastStatistics& expected, const FastStatistics& stored, const bool& checkPercentiles)
+    {
+        AString ret;
+        if (!closeEnough(expected.getMin(), stored.getMin())) ret += " min";
+        if (!closeEnough(expected.getMax(), stored.getMax())) ret += " max";
+        if (!closeEnough(expected.getMean(), stored.getMean())) ret += " mean";
+        if (!closeEnough(expected.getPopulationStdDev(), stored.getPopulationStdDev())) ret += " stdev";
+        if (!closeEnough(expected.getSampleStdDev(), stored.getSampleStdDev())) ret += " sample-stdev";
+        int64_t expectCounts[6], storedCounts[6];
+        expected.getCounts(expectCounts[0], expectCounts[1], expectCounts[2], expectCounts[3], expectCounts[4], expectCounts[5]);
+        stored.getCounts(storedCounts[0], storedCounts[1], storedCounts[2], storedCounts[3], storedCounts[4], storedCounts[5]);
+        for (int i = 0; i < 6; ++i)
+        {
+            if (expectCounts[i] != storedCounts[i]) ret += " count" + AString::number(i);
+        }
+        if (checkPercentiles)
+        {
+            const float percents[] = { 2.0f, 25.0f, 50.0f, 75.0f, 98.0f };
+            for (int i = 0; i < 5; ++i)
+            {
+                if (!closeEnough(expected.getApproxPositivePercentile(percents[i]), stored.getApproxPositivePercentile(percents[i])) ||
+                    !closeEnough(expected.getApproxNegativePercentile(percents[i]), stored.getApproxNegativePercentile(percents[i])) ||
+                    !closeEnough(expected.getApproxAbsolutePercentile(percents[i]), stored.getApproxAbsolutePercentile(percents[i])))
+                {
+                    ret += " percentile" + AString::number(percents[i]);
+                }
+            }
+        }
+        return ret;
+    }
+
+    AString compareHistograms(const Histogram& expected, const Histogram& stored)
+    {
+        AString ret;
+        if (expected.getHistogramCounts() != stored.getHistogramCounts()) ret += " buckets";
+        float expectMin, expectMax, storedMin, storedMax;
+        expected.getRange(expectMin, expectMax);
+        stored.getRange(storedMin, storedMax);
+        if (expectMin != storedMin || expectMax != storedMax) ret += " range";
+        return ret;
+    }
+}
+
+CiftiStatisticsExtensionTest::CiftiStatisticsExtensionTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void CiftiStatisticsExtensionTest::execute()
+{//write statistics with a file that has nonfinite values and zeros, and check them against what FastStatistics and Histogram compute from the data
+    const int64_t NUM_ROWS = 500, NUM_MAPS = 20;
+    AString baseName = SystemUtilities::getTempDirectory() + "/wb_ciftistatistics_" + SystemUtilities::createUniqueID();
+    AString streamName = baseName + "_stream.dscalar.nii", savedName = baseName + "_saved.dscalar.nii";
+    AString rowChangedName = baseName + "_rowchanged.dscalar.nii", slopeChangedName = baseName + "_slopechanged.dscalar.nii";
+    vector<float> allData(NUM_ROWS * NUM_MAPS);
+    for (int64_t i = 0; i < NUM_ROWS; ++i)
+    {
+        for (int64_t j = 0; j < NUM_MAPS; ++j)
+        {
+            float value = sin(i * 0.37f + j * 1.3f) * (j + 1) * 10.0f;
+            switch ((i * NUM_MAPS + j) % 97)
+            {
+                case 3: value = numeric_limits<float>::quiet_NaN(); break;
+                case 17: value = numeric_limits<float>::infinity(); break;
+                case 41: value = -numeric_limits<float>::infinity(); break;
+                case 60: case 61: value = 0.0f; break;
+                default: break;
+            }
+            allData[i * NUM_MAPS + j] = value;
+        }
+    }
+    WriteStatisticsGuard statisticsOn;
+    {
+        CiftiXML outXML;
+        outXML.setNumberOfDimensions(2);
+        CiftiScalarsMap rowMap, colMap;
+        rowMap.setLength(NUM_MAPS);
+        colMap.setLength(NUM_ROWS);
+        outXML.setMap(CiftiXML::ALONG_ROW, rowMap);
+        outXML.setMap(CiftiXML::ALONG_COLUMN, colMap);
+        CiftiFile outFile;
+        outFile.setWritingFile(streamName);
+        outFile.setCiftiXML(outXML);
+        for (int64_t i = 0; i < NUM_ROWS; ++i)
+        {
+            outFile.setRow(allData.data() + i * NUM_MAPS, i);
+        }
+        outFile.close();
+    }
+    {
+        CiftiFile checkFile;
+        checkFile.openFile(streamName);
+        const CiftiStatisticsExtension* stored = checkFile.getStoredStatistics();
+        if (stored == NULL)
+        {
+            setFailed("no statistics stored in streamed file");
+        } else {
+            FastStatistics expectStats(allData.data(), allData.size()), storedStats;
+            stored->getFileStatistics(storedStats);
+            AString mismatch = compareStatistics(expectStats, storedStats, true);
+            if (mismatch != "") setFailed("stored file statistics differ in:" + mismatch);
+            Histogram expectHist(CiftiStatisticsExtension::NUM_DISPLAY_BUCKETS, allData.data(), allData.size());
+            mismatch = compareHistograms(expectHist, stored->getFileHistogram());
+            if (mismatch != "") setFailed("stored file histogram differs in:" + mismatch);
+            if (!stored->hasMapSummaries())
+            {
+                setFailed("no map statistics stored for scalar file");
+            } else {
+                vector<float> mapData(NUM_ROWS);
+                for (int64_t j = 0; j < NUM_MAPS; ++j)
+                {
+                    for (int64_t i = 0; i < NUM_ROWS; ++i)
+                    {
+                        mapData[i] = allData[i * NUM_MAPS + j];
+                    }
+                    FastStatistics expectMapStats(mapData.data(), mapData.size()), storedMapStats;
+                    stored->getMapStatistics(j, storedMapStats);
+                    mismatch = compareStatistics(expectMapStats, storedMapStats, false);//map percentiles are coarse
+                    if (mismatch != "") setFailed("stored statistics of map " + AString::number(j) + " differ in:" + mismatch);
+                    Histogram expectMapHist(CiftiStatisticsExtension::NUM_DISPLAY_BUCKETS, mapData.data(), mapData.size());
+                    mismatch = compareHistograms(expectMapHist, stored->getMapHistogram(j));
+                    if (mismatch != "") setFailed("stored histogram of map " + AString::number(j) + " differs in:" + mismatch);
+                }
+            }
+        }
+        checkFile.convertToInMemory();
+        checkFile.writeFile(savedName);//the path wb_view uses to save
+        checkFile.setRow(allData.data(), 0);
+        if (checkFile.getStoredStatistics() != NULL) setFailed("stored statistics not dropped after modifying data");
+        checkFile.close();
+    }
+    {
+        CiftiFile savedFile;
+        savedFile.openFile(savedName);
+        if (savedFile.getStoredStatistics() == NULL) setFailed("no statistics stored in saved file");
+        savedFile.close();
+    }
+    QFile::copy(savedName, rowChangedName);
+    QFile::copy(savedName, slopeChangedName);
+    float changedValue = 12345.0f;//the data ends the file, so this changes the last value of the last row
+    double changedSlope = 2.0;//files are written in native byte order
+    if (!overwriteBytes(rowChangedName, -(int64_t)sizeof(changedValue), &changedValue, sizeof(changedValue)) ||
+        !overwriteBytes(slopeChangedName, offsetof(nifti_2_header, scl_slope), &changedSlope, sizeof(changedSlope)))
+    {
+        setFailed("failed to modify copies of saved file");
+    } else {
+        CiftiFile rowChangedFile, slopeChangedFile;
+        rowChangedFile.openFile(rowChangedName);
+        if (rowChangedFile.getStoredStatistics() != NULL) setFailed("stored statistics used after data was changed by another program");
+        rowChangedFile.close();
+        slopeChangedFile.openFile(slopeChangedName);
+        if (slopeChangedFile.getStoredStatistics() != NULL) setFailed("stored statistics used after scaling was changed by another program");
+        slopeChangedFile.close();
+    }
+    QFile::remove(streamName);
+    QFile::remove(savedName);
+    QFile::remove(rowChangedName);
+    QFile::remove(slopeChangedName);
+}
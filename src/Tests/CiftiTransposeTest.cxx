@@ -0,0 +1,115 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiTransposeTest.h"
+
+#include "AlgorithmCiftiTranspose.h"
+#include "CiftiFile.h"
+#include "ElapsedTimer.h"
+#include "SystemUtilities.h"
+
+#include <QFile>
+
+#include <iostream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+CiftiTransposeTest::CiftiTransposeTest(const AString& identifier, const bool& benchmark) : TestInterface(identifier, benchmark)
+{
+}
+
+void CiftiTransposeTest::execute()
+{//transpose an on-disk matrix with a memory limit much smaller than it, with both implementations, and compare speed when benchmarking
+    const int64_t NUM_ROWS = 2000, NUM_COLS = 3000;
+    const int64_t MEM_LIMIT = 2 * 1024 * 1024;
+    const double MEBIBYTES = (NUM_ROWS * NUM_COLS * sizeof(float)) / (1024.0 * 1024.0);
+    AString baseName = SystemUtilities::getTempDirectory() + "/wb_ciftitranspose_" + SystemUtilities::createUniqueID();
+    AString inName = baseName + "_in.dconn.nii";
+    {
+        CiftiXML inXML;
+        inXML.setNumberOfDimensions(2);
+        CiftiScalarsMap rowMap, colMap;
+        rowMap.setLength(NUM_COLS);
+        colMap.setLength(NUM_ROWS);
+        inXML.setMap(CiftiXML::ALONG_ROW, rowMap);
+        inXML.setMap(CiftiXML::ALONG_COLUMN, colMap);
+        CiftiFile inFile;
+        inFile.setWritingFile(inName);
+        inFile.setCiftiXML(inXML);
+        vector<float> row(NUM_COLS);
+        for (int64_t i = 0; i < NUM_ROWS; ++i)
+        {
+            for (int64_t j = 0; j < NUM_COLS; ++j)
+            {
+                row[j] = i * NUM_COLS + j;//exactly representable in float32
+            }
+            inFile.setRow(row.data(), i);
+        }
+        inFile.close();
+    }
+    CiftiFile inFile;
+    inFile.openFile(inName);
+    for (int method = 0; method < 2; ++method)
+    {
+        AString outName = baseName + (method ? "_external" : "_reread") + ".dconn.nii";
+        {
+            CiftiFile outFile;
+            outFile.setWritingFile(outName);
+            CiftiXML outXML;
+            outXML.setNumberOfDimensions(2);
+            outXML.setMap(CiftiXML::ALONG_ROW, *(inFile.getCiftiXML().getMap(CiftiXML::ALONG_COLUMN)));
+            outXML.setMap(CiftiXML::ALONG_COLUMN, *(inFile.getCiftiXML().getMap(CiftiXML::ALONG_ROW)));
+            outFile.setCiftiXML(outXML);
+            ElapsedTimer myTimer;
+            myTimer.start();
+            if (method)
+            {
+                AlgorithmCiftiTranspose::transposeExternal(&inFile, &outFile, MEM_LIMIT);
+            } else {
+                AlgorithmCiftiTranspose::transposeRereading(&inFile, &outFile, MEM_LIMIT);
+            }
+            outFile.close();
+            double seconds = myTimer.getElapsedTimeSeconds();
+            if (isBenchmark()) cout << (method ? "external" : "rereading") << " transpose: " << seconds << " seconds, " << MEBIBYTES / seconds << " MiB/s" << endl;
+        }
+        CiftiFile checkFile;
+        checkFile.openFile(outName);
+        vector<float> row(NUM_ROWS);
+        int64_t numBad = 0;
+        for (int64_t j = 0; j < NUM_COLS; ++j)
+        {
+            checkFile.getRow(row.data(), j);
+            for (int64_t i = 0; i < NUM_ROWS; ++i)
+            {
+                if (row[i] != i * NUM_COLS + j) ++numBad;
+            }
+        }
+        checkFile.close();
+        QFile::remove(outName);
+        if (numBad != 0)
+        {
+            setFailed(AString::number(numBad) + " incorrect values from " + (method ? "external" : "rereading") + " transpose");
+        }
+    }
+    inFile.close();
+    QFile::remove(inName);
+}
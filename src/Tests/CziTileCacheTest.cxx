@@ -0,0 +1,143 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CziTileCacheTest.h"
+
+#include "CziSubBlockCache.h"
+#include "ElapsedTimer.h"
+#include "FileInformation.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace caret;
+using namespace std;
+
+CziTileCacheTest::CziTileCacheTest(const AString& identifier, const bool& benchmark): TestInterface(identifier, benchmark)
+{
+}
+
+namespace
+{
+    struct ViewStep
+    {
+        libCZI::IntRect m_roi;
+        float m_zoom;
+    };
+    
+    //zoom in toward the center of the image, pan right and back down, then zoom out, like a user exploring a slide
+    vector<ViewStep> makeViewPath(const libCZI::IntRect& bounds, const int outputDimension)
+    {
+        vector<ViewStep> ret;
+        const int NUM_ZOOM = 6, NUM_PAN = 16;
+        double centerX = bounds.x + bounds.w / 2.0, centerY = bounds.y + bounds.h / 2.0;
+        double width = bounds.w, height = bounds.h;
+        vector<ViewStep> zoomSteps;
+        for (int i = 0; i < NUM_ZOOM && width >= outputDimension; ++i)
+        {
+            ViewStep step;
+            step.m_roi = libCZI::IntRect{ (int)(centerX - width / 2), (int)(centerY - height / 2), (int)width, (int)height };
+            step.m_zoom = min(1.0f, (float)(outputDimension / max(width, height)));
+            zoomSteps.push_back(step);
+            width /= 2.0;
+            height /= 2.0;
+        }
+        ret = zoomSteps;
+        const ViewStep deepest = zoomSteps.back();
+        for (int i = 1; i <= NUM_PAN; ++i)
+        {
+            ViewStep step = deepest;
+            if (i <= NUM_PAN / 2)
+            {
+                step.m_roi.x += i * deepest.m_roi.w / 4;
+            } else {
+                step.m_roi.x += (NUM_PAN / 2) * deepest.m_roi.w / 4;
+                step.m_roi.y += (i - NUM_PAN / 2) * deepest.m_roi.h / 4;
+            }
+            ret.push_back(step);
+        }
+        ret.insert(ret.end(), zoomSteps.rbegin(), zoomSteps.rend());
+        return ret;
+    }
+}
+
+void CziTileCacheTest::execute()
+{//replays a pan/zoom path over a CZI file, set WB_TEST_CZI_FILE to use a file other than the default
+    AString fileName = m_default_path + "/czi/sample.czi";
+    const char* envFile = getenv("WB_TEST_CZI_FILE");
+    if (envFile != NULL && strlen(envFile) > 0) fileName = envFile;
+    if (!FileInformation(fileName).exists())
+    {
+        cout << "czi file '" << fileName << "' not found, skipping tile cache test" << endl;
+        return;
+    }
+    shared_ptr<libCZI::ICZIReader> reader = libCZI::CreateCZIReader();
+    reader->Open(libCZI::CreateStreamFromFile(fileName.toStdWString().c_str()));
+    const libCZI::IntRect bounds = reader->GetStatistics().boundingBox;
+    const vector<ViewStep> path = makeViewPath(bounds, 2048);
+    libCZI::CDimCoordinate coordinate;
+    coordinate.Set(libCZI::DimensionIndex::C, 0);
+    const vector<libCZI::CDimCoordinate> planeCoordinates(1, coordinate);
+    vector<shared_ptr<libCZI::IBitmapData> > reference;
+    const char* modeNames[3] = { "uncached", "cached", "cached with prefetch" };
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        shared_ptr<CziSubBlockCache> cache(new CziSubBlockCache(reader, (mode == 0 ? 0 : CziSubBlockCache::DEFAULT_MEMORY_BUDGET_BYTES)));
+        shared_ptr<libCZI::ISingleChannelScalingTileAccessor> accessor = dynamic_pointer_cast<libCZI::ISingleChannelScalingTileAccessor>(
+            libCZI::CreateAccesor(cache, libCZI::AccessorType::SingleChannelScalingTileAccessor));
+        double readSeconds = 0.0;
+        for (size_t i = 0; i < path.size(); ++i)
+        {
+            ElapsedTimer myTimer;
+            myTimer.start();
+            shared_ptr<libCZI::IBitmapData> bitmap = accessor->Get(libCZI::PixelType::Bgr24, path[i].m_roi, &coordinate, path[i].m_zoom, NULL);
+            readSeconds += myTimer.getElapsedTimeSeconds();
+            if (mode == 2)
+            {//the user looks at each view for a while, which is when prefetching happens
+                cache->prefetchNeighbors(path[i].m_roi, planeCoordinates, path[i].m_zoom);
+                cache->waitForPrefetching();
+            }
+            if (mode == 0)
+            {
+                reference.push_back(bitmap);
+                continue;
+            }
+            libCZI::BitmapLockInfo refLock = reference[i]->Lock(), testLock = bitmap->Lock();
+            bool same = (reference[i]->GetWidth() == bitmap->GetWidth() && reference[i]->GetHeight() == bitmap->GetHeight());
+            for (uint32_t row = 0; same && row < bitmap->GetHeight(); ++row)
+            {
+                same = (memcmp((const char*)refLock.ptrDataRoi + row * refLock.stride, (const char*)testLock.ptrDataRoi + row * testLock.stride, bitmap->GetWidth() * 3) == 0);
+            }
+            reference[i]->Unlock();
+            bitmap->Unlock();
+            if (!same) setFailed(AString(modeNames[mode]) + " read of view " + AString::number(i) + " differs from uncached read");
+        }
+        if (isBenchmark())
+        {
+            CziSubBlockCache::Statistics stats = cache->getStatistics();
+            int64_t numTiles = stats.m_hitCount + stats.m_missCount;
+            cout << modeNames[mode] << ": " << path.size() << " views, " << numTiles / readSeconds << " tiles/s, "
+                 << path.size() / readSeconds << " views/s, hit rate " << (numTiles > 0 ? 100.0 * stats.m_hitCount / numTiles : 0.0) << "%, "
+                 << stats.m_prefetchCount << " prefetched, " << stats.m_evictionCount << " evicted, " << stats.m_bytesUsed / (1024 * 1024) << " MiB cached" << endl;
+        }
+    }
+    reader->Close();
+}
@@ -19,15 +19,26 @@
 /*LICENSE_END*/
 #include "GeodesicHelperTest.h"
 
+#include "AlgorithmMetricDilate.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "CaretException.h"
+#include "ElapsedTimer.h"
+#include "FastStatistics.h"
 #include "GeodesicHelper.h"
+#include "GeodesicNeighborhoodIndex.h"
+#include "MetricFile.h"
+#include "MetricSmoothingObject.h"
 #include "SurfaceFile.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <iostream>
 
 using namespace caret;
 using namespace std;
 
-GeodesicHelperTest::GeodesicHelperTest(const AString& identifier): TestInterface(identifier)
+GeodesicHelperTest::GeodesicHelperTest(const AString& identifier, const bool& benchmark): TestInterface(identifier, benchmark)
 {
 }
 
@@ -96,4 +107,182 @@ void GeodesicHelperTest::execute()
         checkNodeLists(this, "Comparing normal to quarter areas, getPathFollowingData", nodesNorm, nodesQuarter);
         checkNodeLists(this, "Comparing normal to quad areas, getPathFollowingData", nodesNorm, nodesQuad);
     }
+    if (!failed()) checkNeighborhoodIndex(mySurf);
+    if (!failed()) checkDilateLegacyCutoff();
+    if (!failed()) checkSmoothingReuse();
+    if (isBenchmark() && !failed()) benchmark();
+}
+
+void GeodesicHelperTest::checkNeighborhoodIndex(const SurfaceFile& mySurf)
+{
+    const float INDEX_DIST = 6.0f, SMALLER_DIST = 3.5f;
+    CaretPointer<const GeodesicNeighborhoodIndex> myIndex = mySurf.getGeodesicNeighborhoodIndex(INDEX_DIST);
+    CaretPointer<GeodesicHelper> myHelp = mySurf.getGeodesicHelper();
+    int32_t numNodes = mySurf.getNumberOfNodes();
+    vector<float> distsIndex, distsHelp;
+    vector<int32_t> nodesIndex, nodesHelp;
+    const int TEST_SAMPLES = 100;
+    for (int i = 0; !failed() && i < TEST_SAMPLES; ++i)
+    {
+        int32_t startNode = rand() % numNodes;
+        myIndex->getNodesToGeoDist(startNode, INDEX_DIST, nodesIndex, distsIndex);
+        myHelp->getNodesToGeoDist(startNode, INDEX_DIST, nodesHelp, distsHelp);
+        checkNodeLists(this, "Comparing neighborhood index to helper, full radius", nodesIndex, nodesHelp);
+        myIndex->getNodesToGeoDist(startNode, SMALLER_DIST, nodesIndex, distsIndex);
+        myHelp->getNodesToGeoDist(startNode, SMALLER_DIST, nodesHelp, distsHelp);
+        sort(nodesIndex.begin(), nodesIndex.end());//vertices at exactly the same distance may come out in a different order
+        sort(nodesHelp.begin(), nodesHelp.end());
+        checkNodeLists(this, "Comparing neighborhood index to helper, smaller radius", nodesIndex, nodesHelp);
+    }
+    vector<float> areas;
+    mySurf.computeNodeAreas(areas);
+    if (mySurf.getGeodesicNeighborhoodIndex(SMALLER_DIST, areas.data()) != myIndex)
+    {
+        setFailed("surface did not reuse cached neighborhoods for a smaller radius and its own vertex areas");
+    }
+    if (mySurf.findGeodesicNeighborhoodIndex(INDEX_DIST * 2.0f) != NULL)
+    {
+        setFailed("surface returned cached neighborhoods that are too small");
+    }
+}
+
+void GeodesicHelperTest::checkDilateLegacyCutoff()
+{//a vertex pulled far off the sphere has only long edges, so the legacy cutoff from its nearest good vertex is far larger than any cached neighborhoods
+    SurfaceFile indexedSurf, plainSurf;
+    AlgorithmSurfaceCreateSphere(NULL, 2562, &indexedSurf);
+    AlgorithmSurfaceCreateSphere(NULL, 2562, &plainSurf);
+    int32_t numNodes = indexedSurf.getNumberOfNodes();
+    const int32_t farNode = numNodes / 2;
+    const float* farCoord = indexedSurf.getCoordinate(farNode);
+    const float farX = farCoord[0] * 5.0f, farY = farCoord[1] * 5.0f, farZ = farCoord[2] * 5.0f;
+    indexedSurf.setCoordinate(farNode, farX, farY, farZ);
+    plainSurf.setCoordinate(farNode, farX, farY, farZ);
+    const float DILATE_DIST = 1.0f;
+    FastStatistics spacingStats;
+    indexedSurf.getNodesSpacingStatistics(spacingStats);
+    CaretPointer<const GeodesicNeighborhoodIndex> myIndex = indexedSurf.getGeodesicNeighborhoodIndex(2.0f * max(2.0f * DILATE_DIST, 2.0f * spacingStats.getMean()));//large enough for dilate to reuse
+    MetricFile input, badRoi;
+    input.setNumberOfNodesAndColumns(numNodes, 1);
+    badRoi.setNumberOfNodesAndColumns(numNodes, 1);
+    vector<float> column(numNodes), roiColumn(numNodes, 0.0f);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        column[i] = 1.0f + ((float)rand()) / RAND_MAX;
+    }
+    column[farNode] = 0.0f;
+    roiColumn[farNode] = 1.0f;
+    input.setValuesForColumn(0, column.data());
+    badRoi.setValuesForColumn(0, roiColumn.data());
+    for (int useRoi = 0; useRoi < 2; ++useRoi)//without a bad vertex roi, each column is dilated directly, with it, stencils are precomputed
+    {
+        const MetricFile* roiPtr = (useRoi ? &badRoi : NULL);
+        AString condition = AString("legacy cutoff dilation") + (useRoi ? " with bad vertex roi" : "");
+        MetricFile indexedOut, plainOut;
+        try
+        {
+            AlgorithmMetricDilate(NULL, &input, &indexedSurf, DILATE_DIST, &indexedOut, roiPtr, NULL, -1, AlgorithmMetricDilate::WEIGHTED, 6.0f, NULL, true);
+            AlgorithmMetricDilate(NULL, &input, &plainSurf, DILATE_DIST, &plainOut, roiPtr, NULL, -1, AlgorithmMetricDilate::WEIGHTED, 6.0f, NULL, true);
+        } catch (CaretException& e) {
+            setFailed(condition + " threw: " + e.whatString());
+            return;
+        }
+        const float* indexedData = indexedOut.getValuePointerForColumn(0), *plainData = plainOut.getValuePointerForColumn(0);
+        if (!(indexedData[farNode] >= 1.0f && indexedData[farNode] <= 2.0f))
+        {
+            setFailed(condition + ", far vertex was not dilated, got " + AString::number(indexedData[farNode]));
+        }
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            if (indexedData[i] != plainData[i])
+            {
+                setFailed(condition + ", output with cached neighborhoods differs at vertex " + AString::number(i));
+                break;
+            }
+        }
+    }
+    if (indexedSurf.findGeodesicNeighborhoodIndex(myIndex->getMaxDistance()) != myIndex)
+    {
+        setFailed("surface lost its cached neighborhoods during dilation");
+    }
+}
+
+void GeodesicHelperTest::checkSmoothingReuse()
+{//smoothing should give the same answer with or without cached neighborhoods, and not add any to the surface itself
+    SurfaceFile indexedSurf, plainSurf;
+    AlgorithmSurfaceCreateSphere(NULL, 2562, &indexedSurf);
+    AlgorithmSurfaceCreateSphere(NULL, 2562, &plainSurf);
+    int32_t numNodes = indexedSurf.getNumberOfNodes();
+    const float KERNEL = 4.0f;
+    CaretPointer<const GeodesicNeighborhoodIndex> myIndex = indexedSurf.getGeodesicNeighborhoodIndex(KERNEL * 3.0f);
+    MetricFile input, roi;
+    input.setNumberOfNodesAndColumns(numNodes, 1);
+    roi.setNumberOfNodesAndColumns(numNodes, 1);
+    vector<float> column(numNodes), roiColumn(numNodes);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        column[i] = ((float)rand()) / RAND_MAX;
+        roiColumn[i] = (indexedSurf.getCoordinate(i)[2] > 0.0f ? 1.0f : 0.0f);//half the sphere
+    }
+    input.setValuesForColumn(0, column.data());
+    roi.setValuesForColumn(0, roiColumn.data());
+    const MetricSmoothingObject::Method methods[3] = { MetricSmoothingObject::GEO_GAUSS_AREA, MetricSmoothingObject::GEO_GAUSS_EQUAL, MetricSmoothingObject::GEO_GAUSS };
+    for (int method = 0; method < 3 && !failed(); ++method)
+    {
+        for (int useRoi = 0; useRoi < 2 && !failed(); ++useRoi)
+        {
+            const MetricFile* roiPtr = (useRoi ? &roi : NULL);
+            AString condition = "smoothing method " + AString::number(method) + (useRoi ? " with roi" : "");
+            MetricFile indexedOut, plainOut;
+            MetricSmoothingObject(&indexedSurf, KERNEL, roiPtr, methods[method]).smoothColumn(&input, 0, &indexedOut, roiPtr);
+            MetricSmoothingObject(&plainSurf, KERNEL, roiPtr, methods[method]).smoothColumn(&input, 0, &plainOut, roiPtr);
+            const float* indexedData = indexedOut.getValuePointerForColumn(0), *plainData = plainOut.getValuePointerForColumn(0);
+            for (int32_t i = 0; i < numNodes; ++i)
+            {
+                if (abs(indexedData[i] - plainData[i]) > 0.00001f)//vertices at the same distance may be summed in a different order
+                {
+                    setFailed(condition + ", output with cached neighborhoods differs at vertex " + AString::number(i));
+                    break;
+                }
+            }
+            if (plainSurf.findGeodesicNeighborhoodIndex(0.0f) != NULL)
+            {
+                setFailed(condition + ", smoothing cached neighborhoods on the surface");
+            }
+        }
+    }
+}
+
+void GeodesicHelperTest::benchmark()
+{//per-query timing on a sphere with the same vertex count as the 164k fs_LR mesh
+    SurfaceFile sphere;
+    AlgorithmSurfaceCreateSphere(NULL, 163842, &sphere);
+    int32_t numNodes = sphere.getNumberOfNodes();
+    ElapsedTimer myTimer;
+    myTimer.start();
+    CaretPointer<GeodesicHelperBase> myBase(new GeodesicHelperBase(&sphere));
+    cout << "geodesic base for " << numNodes << " vertices: " << myTimer.getElapsedTimeSeconds() << " seconds" << endl;
+    myTimer.start();
+    GeodesicNeighborhoodIndex myIndex(&sphere, 5.0f);
+    cout << "geodesic neighborhoods to 5mm for all vertices: " << myTimer.getElapsedTimeSeconds() << " seconds, "
+         << myIndex.getMemoryUsage() / 1048576 << " MiB" << endl;
+    GeodesicHelper myHelp(myBase);
+    const int NUM_LIMITED = 200, NUM_FULL = 10;
+    const float LIMIT_DIST = 10.0f;//radius 100 sphere, so about 10 vertices across
+    vector<int32_t> nodes;
+    vector<float> dists, fullDists(numNodes);
+    int64_t totalFound = 0;
+    myTimer.start();
+    for (int i = 0; i < NUM_LIMITED; ++i)
+    {
+        myHelp.getNodesToGeoDist(rand() % numNodes, LIMIT_DIST, nodes, dists);
+        totalFound += nodes.size();
+    }
+    cout << "getNodesToGeoDist to " << LIMIT_DIST << "mm: " << myTimer.getElapsedTimeSeconds() * 1000.0 / NUM_LIMITED << " ms per query, "
+         << totalFound / NUM_LIMITED << " vertices per query" << endl;
+    myTimer.start();
+    for (int i = 0; i < NUM_FULL; ++i)
+    {
+        myHelp.getGeoFromNode(rand() % numNodes, fullDists.data());
+    }
+    cout << "getGeoFromNode, whole surface: " << myTimer.getElapsedTimeSeconds() * 1000.0 / NUM_FULL << " ms per query" << endl;
 }
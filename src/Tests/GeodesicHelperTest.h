@@ -24,10 +24,16 @@
 
 namespace caret {
 
+    class SurfaceFile;
+
     class GeodesicHelperTest : public TestInterface
     {
+        void benchmark();
+        void checkNeighborhoodIndex(const SurfaceFile& mySurf);
+        void checkDilateLegacyCutoff();
+        void checkSmoothingReuse();
     public:
-        GeodesicHelperTest(const AString& identifier);
+        GeodesicHelperTest(const AString& identifier, const bool& benchmark = false);//benchmark adds timing on a 164k vertex sphere
         virtual void execute();
     };
 
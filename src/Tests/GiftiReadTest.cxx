@@ -0,0 +1,252 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GiftiReadTest.h"
+
+#include "ElapsedTimer.h"
+#include "GiftiDataArray.h"
+#include "GiftiEncodedDataDecoder.h"
+#include "GiftiException.h"
+#include "GiftiFile.h"
+#include "GiftiFileSaxReader.h"
+#include "SystemUtilities.h"
+#include "XmlSaxParser.h"
+
+#include <QFile>
+
+#ifndef CARET_OS_WINDOWS
+#include <sys/resource.h>
+#endif
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    float testValue(const int64_t& map, const int64_t& vertex)
+    {
+        return ((vertex * 7919 + map * 104729) % 1000003) / 8.0f;//exactly representable, and not too compressible
+    }
+
+    double getPeakMemoryMiB()
+    {//peak only ever grows, so this shows the largest use so far, -1 if unknown
+#ifdef CARET_OS_WINDOWS
+        return -1.0;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return -1.0;
+#ifdef CARET_OS_MACOSX
+        return usage.ru_maxrss / (1024.0 * 1024.0);//bytes
+#else
+        return usage.ru_maxrss / 1024.0;//kilobytes
+#endif
+#endif
+    }
+
+    string encodeBase64(const vector<unsigned char>& bytes)
+    {//with "=" padding, so a remainder of 1 byte ends in "==" and 2 bytes end in "="
+        const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        const int64_t length = (int64_t)bytes.size();
+        string ret;
+        for (int64_t i = 0; i < length; i += 3)
+        {
+            uint32_t bits = ((uint32_t)bytes[i]) << 16;
+            if (i + 1 < length) bits |= ((uint32_t)bytes[i + 1]) << 8;
+            if (i + 2 < length) bits |= bytes[i + 2];
+            ret += table[(bits >> 18) & 63];
+            ret += table[(bits >> 12) & 63];
+            ret += (i + 1 < length ? table[(bits >> 6) & 63] : '=');
+            ret += (i + 2 < length ? table[bits & 63] : '=');
+        }
+        return ret;
+    }
+}
+
+GiftiReadTest::GiftiReadTest(const AString& identifier, const bool& benchmark) : TestInterface(identifier, benchmark)
+{
+}
+
+void GiftiReadTest::checkDecoderChunks()
+{//short arrays with every remainder, delivered in pieces that split groups of 4 characters (including padding) across calls, with and without line breaks
+    const int64_t chunkSizes[] = { 1, 2, 3, 5, 7, 0 };//0 is all at once
+    const int numChunkSizes = sizeof(chunkSizes) / sizeof(chunkSizes[0]);
+    GiftiEncodingEnum::Enum encodings[2] = { GiftiEncodingEnum::BASE64_BINARY, GiftiEncodingEnum::GZIP_BASE64_BINARY };
+    for (int e = 0; e < 2; ++e)
+    {
+        for (int64_t length = 1; length <= 11; ++length)
+        {
+            vector<unsigned char> original(length), encoded;
+            for (int64_t i = 0; i < length; ++i)
+            {
+                original[i] = (unsigned char)(rand() % 256);
+            }
+            if (encodings[e] == GiftiEncodingEnum::GZIP_BASE64_BINARY)
+            {
+                uLongf compressedSize = compressBound(length);
+                encoded.resize(compressedSize);
+                if (compress(encoded.data(), &compressedSize, original.data(), length) != Z_OK)
+                {
+                    setFailed("zlib failed to compress test data");
+                    return;
+                }
+                encoded.resize(compressedSize);
+            } else {
+                encoded = original;
+            }
+            const string plainText = encodeBase64(encoded);
+            for (int wrapped = 0; wrapped < 2; ++wrapped)
+            {
+                string text;
+                for (size_t i = 0; i < plainText.size(); ++i)
+                {
+                    text += plainText[i];
+                    if (wrapped && i % 9 == 8) text += "\n";//not a multiple of 4, so line breaks fall inside groups
+                }
+                for (int c = 0; c < numChunkSizes; ++c)
+                {
+                    const int64_t chunkSize = (chunkSizes[c] == 0 ? (int64_t)text.size() : chunkSizes[c]);
+                    AString condition = GiftiEncodingEnum::toName(encodings[e]) + ", " + AString::number(length) + " bytes, " +
+                                        AString::number(chunkSize) + " characters per piece" + (wrapped ? ", with line breaks" : "");
+                    vector<uint8_t> output(length, 0);
+                    try
+                    {
+                        GiftiEncodedDataDecoder decoder(encodings[e], output.data(), length);
+                        for (int64_t pos = 0; pos < (int64_t)text.size(); pos += chunkSize)
+                        {
+                            decoder.addText(text.data() + pos, min(chunkSize, (int64_t)text.size() - pos));
+                        }
+                        decoder.finish();
+                    } catch (GiftiException& ex) {
+                        setFailed(condition + ": " + ex.whatString());
+                        return;
+                    }
+                    if (output != original)
+                    {
+                        setFailed(condition + ": decoded data is incorrect");
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void GiftiReadTest::execute()
+{//write a multi-map file in both base64 encodings, read it with the native and Qt XML parsers, check the values with one thread and with all of them, and compare speed and memory when benchmarking
+    checkDecoderChunks();
+    if (failed()) return;
+    const int64_t NUM_VERTICES = 163842, NUM_MAPS = 20;
+    const double MEBIBYTES = (NUM_VERTICES * NUM_MAPS * sizeof(float)) / (1024.0 * 1024.0);
+    AString fileName = SystemUtilities::getTempDirectory() + "/wb_giftiread_" + SystemUtilities::createUniqueID() + ".func.gii";
+    GiftiEncodingEnum::Enum encodings[2] = { GiftiEncodingEnum::BASE64_BINARY, GiftiEncodingEnum::GZIP_BASE64_BINARY };
+    const int32_t threadSettings[2] = { 1, 0 };//0 is as many as OpenMP allows
+    for (int e = 0; e < 2; ++e)
+    {
+        for (int t = 0; t < 2; ++t)
+        {
+            GiftiFile::setMaximumDataArrayThreads(threadSettings[t]);
+            AString threadsName = AString::number(GiftiFile::getDataArrayThreads()) + " thread(s)";
+            {
+                GiftiFile outFile;
+                for (int64_t m = 0; m < NUM_MAPS; ++m)
+                {
+                    GiftiDataArray* thisArray = new GiftiDataArray(NiftiIntentEnum::NIFTI_INTENT_NONE, NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32,
+                                                                   vector<int64_t>(1, NUM_VERTICES), encodings[e]);
+                    float* data = thisArray->getDataPointerFloat();
+                    for (int64_t i = 0; i < NUM_VERTICES; ++i)
+                    {
+                        data[i] = testValue(m, i);
+                    }
+                    outFile.addDataArray(thisArray);
+                }
+                outFile.setEncodingForWriting(encodings[e]);
+                ElapsedTimer myTimer;
+                myTimer.start();
+                outFile.writeFile(fileName);
+                double seconds = myTimer.getElapsedTimeSeconds();
+                if (isBenchmark())
+                {
+                    cout << GiftiEncodingEnum::toName(encodings[e]).toStdString() << ", write, " << threadsName.toStdString() << ": " << seconds << " seconds, "
+                         << MEBIBYTES / seconds << " MiB/s" << endl;
+                }
+            }
+            for (int method = 0; method < 2; ++method)
+            {//native first, so that its peak memory is not hidden by the Qt parser's
+                GiftiFile inFile;
+                ElapsedTimer myTimer;
+                myTimer.start();
+                if (method == 0)
+                {
+                    inFile.readFile(fileName);
+                } else {
+                    inFile.setFileName(fileName);
+                    GiftiFileSaxReader saxReader(&inFile);
+                    unique_ptr<XmlSaxParser> parser(XmlSaxParser::createXmlParser());
+                    parser->parseFile(fileName, &saxReader);
+                }
+                double seconds = myTimer.getElapsedTimeSeconds();
+                AString methodName = (method == 0 ? "native parser" : "Qt parser");
+                if (isBenchmark())
+                {
+                    cout << GiftiEncodingEnum::toName(encodings[e]).toStdString() << ", " << methodName.toStdString() << ", " << threadsName.toStdString() << ": " << seconds << " seconds, "
+                         << MEBIBYTES / seconds << " MiB/s, peak memory so far " << getPeakMemoryMiB() << " MiB" << endl;
+                }
+                if (inFile.getNumberOfDataArrays() != NUM_MAPS)
+                {
+                    setFailed(methodName + " read " + AString::number(inFile.getNumberOfDataArrays()) + " arrays instead of " + AString::number(NUM_MAPS) + " with " + threadsName);
+                    break;
+                }
+                int64_t numBad = 0;
+                for (int64_t m = 0; m < NUM_MAPS; ++m)
+                {
+                    const GiftiDataArray* thisArray = inFile.getDataArray(m);
+                    if (thisArray->getTotalNumberOfElements() != NUM_VERTICES || thisArray->getDataType() != NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32)
+                    {
+                        ++numBad;
+                        continue;
+                    }
+                    const float* data = thisArray->getDataPointerFloat();
+                    for (int64_t i = 0; i < NUM_VERTICES; ++i)
+                    {
+                        if (data[i] != testValue(m, i)) ++numBad;
+                    }
+                }
+                if (numBad != 0)
+                {
+                    setFailed(AString::number(numBad) + " incorrect values with " + methodName + ", encoding " + GiftiEncodingEnum::toName(encodings[e]) + ", " + threadsName);
+                    break;
+                }
+            }
+            if (failed()) break;
+        }
+        if (failed()) break;
+    }
+    GiftiFile::setMaximumDataArrayThreads(0);
+    QFile::remove(fileName);
+}
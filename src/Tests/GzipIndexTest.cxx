@@ -0,0 +1,147 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GzipIndexTest.h"
+
+#include "CaretBinaryFile.h"
+#include "GzipIndex.h"
+#include "SystemUtilities.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+GzipIndexTest::GzipIndexTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void GzipIndexTest::execute()
+{//read an indexed .gz at random offsets, compare against a sequential decompress, then check that damaged indexes are rejected
+    const int64_t DATA_SIZE = 3 * 1024 * 1024 + 12345, SPAN = 64 * 1024;
+    const int NUM_SEEKS = 200;
+    AString gzName = SystemUtilities::getTempDirectory() + "/wb_gzipindex_" + SystemUtilities::createUniqueID() + ".nii.gz";
+    AString indexName = GzipIndex::getIndexFileName(gzName);
+    const bool origSetting = CaretBinaryFile::getParallelCompression();
+    CaretBinaryFile::setParallelCompression(false);//plain gzwrite output, like most existing files
+    {
+        vector<unsigned char> data(DATA_SIZE);
+        for (int64_t i = 0; i < DATA_SIZE; ++i)
+        {
+            data[i] = (unsigned char)((i / 1000) % 7 == 0 ? rand() : (i * 31) % 251);//runs of noise between compressible stretches
+        }
+        CaretBinaryFile outFile;
+        outFile.open(gzName, CaretBinaryFile::WRITE_TRUNCATE);
+        outFile.write(data.data(), DATA_SIZE);
+        outFile.close();
+    }
+    CaretBinaryFile::setParallelCompression(origSetting);
+    vector<unsigned char> reference(DATA_SIZE);
+    {//no index exists yet, so this is the ordinary sequential decompress
+        CaretBinaryFile inFile;
+        inFile.open(gzName);
+        inFile.read(reference.data(), DATA_SIZE);
+        inFile.close();
+    }
+    {
+        GzipIndex myIndex;
+        myIndex.build(gzName, SPAN);
+        if (myIndex.getUncompressedSize() != DATA_SIZE) setFailed("gzip index has the wrong uncompressed size");
+        if (myIndex.getNumberOfAccessPoints() < DATA_SIZE / SPAN) setFailed("gzip index has too few access points, " + AString::number(myIndex.getNumberOfAccessPoints()));
+        myIndex.writeIndex(indexName);
+    }
+    {
+        CaretBinaryFile inFile;
+        inFile.open(gzName);//finds the index
+        if (inFile.size() != DATA_SIZE) setFailed("indexed gzip file reports the wrong size");
+        vector<unsigned char> buffer;
+        int numBad = 0;
+        for (int i = 0; i < NUM_SEEKS; ++i)
+        {
+            int64_t offset = ((int64_t)rand() * RAND_MAX + rand()) % DATA_SIZE;
+            if (i % 10 == 0) offset = DATA_SIZE - 1 - (i % 3);//the last few bytes
+            int64_t count = min((int64_t)(rand() % (3 * SPAN)) + 1, DATA_SIZE - offset);//sometimes crosses access points
+            buffer.resize(count);
+            inFile.seek(offset);
+            inFile.read(buffer.data(), count);
+            if (inFile.pos() != offset + count || memcmp(buffer.data(), reference.data() + offset, count) != 0) ++numBad;
+        }
+        inFile.close();
+        if (numBad != 0) setFailed(AString::number(numBad) + " of " + AString::number(NUM_SEEKS) + " random reads from the indexed file were wrong");
+    }
+    {//a count that claims more access points than the file can hold, and a truncated index, must both be rejected
+        QFile indexFile(indexName);
+        indexFile.open(QIODevice::ReadOnly);
+        QByteArray indexBytes = indexFile.readAll();
+        indexFile.close();
+        const int NUM_POINTS_OFFSET = 8 + 6 * 8;//magic, then compressed size, modified time, content checks, uncompressed size and span
+        QByteArray hugeCount = indexBytes;
+        for (int i = 0; i < 8; ++i)
+        {
+            hugeCount[NUM_POINTS_OFFSET + i] = (char)(i == 6 ? 0x10 : 0);//little endian 2^52
+        }
+        QByteArray truncated = indexBytes.left(indexBytes.size() / 2);
+        const QByteArray* damaged[2] = { &hugeCount, &truncated };
+        for (int d = 0; d < 2; ++d)
+        {
+            indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+            indexFile.write(*damaged[d]);
+            indexFile.close();
+            GzipIndex myIndex;
+            if (myIndex.readIndex(indexName, gzName))
+            {
+                setFailed(AString(d == 0 ? "gzip index with a huge access point count" : "truncated gzip index") + " was accepted");
+            }
+        }
+    }
+    {//same size and modification time, different content
+        GzipIndex myIndex;
+        myIndex.build(gzName, SPAN);
+        myIndex.writeIndex(indexName);
+        QDateTime origModified = QFileInfo(gzName).lastModified();
+        QFile gzFile(gzName);
+        gzFile.open(QIODevice::ReadWrite);
+        gzFile.seek(4);//the timestamp in the gzip header, gzip readers don't care about it
+        gzFile.write("WBWB", 4);
+        gzFile.close();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        gzFile.open(QIODevice::ReadWrite);
+        gzFile.setFileTime(origModified, QFileDevice::FileModificationTime);
+        gzFile.close();
+#endif
+        if (myIndex.readIndex(indexName, gzName)) setFailed("gzip index was accepted for a file with different content");
+    }
+    {//rewriting the file must not leave an index for the old contents behind
+        CaretBinaryFile outFile;
+        outFile.open(gzName, CaretBinaryFile::WRITE_TRUNCATE);
+        outFile.write(reference.data(), SPAN);
+        outFile.close();
+        if (QFile::exists(indexName)) setFailed("gzip index file was not removed when the file was rewritten");
+    }
+    QFile::remove(indexName);
+    QFile::remove(gzName);
+}
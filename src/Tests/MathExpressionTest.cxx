@@ -22,6 +22,7 @@
 #include "CaretMathExpression.h"
 
 #include <cmath>
+#include <vector>
 
 using namespace caret;
 using namespace std;
@@ -55,4 +56,48 @@ void MathExpressionTest::execute()
     {
         setFailed("output value incorrect, expected " + AString::number(correctresult) + ", got " + AString::number(testresult));
     }
+    const char* arrayExprs[] = { " sin ( - yip * 5 ) + x ^ 3 * ( clamp(1, 3, 5) + 2 ) + - 2 ^ - 2 ",
+                                 "x > 0 && yip < 1 || !(x == yip) && x != 1 || x >= yip || x <= -yip",
+                                 "min(x, yip) / max(x, 0.1) - mod(x, yip) + atan2(x, yip) * round(x * 3)",
+                                 "x * (yip > 0.5) - -x / yip" };
+    const int numElems = 1000;//more than one block, with a partial block at the end
+    vector<float> xData(numElems), yipData(numElems), arrayOut(numElems);
+    for (int i = 0; i < numElems; ++i)
+    {
+        xData[i] = (i % 37) * 0.25f - 4.0f;
+        yipData[i] = (i % 23) * 0.5f - 5.0f;
+    }
+    for (int e = 0; e < 4; ++e)
+    {//the block evaluator must agree exactly with the tree evaluator, including the stride 0 case
+        CaretMathExpression arrayExpr(arrayExprs[e]);
+        vector<AString> arrayVarNames = arrayExpr.getVarNames();
+        vector<const float*> varData(arrayVarNames.size());
+        vector<int64_t> varStrides(arrayVarNames.size(), 1);
+        for (int v = 0; v < (int)arrayVarNames.size(); ++v)
+        {
+            if (arrayVarNames[v] == "x")
+            {
+                varData[v] = xData.data();
+            } else {
+                varData[v] = yipData.data() + 7;
+                varStrides[v] = 0;
+            }
+        }
+        arrayExpr.evaluateArray(varData, arrayOut.data(), numElems, varStrides);
+        vector<float> elemVars(arrayVarNames.size());
+        for (int i = 0; i < numElems; ++i)
+        {
+            for (int v = 0; v < (int)arrayVarNames.size(); ++v)
+            {
+                elemVars[v] = varData[v][i * varStrides[v]];
+            }
+            float elemResult = (float)arrayExpr.evaluate(elemVars);
+            if (elemResult != arrayOut[i] && (elemResult == elemResult || arrayOut[i] == arrayOut[i]))
+            {
+                setFailed("evaluateArray disagrees with evaluate for '" + AString(arrayExprs[e]) + "' at element " + AString::number(i) +
+                          ", expected " + AString::number(elemResult) + ", got " + AString::number(arrayOut[i]));
+                break;
+            }
+        }
+    }
 }
@@ -0,0 +1,115 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "MetricResampleTest.h"
+
+#include "AlgorithmMetricResample.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "CaretException.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "SurfaceResamplingMethodEnum.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+MetricResampleTest::MetricResampleTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void MetricResampleTest::execute()
+{//multi-column metrics are resampled in interleaved blocks of columns, each column must come out exactly the same as resampling it by itself
+    const int NUM_COLUMNS = 150;//two full blocks of 64 and a partial block
+    try
+    {
+        SurfaceFile curSphere, newSphere;
+        AlgorithmSurfaceCreateSphere(NULL, 642, &curSphere);
+        AlgorithmSurfaceCreateSphere(NULL, 1002, &newSphere);
+        int numCurNodes = curSphere.getNumberOfNodes();
+        MetricFile metricIn, curAreas, newAreas, roi;
+        metricIn.setNumberOfNodesAndColumns(numCurNodes, NUM_COLUMNS);
+        metricIn.setStructure(curSphere.getStructure());
+        vector<float> scratch(numCurNodes);
+        for (int col = 0; col < NUM_COLUMNS; ++col)
+        {
+            for (int i = 0; i < numCurNodes; ++i)
+            {
+                scratch[i] = rand() / (float)RAND_MAX - 0.5f;
+            }
+            metricIn.setValuesForColumn(col, scratch.data());
+        }
+        roi.setNumberOfNodesAndColumns(numCurNodes, 1);
+        for (int i = 0; i < numCurNodes; ++i)
+        {
+            scratch[i] = (i % 5 == 0) ? 0.0f : 1.0f;
+        }
+        roi.setValuesForColumn(0, scratch.data());
+        vector<float> areaScratch;
+        curSphere.computeNodeAreas(areaScratch);
+        curAreas.setNumberOfNodesAndColumns(numCurNodes, 1);
+        curAreas.setValuesForColumn(0, areaScratch.data());
+        newSphere.computeNodeAreas(areaScratch);
+        newAreas.setNumberOfNodesAndColumns(newSphere.getNumberOfNodes(), 1);
+        newAreas.setValuesForColumn(0, areaScratch.data());
+        vector<SurfaceResamplingMethodEnum::Enum> methods;
+        methods.push_back(SurfaceResamplingMethodEnum::BARYCENTRIC);
+        methods.push_back(SurfaceResamplingMethodEnum::ADAP_BARY_AREA);
+        for (int m = 0; m < (int)methods.size(); ++m)
+        {
+            for (int useRoi = 0; useRoi < 2; ++useRoi)
+            {
+                const MetricFile* roiPtr = (useRoi ? &roi : NULL);
+                AString caseName = SurfaceResamplingMethodEnum::toName(methods[m]) + (useRoi ? " with roi" : "");
+                MetricFile blockOut;
+                AlgorithmMetricResample(NULL, &metricIn, &curSphere, &newSphere, methods[m], &blockOut, &curAreas, &newAreas, roiPtr);
+                if (blockOut.getNumberOfNodes() != newSphere.getNumberOfNodes() || blockOut.getNumberOfColumns() != NUM_COLUMNS)
+                {
+                    setFailed(caseName + ": resampled metric has wrong dimensions");
+                    continue;
+                }
+                int numNewNodes = blockOut.getNumberOfNodes();
+                MetricFile singleIn;
+                singleIn.setNumberOfNodesAndColumns(numCurNodes, 1);
+                singleIn.setStructure(metricIn.getStructure());
+                for (int col = 0; col < NUM_COLUMNS; ++col)
+                {
+                    singleIn.setValuesForColumn(0, metricIn.getValuePointerForColumn(col));
+                    MetricFile singleOut;
+                    AlgorithmMetricResample(NULL, &singleIn, &curSphere, &newSphere, methods[m], &singleOut, &curAreas, &newAreas, roiPtr);
+                    const float* blockData = blockOut.getValuePointerForColumn(col), *singleData = singleOut.getValuePointerForColumn(0);
+                    for (int i = 0; i < numNewNodes; ++i)
+                    {
+                        if (blockData[i] != singleData[i])
+                        {
+                            setFailed(caseName + ": column " + AString::number(col + 1) + " differs from resampling it alone at vertex " + AString::number(i));
+                            break;
+                        }
+                    }
+                    if (failed()) return;
+                }
+            }
+        }
+    } catch (CaretException& e) {
+        setFailed(e.whatString());
+    }
+}
@@ -0,0 +1,137 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "NiftiGzipTest.h"
+
+#include "CaretBinaryFile.h"
+#include "CaretOMP.h"
+#include "ElapsedTimer.h"
+#include "NiftiIO.h"
+#include "SystemUtilities.h"
+
+#include <QFile>
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+NiftiGzipTest::NiftiGzipTest(const AString& identifier, const bool& benchmark) : TestInterface(identifier, benchmark)
+{
+}
+
+namespace
+{
+    float testValue(const int64_t& frame, const int64_t& elem)
+    {//smooth-ish, so it compresses somewhat like real data
+        return (float)(sin(elem * 0.001 + frame * 0.1) * 1000.0 + (elem % 17));
+    }
+}
+
+void NiftiGzipTest::execute()
+{//write a 4D .nii.gz (4MiB, or 128MiB when benchmarking) with serial and parallel compression, then read each back with and without read-ahead
+    const int64_t DIM_X = 64, DIM_Y = 64, DIM_Z = 32, NUM_FRAMES = (isBenchmark() ? 256 : 8), FRAME_SIZE = DIM_X * DIM_Y * DIM_Z;//even the small size is several compression blocks
+    const double MEBIBYTES = (NUM_FRAMES * FRAME_SIZE * sizeof(float)) / (1024.0 * 1024.0);
+    const bool origSetting = CaretBinaryFile::getParallelCompression();
+    AString baseName = SystemUtilities::getTempDirectory() + "/wb_niftigzip_" + SystemUtilities::createUniqueID();
+    vector<AString> fileNames;
+    int numThreads = 1;
+#ifdef CARET_OMP
+    numThreads = omp_get_max_threads();
+#endif
+    if (isBenchmark()) cout << "parallel compression uses up to " << numThreads << " thread(s)" << endl;
+    for (int parallel = 0; parallel < 2; ++parallel)
+    {
+        AString fileName = baseName + (parallel ? "_parallel" : "_serial") + ".nii.gz";
+        fileNames.push_back(fileName);
+        CaretBinaryFile::setParallelCompression(parallel != 0);
+        ElapsedTimer myTimer;
+        myTimer.start();
+        NiftiHeader header;
+        vector<int64_t> dims;
+        dims.push_back(DIM_X);
+        dims.push_back(DIM_Y);
+        dims.push_back(DIM_Z);
+        dims.push_back(NUM_FRAMES);
+        header.setDimensions(dims);
+        header.setDataType(NIFTI_TYPE_FLOAT32);
+        NiftiIO writer;
+        writer.writeNew(fileName, header);
+        vector<float> frame(FRAME_SIZE);
+        vector<int64_t> indexSelect(1);
+        for (int64_t i = 0; i < NUM_FRAMES; ++i)
+        {
+            for (int64_t j = 0; j < FRAME_SIZE; ++j)
+            {
+                frame[j] = testValue(i, j);
+            }
+            indexSelect[0] = i;
+            writer.writeData(frame.data(), 3, indexSelect);
+        }
+        writer.close();
+        double seconds = myTimer.getElapsedTimeSeconds();
+        if (isBenchmark())
+        {
+            cout << (parallel ? "parallel" : "serial") << " write: " << seconds << " seconds, " << MEBIBYTES / seconds << " MiB/s, "
+                 << QFile(fileName).size() / (1024.0 * 1024.0) << " MiB compressed" << endl;
+        }
+    }
+    for (int f = 0; f < (int)fileNames.size(); ++f)
+    {//read both files both ways, so we know the parallel output is valid for the plain zlib reader
+        for (int parallel = 0; parallel < 2; ++parallel)
+        {
+            CaretBinaryFile::setParallelCompression(parallel != 0);
+            ElapsedTimer myTimer;
+            myTimer.start();
+            NiftiIO reader;
+            reader.openRead(fileNames[f]);
+            int64_t numBad = 0;
+            vector<float> frame(FRAME_SIZE);
+            vector<int64_t> indexSelect(1);
+            for (int64_t i = 0; i < NUM_FRAMES; ++i)
+            {
+                indexSelect[0] = i;
+                reader.readData(frame.data(), 3, indexSelect);
+                for (int64_t j = 0; j < FRAME_SIZE; ++j)
+                {
+                    if (frame[j] != testValue(i, j)) ++numBad;
+                }
+            }
+            reader.close();
+            double seconds = myTimer.getElapsedTimeSeconds();
+            if (isBenchmark())
+            {
+                cout << (parallel ? "read-ahead" : "serial") << " read of " << (f ? "parallel" : "serial") << " file: " << seconds << " seconds, "
+                     << MEBIBYTES / seconds << " MiB/s" << endl;
+            }
+            if (numBad != 0)
+            {
+                setFailed(AString::number(numBad) + " incorrect values read from " + (f ? "parallel" : "serial") + " compressed file");
+            }
+        }
+    }
+    CaretBinaryFile::setParallelCompression(origSetting);
+    for (int f = 0; f < (int)fileNames.size(); ++f)
+    {
+        QFile::remove(fileNames[f]);
+    }
+}
@@ -0,0 +1,109 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "NiftiReadScalingTest.h"
+
+#include "CaretOMP.h"
+#include "ElapsedTimer.h"
+#include "NiftiIO.h"
+#include "SystemUtilities.h"
+
+#include <QFile>
+
+#include <iostream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+NiftiReadScalingTest::NiftiReadScalingTest(const AString& identifier, const bool& benchmark) : TestInterface(identifier, benchmark)
+{
+}
+
+namespace
+{
+    float testValue(const int64_t& frame, const int64_t& elem)
+    {
+        return (float)((frame * 7919 + elem) % 65521);//exactly representable, and different between frames
+    }
+}
+
+void NiftiReadScalingTest::execute()
+{//write a 4D nifti (4MiB, or 64MiB when benchmarking), then read all frames with 1 thread and with all threads, checking the data each time
+    const int64_t DIM = 32, NUM_FRAMES = (isBenchmark() ? 512 : 32), FRAME_SIZE = DIM * DIM * DIM;
+    AString fileName = SystemUtilities::getTempDirectory() + "/wb_niftireadscaling_" + SystemUtilities::createUniqueID() + ".nii";
+    {
+        NiftiHeader header;
+        vector<int64_t> dims(3, DIM);
+        dims.push_back(NUM_FRAMES);
+        header.setDimensions(dims);
+        header.setDataType(NIFTI_TYPE_FLOAT32);
+        NiftiIO writer;
+        writer.writeNew(fileName, header);
+        vector<float> frame(FRAME_SIZE);
+        vector<int64_t> indexSelect(1);
+        for (int64_t i = 0; i < NUM_FRAMES; ++i)
+        {
+            for (int64_t j = 0; j < FRAME_SIZE; ++j)
+            {
+                frame[j] = testValue(i, j);
+            }
+            indexSelect[0] = i;
+            writer.writeData(frame.data(), 3, indexSelect);
+        }
+        writer.close();
+    }
+    NiftiIO reader;
+    reader.openRead(fileName);
+    int maxThreads = 1;
+#ifdef CARET_OMP
+    maxThreads = omp_get_max_threads();
+#endif
+    vector<int> threadCounts(1, 1);
+    if (maxThreads > 1) threadCounts.push_back(maxThreads);
+    for (int t = 0; t < (int)threadCounts.size(); ++t)
+    {
+        int64_t numBad = 0;
+        ElapsedTimer myTimer;
+        myTimer.start();
+#pragma omp CARET_PARFOR schedule(dynamic) num_threads(threadCounts[t]) reduction(+:numBad)
+        for (int64_t i = 0; i < NUM_FRAMES; ++i)
+        {
+            vector<float> frame(FRAME_SIZE);
+            vector<int64_t> indexSelect(1, i);
+            reader.readData(frame.data(), 3, indexSelect);
+            for (int64_t j = 0; j < FRAME_SIZE; ++j)
+            {
+                if (frame[j] != testValue(i, j)) ++numBad;
+            }
+        }
+        double seconds = myTimer.getElapsedTimeSeconds();
+        if (isBenchmark())
+        {
+            cout << threadCounts[t] << " thread(s): read " << NUM_FRAMES << " frames in " << seconds << " seconds, "
+                 << (NUM_FRAMES * FRAME_SIZE * sizeof(float)) / (seconds * 1024 * 1024) << " MiB/s" << endl;
+        }
+        if (numBad != 0)
+        {
+            setFailed(AString::number(numBad) + " incorrect values read with " + AString::number(threadCounts[t]) + " thread(s)");
+        }
+    }
+    reader.close();
+    QFile::remove(fileName);
+}
@@ -0,0 +1,84 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "ReductionAccumulatorTest.h"
+
+#include "CaretException.h"
+#include "ReductionAccumulator.h"
+#include "ReductionOperation.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+ReductionAccumulatorTest::ReductionAccumulatorTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void ReductionAccumulatorTest::execute()
+{//compare streamed and merged results against ReductionOperation for every type
+    const float TOLER = 0.00001f;
+    const int64_t LENGTHS[] = { 3, 10, 101, 1000 };//one value is NaN, so sample stdev needs at least 3
+    vector<ReductionEnum::Enum> types;
+    ReductionEnum::getAllEnums(types);
+    for (int t = 0; t < (int)types.size(); ++t)
+    {
+        ReductionEnum::Enum type = types[t];
+        if (type == ReductionEnum::INVALID) continue;
+        for (int l = 0; l < (int)(sizeof(LENGTHS) / sizeof(LENGTHS[0])); ++l)
+        {
+            int64_t length = LENGTHS[l];
+            vector<float> data(length);
+            for (int64_t i = 0; i < length; ++i)
+            {
+                if (type == ReductionEnum::MODE || type == ReductionEnum::PRODUCT)
+                {//need repeated values for mode, and a product that doesn't overflow
+                    data[i] = (rand() % 7 + 1) * 0.5f;
+                } else {
+                    data[i] = rand() * 10.0f / RAND_MAX + 5.0f;
+                }
+            }
+            data[length / 2] = numeric_limits<float>::quiet_NaN();
+            float correct = ReductionOperation::reduceOnlyNumeric(data.data(), length, type);
+            ReductionAccumulator whole(type, true), left(type, true), right(type, true);
+            whole.addValues(data.data(), length);
+            left.addValues(data.data(), length / 3);
+            right.addValues(data.data() + length / 3, length - length / 3);
+            left.merge(right);
+            float wholeResult = whole.getResult(), mergedResult = left.getResult();
+            if (!(abs(wholeResult - correct) <= abs(correct) * TOLER) || !(abs(mergedResult - correct) <= abs(correct) * TOLER))//trap NaNs
+            {
+                setFailed(ReductionEnum::toName(type) + " of length " + AString::number(length) + " incorrect, expected " + AString::number(correct) +
+                          ", got " + AString::number(wholeResult) + " streamed and " + AString::number(mergedResult) + " merged");
+            }
+        }
+    }
+    ReductionAccumulator sampStdev(ReductionEnum::SAMPSTDEV);
+    sampStdev.addValue(1.0f);
+    try
+    {
+        sampStdev.getResult();
+        setFailed("SAMPSTDEV of one value did not throw");
+    } catch (CaretException&) {
+    }
+}
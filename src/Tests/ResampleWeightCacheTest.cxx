@@ -0,0 +1,104 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ResampleWeightCacheTest.h"
+
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "SurfaceFile.h"
+#include "SurfaceResamplingHelper.h"
+#include "SystemUtilities.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+ResampleWeightCacheTest::ResampleWeightCacheTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void ResampleWeightCacheTest::execute()
+{//weights loaded from the cache must resample exactly like computed ones, and a damaged cache entry must be recomputed rather than used
+    SurfaceFile currentSphere, newSphere;
+    AlgorithmSurfaceCreateSphere(NULL, 2562, &currentSphere);
+    AlgorithmSurfaceCreateSphere(NULL, 3000, &newSphere);
+    const int numCurrent = currentSphere.getNumberOfNodes(), numNew = newSphere.getNumberOfNodes();
+    vector<float> input(numCurrent), expected(numNew), output(numNew);
+    for (int i = 0; i < numCurrent; ++i)
+    {
+        input[i] = rand() / (float)RAND_MAX;
+    }
+    const AString origDirectory = SurfaceResamplingHelper::getWeightCacheDirectory();
+    SurfaceResamplingHelper::setWeightCacheDirectory("");
+    SurfaceResamplingHelper(SurfaceResamplingMethodEnum::BARYCENTRIC, &currentSphere, &newSphere).resampleNormal(input.data(), expected.data());
+    AString cacheDirName = SystemUtilities::getTempDirectory() + "/wb_resampleweightcache_" + SystemUtilities::createUniqueID();
+    SurfaceResamplingHelper::setWeightCacheDirectory(cacheDirName);
+    SurfaceResamplingHelper(SurfaceResamplingMethodEnum::BARYCENTRIC, &currentSphere, &newSphere);//writes the cache entry
+    QDir cacheDir(cacheDirName);
+    QStringList entries = cacheDir.entryList(QStringList("*.wbresample"), QDir::Files);
+    if (entries.size() != 1)
+    {
+        setFailed("expected 1 resampling weight cache file, found " + AString::number(entries.size()));
+    } else {
+        AString cacheFileName = cacheDir.filePath(entries[0]);
+        SurfaceResamplingHelper(SurfaceResamplingMethodEnum::BARYCENTRIC, &currentSphere, &newSphere).resampleNormal(input.data(), output.data());
+        if (output != expected) setFailed("resampling with cached weights differs from computed weights");
+        {//give the last vertex a negative count, and reduce the total so that the elements read before it still add up
+            QFile cacheFile(cacheFileName);
+            cacheFile.open(QIODevice::ReadOnly);
+            QByteArray bytes = cacheFile.readAll();
+            cacheFile.close();
+            QDataStream inStream(bytes);
+            inStream.setByteOrder(QDataStream::LittleEndian);
+            inStream.skipRawData(8);//magic
+            qint64 numNodes, numElems;
+            inStream >> numNodes >> numElems;
+            qint64 countOffset = 8 + 8 + 8;
+            qint32 count = 0;
+            for (qint64 i = 0; i < numNodes; ++i)
+            {
+                inStream.device()->seek(countOffset);
+                inStream >> count;
+                if (i == numNodes - 1) break;
+                countOffset += 4 + 8 * (qint64)count;//node and weight per element
+            }
+            QByteArray damaged = bytes.left(countOffset);
+            QDataStream outStream(&damaged, QIODevice::ReadWrite);
+            outStream.setByteOrder(QDataStream::LittleEndian);
+            outStream.device()->seek(16);
+            outStream << (qint64)(numElems - count);
+            outStream.device()->seek(countOffset);
+            outStream << (qint32)-1;
+            cacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+            cacheFile.write(damaged);
+            cacheFile.close();
+        }
+        SurfaceResamplingHelper(SurfaceResamplingMethodEnum::BARYCENTRIC, &currentSphere, &newSphere).resampleNormal(input.data(), output.data());
+        if (output != expected) setFailed("resampling used weights from a corrupted cache file");
+        QFile::remove(cacheFileName);
+    }
+    cacheDir.rmdir(".");
+    SurfaceResamplingHelper::setWeightCacheDirectory(origDirectory);
+}
@@ -0,0 +1,159 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "RibbonWeightMatrixTest.h"
+
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "AlgorithmVolumeToSurfaceMapping.h"
+#include "CaretException.h"
+#include "DataFileException.h"
+#include "MetricFile.h"
+#include "OperationParameters.h"
+#include "OperationVolumeToSurfaceApplyWeights.h"
+#include "RibbonWeightMatrix.h"
+#include "SurfaceFile.h"
+#include "SystemUtilities.h"
+#include "VolumeFile.h"
+
+#include <QDataStream>
+#include <QFile>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    void scaleSphere(SurfaceFile& mySurf, const float& radius)
+    {//created spheres have radius 100
+        int32_t numNodes = mySurf.getNumberOfNodes();
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            const float* coord = mySurf.getCoordinate(i);
+            mySurf.setCoordinate(i, coord[0] * radius / 100.0f, coord[1] * radius / 100.0f, coord[2] * radius / 100.0f);
+        }
+    }
+}
+
+RibbonWeightMatrixTest::RibbonWeightMatrixTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void RibbonWeightMatrixTest::execute()
+{//save the weights from ribbon mapping, apply them to the same volume file with the operation, and require exactly the same output
+    AString baseName = SystemUtilities::getTempDirectory() + "/wb_ribbonweights_" + SystemUtilities::createUniqueID();
+    AString volumeName = baseName + ".nii", weightsName = baseName + ".ribbonweights", corruptName = baseName + "_corrupt.ribbonweights";
+    const int64_t NUM_FRAMES = 3;
+    vector<int64_t> dims(4);
+    dims[0] = 24; dims[1] = 24; dims[2] = 24; dims[3] = NUM_FRAMES;
+    vector<vector<float> > sform(3, vector<float>(4, 0.0f));
+    for (int i = 0; i < 3; ++i)
+    {
+        sform[i][i] = 2.0f;
+        sform[i][3] = -23.0f;//centered on the origin, like the spheres
+    }
+    SurfaceFile midSurf, innerSurf, outerSurf;
+    AlgorithmSurfaceCreateSphere(NULL, 642, &midSurf);
+    AlgorithmSurfaceCreateSphere(NULL, 642, &innerSurf);
+    AlgorithmSurfaceCreateSphere(NULL, 642, &outerSurf);
+    scaleSphere(innerSurf, 12.0f);
+    scaleSphere(midSurf, 15.0f);
+    scaleSphere(outerSurf, 18.0f);
+    try
+    {
+        {
+            VolumeFile writeVol(dims, sform);
+            int64_t frameSize = dims[0] * dims[1] * dims[2];
+            vector<float> frame(frameSize);
+            for (int64_t f = 0; f < NUM_FRAMES; ++f)
+            {
+                for (int64_t i = 0; i < frameSize; ++i)
+                {
+                    frame[i] = rand() / (float)RAND_MAX - 0.5f;
+                }
+                writeVol.setFrame(frame.data(), f);
+            }
+            writeVol.writeFile(volumeName);
+        }
+        VolumeFile inVol;
+        inVol.readFile(volumeName);//map what the operation will read
+        MetricFile mappedOut;
+        vector<vector<VoxelWeight> > allWeights;
+        AlgorithmVolumeToSurfaceMapping(NULL, &inVol, &midSurf, &mappedOut, &innerSurf, &outerSurf, NULL, false, 3, false, -1, -1.0f, NULL, -1, NULL, &allWeights);
+        if ((int64_t)allWeights.size() != midSurf.getNumberOfNodes())
+        {
+            setFailed("ribbon mapping returned weights for " + AString::number(allWeights.size()) + " vertices, expected " + AString::number(midSurf.getNumberOfNodes()));
+            QFile::remove(volumeName);
+            return;
+        }
+        RibbonWeightMatrix(allWeights, inVol.getVolumeSpace(), midSurf.getStructure()).writeFile(weightsName);
+        CaretPointer<OperationParameters> myParams(OperationVolumeToSurfaceApplyWeights::getParameters());
+        ((StringParameter*)myParams->m_paramList[0])->m_parameter = volumeName;
+        ((StringParameter*)myParams->m_paramList[1])->m_parameter = weightsName;
+        OperationVolumeToSurfaceApplyWeights::useParameters(myParams, NULL);
+        const MetricFile* appliedOut = myParams->getOutputMetric(3);
+        if (appliedOut->getNumberOfNodes() != mappedOut.getNumberOfNodes() || appliedOut->getNumberOfColumns() != mappedOut.getNumberOfColumns())
+        {
+            setFailed("applied weights output has different dimensions than ribbon mapping");
+        } else {
+            int32_t numNodes = mappedOut.getNumberOfNodes();
+            for (int32_t col = 0; col < mappedOut.getNumberOfColumns() && !failed(); ++col)
+            {
+                const float* mappedData = mappedOut.getValuePointerForColumn(col), *appliedData = appliedOut->getValuePointerForColumn(col);
+                for (int32_t i = 0; i < numNodes; ++i)
+                {
+                    if (mappedData[i] != appliedData[i])
+                    {
+                        setFailed("applied weights differ from ribbon mapping in map " + AString::number(col + 1) + " at vertex " + AString::number(i));
+                        break;
+                    }
+                }
+            }
+        }
+        QFile::copy(weightsName, corruptName);
+        {//vertex count goes after the magic, dims, sform, and structure name
+            QFile corruptFile(corruptName);
+            if (!corruptFile.open(QIODevice::ReadWrite))
+            {
+                setFailed("failed to open copy of weights file");
+            } else {
+                QDataStream corruptStream(&corruptFile);
+                corruptStream.setByteOrder(QDataStream::LittleEndian);
+                corruptFile.seek(8 + 3 * 8 + 12 * 4 + 4 + 2 * StructureEnum::toName(midSurf.getStructure()).length());
+                corruptStream << (((qint64)1) << 40);
+                corruptFile.close();
+            }
+        }
+        try
+        {
+            RibbonWeightMatrix corruptMatrix;
+            corruptMatrix.readFile(corruptName);
+            setFailed("weights file with too many vertices for its size was accepted");
+        } catch (DataFileException&) {//expected
+        }
+    } catch (CaretException& e) {
+        setFailed(e.whatString());
+    }
+    QFile::remove(volumeName);
+    QFile::remove(weightsName);
+    QFile::remove(corruptName);
+}
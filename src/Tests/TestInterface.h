@@ -27,14 +27,15 @@ namespace caret {
    class TestInterface
    {
       AString m_identifier, m_failMessage;
-      bool m_failed;
+      bool m_failed, m_benchmark;
       TestInterface();//deny construction without arguments
       TestInterface& operator=(const TestInterface& right);//deny assignment
    protected:
-      TestInterface(const AString& identifier) : m_failMessage("")
-      {
+      TestInterface(const AString& identifier, const bool& benchmark = false) : m_failMessage("")
+      {//benchmarks print timings, and aren't run by "all"
          m_identifier = identifier;
          m_failed = false;
+         m_benchmark = benchmark;
          m_default_path = "../../wb_files";
       }
    public:
@@ -51,6 +52,10 @@ namespace caret {
       {
          return m_failed;
       }
+      bool isBenchmark()
+      {
+         return m_benchmark;
+      }
       const AString& getFailMessage()
       {
          return m_failMessage;
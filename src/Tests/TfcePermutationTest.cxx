@@ -0,0 +1,145 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TfcePermutationTest.h"
+
+#include "AlgorithmMetricTFCE.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TfcePermutationHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+TfcePermutationTest::TfcePermutationTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void TfcePermutationTest::execute()
+{//the null distribution of the sign flip mode must match the extremes of the full per-vertex TFCE of each permuted t-statistic
+    const int NUM_INPUTS = 6, NUM_PERMS = 6, NUM_TRIALS = 4;
+    SurfaceFile sphere;
+    AlgorithmSurfaceCreateSphere(NULL, 2562, &sphere);
+    const int numNodes = sphere.getNumberOfNodes();
+    for (int trial = 0; trial < NUM_TRIALS; ++trial)
+    {
+        MetricFile inputs, roi;
+        inputs.setNumberOfNodesAndColumns(numNodes, NUM_INPUTS);
+        inputs.setStructure(sphere.getStructure());
+        vector<float> column(numNodes);
+        float phase = rand() / (float)RAND_MAX * 6.0f;
+        for (int col = 0; col < NUM_INPUTS; ++col)
+        {
+            for (int i = 0; i < numNodes; ++i)
+            {//a smooth pattern that most inputs share, plus noise, so that there are clusters of both signs
+                const float* coord = sphere.getCoordinate(i);
+                column[i] = sin(coord[0] * 0.05f + coord[2] * 0.03f + phase) * (col % 3 == 2 ? -0.5f : 1.0f) + rand() / (float)RAND_MAX - 0.5f;
+            }
+            inputs.setValuesForColumn(col, column.data());
+        }
+        const MetricFile* roiPtr = NULL;
+        if (trial % 2 == 1)
+        {//include excluded vertices inside clusters
+            roi.setNumberOfNodesAndColumns(numNodes, 1);
+            roi.setStructure(sphere.getStructure());
+            for (int i = 0; i < numNodes; ++i)
+            {
+                column[i] = (rand() % 5 == 0) ? 0.0f : 1.0f;
+            }
+            roi.setValuesForColumn(0, column.data());
+            roiPtr = &roi;
+        }
+        vector<vector<float> > signFlips;
+        TfcePermutationHelper::randomSignFlips(NUM_PERMS, NUM_INPUTS, 1000 + trial, signFlips);
+        MetricFile nullOut;
+        vector<float> nullMax, nullMin;
+        AlgorithmMetricTFCE(NULL, &sphere, &inputs, &nullOut, signFlips, nullMax, nullMin, 0.0f, roiPtr);
+        vector<const float*> inputPtrs(NUM_INPUTS);
+        for (int col = 0; col < NUM_INPUTS; ++col)
+        {
+            inputPtrs[col] = inputs.getValuePointerForColumn(col);
+        }
+        for (int p = 0; p < NUM_PERMS; ++p)
+        {
+            MetricFile tstat, tfce;
+            tstat.setNumberOfNodesAndColumns(numNodes, 1);
+            tstat.setStructure(sphere.getStructure());
+            TfcePermutationHelper::signFlipTStatistic(inputPtrs, signFlips[p].data(), numNodes, column.data());
+            tstat.setValuesForColumn(0, column.data());
+            AlgorithmMetricTFCE(NULL, &sphere, &tstat, &tfce, 0.0f, roiPtr);
+            const float* tfceData = tfce.getValuePointerForColumn(0);
+            float expectMax = 0.0f, expectMin = 0.0f;//the helper reports 0 when there are no values of that sign
+            for (int i = 0; i < numNodes; ++i)
+            {
+                expectMax = max(expectMax, tfceData[i]);
+                expectMin = min(expectMin, tfceData[i]);
+            }
+            const float tolerance = 1e-5f * max(1.0f, max(expectMax, -expectMin));//only the order of summation may differ
+            if (!(abs(nullMax[p] - expectMax) <= tolerance) || !(abs(nullMin[p] - expectMin) <= tolerance))
+            {
+                setFailed("trial " + AString::number(trial) + ", permutation " + AString::number(p) + ": extremes " + AString::number(nullMax[p]) + ", " + AString::number(nullMin[p]) +
+                          " differ from full TFCE extremes " + AString::number(expectMax) + ", " + AString::number(expectMin));
+            }
+        }
+    }
+    if (!failed()) checkLargeOffsetTStatistic();
+}
+
+void TfcePermutationTest::checkLargeOffsetTStatistic()
+{//inputs near 2^24 with a spread of a few units, the deviations from the mean are exact, while the sum of squares minus sum times mean is off by up to 0.1%
+    const int NUM_INPUTS = 8, NUM_ELEMENTS = 4;
+    vector<vector<float> > data(NUM_INPUTS, vector<float>(NUM_ELEMENTS));
+    vector<const float*> inputPtrs(NUM_INPUTS);
+    for (int j = 0; j < NUM_INPUTS; ++j)
+    {
+        for (int i = 0; i < NUM_ELEMENTS; ++i)
+        {
+            data[j][i] = 16777215.0f + (float)((j * j * 7 % 13) * (i + 1));//rounds to even above 2^24, which is fine, the expected values use the stored floats
+        }
+        inputPtrs[j] = data[j].data();
+    }
+    vector<float> signs(NUM_INPUTS, 1.0f), tstat(NUM_ELEMENTS);
+    TfcePermutationHelper::signFlipTStatistic(inputPtrs, signs.data(), NUM_ELEMENTS, tstat.data());
+    for (int i = 0; i < NUM_ELEMENTS; ++i)
+    {
+        double mean = 0.0;
+        for (int j = 0; j < NUM_INPUTS; ++j)
+        {
+            mean += data[j][i];
+        }
+        mean /= NUM_INPUTS;
+        double sum2 = 0.0;
+        for (int j = 0; j < NUM_INPUTS; ++j)
+        {
+            sum2 += (data[j][i] - mean) * (data[j][i] - mean);
+        }
+        float expect = mean / sqrt(sum2 / (NUM_INPUTS - 1) / NUM_INPUTS);
+        if (!(abs(tstat[i] - expect) <= 1e-5f * abs(expect)))
+        {
+            setFailed("t-statistic of inputs with a large mean is " + AString::number(tstat[i]) + ", expected " + AString::number(expect));
+        }
+    }
+}
@@ -0,0 +1,150 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TriangleBVHTest.h"
+
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "CaretTriangleBVH.h"
+#include "ElapsedTimer.h"
+#include "SurfaceFile.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace caret;
+using namespace std;
+
+TriangleBVHTest::TriangleBVHTest(const AString& identifier, const bool& benchmark): TestInterface(identifier, benchmark)
+{
+}
+
+namespace
+{
+    float randRange(const float low, const float high)
+    {
+        return low + (high - low) * ((float)rand()) / RAND_MAX;
+    }
+    
+    //double-sided moller-trumbore over every triangle, the answer the BVH must reproduce
+    int64_t bruteForceHit(const SurfaceFile& surf, const float origin[3], const float direction[3], float& distOut)
+    {
+        int64_t best = -1;
+        distOut = -1.0f;
+        const float* coords = surf.getCoordinateData();
+        for (int32_t i = 0; i < surf.getNumberOfTriangles(); ++i)
+        {
+            const int32_t* tri = surf.getTriangle(i);
+            const float* v0 = coords + tri[0] * 3, *v1 = coords + tri[1] * 3, *v2 = coords + tri[2] * 3;
+            double e1[3], e2[3], p[3], t[3], q[3];
+            for (int j = 0; j < 3; ++j)
+            {
+                e1[j] = v1[j] - v0[j];
+                e2[j] = v2[j] - v0[j];
+                t[j] = origin[j] - v0[j];
+            }
+            p[0] = direction[1] * e2[2] - direction[2] * e2[1];
+            p[1] = direction[2] * e2[0] - direction[0] * e2[2];
+            p[2] = direction[0] * e2[1] - direction[1] * e2[0];
+            double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+            if (det == 0.0) continue;
+            double u = (t[0] * p[0] + t[1] * p[1] + t[2] * p[2]) / det;
+            if (u < 0.0 || u > 1.0) continue;
+            q[0] = t[1] * e1[2] - t[2] * e1[1];
+            q[1] = t[2] * e1[0] - t[0] * e1[2];
+            q[2] = t[0] * e1[1] - t[1] * e1[0];
+            double v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) / det;
+            if (v < 0.0 || u + v > 1.0) continue;
+            double dist = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+            if (dist < 0.0) continue;
+            if (best == -1 || dist < distOut)
+            {
+                best = i;
+                distOut = (float)dist;
+            }
+        }
+        return best;
+    }
+}
+
+void TriangleBVHTest::execute()
+{//sphere with the same vertex count as the 164k fs_LR mesh, rays from outside aimed near the center
+    SurfaceFile sphere;
+    AlgorithmSurfaceCreateSphere(NULL, 163842, &sphere);
+    ElapsedTimer myTimer;
+    myTimer.start();
+    CaretPointer<const CaretTriangleBVH> myBVH = sphere.getTriangleBVH();
+    if (isBenchmark()) cout << "triangle BVH for " << sphere.getNumberOfTriangles() << " triangles: " << myTimer.getElapsedTimeSeconds() << " seconds" << endl;
+    const int NUM_RAYS = 200;
+    vector<float> origins(NUM_RAYS * 3), directions(NUM_RAYS * 3);
+    for (int i = 0; i < NUM_RAYS * 3; ++i)
+    {
+        origins[i] = randRange(-300.0f, 300.0f);
+    }
+    for (int i = 0; i < NUM_RAYS; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            directions[i * 3 + j] = randRange(-50.0f, 50.0f) - origins[i * 3 + j];//some rays miss the radius 100 sphere entirely
+        }
+    }
+    vector<CaretTriangleBVH::RayHit> hits(NUM_RAYS);
+    vector<bool> hitFlags(NUM_RAYS);
+    myTimer.start();
+    for (int i = 0; i < NUM_RAYS; ++i)
+    {
+        hitFlags[i] = myBVH->closestRayHit(origins.data() + i * 3, directions.data() + i * 3, hits[i]);
+    }
+    double bvhTime = myTimer.getElapsedTimeSeconds();
+    myTimer.start();
+    for (int i = 0; i < NUM_RAYS; ++i)
+    {
+        float bruteDist;
+        int64_t bruteTri = bruteForceHit(sphere, origins.data() + i * 3, directions.data() + i * 3, bruteDist);
+        if ((bruteTri != -1) != hitFlags[i])
+        {
+            setFailed("ray " + AString::number(i) + " hit flag differs from brute force");
+            continue;
+        }
+        if (bruteTri != -1 && bruteTri != hits[i].m_triangle && abs(bruteDist - hits[i].m_distance) > 1e-5f)
+        {//ray through an edge can legitimately report either triangle, but only at the same distance
+            setFailed("ray " + AString::number(i) + " hit triangle " + AString::number(hits[i].m_triangle) + ", brute force found " + AString::number(bruteTri));
+        }
+    }
+    double bruteTime = myTimer.getElapsedTimeSeconds();
+    if (isBenchmark()) cout << "closestRayHit: " << bvhTime * 1e6 / NUM_RAYS << " us per ray, brute force: " << bruteTime * 1e6 / NUM_RAYS << " us per ray" << endl;
+    //a filter that rejects the front hit must find the back of the sphere instead
+    float origin[3] = { 0.5f, 0.5f, 300.0f }, direction[3] = { 0.0f, 0.0f, -1.0f };
+    CaretTriangleBVH::RayHit frontHit, backHit;
+    if (!myBVH->closestRayHit(origin, direction, frontHit))
+    {
+        setFailed("ray through the center of the sphere missed");
+        return;
+    }
+    if (!myBVH->closestRayHit(origin, direction, backHit, [](const CaretTriangleBVH::RayHit& hit) { return hit.m_xyz[2] < 0.0f; }))
+    {
+        setFailed("filtered ray through the center of the sphere missed");
+        return;
+    }
+    if (abs(frontHit.m_xyz[2] - 100.0f) > 1.0f || abs(backHit.m_xyz[2] + 100.0f) > 1.0f)
+    {
+        setFailed("ray through the center of the sphere hit at wrong z coordinates: " + AString::number(frontHit.m_xyz[2]) + ", " + AString::number(backHit.m_xyz[2]));
+    }
+}
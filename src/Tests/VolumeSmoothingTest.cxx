@@ -0,0 +1,109 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "VolumeSmoothingTest.h"
+
+#include "AlgorithmVolumeSmoothing.h"
+#include "CaretException.h"
+#include "ElapsedTimer.h"
+#include "VolumeFile.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+VolumeSmoothingTest::VolumeSmoothingTest(const AString& identifier, const bool& benchmark) : TestInterface(identifier, benchmark)
+{
+}
+
+void VolumeSmoothingTest::execute()
+{//compare the recursive gaussian against the direct kernel, which is truncated at 3 sigma, so allow a little difference
+    const float TOLER = 0.005f;
+    const float KERNEL = 6.0f;//2mm voxels, so 3 voxels sigma
+    vector<int64_t> dims(3);
+    dims[0] = 48; dims[1] = 44; dims[2] = 40;
+    vector<vector<float> > sform(3, vector<float>(4, 0.0f));
+    sform[0][0] = 2.0f; sform[1][1] = 2.0f; sform[2][2] = 2.0f;
+    int64_t frameSize = dims[0] * dims[1] * dims[2];
+    VolumeFile inVol, roiVol;
+    inVol.reinitialize(dims, sform);
+    roiVol.reinitialize(dims, sform);
+    vector<float> inData(frameSize), roiData(frameSize);
+    for (int64_t k = 0; k < dims[2]; ++k)
+    {
+        for (int64_t j = 0; j < dims[1]; ++j)
+        {
+            for (int64_t i = 0; i < dims[0]; ++i)
+            {
+                int64_t index = inVol.getIndex(i, j, k);
+                float dx = i - dims[0] / 2.0f, dy = j - dims[1] / 2.0f, dz = k - dims[2] / 2.0f;
+                roiData[index] = (dx * dx + dy * dy + dz * dz < 15.0f * 15.0f) ? 1.0f : 0.0f;//sphere, so the roi has curved edges
+                if (rand() % 10 == 0)
+                {//some zeros for -fix-zeros
+                    inData[index] = 0.0f;
+                } else {
+                    inData[index] = rand() / (float)RAND_MAX;
+                }
+            }
+        }
+    }
+    inVol.setFrame(inData.data());
+    roiVol.setFrame(roiData.data());
+    try
+    {
+        for (int mode = 0; mode < 3; ++mode)
+        {
+            const VolumeFile* roiPtr = (mode == 2 ? &roiVol : NULL);
+            bool fixZeros = (mode == 1);
+            const char* modeName = (mode == 0 ? "plain" : (mode == 1 ? "fix-zeros" : "roi"));
+            VolumeFile directOut, recursiveOut;
+            ElapsedTimer myTimer;
+            myTimer.start();
+            AlgorithmVolumeSmoothing(NULL, &inVol, KERNEL, &directOut, roiPtr, fixZeros, -1, 1000.0f);//force direct
+            double directTime = myTimer.getElapsedTimeSeconds();
+            myTimer.start();
+            AlgorithmVolumeSmoothing(NULL, &inVol, KERNEL, &recursiveOut, roiPtr, fixZeros, -1, 0.0f);//force recursive
+            double recursiveTime = myTimer.getElapsedTimeSeconds();
+            if (isBenchmark()) cout << modeName << ": direct " << directTime << " seconds, recursive " << recursiveTime << " seconds" << endl;
+            const float* directFrame = directOut.getFrame();
+            const float* recursiveFrame = recursiveOut.getFrame();
+            float maxDiff = 0.0f;
+            for (int64_t i = 0; i < frameSize; ++i)
+            {
+                float diff = abs(directFrame[i] - recursiveFrame[i]);
+                if (!(diff <= maxDiff)) maxDiff = diff;//catch NaN
+                if (roiPtr != NULL && roiData[i] == 0.0f && recursiveFrame[i] != 0.0f)
+                {
+                    setFailed(AString(modeName) + ": recursive smoothing wrote nonzero value outside roi at index " + AString::number(i));
+                    break;
+                }
+            }
+            if (!(maxDiff < TOLER))
+            {
+                setFailed(AString(modeName) + ": recursive smoothing differs from direct by " + AString::number(maxDiff));
+            }
+        }
+    } catch (CaretException& e) {
+        setFailed(e.whatString());
+    }
+}
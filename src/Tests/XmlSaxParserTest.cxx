@@ -0,0 +1,212 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "XmlSaxParserTest.h"
+
+#include "SystemUtilities.h"
+#include "XmlAttributes.h"
+#include "XmlSaxParserException.h"
+#include "XmlSaxParserHandlerInterface.h"
+#include "XmlSaxParserNative.h"
+#include "XmlSaxParserWithQt.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    class EventRecorder : public XmlSaxParserHandlerInterface
+    {//text is merged between markup, the parsers are free to split it differently
+        string m_pendingText;
+        void flushText()
+        {
+            if (!m_pendingText.empty())
+            {
+                m_events.push_back("text: " + AString::fromUtf8(m_pendingText.data(), m_pendingText.size()));
+                m_pendingText.clear();
+            }
+        }
+    public:
+        vector<AString> m_events;
+        void startElement(const AString&, const AString& localName, const AString& qName, const XmlAttributes& atts)
+        {
+            flushText();
+            AString event = "start: " + qName + " (" + localName + ")";
+            for (int i = 0; i < atts.getNumberOfAttributes(); ++i)
+            {
+                event += " " + atts.getName(i) + "=\"" + atts.getValue(i) + "\"";
+            }
+            m_events.push_back(event);
+        }
+        void endElement(const AString&, const AString& localName, const AString& qName)
+        {
+            flushText();
+            m_events.push_back("end: " + qName + " (" + localName + ")");
+        }
+        void characters(const char* ch) { m_pendingText += ch; }
+        void characterData(const char* ch, const int64_t& length) { m_pendingText.append(ch, length); }
+        void warning(const XmlSaxParserException&) { }
+        void error(const XmlSaxParserException& e) { throw e; }
+        void fatalError(const XmlSaxParserException& e) { throw e; }
+        void startDocument() { m_events.push_back("start document"); }
+        void endDocument()
+        {
+            flushText();
+            m_events.push_back("end document");
+        }
+    };
+    
+    AString shorten(const AString& event)
+    {
+        if (event.size() <= 200) return event;
+        return event.left(200) + "... (" + AString::number(event.size()) + " characters)";
+    }
+    
+    void compareEvents(TestInterface* test, const AString& condition, const vector<AString>& nativeEvents, const vector<AString>& qtEvents)
+    {
+        size_t numCommon = min(nativeEvents.size(), qtEvents.size());
+        for (size_t i = 0; i < numCommon; ++i)
+        {
+            if (nativeEvents[i] != qtEvents[i])
+            {
+                test->setFailed(condition + ", event " + AString::number(i) + " differs, native parser gave '" + shorten(nativeEvents[i]) + "', Qt parser gave '" + shorten(qtEvents[i]) + "'");
+                return;
+            }
+        }
+        if (nativeEvents.size() != qtEvents.size())
+        {
+            test->setFailed(condition + ", native parser gave " + AString::number(nativeEvents.size()) + " events, Qt parser gave " + AString::number(qtEvents.size()));
+        }
+    }
+}
+
+XmlSaxParserTest::XmlSaxParserTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void XmlSaxParserTest::execute()
+{//the native parser must report the same elements, attributes and text as the Qt parser, and reject what Qt rejects
+    compareString("comments and CDATA",
+                  "<r>a<!-- comment with <tags> & ampersands -->b<![CDATA[<not> &amp; a tag]]>c<!---->d<![CDATA[]]></r>");
+    compareString("predefined entities and character references",
+                  "<r a=\"&lt;&gt;&amp;&quot;&apos;\">&lt;x&gt; &amp; &quot;q&quot; &apos;s&apos; &#65;&#x42;&#x20AC;&#128512;</r>");
+    compareString("document type declaration with internal subset",
+                  "<?xml version=\"1.0\"?>\n<!DOCTYPE r [\n<!ELEMENT r (#PCDATA|b)*>\n<!ELEMENT b EMPTY>\n<!ENTITY unused \"a > b ] c\">\n<!-- a ] > comment -->\n]>\n<r>x<b/>y</r>");
+    compareString("CRLF line endings",
+                  "<?xml version=\"1.0\"?>\r\n<r>\r\n<b a=\"x\">line1\r\nline2\r\n</b>\r\n</r>\r\n");
+    compareString("> in attribute values",
+                  "<r a=\"1 > 0\" b='x>y\"z'><b c=\">\"/></r>");
+    compareString("multibyte UTF-8",
+                  QString::fromUtf8("<r k=\"\xC3\xA9\">\xE2\x82\xAC \xF0\x9F\x98\x80</r>"));
+    checkReadChunks();
+    checkMalformed();
+}
+
+void XmlSaxParserTest::compareString(const AString& condition, const AString& xmlString)
+{
+    EventRecorder nativeEvents, qtEvents;
+    try
+    {
+        XmlSaxParserNative().parseString(xmlString, &nativeEvents);
+    } catch (XmlSaxParserException& e) {
+        setFailed(condition + ", native parser failed: " + e.whatString());
+        return;
+    }
+    try
+    {
+        XmlSaxParserWithQt().parseString(xmlString, &qtEvents);
+    } catch (XmlSaxParserException& e) {
+        setFailed(condition + ", Qt parser failed: " + e.whatString());
+        return;
+    }
+    compareEvents(this, condition, nativeEvents.m_events, qtEvents.m_events);
+}
+
+void XmlSaxParserTest::checkReadChunks()
+{//the native parser reads files 1MiB at a time, put multibyte characters, a character reference, and a CRLF across those boundaries
+    const int64_t READ_BLOCK_SIZE = 1 << 20;
+    const char* straddlers[4] = { "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "&#x20AC;", "\r\n" };
+    string document = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<r>";
+    for (int block = 1; block <= 4; ++block)
+    {
+        int64_t straddleStart = block * READ_BLOCK_SIZE - 1;
+        while ((int64_t)document.size() < straddleStart)
+        {
+            document += (char)('a' + document.size() % 26);
+        }
+        document += straddlers[block - 1];
+    }
+    document += "</r>\n";
+    AString fileName = SystemUtilities::getTempDirectory() + "/wb_xmlsaxparser_" + SystemUtilities::createUniqueID() + ".xml";
+    QFile outFile(fileName);
+    if (!outFile.open(QIODevice::WriteOnly) || outFile.write(document.data(), document.size()) != (qint64)document.size())
+    {
+        setFailed("failed to write temporary file " + fileName);
+        QFile::remove(fileName);
+        return;
+    }
+    outFile.close();
+    EventRecorder nativeEvents, qtEvents;
+    try
+    {
+        XmlSaxParserNative().parseFile(fileName, &nativeEvents);
+        XmlSaxParserWithQt().parseFile(fileName, &qtEvents);
+        compareEvents(this, "characters split across read blocks", nativeEvents.m_events, qtEvents.m_events);
+    } catch (XmlSaxParserException& e) {
+        setFailed("characters split across read blocks, parsing failed: " + e.whatString());
+    }
+    QFile::remove(fileName);
+}
+
+void XmlSaxParserTest::checkMalformed()
+{
+    const char* malformed[] = {
+        "<r><b></r>",//mismatched end tag
+        "<r><b>",//unclosed elements
+        "<r>&undefined;</r>",
+        "<r>&amp</r>",//unterminated reference
+        "<r>&#0;</r>",
+        "<r a=1/>",//unquoted attribute
+        "<r a=\"1/>",//unterminated attribute value
+        "<r/>text",//text after the root element
+        "<r/><s/>",//two root elements
+        "<r><![CDATA[unterminated</r>",
+        "<r><!-- unterminated</r>",
+        "<!DOCTYPE r [ <!ELEMENT r ANY>",//unterminated document type declaration
+        ""//no root element
+    };
+    const int numMalformed = sizeof(malformed) / sizeof(malformed[0]);
+    for (int i = 0; i < numMalformed; ++i)
+    {
+        EventRecorder nativeEvents;
+        try
+        {
+            XmlSaxParserNative().parseString(malformed[i], &nativeEvents);
+            setFailed("native parser accepted malformed XML: '" + AString(malformed[i]) + "'");
+        } catch (XmlSaxParserException&) {//expected
+        }
+    }
+}
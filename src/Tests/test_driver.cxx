@@ -33,21 +33,39 @@
 #include "CaretException.h"
 
 //tests
+#include "CiftiCorrelationTest.h"
 #include "CiftiFileTest.h"
+#include "CiftiMultiFileRowReaderTest.h"
+#include "CiftiParcellateTest.h"
+#include "CiftiStatisticsExtensionTest.h"
+#include "CiftiTransposeTest.h"
+#include "CziTileCacheTest.h"
 #include "DotTest.h"
 #include "GeodesicHelperTest.h"
+#include "GiftiReadTest.h"
+#include "GzipIndexTest.h"
 #include "HttpTest.h"
 #include "HeapTest.h"
 #include "LookupTest.h"
 #include "MathExpressionTest.h"
+#include "MetricResampleTest.h"
 #include "NiftiTest.h"
+#include "NiftiGzipTest.h"
+#include "NiftiReadScalingTest.h"
 #include "PointerTest.h"
 #include "ProgressTest.h"
 #include "QuatTest.h"
+#include "ReductionAccumulatorTest.h"
+#include "ResampleWeightCacheTest.h"
+#include "RibbonWeightMatrixTest.h"
 #include "StatisticsTest.h"
+#include "TfcePermutationTest.h"
 #include "TimerTest.h"
 #include "TopologyHelperTest.h"
+#include "TriangleBVHTest.h"
 #include "VolumeFileTest.h"
+#include "VolumeSmoothingTest.h"
+#include "XmlSaxParserTest.h"
 #include "XnatTest.h"
 
 using namespace std;
@@ -69,22 +87,49 @@ int main(int argc, char** argv)
         caret_global_commandLine_init(argc, argv);
         SessionManager::createSessionManager(ApplicationTypeEnum::APPLICATION_TYPE_COMMAND_LINE);
         vector<TestInterface*> mytests;
+        mytests.push_back(new CiftiCorrelationTest("cifticorrelation"));
         mytests.push_back(new CiftiFileTest("ciftifile"));
+        mytests.push_back(new CiftiMultiFileRowReaderTest("ciftimultifilerowreader"));
+        mytests.push_back(new CiftiMultiFileRowReaderTest("ciftimultifilerowreaderbenchmark", true));//not run by ctest
+        mytests.push_back(new CiftiParcellateTest("ciftiparcellate"));
+        mytests.push_back(new CiftiStatisticsExtensionTest("ciftistatistics"));
+        mytests.push_back(new CiftiTransposeTest("ciftitranspose"));
+        mytests.push_back(new CiftiTransposeTest("ciftitransposebenchmark", true));//not run by ctest
+        mytests.push_back(new CziTileCacheTest("czitilecache"));
+        mytests.push_back(new CziTileCacheTest("czitilecachebenchmark", true));//not run by ctest
         mytests.push_back(new DotTest("dotsimd"));
         mytests.push_back(new GeodesicHelperTest("geohelp"));
+        mytests.push_back(new GeodesicHelperTest("geohelpbenchmark", true));//not run by ctest
+        mytests.push_back(new GiftiReadTest("giftiread"));
+        mytests.push_back(new GiftiReadTest("giftireadbenchmark", true));//not run by ctest
+        mytests.push_back(new GzipIndexTest("gzipindex"));
         mytests.push_back(new HeapTest("heap"));
         mytests.push_back(new HttpTest("http"));
         mytests.push_back(new LookupTest("lookup"));
         mytests.push_back(new MathExpressionTest("mathexpression"));
+        mytests.push_back(new MetricResampleTest("metricresample"));
         mytests.push_back(new NiftiFileTest("niftifile"));
+        mytests.push_back(new NiftiGzipTest("niftigzip"));
+        mytests.push_back(new NiftiGzipTest("niftigzipbenchmark", true));//not run by ctest
         mytests.push_back(new NiftiHeaderTest("niftiheader"));
+        mytests.push_back(new NiftiReadScalingTest("niftireadscaling"));
+        mytests.push_back(new NiftiReadScalingTest("niftireadscalingbenchmark", true));//not run by ctest
         mytests.push_back(new PointerTest("pointer"));
         mytests.push_back(new ProgressTest("progress"));
         mytests.push_back(new QuatTest("quaternion"));
+        mytests.push_back(new ReductionAccumulatorTest("reductionaccumulator"));
+        mytests.push_back(new ResampleWeightCacheTest("resampleweightcache"));
+        mytests.push_back(new RibbonWeightMatrixTest("ribbonweightmatrix"));
         mytests.push_back(new StatisticsTest("statistics"));
+        mytests.push_back(new TfcePermutationTest("tfcepermutation"));
         mytests.push_back(new TimerTest("timer"));
         mytests.push_back(new TopologyHelperTest("topohelp"));
+        mytests.push_back(new TriangleBVHTest("trianglebvh"));
+        mytests.push_back(new TriangleBVHTest("trianglebvhbenchmark", true));//not run by ctest
         mytests.push_back(new VolumeFileTest("volumefile"));
+        mytests.push_back(new VolumeSmoothingTest("volumesmoothing"));
+        mytests.push_back(new VolumeSmoothingTest("volumesmoothingbenchmark", true));//not run by ctest
+        mytests.push_back(new XmlSaxParserTest("xmlsaxparser"));
         mytests.push_back(new XnatTest("xnat"));
         if (argc < 2)
         {
@@ -101,7 +146,7 @@ int main(int argc, char** argv)
         {
             for (int j = 0; j < (int)mytests.size(); ++j)
             {
-                if (mytests[j]->getIdentifier() == AString(argv[i]) || "all" == AString(argv[i]))
+                if (mytests[j]->getIdentifier() == AString(argv[i]) || ("all" == AString(argv[i]) && !mytests[j]->isBenchmark()))
                 {
                     try
                     {
@@ -20,6 +20,7 @@
 
 #include "XmlSaxParser.h"
 #include "XmlSaxParserException.h"
+#include "XmlSaxParserNative.h"
 #include "XmlSaxParserWithQt.h"
 
 using namespace caret;
@@ -48,6 +49,19 @@ XmlSaxParser::createXmlParser()
     return parser;
 }
 
+/**
+ * @return A parser that passes character data to the handler's
+ * characterData() straight from the file's bytes, for files with
+ * large character data.  See XmlSaxParserNative.
+ */
+XmlSaxParser*
+XmlSaxParser::createNativeXmlParser()
+{
+    XmlSaxParser* parser = new XmlSaxParserNative();
+    
+    return parser;
+}
+
 /**
  * Initialize members.
  */
@@ -40,6 +40,8 @@ namespace caret {
     public:
         static XmlSaxParser* createXmlParser();
         
+        static XmlSaxParser* createNativeXmlParser();
+        
         virtual ~XmlSaxParser();
         
     protected:
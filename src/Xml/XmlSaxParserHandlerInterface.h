@@ -23,6 +23,7 @@
 
 
 #include <exception>
+#include <string>
 #include <AString.h>
 
 #include "CaretObject.h"
@@ -116,6 +117,21 @@ namespace caret {
          * @param ch The characters from the XML document.
          */
         virtual void characters(const char* ch) = 0;
+        
+        /**
+         * Receive notification of characters that are not null terminated.
+         * Parsers that read the file as UTF-8 bytes call this instead of
+         * characters(), so that large character data does not need to be
+         * copied.  A chunk never ends in the middle of a UTF-8 sequence.
+         * The default implementation calls characters() with a copy.
+         *
+         * @param ch The UTF-8 characters from the XML document.
+         * @param length Number of bytes in ch.
+         */
+        virtual void characterData(const char* ch, const int64_t& length)
+        {
+            characters(std::string(ch, length).c_str());
+        }
 
         /**
          * Receive notification of a warning.
@@ -0,0 +1,586 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "XmlSaxParserNative.h"
+
+#include "DataFile.h"
+#include "XmlAttributes.h"
+#include "XmlSaxParserHandlerInterface.h"
+#include "XmlSaxParserWithQt.h"
+
+#include <QBuffer>
+#include <QFile>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t READ_BLOCK_SIZE = 1 << 20;//also the smallest piece of character data passed to the handler, unless an element ends first
+
+    bool isXmlSpace(const char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    void appendUtf8(const uint32_t code, string& out)
+    {
+        if (code < 0x80)
+        {
+            out += (char)code;
+        } else if (code < 0x800) {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        } else {
+            out += (char)(0xF0 | (code >> 18));
+            out += (char)(0x80 | ((code >> 12) & 0x3F));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    ///false if the start of the file shows it is UTF-16, or the XML declaration names an encoding other than UTF-8 or ASCII
+    bool isUtf8Document(const QByteArray& fileStart)
+    {
+        string start(fileStart.constData(), fileStart.size());
+        if (start.size() >= 2 && ((unsigned char)start[0] == 0xFE || (unsigned char)start[0] == 0xFF || start[0] == '\0' || start[1] == '\0'))
+        {
+            return false;
+        }
+        if (start.compare(0, 3, "\xEF\xBB\xBF") == 0) start = start.substr(3);
+        if (start.compare(0, 5, "<?xml") != 0) return true;
+        size_t declEnd = start.find("?>");
+        size_t encodingPos = start.find("encoding");
+        if (encodingPos == string::npos || encodingPos > declEnd) return true;
+        size_t quotePos = start.find_first_of("\"'", encodingPos);
+        if (quotePos == string::npos || quotePos > declEnd) return false;
+        size_t quoteEnd = start.find(start[quotePos], quotePos + 1);
+        if (quoteEnd == string::npos || quoteEnd > declEnd) return false;
+        AString encoding = AString::fromLatin1(start.c_str() + quotePos + 1, quoteEnd - quotePos - 1).toLower();
+        return (encoding == "utf-8" || encoding == "utf8" || encoding == "us-ascii" || encoding == "ascii");
+    }
+
+    class NativeXmlReader
+    {
+        QIODevice* m_device;
+        XmlSaxParserHandlerInterface* m_handler;
+        vector<char> m_buffer;
+        int64_t m_pos, m_end;//unparsed data is [m_pos, m_end)
+        bool m_atEnd;
+        int32_t m_lineNumber, m_columnNumber;
+        vector<string> m_openElements;
+        string m_scratch;
+
+        bool readMore();
+        bool startsWith(const char* pattern);
+        int64_t find(const char* pattern, const int64_t& startOffset);
+        int64_t findTagEnd();
+        void advance(const int64_t& count);
+        void fatal(const AString& message);
+        void decodeText(const char* text, const int64_t& length, string& out, const bool& attribute);
+        void emitText(const char* text, const int64_t& length);
+        void parseText();
+        void parseStartTag(const int64_t& tagLength);
+        void parseEndTag(const int64_t& tagLength);
+        void skipDoctype();
+    public:
+        NativeXmlReader(QIODevice* device, XmlSaxParserHandlerInterface* handler);
+        void parse();
+    };
+
+    NativeXmlReader::NativeXmlReader(QIODevice* device, XmlSaxParserHandlerInterface* handler)
+    {
+        m_device = device;
+        m_handler = handler;
+        m_pos = 0;
+        m_end = 0;
+        m_atEnd = false;
+        m_lineNumber = 1;
+        m_columnNumber = 1;
+    }
+
+    bool NativeXmlReader::readMore()
+    {//NOTE: invalidates pointers into m_buffer
+        if (m_atEnd) return false;
+        if (m_pos > 0)
+        {
+            memmove(m_buffer.data(), m_buffer.data() + m_pos, m_end - m_pos);
+            m_end -= m_pos;
+            m_pos = 0;
+        }
+        if ((int64_t)m_buffer.size() - m_end < READ_BLOCK_SIZE)
+        {
+            m_buffer.resize(m_end + READ_BLOCK_SIZE);
+        }
+        qint64 numRead = m_device->read(m_buffer.data() + m_end, READ_BLOCK_SIZE);
+        if (numRead < 0)
+        {
+            fatal("error reading file: " + m_device->errorString());
+        }
+        if (numRead == 0)
+        {
+            m_atEnd = true;
+            return false;
+        }
+        m_end += numRead;
+        return true;
+    }
+
+    bool NativeXmlReader::startsWith(const char* pattern)
+    {
+        int64_t length = strlen(pattern);
+        while (m_end - m_pos < length)
+        {
+            if (!readMore()) return false;
+        }
+        return memcmp(m_buffer.data() + m_pos, pattern, length) == 0;
+    }
+
+    int64_t NativeXmlReader::find(const char* pattern, const int64_t& startOffset)
+    {//offset from m_pos, or -1 if the input ends first
+        int64_t patternLength = strlen(pattern);
+        int64_t searchFrom = startOffset;
+        while (true)
+        {
+            const char* begin = m_buffer.data() + m_pos, *end = m_buffer.data() + m_end;
+            const char* hit = search(begin + min(searchFrom, m_end - m_pos), end, pattern, pattern + patternLength);
+            if (hit != end) return hit - begin;
+            searchFrom = max(startOffset, (m_end - m_pos) - patternLength + 1);
+            if (!readMore()) return -1;
+        }
+    }
+
+    int64_t NativeXmlReader::findTagEnd()
+    {//attribute values may contain '>'
+        char quote = 0;
+        int64_t i = 1;
+        while (true)
+        {
+            const char* begin = m_buffer.data() + m_pos;
+            int64_t available = m_end - m_pos;
+            for (; i < available; ++i)
+            {
+                char thisChar = begin[i];
+                if (quote != 0)
+                {
+                    if (thisChar == quote) quote = 0;
+                } else if (thisChar == '"' || thisChar == '\'') {
+                    quote = thisChar;
+                } else if (thisChar == '>') {
+                    return i;
+                }
+            }
+            if (!readMore()) return -1;
+        }
+    }
+
+    void NativeXmlReader::advance(const int64_t& count)
+    {
+        const char* begin = m_buffer.data() + m_pos, *end = begin + count;
+        const char* lastNewline = NULL;
+        for (const char* newline = (const char*)memchr(begin, '\n', count); newline != NULL; newline = (const char*)memchr(newline + 1, '\n', end - (newline + 1)))
+        {
+            ++m_lineNumber;
+            lastNewline = newline;
+        }
+        if (lastNewline != NULL)
+        {
+            m_columnNumber = (end - lastNewline);
+        } else {
+            m_columnNumber += count;
+        }
+        m_pos += count;
+    }
+
+    void NativeXmlReader::fatal(const AString& message)
+    {
+        XmlSaxParserException e(message, m_lineNumber, m_columnNumber);
+        m_handler->fatalError(e);//normally rethrows
+        throw e;
+    }
+
+    void NativeXmlReader::decodeText(const char* text, const int64_t& length, string& out, const bool& attribute)
+    {//expand references and normalize line endings, and whitespace in attributes, like a conforming parser
+        out.clear();
+        out.reserve(length);
+        for (int64_t i = 0; i < length; ++i)
+        {
+            char thisChar = text[i];
+            if (thisChar == '&')
+            {
+                const char* semicolon = (const char*)memchr(text + i + 1, ';', length - i - 1);
+                if (semicolon == NULL) fatal("unterminated entity reference");
+                string name(text + i + 1, semicolon);
+                if (name == "lt")
+                {
+                    out += '<';
+                } else if (name == "gt") {
+                    out += '>';
+                } else if (name == "amp") {
+                    out += '&';
+                } else if (name == "quot") {
+                    out += '"';
+                } else if (name == "apos") {
+                    out += '\'';
+                } else if (name.size() > 1 && name[0] == '#') {
+                    char* parseEnd = NULL;
+                    unsigned long code;
+                    if (name[1] == 'x')
+                    {
+                        code = strtoul(name.c_str() + 2, &parseEnd, 16);
+                    } else {
+                        code = strtoul(name.c_str() + 1, &parseEnd, 10);
+                    }
+                    if (parseEnd == NULL || *parseEnd != '\0' || code == 0 || code > 0x10FFFF)
+                    {
+                        fatal("invalid character reference: &" + AString::fromUtf8(name.c_str()) + ";");
+                    }
+                    appendUtf8(code, out);
+                } else {
+                    fatal("undefined entity: &" + AString::fromUtf8(name.c_str()) + ";");
+                }
+                i = semicolon - text;
+                continue;
+            }
+            if (thisChar == '\r')
+            {
+                if (i + 1 < length && text[i + 1] == '\n') continue;
+                thisChar = '\n';
+            }
+            if (attribute && (thisChar == '\n' || thisChar == '\t')) thisChar = ' ';
+            out += thisChar;
+        }
+    }
+
+    void NativeXmlReader::emitText(const char* text, const int64_t& length)
+    {
+        if (memchr(text, '&', length) == NULL && memchr(text, '\r', length) == NULL)
+        {
+            m_handler->characterData(text, length);//nearly always, and the whole point of this parser
+        } else {
+            decodeText(text, length, m_scratch, false);
+            m_handler->characterData(m_scratch.data(), m_scratch.size());
+        }
+    }
+
+    void NativeXmlReader::parseText()
+    {
+        const char* begin = m_buffer.data() + m_pos;
+        int64_t available = m_end - m_pos;
+        const char* lessThan = (const char*)memchr(begin, '<', available);
+        int64_t length = available;
+        if (lessThan != NULL)
+        {
+            length = lessThan - begin;
+        } else if (!m_atEnd) {
+            if (available < READ_BLOCK_SIZE)
+            {
+                readMore();//find the end of the text, or collect a full block of it
+                return;
+            }
+            int64_t lead = length - 1;//don't split a UTF-8 sequence, a reference, or a CR LF pair
+            while (lead > 0 && ((unsigned char)begin[lead] & 0xC0) == 0x80) --lead;
+            unsigned char leadByte = begin[lead];
+            int64_t sequenceLength = (leadByte < 0xC0 ? 1 : (leadByte < 0xE0 ? 2 : (leadByte < 0xF0 ? 3 : 4)));
+            if (lead + sequenceLength > length) length = lead;
+            for (int64_t i = length - 1; i >= 0 && i >= length - 32; --i)
+            {
+                if (begin[i] == ';') break;
+                if (begin[i] == '&')
+                {
+                    length = i;
+                    break;
+                }
+            }
+            if (length > 0 && begin[length - 1] == '\r') --length;
+        }
+        if (m_openElements.empty())
+        {
+            for (int64_t i = 0; i < length; ++i)
+            {
+                if (!isXmlSpace(begin[i])) fatal("text outside of the root element");
+            }
+        } else if (length > 0) {
+            emitText(begin, length);
+        }
+        advance(length);
+    }
+
+    void NativeXmlReader::parseStartTag(const int64_t& tagLength)
+    {
+        const char* tag = m_buffer.data() + m_pos;
+        bool selfClosing = (tagLength > 1 && tag[tagLength - 1] == '/');
+        int64_t contentEnd = (selfClosing ? tagLength - 1 : tagLength);
+        int64_t i = 1;
+        while (i < contentEnd && !isXmlSpace(tag[i])) ++i;
+        if (i == 1) fatal("element has no name");
+        string name(tag + 1, tag + i);
+        XmlAttributes attributes;
+        while (true)
+        {
+            while (i < contentEnd && isXmlSpace(tag[i])) ++i;
+            if (i >= contentEnd) break;
+            int64_t attrNameStart = i;
+            while (i < contentEnd && tag[i] != '=' && !isXmlSpace(tag[i])) ++i;
+            string attrName(tag + attrNameStart, tag + i);
+            while (i < contentEnd && isXmlSpace(tag[i])) ++i;
+            if (i >= contentEnd || tag[i] != '=') fatal("attribute \"" + AString::fromUtf8(attrName.c_str()) + "\" has no value");
+            ++i;
+            while (i < contentEnd && isXmlSpace(tag[i])) ++i;
+            if (i >= contentEnd || (tag[i] != '"' && tag[i] != '\'')) fatal("value of attribute \"" + AString::fromUtf8(attrName.c_str()) + "\" is not quoted");
+            const char* valueEnd = (const char*)memchr(tag + i + 1, tag[i], contentEnd - i - 1);
+            if (valueEnd == NULL) fatal("value of attribute \"" + AString::fromUtf8(attrName.c_str()) + "\" is not terminated");
+            decodeText(tag + i + 1, valueEnd - (tag + i + 1), m_scratch, true);
+            attributes.addAttribute(AString::fromUtf8(attrName.c_str(), attrName.size()), AString::fromUtf8(m_scratch.data(), m_scratch.size()));
+            i = valueEnd - tag + 1;
+        }
+        AString qName = AString::fromUtf8(name.c_str(), name.size());
+        AString localName = qName.mid(qName.indexOf(':') + 1);
+        m_handler->startElement("", localName, qName, attributes);
+        if (selfClosing)
+        {
+            m_handler->endElement("", localName, qName);
+        } else {
+            m_openElements.push_back(name);
+        }
+    }
+
+    void NativeXmlReader::parseEndTag(const int64_t& tagLength)
+    {
+        const char* tag = m_buffer.data() + m_pos;
+        int64_t nameEnd = tagLength;
+        while (nameEnd > 2 && isXmlSpace(tag[nameEnd - 1])) --nameEnd;
+        string name(tag + 2, tag + nameEnd);
+        if (m_openElements.empty())
+        {
+            fatal("end tag \"" + AString::fromUtf8(name.c_str()) + "\" has no matching start tag");
+        }
+        if (name != m_openElements.back())
+        {
+            fatal("end tag \"" + AString::fromUtf8(name.c_str()) + "\" does not match start tag \"" + AString::fromUtf8(m_openElements.back().c_str()) + "\"");
+        }
+        AString qName = AString::fromUtf8(name.c_str(), name.size());
+        m_handler->endElement("", qName.mid(qName.indexOf(':') + 1), qName);
+        m_openElements.pop_back();
+    }
+
+    void NativeXmlReader::skipDoctype()
+    {//internal subset may contain '>' inside brackets, quotes, comments or processing instructions, its declarations are not used
+        int depth = 0;
+        char quote = 0;
+        const char* skipEnd = NULL;//end of the comment or processing instruction we are in
+        int64_t i = 9;
+        while (true)
+        {
+            const char* begin = m_buffer.data() + m_pos;
+            int64_t available = m_end - m_pos;
+            for (; i < available; ++i)
+            {
+                char thisChar = begin[i];
+                if (skipEnd != NULL)
+                {//the end marker is 2 or 3 characters ending in '>', and the start marker is always before it in the buffer
+                    int64_t endLength = strlen(skipEnd);
+                    if (thisChar == '>' && memcmp(begin + i - endLength + 1, skipEnd, endLength) == 0) skipEnd = NULL;
+                } else if (quote != 0) {
+                    if (thisChar == quote) quote = 0;
+                } else if (thisChar == '<' && depth > 0) {
+                    if (available - i < 4 && !m_atEnd) break;//need to see what kind of markup this is
+                    if (available - i >= 4 && memcmp(begin + i, "<!--", 4) == 0)
+                    {
+                        skipEnd = "-->";
+                        i += 3;
+                    } else if (available - i >= 2 && begin[i + 1] == '?') {
+                        skipEnd = "?>";
+                        i += 1;
+                    }
+                } else if (thisChar == '"' || thisChar == '\'') {
+                    quote = thisChar;
+                } else if (thisChar == '[') {
+                    ++depth;
+                } else if (thisChar == ']') {
+                    --depth;
+                } else if (thisChar == '>' && depth <= 0) {
+                    advance(i + 1);
+                    return;
+                }
+            }
+            if (!readMore()) fatal("unterminated document type declaration");
+        }
+    }
+
+    void NativeXmlReader::parse()
+    {
+        m_handler->startDocument();
+        if (startsWith("\xEF\xBB\xBF")) m_pos += 3;//byte order mark
+        bool sawRoot = false;
+        while (true)
+        {
+            if (m_pos == m_end && !readMore()) break;
+            if (m_buffer[m_pos] != '<')
+            {
+                parseText();
+                continue;
+            }
+            if (startsWith("<?"))
+            {
+                int64_t endOffset = find("?>", 2);
+                if (endOffset < 0) fatal("unterminated processing instruction");
+                advance(endOffset + 2);
+            } else if (startsWith("<!--")) {
+                int64_t endOffset = find("-->", 4);
+                if (endOffset < 0) fatal("unterminated comment");
+                advance(endOffset + 3);
+            } else if (startsWith("<![CDATA[")) {
+                if (m_openElements.empty()) fatal("CDATA section outside of the root element");
+                int64_t endOffset = find("]]>", 9);
+                if (endOffset < 0) fatal("unterminated CDATA section");
+                if (endOffset > 9) m_handler->characterData(m_buffer.data() + m_pos + 9, endOffset - 9);
+                advance(endOffset + 3);
+            } else if (startsWith("<!DOCTYPE")) {
+                if (sawRoot) fatal("document type declaration after the root element");
+                skipDoctype();
+            } else if (startsWith("<!")) {
+                fatal("unsupported markup declaration");
+            } else if (startsWith("</")) {
+                int64_t endOffset = findTagEnd();
+                if (endOffset < 0) fatal("unterminated end tag");
+                parseEndTag(endOffset);
+                advance(endOffset + 1);
+            } else {
+                int64_t endOffset = findTagEnd();
+                if (endOffset < 0) fatal("unterminated start tag");
+                if (m_openElements.empty())
+                {
+                    if (sawRoot) fatal("document has more than one root element");
+                    sawRoot = true;
+                }
+                parseStartTag(endOffset);
+                advance(endOffset + 1);
+            }
+        }
+        if (!sawRoot) fatal("document has no root element");
+        if (!m_openElements.empty())
+        {
+            fatal("unexpected end of file, element \"" + AString::fromUtf8(m_openElements.back().c_str()) + "\" is not closed");
+        }
+        m_handler->endDocument();
+    }
+}
+
+/**
+ * Constructor.
+ */
+XmlSaxParserNative::XmlSaxParserNative()
+{
+}
+
+/**
+ * Destructor.
+ */
+XmlSaxParserNative::~XmlSaxParserNative()
+{
+}
+
+/**
+ * Parse the contents of the specified file using
+ * the specified handler.
+ *
+ * @param filename
+ *    Name of file that is to be parsed.
+ * @param handler
+ *    Handler that will be called to process XML
+ *    as it is read.
+ * @throws XmlSaxParserException
+ *    If an error occurs.
+ */
+void
+XmlSaxParserNative::parseFile(const QString& filename,
+                              XmlSaxParserHandlerInterface* handler)
+{
+    if (DataFile::isFileOnNetwork(filename)) {
+        XmlSaxParserWithQt qtParser;
+        qtParser.parseFile(filename,
+                           handler);
+        return;
+    }
+
+    QFile file(filename);
+    if (file.open(QFile::ReadOnly) == false) {
+        throw XmlSaxParserException("Unable to open file " + filename);
+    }
+
+    if (isUtf8Document(file.peek(1024)) == false) {
+        file.close();
+        XmlSaxParserWithQt qtParser;
+        qtParser.parseFile(filename,
+                           handler);
+        return;
+    }
+
+    parseDevice(&file,
+                handler);
+
+    file.close();
+}
+
+/**
+ * Parse the contents of the string using
+ * the specified handler.
+ *
+ * @param xmlString
+ *    String whose contents is parsed.
+ * @param handler
+ *    Handler that will be called to process XML
+ *    as it is read.
+ * @throws XmlSaxParserException
+ *    If an error occurs.
+ */
+void
+XmlSaxParserNative::parseString(const QString& xmlString,
+                                XmlSaxParserHandlerInterface* handler)
+{
+    QByteArray utf8 = xmlString.toUtf8();
+    QBuffer buffer(&utf8);
+    buffer.open(QIODevice::ReadOnly);
+    parseDevice(&buffer,
+                handler);
+}
+
+/**
+ * Parse UTF-8 XML from an open device.
+ */
+void
+XmlSaxParserNative::parseDevice(QIODevice* device,
+                                XmlSaxParserHandlerInterface* handler)
+{
+    NativeXmlReader reader(device,
+                           handler);
+    reader.parse();
+}
@@ -0,0 +1,62 @@
+#ifndef __XML_SAX_PARSER_NATIVE_H__
+#define __XML_SAX_PARSER_NATIVE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "XmlSaxParser.h"
+
+class QIODevice;
+
+namespace caret {
+
+    /**
+     * SAX parser that reads UTF-8 XML in blocks and passes character data to
+     * XmlSaxParserHandlerInterface::characterData() directly from its read buffer,
+     * without converting it to QString.  Meant for files with large character
+     * data, like GIFTI.  Document type declarations are skipped, and only the
+     * predefined entities and character references are expanded.  Files that
+     * declare another encoding, and files on the network, are handed to
+     * XmlSaxParserWithQt.
+     */
+    class XmlSaxParserNative : public XmlSaxParser {
+
+    public:
+        XmlSaxParserNative();
+
+        virtual ~XmlSaxParserNative();
+
+        virtual void parseFile(const QString& filename,
+                               XmlSaxParserHandlerInterface* handler);
+
+        virtual void parseString(const QString& xmlString,
+                                 XmlSaxParserHandlerInterface* handler);
+
+    private:
+        XmlSaxParserNative(const XmlSaxParserNative& sp);
+        XmlSaxParserNative& operator=(const XmlSaxParserNative&);
+
+        void parseDevice(QIODevice* device,
+                         XmlSaxParserHandlerInterface* handler);
+    };
+
+} // namespace
+
+#endif // __XML_SAX_PARSER_NATIVE_H__